@@ -38,6 +38,9 @@
 #include <aidl/AidlCameraService.h>
 #include <android-base/macros.h>
 #include <android-base/parseint.h>
+// 个人修改开始
+#include <android-base/strings.h>
+// 个人修改结束
 #include <android/companion/virtualnative/IVirtualDeviceManagerNative.h>
 #include <binder/ActivityManager.h>
 #include <binder/AppOpsManager.h>
@@ -86,6 +89,9 @@
 #include "utils/SessionConfigurationUtils.h"
 #include "utils/TagMonitor.h"
 #include "utils/Utils.h"
+// 个人修改开始
+#include "device3/Camera3StreamInjectionManager.h"
+// 个人修改结束
 
 namespace {
     const char* kActivityServiceName = "activity";
@@ -263,17 +269,51 @@ void CameraService::onFirstRef()
     ALOGI("CameraService pinged cameraservice proxy");
 
     // 个人修改开始
-    ALOGI("标记: 准备初始化 Camera3SocketServer");
-    mSocketServer = new camera3::Camera3SocketServer();
-    if (mSocketServer != nullptr) {
-        status_t res = mSocketServer->start();
-        ALOGI("标记: Camera3SocketServer 启动结果: %d", res);
-    } else {
-        ALOGE("标记: 无法创建 Camera3SocketServer 实例");
-    }
+    startInjectionSocketServers();
     // 个人修改结束
 }
 
+// 个人修改开始
+void CameraService::startInjectionSocketServers() {
+    std::vector<std::string> sourceIds = {
+            camera3::Camera3StreamInjectionManager::kDefaultSourceId};
+    {
+        Mutex::Autolock l(mServiceLock);
+        sourceIds.insert(sourceIds.end(), mNormalDeviceIds.begin(), mNormalDeviceIds.end());
+    }
+    char channels[PROPERTY_VALUE_MAX];
+    property_get("persist.camera.injection.channels", channels, "");
+    for (const auto& channel : base::Split(channels, ",")) {
+        std::string name = base::Trim(channel);
+        if (!name.empty()) {
+            sourceIds.push_back(name);
+        }
+    }
+
+    Mutex::Autolock l(mSocketServersLock);
+    for (const auto& sourceId : sourceIds) {
+        if (mSocketServers.find(sourceId) != mSocketServers.end()) {
+            continue;
+        }
+        sp<camera3::Camera3SocketServer> server = new camera3::Camera3SocketServer(sourceId);
+        status_t res = server->start();
+        ALOGI("标记: Camera3SocketServer (@%s) 启动结果: %d", server->getSocketName().c_str(),
+                res);
+        if (res == OK) {
+            mSocketServers.emplace(sourceId, server);
+        }
+    }
+}
+
+void CameraService::dumpInjection(int fd) {
+    camera3::Camera3StreamInjectionManager::getInstance()->dump(fd);
+    Mutex::Autolock l(mSocketServersLock);
+    for (const auto& entry : mSocketServers) {
+        entry.second->dump(fd);
+    }
+}
+// 个人修改结束
+
 status_t CameraService::enumerateProviders() {
     status_t res;
 
@@ -365,15 +405,22 @@ CameraService::~CameraService() {
     mSensorPrivacyPolicy->unregisterSelf();
     mInjectionStatusListener->removeListener();
     // 个人修改开始
-    if (mSocketServer != nullptr) {
-        mSocketServer->stop();
-        mSocketServer.clear();
+    {
+        Mutex::Autolock l(mSocketServersLock);
+        for (auto& entry : mSocketServers) {
+            entry.second->stop();
+        }
+        mSocketServers.clear();
     }
     // 个人修改结束
 }
 
 void CameraService::onNewProviderRegistered() {
     enumerateProviders();
+    // 个人修改开始
+    // 新 provider 带来的相机也需要各自的注入通道
+    startInjectionSocketServers();
+    // 个人修改结束
 }
 
 void CameraService::filterAPI1SystemCameraLocked(
@@ -5667,6 +5714,24 @@ status_t CameraService::dump(int fd, const Vector<String16>& args) {
                 getCallingUid());
         return NO_ERROR;
     }
+    // 个人修改开始
+    // --injection 只输出注入管线，不等待可能被相机操作长时间持有的 mServiceLock
+    for (size_t i = 0; i < args.size(); i++) {
+        if (args[i] != toString16(camera3::Camera3StreamInjectionManager::kDumpOption)) {
+            continue;
+        }
+        for (size_t j = 0; j + 1 < args.size(); j++) {
+            if (args[j] == toString16(
+                    camera3::Camera3StreamInjectionManager::kLogFramesOption)) {
+                bool enabled = atoi(toStdString(args[j + 1]).c_str()) != 0;
+                camera3::Camera3StreamInjectionManager::getInstance()->setFrameLogging(enabled);
+            }
+        }
+        dumpInjection(fd);
+        return NO_ERROR;
+    }
+    // 个人修改结束
+
     bool locked = tryLock(mServiceLock);
     // failed to lock - CameraService is probably deadlocked
     if (!locked) {
@@ -5764,6 +5829,10 @@ status_t CameraService::dump(int fd, const Vector<String16>& args) {
     dprintf(fd, "\n");
     camera3::CameraTraces::dump(fd);
 
+    // 个人修改开始
+    dumpInjection(fd);
+    // 个人修改结束
+
     // Process dump arguments, if any
     int n = args.size();
     String16 verboseOption("-v");
@@ -1647,7 +1647,16 @@ private:
     VirtualDeviceCameraIdMapper mVirtualDeviceCameraIdMapper;
 
     // 个人修改开始
-    sp<camera3::Camera3SocketServer> mSocketServer;
+    // 为默认注入源、每个相机 ID 以及 persist.camera.injection.channels 中列出的通道
+    // 各启动一个 socket 服务器；已经存在的不会重复创建
+    void startInjectionSocketServers();
+
+    // 注入管线的统计：注入源、输出流、合成线程池和 socket 服务器
+    void dumpInjection(int fd);
+
+    Mutex mSocketServersLock;
+    // 以注入源 ID 为键，默认源为空字符串
+    std::map<std::string, sp<camera3::Camera3SocketServer>> mSocketServers;
     // 个人修改结束
 };
 
@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#define LOG_TAG "AIDOCK_CAM_DECODER"
+#include <utils/Log.h>
+
+#include "Camera3AccessUnitAssembler.h"
+
+namespace android {
+namespace camera3 {
+
+static constexpr size_t kInitialAccessUnitCapacity = 512 * 1024;
+
+Camera3AccessUnitAssembler::Camera3AccessUnitAssembler(size_t maxAccessUnitSize) :
+        mMaxAccessUnitSize(maxAccessUnitSize),
+        mAccessUnitNalCount(0),
+        mHasSlice(false),
+        mKeyFrame(false),
+        mReference(false),
+        mAccessUnitReceiveTime(0),
+        mConfigNalCount(0),
+        mConfigReceiveTime(0) {
+    mAccessUnit.reserve(kInitialAccessUnitCapacity);
+}
+
+void Camera3AccessUnitAssembler::push(const Camera3NalSplitter::NalUnit& nal,
+        const AccessUnitCallback& onAccessUnit, nsecs_t receiveTime) {
+    uint8_t type = nal.type();
+    switch (type) {
+        case NAL_SPS:
+        case NAL_PPS:
+            if (mHasSlice) {
+                emitAccessUnit(onAccessUnit);
+            }
+            if (mConfig.empty()) {
+                mConfigReceiveTime = receiveTime;
+            }
+            append(&mConfig, nal);
+            mConfigNalCount++;
+            return;
+        case NAL_AUD:
+        case NAL_SEI:
+        case 14: case 15: case 16: case 17: case 18:
+            // 这些 NAL 单元只能出现在一个访问单元的第一个 slice 之前
+            if (mHasSlice) {
+                emitAccessUnit(onAccessUnit);
+            }
+            emitConfig(onAccessUnit);
+            break;
+        case NAL_SLICE: case 2: case 3: case 4:
+        case NAL_SLICE_IDR: {
+            // first_mb_in_slice 是 slice header 的第一个 ue(v)，值为 0 时编码为单个 '1' 比特
+            bool firstSliceOfPicture = nal.payloadSize() > 1 && (nal.payload()[1] & 0x80) != 0;
+            if (firstSliceOfPicture && mHasSlice) {
+                emitAccessUnit(onAccessUnit);
+            }
+            emitConfig(onAccessUnit);
+            mHasSlice = true;
+            mKeyFrame |= (type == NAL_SLICE_IDR);
+            mReference |= (nal.refIdc() != 0);
+            break;
+        }
+        default:
+            break;
+    }
+
+    if (mAccessUnit.size() + nal.size > mMaxAccessUnitSize) {
+        ALOGW("标记: 访问单元超过 %zu 字节上限，丢弃当前帧", mMaxAccessUnitSize);
+        mAccessUnit.clear();
+        mAccessUnitNalCount = 0;
+        mHasSlice = false;
+        mKeyFrame = false;
+        mReference = false;
+        return;
+    }
+    if (mAccessUnit.empty()) {
+        mAccessUnitReceiveTime = receiveTime;
+    }
+    append(&mAccessUnit, nal);
+    mAccessUnitNalCount++;
+
+    if ((type == NAL_END_OF_SEQUENCE || type == NAL_END_OF_STREAM) && mHasSlice) {
+        emitAccessUnit(onAccessUnit);
+    }
+}
+
+void Camera3AccessUnitAssembler::flush(const AccessUnitCallback& onAccessUnit) {
+    emitConfig(onAccessUnit);
+    if (mHasSlice) {
+        emitAccessUnit(onAccessUnit);
+    }
+    reset();
+}
+
+bool Camera3AccessUnitAssembler::wrapFrame(const std::vector<Camera3NalSplitter::NalUnit>& nals,
+        nsecs_t receiveTime, AccessUnit* au) {
+    bool hasSlice = false;
+    bool keyFrame = false;
+    bool reference = false;
+    for (const auto& nal : nals) {
+        uint8_t type = nal.type();
+        if (type == NAL_SPS || type == NAL_PPS) {
+            return false;
+        }
+        if (type >= NAL_SLICE && type <= NAL_SLICE_IDR) {
+            hasSlice = true;
+            keyFrame |= (type == NAL_SLICE_IDR);
+            reference |= (nal.refIdc() != 0);
+        }
+    }
+    if (!hasSlice) {
+        return false;
+    }
+    const Camera3NalSplitter::NalUnit& first = nals.front();
+    const Camera3NalSplitter::NalUnit& last = nals.back();
+    *au = AccessUnit{};
+    au->data = first.data;
+    au->size = (last.data + last.size) - first.data;
+    au->codecConfig = false;
+    au->keyFrame = keyFrame;
+    au->reference = reference;
+    au->nalCount = nals.size();
+    au->receiveTime = receiveTime;
+    return true;
+}
+
+void Camera3AccessUnitAssembler::reset() {
+    mAccessUnit.clear();
+    mAccessUnitNalCount = 0;
+    mHasSlice = false;
+    mKeyFrame = false;
+    mReference = false;
+    mConfig.clear();
+    mConfigNalCount = 0;
+}
+
+void Camera3AccessUnitAssembler::emitAccessUnit(const AccessUnitCallback& onAccessUnit) {
+    AccessUnit au{};
+    au.data = mAccessUnit.data();
+    au.size = mAccessUnit.size();
+    au.codecConfig = false;
+    au.keyFrame = mKeyFrame;
+    au.reference = mReference;
+    au.nalCount = mAccessUnitNalCount;
+    au.receiveTime = mAccessUnitReceiveTime;
+    onAccessUnit(au);
+
+    mAccessUnit.clear();
+    mAccessUnitNalCount = 0;
+    mHasSlice = false;
+    mKeyFrame = false;
+    mReference = false;
+}
+
+void Camera3AccessUnitAssembler::emitConfig(const AccessUnitCallback& onAccessUnit) {
+    if (mConfig.empty()) {
+        return;
+    }
+    AccessUnit au{};
+    au.data = mConfig.data();
+    au.size = mConfig.size();
+    au.codecConfig = true;
+    au.keyFrame = false;
+    au.reference = false;
+    au.nalCount = mConfigNalCount;
+    au.receiveTime = mConfigReceiveTime;
+    onAccessUnit(au);
+
+    mConfig.clear();
+    mConfigNalCount = 0;
+}
+
+void Camera3AccessUnitAssembler::append(std::vector<uint8_t>* buffer,
+        const Camera3NalSplitter::NalUnit& nal) {
+    buffer->insert(buffer->end(), nal.data, nal.data + nal.size);
+}
+
+} // namespace camera3
+} // namespace android
+// 个人修改结束
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#ifndef ANDROID_SERVERS_CAMERA_CAMERA3_ACCESS_UNIT_ASSEMBLER_H
+#define ANDROID_SERVERS_CAMERA_CAMERA3_ACCESS_UNIT_ASSEMBLER_H
+
+#include <functional>
+#include <vector>
+
+#include <utils/Timers.h>
+
+#include "Camera3NalSplitter.h"
+
+namespace android {
+namespace camera3 {
+
+/**
+ * 把 NAL 单元聚合为完整的访问单元 (一帧图像)，每帧只提交一次解码器输入缓冲区。
+ *
+ * 新访问单元的起点按 H.264 7.4.1.2.3 判断：AUD、SEI、SPS/PPS、类型 14-18 的 NAL，
+ * 或 first_mb_in_slice 为 0 的 slice (新图像的第一个 slice)。
+ * SPS/PPS 不放入访问单元，而是单独作为 codec-config 输出。
+ * 访问单元在下一个访问单元开始 (或 flush) 时输出。
+ *
+ * 输出的数据保持 Annex-B 格式 (保留各 NAL 单元的起始码)。非线程安全。
+ */
+class Camera3AccessUnitAssembler {
+  public:
+    static constexpr size_t kDefaultMaxAccessUnitSize = 8 * 1024 * 1024;
+
+    struct AccessUnit {
+        const uint8_t* data;
+        size_t size;
+        // SPS/PPS 组成的 codec-config，应以 BUFFER_FLAG_CODEC_CONFIG 提交
+        bool codecConfig;
+        // 包含 IDR slice
+        bool keyFrame;
+        // 包含 nal_ref_idc 非 0 的 slice，即会被后续帧参考；丢弃后直到下一个 IDR 都无法正确解码
+        bool reference;
+        size_t nalCount;
+        // 第一个 NAL 单元从 socket 收到的时间 (用于统计端到端延迟)
+        nsecs_t receiveTime;
+    };
+
+    // 回调中的 AccessUnit 只在回调期间有效
+    using AccessUnitCallback = std::function<void(const AccessUnit&)>;
+
+    explicit Camera3AccessUnitAssembler(size_t maxAccessUnitSize = kDefaultMaxAccessUnitSize);
+
+    // receiveTime 为该 NAL 单元所在数据的接收时间
+    void push(const Camera3NalSplitter::NalUnit& nal, const AccessUnitCallback& onAccessUnit,
+            nsecs_t receiveTime = 0);
+
+    // 输出所有缓存的数据 (连接断开时调用)，并重置状态
+    void flush(const AccessUnitCallback& onAccessUnit);
+
+    // 分帧协议约定一帧即一个访问单元。nals 为一帧切分出的 NAL 单元，按顺序在内存中连续；
+    // 帧内有 slice 且没有 SPS/PPS 时把整帧原地包装为 au 并返回 true。
+    // 含 SPS/PPS 的帧需要经过 push() 拆出 codec-config，返回 false
+    static bool wrapFrame(const std::vector<Camera3NalSplitter::NalUnit>& nals,
+            nsecs_t receiveTime, AccessUnit* au);
+
+    void reset();
+
+  private:
+    enum NalType : uint8_t {
+        NAL_SLICE = 1,
+        NAL_SLICE_IDR = 5,
+        NAL_SEI = 6,
+        NAL_SPS = 7,
+        NAL_PPS = 8,
+        NAL_AUD = 9,
+        NAL_END_OF_SEQUENCE = 10,
+        NAL_END_OF_STREAM = 11,
+    };
+
+    void emitAccessUnit(const AccessUnitCallback& onAccessUnit);
+    void emitConfig(const AccessUnitCallback& onAccessUnit);
+    static void append(std::vector<uint8_t>* buffer, const Camera3NalSplitter::NalUnit& nal);
+
+    const size_t mMaxAccessUnitSize;
+
+    std::vector<uint8_t> mAccessUnit;
+    size_t mAccessUnitNalCount;
+    bool mHasSlice;
+    bool mKeyFrame;
+    bool mReference;
+    nsecs_t mAccessUnitReceiveTime;
+
+    std::vector<uint8_t> mConfig;
+    size_t mConfigNalCount;
+    nsecs_t mConfigReceiveTime;
+};
+
+} // namespace camera3
+} // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA_CAMERA3_ACCESS_UNIT_ASSEMBLER_H
+// 个人修改结束
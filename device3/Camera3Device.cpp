@@ -69,6 +69,9 @@
 #include "device3/Camera3InputStream.h"
 #include "device3/Camera3OutputStream.h"
 #include "device3/Camera3SharedOutputStream.h"
+// 个人修改开始
+#include "device3/Camera3StreamInjectionManager.h"
+// 个人修改结束
 #include "utils/CameraTraces.h"
 #include "utils/SchedulingPolicyUtils.h"
 #include "utils/SessionConfigurationUtils.h"
@@ -76,6 +79,7 @@
 #include "utils/Utils.h"
 
 #include <algorithm>
+#include <array>
 #include <optional>
 #include <tuple>
 
@@ -632,6 +636,12 @@ status_t Camera3Device::dump(int fd, [[maybe_unused]] const Vector<String16> &ar
         mRequestThread->dumpCaptureRequestLatency(fd,
                 "    ProcessCaptureRequest latency histogram:");
     }
+    // 个人修改开始
+    if (mRequestThread != NULL) {
+        mRequestThread->dumpRequestBatchSizes(fd);
+        mRequestThread->dumpInjectionOnlyState(fd);
+    }
+    // 个人修改结束
 
     {
         lines = "    Last request sent:\n";
@@ -1240,6 +1250,10 @@ status_t Camera3Device::createStream(const std::vector<SurfaceHolder>& consumers
 
     newStream->setImageDumpMask(mImageDumpMask);
 
+    // 个人修改开始
+    newStream->setInjectionCameraId(mId);
+    // 个人修改结束
+
     res = mOutputStreams.add(mNextStreamId, newStream);
     if (res < 0) {
         SET_ERR_L("Can't add new stream to set: %s (%d)", strerror(-res), res);
@@ -2003,6 +2017,12 @@ void Camera3Device::notifyStatus(bool idle) {
             // Populate stream statistics in case of Idle
             if (idle) {
                 streamIds.push_back(stream->getId());
+                // 个人修改开始
+                int64_t injected, repeated, placeholder;
+                stream->takeInjectionFrameCounts(&injected, &repeated, &placeholder);
+                mSessionStatsBuilder.incInjectionCounters(stream->getId(), injected, repeated,
+                        placeholder);
+                // 个人修改结束
                 Camera3Stream* camera3Stream = Camera3Stream::cast(stream->asHalStream());
                 int64_t usage = 0LL;
                 int64_t streamUseCase = ANDROID_SCALER_AVAILABLE_STREAM_USE_CASES_DEFAULT;
@@ -2050,6 +2070,17 @@ void Camera3Device::notifyStatus(bool idle) {
                     streamStats[i].mHistogramCounts.assign(
                            stats->second.mCaptureLatencyHistogram.begin(),
                            stats->second.mCaptureLatencyHistogram.end());
+                    // 个人修改开始
+                    // CameraStreamStats 没有注入相关的字段，只记录到日志
+                    if (stats->second.mInjectedFrameCount > 0 ||
+                            stats->second.mPlaceholderFrameCount > 0) {
+                        ALOGI("标记: Camera %s 流 %d 本次会话: 注入帧 %" PRId64 " (重复 %" PRId64
+                                ")，占位帧 %" PRId64, mId.c_str(), streamId,
+                                stats->second.mInjectedFrameCount,
+                                stats->second.mRepeatedInjectedFrameCount,
+                                stats->second.mPlaceholderFrameCount);
+                    }
+                    // 个人修改结束
                 }
             }
             listener->notifyIdle(requestCount, resultErrorCount, deviceError,
@@ -2936,6 +2967,9 @@ status_t Camera3Device::registerInFlight(uint32_t frameNumber,
 void Camera3Device::onInflightEntryRemovedLocked(nsecs_t duration) {
     // Indicate idle inFlightMap to the status tracker
     if (mInFlightMap.size() == 0) {
+        // 个人修改开始
+        mInFlightDrained.notify_all();
+        // 个人修改结束
         mRequestBufferSM.onInflightMapEmpty();
         // Hold a separate dedicated tracker lock to prevent race with disconnect and also
         // avoid a deadlock during reprocess requests.
@@ -2966,6 +3000,9 @@ void Camera3Device::checkInflightMapLengthLocked() {
 
 void Camera3Device::onInflightMapFlushedLocked() {
     mExpectedInflightDuration = 0;
+    // 个人修改开始
+    mInFlightDrained.notify_all();
+    // 个人修改结束
 }
 
 void Camera3Device::removeInFlightMapEntryLocked(int idx) {
@@ -3187,7 +3224,14 @@ Camera3Device::RequestThread::RequestThread(wp<Camera3Device> parent,
         mUseHalBufManager(useHalBufManager),
         mSupportCameraMute(supportCameraMute),
         mRotationOverride(rotationOverride),
-        mSupportSettingsOverride(supportSettingsOverride) {
+        mSupportSettingsOverride(supportSettingsOverride),
+        // 个人修改开始
+        mInjectionOnlyEnabled(
+                property_get_bool("persist.camera.injection.injection_only", false)),
+        mMaxRequestBatchSize(std::clamp<int32_t>(
+                property_get_int32("persist.camera.injection.request_batch_size", 1),
+                1, kMaxRequestBatchSize)) {
+        // 个人修改结束
     mStatusId = statusTracker->addComponent("RequestThread");
     mVndkVersion = getVNDKVersion();
 }
@@ -3533,6 +3577,187 @@ bool Camera3Device::RequestThread::sendRequestsBatch() {
     return true;
 }
 
+// 个人修改开始
+bool Camera3Device::RequestThread::canCompleteWithInjection() {
+    if (!mInjectionOnlyEnabled) {
+        return false;
+    }
+    // 与 Camera3OutputStream::compositeInjectedFrame 选择同一个注入源
+    sp<Camera3InjectionSource> source =
+            Camera3StreamInjectionManager::getInstance()->routeSource(mId, "");
+    if (!source->isInjectionActive()) {
+        return false;
+    }
+    sp<Camera3Device> parent = mParent.promote();
+    if (parent == nullptr) {
+        return false;
+    }
+    for (size_t i = 0; i < mNextRequests.size(); i++) {
+        const sp<CaptureRequest>& captureRequest = mNextRequests[i].captureRequest;
+        // 重处理的输入来自应用，仍由 HAL 处理
+        if (captureRequest->mInputStream != nullptr) {
+            return false;
+        }
+        for (size_t j = 0; j < captureRequest->mOutputStreams.size(); j++) {
+            const sp<camera3::Camera3OutputStreamInterface>& stream =
+                    captureRequest->mOutputStreams[j];
+            // HAL 管理的缓冲区由 HAL 申请；物理相机的流需要 HAL 给出物理相机的结果
+            if (parent->isHalBufferManagedStream(stream->getId()) ||
+                    !stream->getPhysicalCameraId().empty() ||
+                    mGroupIdPhysicalCameraMap.count(stream->getHalStreamGroupId()) != 0 ||
+                    !stream->isInjectionFillable()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void Camera3Device::RequestThread::waitForInjectedFrameTime() {
+    ATRACE_CALL();
+    // 设置可能正被锁定交给 updateNextRequest，复制一份再计算帧间隔
+    CameraMetadata settings(mNextRequests[0].captureRequest->mSettingsList.begin()->metadata);
+    const camera_metadata_t* raw = settings.getAndLock();
+    mInjectedFrameDuration = calculateExpectedDurationRange(raw).minDuration;
+    settings.unlock(raw);
+
+    // HFR 批次一次完成多帧，间隔按批次大小累计
+    nsecs_t batchDuration = mInjectedFrameDuration * mNextRequests.size();
+    nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+    if (mNextInjectedFrameTime > now) {
+        nsecs_t wait = mNextInjectedFrameTime - now;
+        usleep(ns2us(wait < kRequestSubmitTimeout ? wait : kRequestSubmitTimeout));
+        now = systemTime(SYSTEM_TIME_MONOTONIC);
+    }
+    // 落后超过一个批次时不追赶，从当前时间重新计时
+    mNextInjectedFrameTime = std::max(mNextInjectedFrameTime, now - batchDuration) +
+            batchDuration;
+}
+
+bool Camera3Device::RequestThread::sendInjectedRequestsBatch() {
+    ATRACE_CALL();
+    sp<Camera3Device> parent = mParent.promote();
+    if (parent == nullptr) {
+        CLOGE("RequestThread: Parent is gone");
+        cleanUpFailedRequests(/*sendRequestError*/ false);
+        return false;
+    }
+
+    // 时间戳与 HAL 的 sensor 时间戳使用同一时钟，批次内最后一帧为当前时间
+    nsecs_t now = systemTime(parent->mDeviceTimeBaseIsRealtime ?
+            SYSTEM_TIME_BOOTTIME : SYSTEM_TIME_MONOTONIC);
+    size_t batchSize = mNextRequests.size();
+    for (size_t i = 0; i < batchSize; i++) {
+        NextRequest& nextRequest = mNextRequests.editItemAt(i);
+        uint32_t frameNumber = nextRequest.halRequest.frame_number;
+        ATRACE_ASYNC_BEGIN("frame capture", frameNumber);
+
+        // 结果元数据取本帧生效的设置 (含本帧的 trigger)，必须在解锁和移除 trigger 之前复制
+        CameraMetadata result(nextRequest.captureRequest->mSettingsList.begin()->metadata);
+
+        nextRequest.submitted = true;
+        updateNextRequest(nextRequest);
+        status_t res = removeTriggers(mPrevRequest);
+        if (res != OK) {
+            SET_ERR("RequestThread: Unable to remove triggers "
+                    "(capture request %d: %s (%d)", frameNumber, strerror(-res), res);
+            cleanUpFailedRequests(/*sendRequestError*/ false);
+            return false;
+        }
+
+        nsecs_t timestamp = now - static_cast<nsecs_t>(batchSize - 1 - i) *
+                mInjectedFrameDuration;
+        parent->completeInjectedCapture(frameNumber, result,
+                nextRequest.halRequest.output_buffers, nextRequest.halRequest.num_output_buffers,
+                timestamp);
+    }
+    mInjectedRequestCount += batchSize;
+    return true;
+}
+
+void Camera3Device::RequestThread::dumpInjectionOnlyState(int fd) {
+    dprintf(fd, "    Injection-only mode: %s, bypassing HAL: %s, requests completed without "
+            "HAL: %" PRId64 ", mode switches: %" PRId64 ", switches deferred for HAL "
+            "captures: %" PRId64 "\n",
+            mInjectionOnlyEnabled ? "enabled" : "disabled",
+            mInjectionOnlyMode.isActive() ? "yes" : "no", mInjectedRequestCount.load(),
+            mInjectionOnlyMode.getSwitchCount(), mInjectionOnlyMode.getDeferredCount());
+}
+
+void Camera3Device::RequestThread::dumpRequestBatchSizes(int fd) {
+    dprintf(fd, "    Request batch sizes (accumulating up to %zu):", mMaxRequestBatchSize);
+    bool empty = true;
+    for (size_t i = 0; i < kRequestBatchSizeBins; i++) {
+        int64_t count = mRequestBatchSizeCounts[i].load();
+        if (count == 0) {
+            continue;
+        }
+        if (i + 1 < kRequestBatchSizeBins) {
+            dprintf(fd, "%s %zu: %" PRId64, empty ? "" : ",", i + 1, count);
+        } else {
+            dprintf(fd, "%s >%zu: %" PRId64, empty ? "" : ",", kMaxRequestBatchSize, count);
+        }
+        empty = false;
+    }
+    dprintf(fd, "%s\n", empty ? " None" : "");
+}
+
+void Camera3Device::RequestThread::accumulateRequestBatchLocked() {
+    // 高速录像的批次已经由 mBatchSize 决定；重处理请求需要先取输入缓冲区，单独提交
+    if (mMaxRequestBatchSize <= 1 || mNextRequests.size() != 1 ||
+            mNextRequests[0].captureRequest->mBatchSize > 1 ||
+            mNextRequests[0].captureRequest->mInputStream != nullptr) {
+        return;
+    }
+    // 只合并已经在排队的请求，不为凑满批次而等待；批次大小不超过 HAL 能同时持有的缓冲区数
+    while (mNextRequests.size() < mMaxRequestBatchSize) {
+        sp<CaptureRequest> candidate;
+        if (!mRequestQueue.empty()) {
+            candidate = *mRequestQueue.begin();
+        } else if (!mRepeatingRequests.empty()) {
+            candidate = *mRepeatingRequests.begin();
+        }
+        if (candidate == nullptr || !canJoinRequestBatchLocked(candidate)) {
+            break;
+        }
+
+        NextRequest additionalRequest;
+        additionalRequest.captureRequest = waitForNextRequestLocked();
+        if (additionalRequest.captureRequest == nullptr) {
+            break;
+        }
+        additionalRequest.halRequest = camera_capture_request_t();
+        additionalRequest.submitted = false;
+        mNextRequests.add(additionalRequest);
+    }
+}
+
+bool Camera3Device::RequestThread::canJoinRequestBatchLocked(
+        const sp<CaptureRequest>& request) const {
+    auto describe = [](const sp<CaptureRequest>& r) {
+        camera3::Camera3RequestBatch::Request batchRequest;
+        batchRequest.id = r.get();
+        batchRequest.hfrBatchSize = r->mBatchSize;
+        batchRequest.reprocess = r->mInputStream != nullptr;
+        batchRequest.settings = &r->mSettingsList.begin()->metadata;
+        for (const auto& stream : r->mOutputStreams) {
+            size_t maxHalBuffers = static_cast<size_t>(std::max(stream->getMaxHalBuffers(), 1));
+            if (batchRequest.halQueueLimit == 0 || maxHalBuffers < batchRequest.halQueueLimit) {
+                batchRequest.halQueueLimit = maxHalBuffers;
+            }
+        }
+        return batchRequest;
+    };
+    std::array<camera3::Camera3RequestBatch::Request, kMaxRequestBatchSize> batch;
+    size_t batchSize = std::min(mNextRequests.size(), batch.size());
+    for (size_t i = 0; i < batchSize; i++) {
+        batch[i] = describe(mNextRequests[i].captureRequest);
+    }
+    return camera3::Camera3RequestBatch::canJoin(describe(request), batch.data(), batchSize,
+            mSessionParamKeys.array(), mSessionParamKeys.size());
+}
+// 个人修改结束
+
 Camera3Device::RequestThread::ExpectedDurationInfo
         Camera3Device::RequestThread::calculateExpectedDurationRange(
                 const camera_metadata_t *request) {
@@ -3750,6 +3975,10 @@ bool Camera3Device::RequestThread::threadLoop() {
     //  or a single request from streaming or burst. In either case the first element
     //  should contain the latest camera settings that we need to check for any session
     //  parameter updates.
+    // 个人修改开始
+    // 合并的普通请求也只按第一个请求检查：accumulateRequestBatchLocked 只合并会话参数
+    // 与第一个请求相同的请求
+    // 个人修改结束
     if (updateSessionParameters(mNextRequests[0].captureRequest->mSettingsList.begin()->metadata)) {
         res = OK;
 
@@ -3784,6 +4013,29 @@ bool Camera3Device::RequestThread::threadLoop() {
         }
     }
 
+    // 个人修改开始
+    // 注入期间 HAL 采集的画面都会被覆盖，满足条件时由 RequestThread 自己完成请求
+    auto transition = mInjectionOnlyMode.update(canCompleteWithInjection(), [this]() {
+        // 合成的 shutter 必须排在 HAL 所有未完成的帧之后
+        sp<Camera3Device> parent = mParent.promote();
+        return parent != nullptr && parent->waitForHalCapturesDrained(
+                parent->getExpectedInFlightDuration() + kRequestSubmitTimeout);
+    });
+    if (transition == camera3::Camera3InjectionOnlyMode::Transition::DEFERRED) {
+        ALOGW("标记: Camera %s: HAL 仍有未完成的请求，暂不切换到仅注入模式", mId.c_str());
+    } else if (transition != camera3::Camera3InjectionOnlyMode::Transition::NONE) {
+        bool injectionOnly = transition == camera3::Camera3InjectionOnlyMode::Transition::ENTERED;
+        ALOGI("标记: Camera %s: 从帧 %" PRId64 " 起%s", mId.c_str(),
+                mNextRequests[0].captureRequest->mResultExtras.frameNumber,
+                injectionOnly ? "进入仅注入模式，请求不再提交给 HAL" : "恢复向 HAL 提交请求");
+        mNextInjectedFrameTime = 0;
+        if (!injectionOnly) {
+            // HAL 没有收到仅注入期间的设置，下一个请求必须携带完整设置
+            mPrevRequest.clear();
+        }
+    }
+    // 个人修改结束
+
     // Prepare a batch of HAL requests and output buffers.
     res = prepareHalRequests();
     if (res == TIMED_OUT) {
@@ -3811,7 +4063,15 @@ bool Camera3Device::RequestThread::threadLoop() {
     // process_capture_request() defeats the purpose of cancelling requests ASAP with flush().
     // For now, only synchronize for high speed recording and we should figure something out for
     // removing the synchronization.
-    bool useFlushLock = mNextRequests.size() > 1;
+    // 个人修改开始
+    // 合并的普通请求也有多个，但与合并前一样只在高速录像时同步
+    bool useFlushLock = mNextRequests[0].captureRequest->mBatchSize > 1;
+
+    // 仅注入模式按请求的帧间隔节流，等待时间不计入提交延迟
+    if (mInjectionOnlyMode.isActive()) {
+        waitForInjectedFrameTime();
+    }
+    // 个人修改结束
 
     if (useFlushLock) {
         mFlushLock.lock();
@@ -3827,10 +4087,16 @@ bool Camera3Device::RequestThread::threadLoop() {
 
     bool submitRequestSuccess = false;
     nsecs_t tRequestStart = systemTime(SYSTEM_TIME_MONOTONIC);
-    submitRequestSuccess = sendRequestsBatch();
+    // 个人修改开始
+    submitRequestSuccess = mInjectionOnlyMode.isActive() ? sendInjectedRequestsBatch() :
+            sendRequestsBatch();
+    // 个人修改结束
 
     nsecs_t tRequestEnd = systemTime(SYSTEM_TIME_MONOTONIC);
     mRequestLatency.add(tRequestStart, tRequestEnd);
+    // 个人修改开始
+    mRequestBatchSizeCounts[std::min(mNextRequests.size(), kRequestBatchSizeBins) - 1]++;
+    // 个人修改结束
 
     if (useFlushLock) {
         mFlushLock.unlock();
@@ -4498,6 +4764,73 @@ nsecs_t Camera3Device::getExpectedInFlightDuration() {
             mExpectedInflightDuration : kMinInflightDuration;
 }
 
+// 个人修改开始
+bool Camera3Device::waitForHalCapturesDrained(nsecs_t timeout) {
+    ATRACE_CALL();
+    // 仅注入的请求在提交时就已完成，这里只会等到 HAL 的请求
+    std::unique_lock<std::mutex> l(mInFlightLock);
+    return mInFlightDrained.wait_for(l, std::chrono::nanoseconds(timeout),
+            [this]() { return mInFlightMap.size() == 0; });
+}
+
+void Camera3Device::completeInjectedCapture(uint32_t frameNumber, CameraMetadata& settings,
+        const camera_stream_buffer_t* outputBuffers, size_t numBuffers, nsecs_t timestamp) {
+    ATRACE_CALL();
+    // 缓冲区没有经过 HAL，acquire fence 原样作为 release fence 交回，
+    // 输出流合成注入帧前会等待它
+    std::vector<camera_stream_buffer_t> buffers(outputBuffers, outputBuffers + numBuffers);
+    for (auto& buffer : buffers) {
+        buffer.status = CAMERA_BUFFER_STATUS_OK;
+        buffer.release_fence = buffer.acquire_fence;
+        buffer.acquire_fence = -1;
+    }
+
+    sp<NotificationListener> listener;
+    {
+        std::lock_guard<std::mutex> l(mOutputLock);
+        listener = mListener.promote();
+    }
+
+    Mutex::Autolock l(mProcessCaptureResultLock);
+    camera3::CaptureOutputStates states {
+        mId,
+        mInFlightLock, mLastCompletedRegularFrameNumber,
+        mLastCompletedReprocessFrameNumber, mLastCompletedZslFrameNumber,
+        mInFlightMap, mOutputLock, mResultQueue, mResultSignal,
+        mNextShutterFrameNumber,
+        mNextReprocessShutterFrameNumber, mNextZslStillShutterFrameNumber,
+        mNextResultFrameNumber,
+        mNextReprocessResultFrameNumber, mNextZslStillResultFrameNumber,
+        mUseHalBufManager, mHalBufManagedStreamIds, mUsePartialResult, mNeedFixupMonochromeTags,
+        mNumPartialResults, mVendorTagId, mDeviceInfo, mPhysicalDeviceInfoMap,
+        mDistortionMappers, mZoomRatioMappers, mRotateAndCropMappers,
+        mTagMonitor, mInputStream, mOutputStreams, mSessionStatsBuilder, listener, *this,
+        *this, *(mInterface), mLegacyClient, mMinExpectedDuration, mIsFixedFps,
+        mRotationOverride, mActivePhysicalId
+    };
+
+    camera_notify_msg_t msg = {};
+    msg.type = CAMERA_MSG_SHUTTER;
+    msg.message.shutter.frame_number = frameNumber;
+    msg.message.shutter.timestamp = timestamp;
+    msg.message.shutter.readout_timestamp_valid = false;
+    camera3::notify(states, &msg);
+
+    mInjectedResultBuilder.fill(&settings, timestamp);
+    const camera_metadata_t* metadata = settings.getAndLock();
+    camera_capture_result_t result = {};
+    result.frame_number = frameNumber;
+    result.result = metadata;
+    result.num_output_buffers = buffers.size();
+    result.output_buffers = buffers.data();
+    result.input_buffer = nullptr;
+    // 一次给出完整结果
+    result.partial_result = mNumPartialResults;
+    camera3::processCaptureResult(states, &result);
+    settings.unlock(metadata);
+}
+// 个人修改结束
+
 void Camera3Device::RequestThread::cleanupPhysicalSettings(sp<CaptureRequest> request,
         camera_capture_request_t *halRequest) {
     if ((request == nullptr) || (halRequest == nullptr)) {
@@ -4670,6 +5003,10 @@ void Camera3Device::RequestThread::waitForNextRequestBatch() {
         cleanUpFailedRequests(/*sendRequestError*/true);
     }
 
+    // 个人修改开始
+    accumulateRequestBatchLocked();
+    // 个人修改结束
+
     return;
 }
 
@@ -17,6 +17,7 @@
 #ifndef ANDROID_SERVERS_CAMERA3DEVICE_H
 #define ANDROID_SERVERS_CAMERA3DEVICE_H
 
+#include <atomic>
 #include <utility>
 #include <unordered_map>
 #include <set>
@@ -50,6 +51,10 @@
 #include "device3/Camera3OutputInterface.h"
 #include "device3/Camera3OfflineSession.h"
 #include "device3/Camera3StreamInterface.h"
+// 个人修改开始
+#include "device3/Camera3InjectionOnlyMode.h"
+#include "device3/Camera3RequestBatch.h"
+// 个人修改结束
 #include "utils/AttributionAndPermissionUtils.h"
 #include "utils/TagMonitor.h"
 #include "utils/IPCTransport.h"
@@ -783,6 +788,27 @@ class Camera3Device :
     // lock to ensure only one processCaptureResult is called at a time.
     Mutex mProcessCaptureResultLock;
 
+    // 个人修改开始
+    /**
+     * Injection-only capture: requests completed by the request thread without a HAL capture.
+     *
+     * completeInjectedCapture sends the shutter and a result built from the request settings
+     * for a frame registered in flight, and returns its output buffers, which the output
+     * streams overwrite with the injected frame. Serialized with HAL results by
+     * mProcessCaptureResultLock.
+     */
+    void completeInjectedCapture(uint32_t frameNumber, CameraMetadata& settings,
+            const camera_stream_buffer_t* outputBuffers, size_t numBuffers, nsecs_t timestamp);
+
+    // Wait until no request submitted to the HAL is in flight; false if timeout expires first.
+    // Woken by onInflightEntryRemovedLocked/onInflightMapFlushedLocked through mInFlightDrained.
+    bool waitForHalCapturesDrained(nsecs_t timeout);
+
+    // Builds the dynamic keys of synthesized results and keeps the AF lock state across
+    // frames; protected by mProcessCaptureResultLock
+    camera3::Camera3InjectedResultBuilder mInjectedResultBuilder;
+    // 个人修改结束
+
     /**
      * Common initialization code shared by both HAL paths
      *
@@ -1097,6 +1123,14 @@ class Camera3Device :
             mRequestLatency.dump(fd, name);
         }
 
+        // 个人修改开始
+        // dump injection-only mode state
+        void dumpInjectionOnlyState(int fd);
+
+        // dump the histogram of request batch sizes submitted to the HAL
+        void dumpRequestBatchSizes(int fd);
+        // 个人修改结束
+
         void signalPipelineDrain(const std::vector<int>& streamIds);
         void resetPipelineDrain();
 
@@ -1245,6 +1279,31 @@ class Camera3Device :
         // Update next request sent to HAL
         void updateNextRequest(NextRequest& nextRequest);
 
+        // 个人修改开始
+        // Whether the requests in mNextRequests can be completed from the injection source
+        // alone: injection-only mode is enabled, the camera's injection source is active and
+        // every output is a framework-owned buffer of a stream that injection overwrites.
+        bool canCompleteWithInjection();
+
+        // Sleep until the next injected frame is due, at the frame duration requested by
+        // mNextRequests.
+        void waitForInjectedFrameTime();
+
+        // Complete the requests in mNextRequests without submitting them to the HAL.
+        // Return true = success
+        bool sendInjectedRequestsBatch();
+
+        // Append requests that are already pending to a single regular request in
+        // mNextRequests, up to mMaxRequestBatchSize and the HAL's queue limit, so that
+        // they are submitted in one processCaptureRequest call. Must be called with
+        // mRequestLock held.
+        void accumulateRequestBatchLocked();
+
+        // Whether a pending request can be submitted in the same batch as mNextRequests.
+        // Must be called with mRequestLock held.
+        bool canJoinRequestBatchLocked(const sp<CaptureRequest>& request) const;
+        // 个人修改结束
+
         wp<Camera3Device>  mParent;
         wp<camera3::StatusTracker>  mStatusTracker;
         sp<HalInterface>   mInterface;
@@ -1331,6 +1390,26 @@ class Camera3Device :
         const bool         mRotationOverride;
         const bool         mSupportSettingsOverride;
         int32_t            mVndkVersion = -1;
+
+        // 个人修改开始
+        // persist.camera.injection.injection_only, read when the session is created
+        const bool         mInjectionOnlyEnabled;
+        // Whether the last batch bypassed the HAL, and the switches in and out of that mode
+        camera3::Camera3InjectionOnlyMode mInjectionOnlyMode;
+        // Frame duration of the last injected batch, and when the next batch is due
+        nsecs_t            mInjectedFrameDuration = 0;
+        nsecs_t            mNextInjectedFrameTime = 0;
+        std::atomic<int64_t> mInjectedRequestCount = 0;
+
+        static constexpr size_t kMaxRequestBatchSize = camera3::Camera3RequestBatch::kMaxSize;
+        // persist.camera.injection.request_batch_size, read when the session is created;
+        // 1 disables accumulating regular requests
+        const size_t       mMaxRequestBatchSize;
+        // Submitted batches per batch size 1..kMaxRequestBatchSize; the last bin counts
+        // larger (high speed) batches
+        static constexpr size_t kRequestBatchSizeBins = kMaxRequestBatchSize + 1;
+        std::atomic<int64_t> mRequestBatchSizeCounts[kRequestBatchSizeBins] = {};
+        // 个人修改结束
     };
 
     virtual sp<RequestThread> createNewRequestThread(wp<Camera3Device> /*parent*/,
@@ -1353,6 +1432,10 @@ class Camera3Device :
     int64_t                       mLastCompletedRegularFrameNumber = -1;
     int64_t                       mLastCompletedReprocessFrameNumber = -1;
     int64_t                       mLastCompletedZslFrameNumber = -1;
+    // 个人修改开始
+    // Signaled when mInFlightMap becomes empty
+    std::condition_variable       mInFlightDrained;
+    // 个人修改结束
     // End of mInFlightLock protection scope
 
     int mInFlightStatusId; // const after initialize
@@ -103,6 +103,17 @@ class Camera3FakeStream :
     virtual void onMinDurationChanged(nsecs_t /*duration*/, bool /*fixedFps*/) {}
 
     virtual void setStreamUseCase(int64_t /*streamUseCase*/) {}
+
+    // 个人修改开始
+    virtual void takeInjectionFrameCounts(int64_t* injected, int64_t* repeated,
+            int64_t* placeholder) {
+        *injected = 0;
+        *repeated = 0;
+        *placeholder = 0;
+    }
+
+    virtual bool isInjectionFillable() const { return false; }
+    // 个人修改结束
   protected:
 
     /**
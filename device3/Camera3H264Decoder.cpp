@@ -16,22 +16,97 @@
 
 // 个人修改开始
 #define LOG_TAG "AIDOCK_CAM_DECODER"
+#include <algorithm>
+#include <chrono>
+#include <inttypes.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <cutils/properties.h>
 #include <utils/Log.h>
+#include <utils/Timers.h>
 #include <media/NdkMediaCodec.h>
 #include <media/NdkMediaFormat.h>
 
 #include "Camera3H264Decoder.h"
 #include "Camera3StreamInjectionManager.h"
 #include <system/graphics.h>
+#include <libyuv.h>
 
 namespace android {
 namespace camera3 {
 
-Camera3H264Decoder::Camera3H264Decoder() :
+// 异步模式下等待空闲输入缓冲区的上限，超时则丢弃该访问单元
+static constexpr auto kAsyncInputTimeout = std::chrono::milliseconds(20);
+static constexpr int32_t kLatencyBinSizeMs = 5;
+// AImageReader 在注入源可能同时持有的帧之外还需要的缓冲区：
+// 解码器正在写入的一个，以及已入队、等待回调取出的一个
+static constexpr int32_t kExtraImages = 2;
+
+namespace {
+
+Camera3H264Decoder::OutputMode readOutputMode() {
+    char value[PROPERTY_VALUE_MAX];
+    property_get("persist.camera.injection.decoder_output", value, "graphic");
+    return Camera3H264Decoder::parseOutputMode(value, Camera3H264Decoder::OutputMode::GRAPHIC);
+}
+
+// 输出帧持有的 AImage；最后一个引用释放时把缓冲区还给 AImageReader
+struct ImageHolder {
+    std::shared_ptr<AImageReader> reader;
+    AImage* image = nullptr;
+    int fence = -1;
+
+    ~ImageHolder() {
+        if (fence >= 0) {
+            close(fence);
+        }
+        // 合成路径的 CPU 读取在解锁时已经完成，不需要 release fence
+        AImage_delete(image);
+    }
+};
+
+} // namespace
+
+Camera3H264Decoder::OutputMode Camera3H264Decoder::parseOutputMode(const char* name,
+        OutputMode fallback) {
+    if (name == nullptr) return fallback;
+    if (strcmp(name, "buffer") == 0) return OutputMode::BUFFER;
+    if (strcmp(name, "graphic") == 0) return OutputMode::GRAPHIC;
+    return fallback;
+}
+
+const char* Camera3H264Decoder::outputModeName(OutputMode mode) {
+    switch (mode) {
+        case OutputMode::BUFFER: return "buffer";
+        case OutputMode::GRAPHIC: return "graphic";
+    }
+    return "unknown";
+}
+
+Camera3H264Decoder::Camera3H264Decoder(const sp<Camera3InjectionSource>& source) :
+        mSource(source),
         mCodec(nullptr),
         mInitialized(false),
         mCurrentWidth(0),
-        mCurrentHeight(0) { // 个人修改
+        mCurrentHeight(0), // 个人修改
+        mLastPresentationTimeUs(0),
+        mAccessUnitsQueued(0),
+        mNalUnitsQueued(0),
+        mMaxNalsPerAccessUnit(0),
+        mConfigsQueued(0),
+        mConfigsSkipped(0),
+        mInputBufferTimeouts(0),
+        mFramesPublished(0),
+        mCodecErrors(0),
+        mEndToEndLatency(kLatencyBinSizeMs),
+        mDecodeLatency(kLatencyBinSizeMs),
+        mNextInFlightInput(0),
+        mAsync(false),
+        mOutputExit(false),
+        mOutputMode(OutputMode::BUFFER),
+        mImagesPublished(0),
+        mImagesCopied(0),
+        mImageAcquireFailures(0) {
 }
 
 Camera3H264Decoder::~Camera3H264Decoder() {
@@ -40,6 +115,8 @@ Camera3H264Decoder::~Camera3H264Decoder() {
 
 status_t Camera3H264Decoder::initialize(uint32_t width, uint32_t height) {
     if (mInitialized && mCurrentWidth == width && mCurrentHeight == height) return OK; // 个人修改
+    // 尺寸变化时先释放旧的解码器实例，避免泄漏
+    release();
 
     mCodec = AMediaCodec_createDecoderByType("video/avc");
     if (!mCodec) {
@@ -47,6 +124,36 @@ status_t Camera3H264Decoder::initialize(uint32_t width, uint32_t height) {
         return UNKNOWN_ERROR;
     }
 
+    {
+        // 在收到真正的输出格式之前，按配置尺寸假定紧凑排列
+        std::lock_guard<std::mutex> l(mAsyncLock);
+        mOutputFormat = OutputFormat();
+        mOutputFormat.width = width;
+        mOutputFormat.height = height;
+        mOutputFormat.stride = width;
+        mOutputFormat.sliceHeight = height;
+    }
+
+    mAsync = property_get_bool("persist.camera.injection.decoder_async", true);
+    if (mAsync) {
+        {
+            std::lock_guard<std::mutex> l(mAsyncLock);
+            mFreeInputs.clear();
+            mPendingOutputs.clear();
+            mOutputExit = false;
+        }
+        AMediaCodecOnAsyncNotifyCallback callback = {
+            onAsyncInputAvailable,
+            onAsyncOutputAvailable,
+            onAsyncFormatChanged,
+            onAsyncError,
+        };
+        if (AMediaCodec_setAsyncNotifyCallback(mCodec, callback, this) != AMEDIA_OK) {
+            ALOGW("标记: 无法启用解码器异步回调，回退到同步模式");
+            mAsync = false;
+        }
+    }
+
     AMediaFormat* format = AMediaFormat_new();
     AMediaFormat_setString(format, AMEDIAFORMAT_KEY_MIME, "video/avc");
     AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_WIDTH, width);
@@ -54,7 +161,22 @@ status_t Camera3H264Decoder::initialize(uint32_t width, uint32_t height) {
     // COLOR_FormatYUV420SemiPlanar = 21 (NV12/NV21 depending on platform)
     AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_COLOR_FORMAT, 21);
 
-    media_status_t status = AMediaCodec_configure(mCodec, format, nullptr, nullptr, 0);
+    // graphic 输出方式下解码器渲染到内部的 AImageReader，不可用时回退到 CPU 输出缓冲区
+    mOutputMode = readOutputMode();
+    ANativeWindow* window = nullptr;
+    if (mOutputMode == OutputMode::GRAPHIC) {
+        window = createImageReader(width, height);
+    }
+    media_status_t status = AMediaCodec_configure(mCodec, format, window, nullptr, 0);
+    if (status != AMEDIA_OK && window != nullptr) {
+        ALOGW("标记: 解码器无法输出到 gralloc 缓冲区 (%d)，回退到 CPU 输出缓冲区", status);
+        destroyImageReader();
+        window = nullptr;
+        status = AMediaCodec_configure(mCodec, format, nullptr, nullptr, 0);
+    }
+    if (window == nullptr) {
+        mOutputMode = OutputMode::BUFFER;
+    }
     AMediaFormat_delete(format);
 
     if (status != AMEDIA_OK) {
@@ -64,18 +186,39 @@ status_t Camera3H264Decoder::initialize(uint32_t width, uint32_t height) {
         return UNKNOWN_ERROR;
     }
 
+    if (mAsync) {
+        mOutputThread = new OutputThread(this);
+        status_t res = mOutputThread->run("InjectDecodeOut", PRIORITY_URGENT_DISPLAY);
+        if (res != OK) {
+            ALOGE("标记: 无法启动解码输出线程: %s (%d)", strerror(-res), res);
+            mOutputThread.clear();
+            AMediaCodec_delete(mCodec);
+            mCodec = nullptr;
+            destroyImageReader();
+            return res;
+        }
+    }
+
     status = AMediaCodec_start(mCodec);
     if (status != AMEDIA_OK) {
         ALOGE("标记: 解码器启动失败: %d", status);
+        if (mOutputThread != nullptr) {
+            mOutputThread->requestExit();
+            mOutputThread->join();
+            mOutputThread.clear();
+        }
         AMediaCodec_delete(mCodec);
         mCodec = nullptr;
+        destroyImageReader();
         return UNKNOWN_ERROR;
     }
 
     mInitialized = true;
     mCurrentWidth = width;  // 个人修改
     mCurrentHeight = height; // 个人修改
-    ALOGI("标记: H.264 硬件解码器已初始化并启动 (%ux%u)", width, height);
+    ALOGI("标记: H.264 硬件解码器已初始化并启动 (%ux%u, %s模式, 输出到%s)", width, height,
+            mAsync ? "异步" : "同步",
+            mOutputMode == OutputMode::GRAPHIC ? " gralloc 缓冲区" : " CPU 内存");
     return OK;
 }
 
@@ -88,50 +231,264 @@ status_t Camera3H264Decoder::reconfigure(uint32_t width, uint32_t height) {
 void Camera3H264Decoder::release() {
     if (!mInitialized) return;
 
+    // 先停止输出线程，确保不会在解码器停止后再访问输出缓冲区
+    if (mOutputThread != nullptr) {
+        mOutputThread->requestExit();
+        mOutputThread->join();
+        mOutputThread.clear();
+    }
     if (mCodec) {
         AMediaCodec_stop(mCodec);
         AMediaCodec_delete(mCodec);
         mCodec = nullptr;
     }
+    // 解码器不再渲染新的图像；已发布的帧各自持有 AImageReader，不受影响
+    destroyImageReader();
+    {
+        // 解码器停止后，回调送来的缓冲区索引全部失效
+        std::lock_guard<std::mutex> l(mAsyncLock);
+        mFreeInputs.clear();
+        mPendingOutputs.clear();
+    }
     mInitialized = false;
+    // 新的解码器实例需要重新收到 SPS/PPS
+    mLastConfig.clear();
     ALOGI("标记: H.264 硬件解码器已释放资源");
 }
 
-status_t Camera3H264Decoder::decode(uint8_t* data, size_t size) {
+status_t Camera3H264Decoder::decodeAccessUnit(const Camera3AccessUnitAssembler::AccessUnit& au) {
+    if (au.codecConfig) {
+        // 码流中每个 IDR 前通常都会重复 SPS/PPS，内容不变时无需再次配置解码器
+        if (mInitialized && au.size == mLastConfig.size() &&
+                memcmp(au.data, mLastConfig.data(), au.size) == 0) {
+            std::lock_guard<std::mutex> l(mStatsLock);
+            mConfigsSkipped++;
+            return OK;
+        }
+        status_t res = decode(au.data, au.size, AMEDIACODEC_BUFFER_FLAG_CODEC_CONFIG,
+                au.receiveTime);
+        if (res == OK) {
+            mLastConfig.assign(au.data, au.data + au.size);
+            std::lock_guard<std::mutex> l(mStatsLock);
+            mConfigsQueued++;
+        }
+        return res;
+    }
+
+    status_t res = decode(au.data, au.size, 0, au.receiveTime);
+    if (res == OK) {
+        std::lock_guard<std::mutex> l(mStatsLock);
+        mAccessUnitsQueued++;
+        mNalUnitsQueued += au.nalCount;
+        mMaxNalsPerAccessUnit = std::max(mMaxNalsPerAccessUnit, au.nalCount);
+    }
+    return res;
+}
+
+status_t Camera3H264Decoder::decode(const uint8_t* data, size_t size, uint32_t flags,
+        nsecs_t receiveTime) {
     if (!mInitialized) {
         ALOGE("标记: 解码器未初始化，拒绝解码请求");
         return INVALID_OPERATION;
     }
 
-    // 1. 先尝试清理输出队列，释放输入缓冲区空间
-    processOutput();
-
-    // 2. 增加 dequeueInputBuffer 的等待时间，并尝试获取输入缓冲区
-    ssize_t index = AMediaCodec_dequeueInputBuffer(mCodec, 5000); // 增加到 5ms
-    
-    // 如果队列依然满，再次尝试清理输出并重试一次
-    if (index == AMEDIACODEC_INFO_TRY_AGAIN_LATER) {
+    ssize_t index;
+    if (mAsync) {
+        // 异步模式：等待回调送来空闲的输入缓冲区，输出由输出线程处理
+        std::unique_lock<std::mutex> l(mAsyncLock);
+        if (mInputAvailable.wait_for(l, kAsyncInputTimeout,
+                [this]() { return !mFreeInputs.empty(); })) {
+            index = mFreeInputs.front();
+            mFreeInputs.pop_front();
+        } else {
+            index = AMEDIACODEC_INFO_TRY_AGAIN_LATER;
+        }
+    } else {
+        // 1. 先尝试清理输出队列，释放输入缓冲区空间
         processOutput();
-        index = AMediaCodec_dequeueInputBuffer(mCodec, 5000);
+
+        // 2. 增加 dequeueInputBuffer 的等待时间，并尝试获取输入缓冲区
+        index = AMediaCodec_dequeueInputBuffer(mCodec, 5000); // 增加到 5ms
+
+        // 如果队列依然满，再次尝试清理输出并重试一次
+        if (index == AMEDIACODEC_INFO_TRY_AGAIN_LATER) {
+            processOutput();
+            index = AMediaCodec_dequeueInputBuffer(mCodec, 5000);
+        }
+    }
+
+    // 以接收时间作为 presentation time，输出时据此计算端到端延迟
+    int64_t presentationTimeUs = (receiveTime > 0 ? receiveTime : systemTime()) / 1000;
+    if (presentationTimeUs <= mLastPresentationTimeUs) {
+        presentationTimeUs = mLastPresentationTimeUs + 1;
     }
 
+    status_t res = OK;
     if (index >= 0) {
         size_t bufSize;
         uint8_t* buf = AMediaCodec_getInputBuffer(mCodec, index, &bufSize);
         if (buf && bufSize >= size) {
             memcpy(buf, data, size);
-            AMediaCodec_queueInputBuffer(mCodec, index, 0, size, 0, 0);
+            AMediaCodec_queueInputBuffer(mCodec, index, 0, size, presentationTimeUs, flags);
+            mLastPresentationTimeUs = presentationTimeUs;
+            if (!(flags & AMEDIACODEC_BUFFER_FLAG_CODEC_CONFIG)) {
+                std::lock_guard<std::mutex> l(mStatsLock);
+                InFlightInput& input = mInFlightInputs[mNextInFlightInput];
+                input.presentationTimeUs = presentationTimeUs;
+                input.queueTime = systemTime();
+                mNextInFlightInput = (mNextInFlightInput + 1) % kMaxInFlightInputs;
+            }
         } else {
             ALOGE("标记: 输入缓冲区异常 (buf: %p, bufSize: %zu, dataSize: %zu)", buf, bufSize, size);
             AMediaCodec_queueInputBuffer(mCodec, index, 0, 0, 0, 0);
+            res = NO_MEMORY;
         }
     } else {
-        ALOGW("标记: 解码器输入队列已满，当前帧已丢弃 (Result: %zd)", index);
+        // 数据没有提交，由调用者决定重试还是丢弃
+        ALOGV("标记: 解码器暂时没有空闲的输入缓冲区 (Result: %zd)", index);
+        std::lock_guard<std::mutex> l(mStatsLock);
+        mInputBufferTimeouts++;
+        res = WOULD_BLOCK;
     }
 
-    // 3. 提交输入后再次尝试获取输出，提高实时性
-    processOutput();
-    return OK;
+    if (!mAsync) {
+        // 3. 提交输入后再次尝试获取输出，提高实时性
+        processOutput();
+    }
+    return res;
+}
+
+void Camera3H264Decoder::dump(int fd) {
+    OutputFormat outputFormat;
+    {
+        std::lock_guard<std::mutex> l(mAsyncLock);
+        outputFormat = mOutputFormat;
+    }
+    std::lock_guard<std::mutex> l(mStatsLock);
+    dprintf(fd, "  H.264 decoder: %s, %ux%u, %s mode, %s output\n",
+            mInitialized ? "running" : "stopped", mCurrentWidth, mCurrentHeight,
+            mAsync ? "async" : "sync", outputModeName(mOutputMode));
+    dprintf(fd, "    Output format: %dx%d, stride %d, slice height %d, crop offset (%d, %d)\n",
+            outputFormat.width, outputFormat.height, outputFormat.stride,
+            outputFormat.sliceHeight, outputFormat.cropLeft, outputFormat.cropTop);
+    dprintf(fd, "    Access units queued: %" PRIu64 ", NAL units per access unit: avg %.2f, "
+            "max %zu\n", mAccessUnitsQueued,
+            mAccessUnitsQueued > 0 ? (double)mNalUnitsQueued / mAccessUnitsQueued : 0.0,
+            mMaxNalsPerAccessUnit);
+    dprintf(fd, "    Codec configs queued: %" PRIu64 ", unchanged configs skipped: %" PRIu64
+            "\n", mConfigsQueued, mConfigsSkipped);
+    dprintf(fd, "    Input buffer wait timeouts: %" PRIu64 "\n", mInputBufferTimeouts);
+    dprintf(fd, "    Frames published: %" PRIu64 ", codec errors: %" PRIu64 "\n",
+            mFramesPublished, mCodecErrors);
+    if (mOutputMode == OutputMode::GRAPHIC) {
+        dprintf(fd, "    Graphic buffers published: %" PRIu64 ", copied to frame pool: %" PRIu64
+                ", acquire failures: %" PRIu64 "\n", mImagesPublished, mImagesCopied,
+                mImageAcquireFailures);
+    }
+    mEndToEndLatency.dump(fd, "Capture (or socket receive) to frame published latency");
+    mDecodeLatency.dump(fd, "Decoder input queued to output published latency");
+}
+
+void Camera3H264Decoder::onAsyncInputAvailable(AMediaCodec* /*codec*/, void* userdata,
+        int32_t index) {
+    Camera3H264Decoder* decoder = static_cast<Camera3H264Decoder*>(userdata);
+    {
+        std::lock_guard<std::mutex> l(decoder->mAsyncLock);
+        decoder->mFreeInputs.push_back(index);
+    }
+    decoder->mInputAvailable.notify_one();
+}
+
+void Camera3H264Decoder::onAsyncOutputAvailable(AMediaCodec* /*codec*/, void* userdata,
+        int32_t index, AMediaCodecBufferInfo* bufferInfo) {
+    Camera3H264Decoder* decoder = static_cast<Camera3H264Decoder*>(userdata);
+    {
+        std::lock_guard<std::mutex> l(decoder->mAsyncLock);
+        decoder->mPendingOutputs.push_back({index, *bufferInfo});
+    }
+    decoder->mOutputAvailable.notify_one();
+}
+
+void Camera3H264Decoder::onAsyncFormatChanged(AMediaCodec* /*codec*/, void* userdata,
+        AMediaFormat* format) {
+    Camera3H264Decoder* decoder = static_cast<Camera3H264Decoder*>(userdata);
+    ALOGI("标记: 解码格式已更改: %s", AMediaFormat_toString(format));
+    std::lock_guard<std::mutex> l(decoder->mAsyncLock);
+    decoder->mOutputFormat = parseOutputFormat(format, decoder->mOutputFormat);
+    // 回调传入的 format 由接收方负责释放
+    AMediaFormat_delete(format);
+}
+
+Camera3H264Decoder::OutputFormat Camera3H264Decoder::parseOutputFormat(AMediaFormat* format,
+        const OutputFormat& fallback) {
+    OutputFormat result = fallback;
+    int32_t width, height;
+    if (AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_WIDTH, &width) &&
+            AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_HEIGHT, &height)) {
+        result.width = width;
+        result.height = height;
+        result.stride = width;
+        result.sliceHeight = height;
+        result.cropLeft = 0;
+        result.cropTop = 0;
+    }
+    int32_t stride, sliceHeight;
+    if (AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_STRIDE, &stride) && stride > 0) {
+        result.stride = stride;
+    }
+    if (AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_SLICE_HEIGHT, &sliceHeight) &&
+            sliceHeight > 0) {
+        result.sliceHeight = sliceHeight;
+    }
+    // 宽高是按宏块对齐的编码尺寸 (例如 1088)，实际图像区域由 display-crop 给出
+    int32_t left, top, right, bottom;
+    if (AMediaFormat_getRect(format, AMEDIAFORMAT_KEY_DISPLAY_CROP, &left, &top, &right,
+            &bottom) && right >= left && bottom >= top) {
+        result.cropLeft = left & ~1;
+        result.cropTop = top & ~1;
+        result.width = right - left + 1;
+        result.height = bottom - top + 1;
+    }
+    return result;
+}
+
+void Camera3H264Decoder::onAsyncError(AMediaCodec* /*codec*/, void* userdata,
+        media_status_t error, int32_t actionCode, const char* detail) {
+    Camera3H264Decoder* decoder = static_cast<Camera3H264Decoder*>(userdata);
+    ALOGE("标记: 解码器异步错误: %d (action %d): %s", error, actionCode,
+            detail != nullptr ? detail : "");
+    std::lock_guard<std::mutex> l(decoder->mStatsLock);
+    decoder->mCodecErrors++;
+}
+
+void Camera3H264Decoder::OutputThread::requestExit() {
+    Thread::requestExit();
+    {
+        std::lock_guard<std::mutex> l(mDecoder->mAsyncLock);
+        mDecoder->mOutputExit = true;
+    }
+    mDecoder->mOutputAvailable.notify_all();
+}
+
+bool Camera3H264Decoder::OutputThread::threadLoop() {
+    return mDecoder->processAsyncOutput();
+}
+
+bool Camera3H264Decoder::processAsyncOutput() {
+    PendingOutput output;
+    OutputFormat outputFormat;
+    {
+        std::unique_lock<std::mutex> l(mAsyncLock);
+        mOutputAvailable.wait(l, [this]() { return mOutputExit || !mPendingOutputs.empty(); });
+        if (mOutputExit) {
+            return false;
+        }
+        output = mPendingOutputs.front();
+        mPendingOutputs.pop_front();
+        outputFormat = mOutputFormat;
+    }
+    publishOutputBuffer(output.index, output.info, outputFormat);
+    return true;
 }
 
 void Camera3H264Decoder::processOutput() {
@@ -145,8 +502,13 @@ void Camera3H264Decoder::processOutput() {
         if (index == AMEDIACODEC_INFO_TRY_AGAIN_LATER) {
             break;
         } else if (index == AMEDIACODEC_INFO_OUTPUT_FORMAT_CHANGED) {
+            // 只在格式变化时查询一次，逐帧路径使用缓存的布局
             AMediaFormat* format = AMediaCodec_getOutputFormat(mCodec);
             ALOGI("标记: 解码格式已更改: %s", AMediaFormat_toString(format));
+            {
+                std::lock_guard<std::mutex> l(mAsyncLock);
+                mOutputFormat = parseOutputFormat(format, mOutputFormat);
+            }
             AMediaFormat_delete(format);
             continue; // 继续 dequeue
         } else if (index < 0) {
@@ -154,50 +516,313 @@ void Camera3H264Decoder::processOutput() {
         }
 
         // 正常处理解码后的数据 (index >= 0)
-        if (info.size > 0) {
-            uint8_t* outBuf = AMediaCodec_getOutputBuffer(mCodec, index, nullptr);
-            if (outBuf) {
-                AMediaFormat* format = AMediaCodec_getOutputFormat(mCodec);
-                int32_t width, height, stride, sliceHeight;
-                AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_WIDTH, &width);
-                AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_HEIGHT, &height);
-                if (!AMediaFormat_getInt32(format, "stride", &stride)) stride = width;
-                if (!AMediaFormat_getInt32(format, "slice-height", &sliceHeight)) sliceHeight = height;
-
-                auto frame = std::make_shared<DecodedFrame>();
-                frame->width = width;
-                frame->height = height;
-                frame->timestamp = info.presentationTimeUs * 1000;
-                frame->format = HAL_PIXEL_FORMAT_YCrCb_420_SP; // NV21
-                frame->data.resize(width * height * 3 / 2);
-                
-                uint8_t* dstY = frame->data.data();
-                uint8_t* dstUV = dstY + width * height;
-                uint8_t* srcY = outBuf + info.offset;
-                uint8_t* srcUV = srcY + (stride * sliceHeight);
-            
-                // 1. 拷贝 Y 平面
-                for (int i = 0; i < height; ++i) {
-                    memcpy(dstY + i * width, srcY + i * stride, width);
-                }
-                // 2. 转换 NV12 (UV) 到 NV21 (VU)
-                for (int i = 0; i < height / 2; ++i) {
-                    uint8_t* sUV = srcUV + i * stride;
-                    uint8_t* dUV = dstUV + i * width;
-                    for (int j = 0; j < width; j += 2) {
-                        dUV[j] = sUV[j+1]; // V
-                        dUV[j+1] = sUV[j]; // U
-                    }
-                }
-                Camera3StreamInjectionManager::getInstance()->updateFrame(frame);
-                AMediaFormat_delete(format);
+        OutputFormat outputFormat;
+        {
+            std::lock_guard<std::mutex> l(mAsyncLock);
+            outputFormat = mOutputFormat;
+        }
+        publishOutputBuffer(index, info, outputFormat);
+    }
+}
+
+void Camera3H264Decoder::publishOutputBuffer(int32_t index, const AMediaCodecBufferInfo& info,
+        const OutputFormat& outputFormat) {
+    if (mOutputMode == OutputMode::GRAPHIC) {
+        // 渲染到 AImageReader，时间戳为 presentation time，由 onImageAvailable 发布
+        AMediaCodec_releaseOutputBuffer(mCodec, index, info.size > 0);
+        return;
+    }
+    const int32_t width = outputFormat.width;
+    const int32_t height = outputFormat.height;
+    const int32_t stride = outputFormat.stride;
+    uint8_t* outBuf = nullptr;
+    if (info.size > 0 && width > 0 && height > 0) {
+        outBuf = AMediaCodec_getOutputBuffer(mCodec, index, nullptr);
+    }
+    if (outBuf) {
+        // 直接写入帧池中的槽位，避免每帧分配
+        auto frame = mSource->acquireFrame(width, height);
+        frame->timestamp = info.presentationTimeUs * 1000;
+        frame->format = HAL_PIXEL_FORMAT_YCrCb_420_SP; // NV21
+
+        uint8_t* dstY = frame->data.data();
+        uint8_t* dstUV = dstY + width * height;
+        // 跳过 display-crop 之外的区域 (例如 1088 行编码高度中多出的 8 行)
+        uint8_t* planeY = outBuf + info.offset;
+        uint8_t* srcY = planeY + outputFormat.cropTop * stride + outputFormat.cropLeft;
+        uint8_t* srcUV = planeY + stride * outputFormat.sliceHeight +
+                (outputFormat.cropTop / 2) * stride + outputFormat.cropLeft;
+
+        // 一次遍历完成 Y 平面拷贝和 NV12 (UV) 到 NV21 (VU) 的交换
+        libyuv::NV21ToNV12(srcY, stride, srcUV, stride,
+                dstY, width, dstUV, width, width, height);
+        mSource->addBytesCopied(frame->data.size());
+        Camera3StreamInjectionManager::getInstance()->publishFrame(mSource, std::move(frame));
+        recordFramePublished(info.presentationTimeUs);
+    }
+    AMediaCodec_releaseOutputBuffer(mCodec, index, false);
+}
+
+void Camera3H264Decoder::recordFramePublished(int64_t presentationTimeUs) {
+    nsecs_t now = systemTime();
+    std::lock_guard<std::mutex> l(mStatsLock);
+    mFramesPublished++;
+    mEndToEndLatency.add(presentationTimeUs * 1000, now);
+    for (InFlightInput& input : mInFlightInputs) {
+        if (input.presentationTimeUs == presentationTimeUs) {
+            mDecodeLatency.add(input.queueTime, now);
+            input.presentationTimeUs = -1;
+            break;
+        }
+    }
+}
+
+ANativeWindow* Camera3H264Decoder::createImageReader(uint32_t width, uint32_t height) {
+    // 缓冲区数量覆盖注入源可能同时持有的所有帧，否则解码器会因为没有空闲缓冲区而停顿
+    int32_t maxImages = static_cast<int32_t>(mSource->getMaxFramesHeld()) + kExtraImages;
+    AImageReader* reader = nullptr;
+    media_status_t status = AImageReader_newWithUsage(width, height, AIMAGE_FORMAT_YUV_420_888,
+            AHARDWAREBUFFER_USAGE_CPU_READ_OFTEN, maxImages, &reader);
+    if (status != AMEDIA_OK) {
+        ALOGW("标记: 无法创建解码输出的 AImageReader (%d)，回退到 CPU 输出缓冲区", status);
+        return nullptr;
+    }
+    ANativeWindow* window = nullptr;
+    if (AImageReader_getWindow(reader, &window) != AMEDIA_OK) {
+        ALOGW("标记: 无法取得 AImageReader 的 surface，回退到 CPU 输出缓冲区");
+        AImageReader_delete(reader);
+        return nullptr;
+    }
+    // 回调上下文与 AImageReader 同生共死：已发布的帧可能让 AImageReader 比解码器活得更久，
+    // 回调只通过上下文访问解码器，解码器释放时在上下文的锁内断开
+    auto context = std::make_shared<ImageListenerContext>();
+    context->decoder = this;
+    {
+        std::lock_guard<std::mutex> l(mImageLock);
+        mImageReader = std::shared_ptr<AImageReader>(reader, [context](AImageReader* r) {
+            AImageReader_delete(r);
+        });
+        mImageListenerContext = context;
+        mImageLayout = ImageLayout();
+    }
+    AImageReader_ImageListener listener = {context.get(), onImageAvailable};
+    AImageReader_setImageListener(reader, &listener);
+    ALOGI("标记: 解码输出到 AImageReader (%ux%u, %d 个缓冲区)", width, height, maxImages);
+    return window;
+}
+
+void Camera3H264Decoder::destroyImageReader() {
+    std::shared_ptr<AImageReader> reader;
+    std::shared_ptr<ImageListenerContext> context;
+    {
+        std::lock_guard<std::mutex> l(mImageLock);
+        reader.swap(mImageReader);
+        context.swap(mImageListenerContext);
+    }
+    if (context != nullptr) {
+        // 等待正在执行的回调结束；此后迟到的回调看到空指针直接返回
+        std::lock_guard<std::mutex> l(context->lock);
+        context->decoder = nullptr;
+    }
+    if (reader != nullptr) {
+        AImageReader_ImageListener listener = {nullptr, nullptr};
+        AImageReader_setImageListener(reader.get(), &listener);
+    }
+}
+
+void Camera3H264Decoder::onImageAvailable(void* context, AImageReader* /*reader*/) {
+    ImageListenerContext* listenerContext = static_cast<ImageListenerContext*>(context);
+    std::lock_guard<std::mutex> contextLock(listenerContext->lock);
+    Camera3H264Decoder* decoder = listenerContext->decoder;
+    if (decoder == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> l(decoder->mImageLock);
+    if (decoder->mImageReader == nullptr) {
+        return;
+    }
+    // 回调可能合并，一次取完所有已入队的图像
+    while (decoder->publishImageLocked()) {
+    }
+}
+
+bool Camera3H264Decoder::publishImageLocked() {
+    // 按解码顺序逐个取出，由注入源的帧环按选帧策略决定保留哪些帧
+    AImage* image = nullptr;
+    int fenceFd = -1;
+    media_status_t status = AImageReader_acquireNextImageAsync(mImageReader.get(), &image,
+            &fenceFd);
+    if (status != AMEDIA_OK) {
+        if (status != AMEDIA_IMGREADER_NO_BUFFER_AVAILABLE) {
+            ALOGW("标记: 无法取得解码输出图像: %d", status);
+            std::lock_guard<std::mutex> l(mStatsLock);
+            mImageAcquireFailures++;
+        }
+        return false;
+    }
+    auto holder = std::make_shared<ImageHolder>();
+    holder->reader = mImageReader;
+    holder->image = image;
+    holder->fence = fenceFd;
+
+    AHardwareBuffer* buffer = nullptr;
+    int64_t timestamp = 0;
+    AImageCropRect crop = {};
+    int32_t width = 0;
+    int32_t height = 0;
+    if (AImage_getHardwareBuffer(image, &buffer) != AMEDIA_OK || buffer == nullptr ||
+            AImage_getTimestamp(image, &timestamp) != AMEDIA_OK ||
+            AImage_getWidth(image, &width) != AMEDIA_OK ||
+            AImage_getHeight(image, &height) != AMEDIA_OK) {
+        ALOGE("标记: 解码输出图像不完整，丢弃");
+        return true;
+    }
+    if (AImage_getCropRect(image, &crop) != AMEDIA_OK || crop.right <= crop.left ||
+            crop.bottom <= crop.top) {
+        crop = {0, 0, width, height};
+    }
+    // 与 CPU 输出路径一致，裁剪起点按色度对齐
+    crop.left &= ~1;
+    crop.top &= ~1;
+
+    const ImageLayout& layout = probeImageLayoutLocked(buffer, fenceFd);
+    if (!layout.probed) {
+        return true;
+    }
+    if (!layout.direct) {
+        // 持有者关闭原来的 fence，拷贝使用复制的 fence
+        if (copyImageToFrame(buffer, fenceFd >= 0 ? dup(fenceFd) : -1, crop, timestamp) == OK) {
+            {
+                std::lock_guard<std::mutex> l(mStatsLock);
+                mImagesCopied++;
             }
+            recordFramePublished(timestamp / 1000);
         }
-        AMediaCodec_releaseOutputBuffer(mCodec, index, false);
+        return true;
+    }
+
+    auto frame = std::make_shared<DecodedFrame>();
+    frame->width = crop.right - crop.left;
+    frame->height = crop.bottom - crop.top;
+    frame->timestamp = timestamp;
+    frame->format = HAL_PIXEL_FORMAT_YCBCR_420_888;
+    frame->stride = layout.rowStride;
+    frame->hardwareBuffer = buffer;
+    frame->acquireFence = fenceFd;
+    frame->cropLeft = crop.left;
+    frame->cropTop = crop.top;
+    frame->chromaUV = layout.chromaUV;
+    frame->holder = std::move(holder);
+    Camera3StreamInjectionManager::getInstance()->publishFrame(mSource, std::move(frame));
+    {
+        std::lock_guard<std::mutex> l(mStatsLock);
+        mImagesPublished++;
     }
+    recordFramePublished(timestamp / 1000);
+    return true;
+}
+
+const Camera3H264Decoder::ImageLayout& Camera3H264Decoder::probeImageLayoutLocked(
+        AHardwareBuffer* buffer, int fenceFd) {
+    AHardwareBuffer_Desc desc = {};
+    AHardwareBuffer_describe(buffer, &desc);
+    if (mImageLayout.probed && desc.width == mImageLayout.desc.width &&
+            desc.height == mImageLayout.desc.height &&
+            desc.format == mImageLayout.desc.format &&
+            desc.stride == mImageLayout.desc.stride) {
+        return mImageLayout;
+    }
+
+    // 只在缓冲区描述变化时等待一次解码完成
+    mImageLayout = ImageLayout();
+    AHardwareBuffer_Planes planes = {};
+    int res = AHardwareBuffer_lockPlanes(buffer, AHARDWAREBUFFER_USAGE_CPU_READ_OFTEN,
+            fenceFd >= 0 ? dup(fenceFd) : -1, nullptr, &planes);
+    if (res != 0) {
+        ALOGE("标记: 无法锁定解码输出缓冲区: %s (%d)", strerror(-res), res);
+        return mImageLayout;
+    }
+    mImageLayout.desc = desc;
+    mImageLayout.probed = true;
+    if (planes.planeCount == 3) {
+        const AHardwareBuffer_Plane& y = planes.planes[0];
+        const AHardwareBuffer_Plane& u = planes.planes[1];
+        const AHardwareBuffer_Plane& v = planes.planes[2];
+        const uint8_t* uData = static_cast<const uint8_t*>(u.data);
+        const uint8_t* vData = static_cast<const uint8_t*>(v.data);
+        mImageLayout.direct = u.pixelStride == 2 && v.pixelStride == 2 &&
+                u.rowStride == y.rowStride && v.rowStride == y.rowStride &&
+                (uData + 1 == vData || vData + 1 == uData);
+        mImageLayout.chromaUV = uData < vData;
+        mImageLayout.rowStride = y.rowStride;
+    }
+    AHardwareBuffer_unlock(buffer, nullptr);
+    ALOGI("标记: 解码输出缓冲区 %ux%u (stride %u, format 0x%x)：%s", desc.width, desc.height,
+            desc.stride, desc.format, mImageLayout.direct ?
+            (mImageLayout.chromaUV ? "NV12，直接发布" : "NV21，直接发布") :
+            "无法直接读取，逐帧拷贝到帧池");
+    return mImageLayout;
+}
+
+status_t Camera3H264Decoder::copyImageToFrame(AHardwareBuffer* buffer, int fenceFd,
+        const AImageCropRect& crop, nsecs_t timestamp) {
+    AHardwareBuffer_Planes planes = {};
+    int res = AHardwareBuffer_lockPlanes(buffer, AHARDWAREBUFFER_USAGE_CPU_READ_OFTEN, fenceFd,
+            nullptr, &planes);
+    if (res != 0) {
+        ALOGE("标记: 无法锁定解码输出缓冲区: %s (%d)", strerror(-res), res);
+        return res;
+    }
+    int32_t width = crop.right - crop.left;
+    int32_t height = crop.bottom - crop.top;
+    status_t status = OK;
+    if (planes.planeCount != 3) {
+        status = BAD_VALUE;
+    } else {
+        const AHardwareBuffer_Plane& y = planes.planes[0];
+        const AHardwareBuffer_Plane& u = planes.planes[1];
+        const AHardwareBuffer_Plane& v = planes.planes[2];
+        auto planeAt = [&crop](const AHardwareBuffer_Plane& plane, int32_t shift) {
+            return static_cast<const uint8_t*>(plane.data) +
+                    (crop.top >> shift) * plane.rowStride +
+                    (crop.left >> shift) * plane.pixelStride;
+        };
+        const uint8_t* srcY = planeAt(y, 0);
+        const uint8_t* srcU = planeAt(u, 1);
+        const uint8_t* srcV = planeAt(v, 1);
+
+        auto frame = mSource->acquireFrame(width, height);
+        frame->timestamp = timestamp;
+        frame->format = HAL_PIXEL_FORMAT_YCrCb_420_SP; // NV21
+        uint8_t* dstY = frame->data.data();
+        uint8_t* dstUV = dstY + width * height;
+        if (u.pixelStride == 2 && v.pixelStride == 2 && srcU < srcV) {
+            // NV12：交换为 NV21
+            libyuv::NV21ToNV12(srcY, y.rowStride, srcU, u.rowStride, dstY, width, dstUV, width,
+                    width, height);
+        } else if (u.pixelStride == 2 && v.pixelStride == 2) {
+            libyuv::CopyPlane(srcY, y.rowStride, dstY, width, width, height);
+            libyuv::CopyPlane(srcV, v.rowStride, dstUV, width, (width + 1) & ~1,
+                    (height + 1) / 2);
+        } else if (u.pixelStride == 1 && v.pixelStride == 1) {
+            libyuv::I420ToNV21(srcY, y.rowStride, srcU, u.rowStride, srcV, v.rowStride,
+                    dstY, width, dstUV, width, width, height);
+        } else {
+            status = BAD_VALUE;
+        }
+        if (status == OK) {
+            mSource->addBytesCopied(frame->data.size());
+            Camera3StreamInjectionManager::getInstance()->publishFrame(mSource,
+                    std::move(frame));
+        }
+    }
+    AHardwareBuffer_unlock(buffer, nullptr);
+    if (status != OK) {
+        ALOGE("标记: 不支持的解码输出平面布局 (%u 个平面)", planes.planeCount);
+    }
+    return status;
 }
 
 } // namespace camera3
 } // namespace android
 // 个人修改结束
-
@@ -18,33 +18,99 @@
 #ifndef ANDROID_SERVERS_CAMERA_CAMERA3_H264_DECODER_H
 #define ANDROID_SERVERS_CAMERA_CAMERA3_H264_DECODER_H
 
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include <utils/RefBase.h>
 #include <utils/Errors.h>
+#include <utils/Thread.h>
+#include <android/hardware_buffer.h>
+#include <media/NdkImageReader.h>
 #include <media/NdkMediaCodec.h>
 #include <media/NdkMediaFormat.h>
 
+#include "utils/LatencyHistogram.h"
+
+#include "Camera3AccessUnitAssembler.h"
+#include "Camera3InjectionDecoder.h"
+#include "Camera3InjectionSource.h"
+
 namespace android {
 namespace camera3 {
 
 /**
  * 硬件加速的 H.264 解码器，封装了 MediaCodec。
+ *
+ * 默认使用异步回调模式 (persist.camera.injection.decoder_async)：
+ * MediaCodec 回调把可用的输入缓冲区放入队列，由 socket 线程取用并提交；
+ * 输出缓冲区交给专门的输出线程，解码完成后立即发布到所属的 Camera3InjectionSource，
+ * 不再依赖 socket 线程的轮询节奏。同步模式保留为回退路径。
+ *
+ * 输出方式由 persist.camera.injection.decoder_output 选择：
+ * - graphic (默认)：解码器直接渲染到内部 AImageReader 的 gralloc 缓冲区，帧以缓冲区句柄
+ *   和 acquire fence 发布，输出流合成时直接从中读取，省去解码端整帧拷贝到 CPU 内存的一次读写。
+ *   平面布局无法直接读取 (三平面、Y/UV 行跨度不同) 时逐帧拷贝到帧池。
+ * - buffer：解码到 CPU 内存的输出缓冲区，逐帧拷贝到帧池。AImageReader 不可用时也回退到此方式。
+ *
+ * 这是 Camera3InjectionDecoder 的 MediaCodec 后端，没有可用的硬件解码器时
+ * 由 Camera3SoftwareH264Decoder 代替。
  */
-class Camera3H264Decoder : public virtual RefBase {
+class Camera3H264Decoder : public Camera3InjectionDecoder {
 public:
-    Camera3H264Decoder();
+    // 解码出的帧发布到 source
+    explicit Camera3H264Decoder(const sp<Camera3InjectionSource>& source);
     virtual ~Camera3H264Decoder();
 
+    enum class OutputMode {
+        BUFFER,
+        GRAPHIC,
+    };
+
+    // "buffer" / "graphic"，无法识别时返回 fallback
+    static OutputMode parseOutputMode(const char* name, OutputMode fallback);
+    static const char* outputModeName(OutputMode mode);
+
+    Backend getBackend() const override { return Backend::MEDIACODEC; }
+
     // 初始化解码器 (支持动态宽高)
-    status_t initialize(uint32_t width = 1080, uint32_t height = 720);
+    status_t initialize(uint32_t width, uint32_t height) override;
     // 重新配置解码器宽高
-    status_t reconfigure(uint32_t width, uint32_t height);
+    status_t reconfigure(uint32_t width, uint32_t height) override;
     // 释放解码器
-    void release();
+    void release() override;
+
+    // 提交一个完整的访问单元 (或 SPS/PPS codec-config) 进行解码
+    status_t decodeAccessUnit(const Camera3AccessUnitAssembler::AccessUnit& au) override;
+
+    // 提交一个输入缓冲区；flags 为 AMEDIACODEC_BUFFER_FLAG_*。
+    // receiveTime 作为 presentation time 传给解码器，用于统计端到端延迟。
+    // 等不到空闲输入缓冲区时不提交数据，返回 WOULD_BLOCK
+    status_t decode(const uint8_t* data, size_t size, uint32_t flags = 0,
+            nsecs_t receiveTime = 0);
 
-    // 提交 NAL 单元进行解码
-    status_t decode(uint8_t* data, size_t size);
+    bool isInitialized() const override { return mInitialized; }
+
+    void dump(int fd) override;
 
 private:
+    const sp<Camera3InjectionSource> mSource;
+
+    // 解码输出的布局；只在配置时和 INFO_OUTPUT_FORMAT_CHANGED 时更新，逐帧路径直接使用缓存值
+    struct OutputFormat {
+        int32_t width = 0;      // 裁剪后的显示尺寸
+        int32_t height = 0;
+        int32_t stride = 0;
+        int32_t sliceHeight = 0;
+        int32_t cropLeft = 0;
+        int32_t cropTop = 0;
+    };
+
+    // 从解码器输出格式中读取布局；缺失的字段沿用 fallback 的值
+    static OutputFormat parseOutputFormat(AMediaFormat* format, const OutputFormat& fallback);
+
     AMediaCodec* mCodec;
     bool mInitialized;
     
@@ -53,7 +119,123 @@ private:
     uint32_t mCurrentHeight;
     // 个人修改结束
 
+    // 上一次提交的 codec-config；内容相同的 SPS/PPS 不重复提交
+    std::vector<uint8_t> mLastConfig;
+
+    // 保证 presentation time 严格递增
+    int64_t mLastPresentationTimeUs;
+
+    std::mutex mStatsLock;
+    uint64_t mAccessUnitsQueued;
+    uint64_t mNalUnitsQueued;
+    size_t mMaxNalsPerAccessUnit;
+    uint64_t mConfigsQueued;
+    uint64_t mConfigsSkipped;
+    // 等不到空闲输入缓冲区而返回 WOULD_BLOCK 的次数
+    uint64_t mInputBufferTimeouts;
+    uint64_t mFramesPublished;
+    uint64_t mCodecErrors;
+    // 发送端采集 (原始模式下为 socket 接收) -> 帧发布到注入源
+    CameraLatencyHistogram mEndToEndLatency;
+    // 输入缓冲区提交 -> 对应的输出缓冲区可用，按 presentation time 匹配
+    CameraLatencyHistogram mDecodeLatency;
+    static constexpr size_t kMaxInFlightInputs = 16;
+    struct InFlightInput {
+        int64_t presentationTimeUs = -1;
+        nsecs_t queueTime = 0;
+    };
+    // 最近提交的输入，循环覆盖；解码器内部积压超过 kMaxInFlightInputs 帧时不再统计
+    InFlightInput mInFlightInputs[kMaxInFlightInputs];
+    size_t mNextInFlightInput;
+
+    // 异步模式
+    struct PendingOutput {
+        int32_t index;
+        AMediaCodecBufferInfo info;
+    };
+
+    class OutputThread : public Thread {
+      public:
+        explicit OutputThread(Camera3H264Decoder* decoder) :
+                Thread(/*canCallJava*/false), mDecoder(decoder) {}
+        void requestExit() override;
+      private:
+        bool threadLoop() override;
+        Camera3H264Decoder* mDecoder;
+    };
+
+    bool mAsync;
+    std::mutex mAsyncLock;
+    std::condition_variable mInputAvailable;
+    std::condition_variable mOutputAvailable;
+    std::deque<int32_t> mFreeInputs;
+    std::deque<PendingOutput> mPendingOutputs;
+    bool mOutputExit;
+    sp<OutputThread> mOutputThread;
+    // 最近一次的输出格式，由 mAsyncLock 保护
+    OutputFormat mOutputFormat;
+
+    static void onAsyncInputAvailable(AMediaCodec* codec, void* userdata, int32_t index);
+    static void onAsyncOutputAvailable(AMediaCodec* codec, void* userdata, int32_t index,
+            AMediaCodecBufferInfo* bufferInfo);
+    static void onAsyncFormatChanged(AMediaCodec* codec, void* userdata, AMediaFormat* format);
+    static void onAsyncError(AMediaCodec* codec, void* userdata, media_status_t error,
+            int32_t actionCode, const char* detail);
+
+    // 输出线程：取出一个待处理的输出缓冲区并发布；退出时返回 false
+    bool processAsyncOutput();
+
     void processOutput();
+    // 把解码输出拷贝到帧池并发布，然后归还输出缓冲区；
+    // graphic 方式下只把缓冲区渲染到 AImageReader，由 publishImage 发布
+    void publishOutputBuffer(int32_t index, const AMediaCodecBufferInfo& info,
+            const OutputFormat& outputFormat);
+    // 统计一帧的发布 (端到端延迟与解码延迟)
+    void recordFramePublished(int64_t presentationTimeUs);
+
+    // graphic 输出方式
+    OutputMode mOutputMode;
+    // 输出帧的 holder 各持有一份引用，已发布的帧在解码器释放后仍然有效
+    std::shared_ptr<AImageReader> mImageReader;
+    // AImageReader 回调的上下文，生命周期跟随 AImageReader 而不是解码器；
+    // decoder 在 destroyImageReader() 中于 lock 内清空，迟到的回调不会访问已销毁的解码器
+    struct ImageListenerContext {
+        std::mutex lock;
+        Camera3H264Decoder* decoder = nullptr;
+    };
+    std::shared_ptr<ImageListenerContext> mImageListenerContext;
+    // 保护 mImageReader、mImageListenerContext 与 mImageLayout；
+    // AImageReader 的回调线程与 release() 互斥
+    std::mutex mImageLock;
+
+    // 输出缓冲区的平面布局。同一 AImageReader 的缓冲区按相同参数分配，
+    // 因此只在缓冲区描述变化时锁定一次探测
+    struct ImageLayout {
+        AHardwareBuffer_Desc desc = {};
+        bool probed = false;
+        // 半平面且 Y/UV 行跨度相同，可以直接发布缓冲区
+        bool direct = false;
+        bool chromaUV = false;
+        uint32_t rowStride = 0;
+    };
+    ImageLayout mImageLayout;
+
+    // 创建 AImageReader，返回交给解码器的输出 surface；失败时返回 nullptr
+    ANativeWindow* createImageReader(uint32_t width, uint32_t height);
+    void destroyImageReader();
+
+    static void onImageAvailable(void* context, AImageReader* reader);
+    // 取出下一个输出图像并发布，没有可取的图像时返回 false；调用者持有 mImageLock
+    bool publishImageLocked();
+    // 按需探测 buffer 的平面布局，调用者持有 mImageLock
+    const ImageLayout& probeImageLayoutLocked(AHardwareBuffer* buffer, int fenceFd);
+    // 无法直接发布时把图像拷贝到帧池，消耗 fenceFd
+    status_t copyImageToFrame(AHardwareBuffer* buffer, int fenceFd,
+            const AImageCropRect& crop, nsecs_t timestamp);
+
+    uint64_t mImagesPublished;
+    uint64_t mImagesCopied;
+    uint64_t mImageAcquireFailures;
 };
 
 } // namespace camera3
@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#define LOG_TAG "AIDOCK_CAM_DECODER"
+#include <vector>
+
+#include <utils/Log.h>
+
+#include "Camera3H264SpsParser.h"
+#include "Camera3NalSplitter.h"
+
+namespace android {
+namespace camera3 {
+
+namespace {
+
+// RBSP 的 MSB 优先比特读取器；越界后所有读取返回 0 并置错误标志
+class BitReader {
+  public:
+    BitReader(const uint8_t* data, size_t size) : mData(data), mSize(size), mPos(0),
+            mOverrun(false) {}
+
+    uint32_t readBits(size_t count) {
+        uint32_t value = 0;
+        for (size_t i = 0; i < count; i++) {
+            value = (value << 1) | readBit();
+        }
+        return value;
+    }
+
+    uint32_t readBit() {
+        if (mPos >= mSize * 8) {
+            mOverrun = true;
+            return 0;
+        }
+        uint32_t bit = (mData[mPos / 8] >> (7 - (mPos % 8))) & 0x01;
+        mPos++;
+        return bit;
+    }
+
+    // ue(v)：指数哥伦布编码
+    uint32_t readUe() {
+        size_t leadingZeros = 0;
+        while (readBit() == 0) {
+            if (mOverrun || ++leadingZeros > 31) {
+                mOverrun = true;
+                return 0;
+            }
+        }
+        if (leadingZeros == 0) {
+            return 0;
+        }
+        return ((1u << leadingZeros) - 1) + readBits(leadingZeros);
+    }
+
+    // se(v)
+    int32_t readSe() {
+        uint32_t codeNum = readUe();
+        int32_t magnitude = static_cast<int32_t>((codeNum + 1) / 2);
+        return (codeNum & 0x01) ? magnitude : -magnitude;
+    }
+
+    bool overrun() const { return mOverrun; }
+
+  private:
+    const uint8_t* mData;
+    size_t mSize;
+    size_t mPos;
+    bool mOverrun;
+};
+
+void skipScalingList(BitReader* reader, size_t size) {
+    int32_t lastScale = 8;
+    int32_t nextScale = 8;
+    for (size_t i = 0; i < size; i++) {
+        if (nextScale != 0) {
+            int32_t deltaScale = reader->readSe();
+            nextScale = (lastScale + deltaScale + 256) % 256;
+        }
+        lastScale = (nextScale == 0) ? lastScale : nextScale;
+    }
+}
+
+bool isHighProfile(uint8_t profileIdc) {
+    switch (profileIdc) {
+        case 100: case 110: case 122: case 244: case 44:
+        case 83: case 86: case 118: case 128: case 138: case 139: case 134: case 135:
+            return true;
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+status_t Camera3H264SpsParser::parse(const uint8_t* payload, size_t size, SpsInfo* info) {
+    if (payload == nullptr || info == nullptr || size < 4 || (payload[0] & 0x1F) != 7) {
+        return BAD_VALUE;
+    }
+
+    std::vector<uint8_t> rbsp;
+    Camera3NalSplitter::extractRbsp(payload + 1, size - 1, &rbsp);
+    BitReader reader(rbsp.data(), rbsp.size());
+    SpsInfo sps;
+
+    sps.profileIdc = reader.readBits(8);
+    reader.readBits(8); // constraint_set0..5_flag + reserved_zero_2bits
+    sps.levelIdc = reader.readBits(8);
+    sps.spsId = reader.readUe();
+    if (sps.spsId > 31) {
+        return BAD_VALUE;
+    }
+
+    if (isHighProfile(sps.profileIdc)) {
+        sps.chromaFormatIdc = reader.readUe();
+        if (sps.chromaFormatIdc > 3) {
+            return BAD_VALUE;
+        }
+        if (sps.chromaFormatIdc == 3) {
+            reader.readBit(); // separate_colour_plane_flag
+        }
+        sps.bitDepthLuma = reader.readUe() + 8;
+        sps.bitDepthChroma = reader.readUe() + 8;
+        reader.readBit(); // qpprime_y_zero_transform_bypass_flag
+        if (reader.readBit()) { // seq_scaling_matrix_present_flag
+            size_t listCount = (sps.chromaFormatIdc != 3) ? 8 : 12;
+            for (size_t i = 0; i < listCount; i++) {
+                if (reader.readBit()) { // seq_scaling_list_present_flag[i]
+                    skipScalingList(&reader, i < 6 ? 16 : 64);
+                }
+            }
+        }
+    }
+
+    reader.readUe(); // log2_max_frame_num_minus4
+    uint32_t picOrderCntType = reader.readUe();
+    if (picOrderCntType == 0) {
+        reader.readUe(); // log2_max_pic_order_cnt_lsb_minus4
+    } else if (picOrderCntType == 1) {
+        reader.readBit(); // delta_pic_order_always_zero_flag
+        reader.readSe(); // offset_for_non_ref_pic
+        reader.readSe(); // offset_for_top_to_bottom_field
+        uint32_t cycle = reader.readUe();
+        if (cycle > 255) {
+            return BAD_VALUE;
+        }
+        for (uint32_t i = 0; i < cycle; i++) {
+            reader.readSe(); // offset_for_ref_frame[i]
+        }
+    } else if (picOrderCntType != 2) {
+        return BAD_VALUE;
+    }
+
+    reader.readUe(); // max_num_ref_frames
+    reader.readBit(); // gaps_in_frame_num_value_allowed_flag
+    uint32_t widthInMbs = reader.readUe() + 1;
+    uint32_t heightInMapUnits = reader.readUe() + 1;
+    sps.frameMbsOnly = reader.readBit();
+    if (!sps.frameMbsOnly) {
+        reader.readBit(); // mb_adaptive_frame_field_flag
+    }
+    reader.readBit(); // direct_8x8_inference_flag
+
+    if (widthInMbs > 1024 || heightInMapUnits > 1024) {
+        return BAD_VALUE;
+    }
+    sps.codedWidth = widthInMbs * 16;
+    sps.codedHeight = (sps.frameMbsOnly ? 1 : 2) * heightInMapUnits * 16;
+
+    if (reader.readBit()) { // frame_cropping_flag
+        // 7.4.2.1.1: CropUnitX/CropUnitY 取决于色度采样格式和场编码
+        uint32_t cropUnitX = 1;
+        uint32_t cropUnitY = sps.frameMbsOnly ? 1 : 2;
+        if (sps.chromaFormatIdc == 1) {
+            cropUnitX = 2;
+            cropUnitY *= 2;
+        } else if (sps.chromaFormatIdc == 2) {
+            cropUnitX = 2;
+        }
+        sps.cropLeft = reader.readUe() * cropUnitX;
+        sps.cropRight = reader.readUe() * cropUnitX;
+        sps.cropTop = reader.readUe() * cropUnitY;
+        sps.cropBottom = reader.readUe() * cropUnitY;
+    }
+    if (sps.cropLeft + sps.cropRight >= sps.codedWidth ||
+            sps.cropTop + sps.cropBottom >= sps.codedHeight) {
+        return BAD_VALUE;
+    }
+    sps.width = sps.codedWidth - sps.cropLeft - sps.cropRight;
+    sps.height = sps.codedHeight - sps.cropTop - sps.cropBottom;
+
+    if (reader.readBit()) { // vui_parameters_present_flag
+        if (reader.readBit()) { // aspect_ratio_info_present_flag
+            uint32_t aspectRatioIdc = reader.readBits(8);
+            if (aspectRatioIdc == 255) { // Extended_SAR
+                sps.sarWidth = reader.readBits(16);
+                sps.sarHeight = reader.readBits(16);
+            }
+        }
+        if (reader.readBit()) { // overscan_info_present_flag
+            reader.readBit(); // overscan_appropriate_flag
+        }
+        if (reader.readBit()) { // video_signal_type_present_flag
+            reader.readBits(3); // video_format
+            sps.videoFullRange = reader.readBit();
+            if (reader.readBit()) { // colour_description_present_flag
+                reader.readBits(24); // colour_primaries, transfer, matrix_coefficients
+            }
+        }
+        if (reader.readBit()) { // chroma_loc_info_present_flag
+            reader.readUe();
+            reader.readUe();
+        }
+        sps.timingInfoPresent = reader.readBit();
+        if (sps.timingInfoPresent) {
+            sps.numUnitsInTick = reader.readBits(32);
+            sps.timeScale = reader.readBits(32);
+            sps.fixedFrameRate = reader.readBit();
+        }
+        // 其余的 HRD / bitstream_restriction 参数不影响解码器配置
+    }
+
+    if (reader.overrun()) {
+        ALOGW("标记: SPS 数据不完整 (%zu 字节)", size);
+        return BAD_VALUE;
+    }
+    *info = sps;
+    return OK;
+}
+
+} // namespace camera3
+} // namespace android
+// 个人修改结束
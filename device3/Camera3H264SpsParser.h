@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#ifndef ANDROID_SERVERS_CAMERA_CAMERA3_H264_SPS_PARSER_H
+#define ANDROID_SERVERS_CAMERA_CAMERA3_H264_SPS_PARSER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <utils/Errors.h>
+
+namespace android {
+namespace camera3 {
+
+/**
+ * H.264 序列参数集 (SPS, 7.3.2.1.1) 解析器。
+ *
+ * 解析出编码尺寸、frame cropping 之后的显示尺寸、色度格式和 VUI 中的帧率信息，
+ * 用于在第一帧之前就按正确的尺寸配置解码器，并判断 SPS 是否真的改变了分辨率。
+ */
+class Camera3H264SpsParser {
+  public:
+    struct SpsInfo {
+        uint8_t profileIdc = 0;
+        uint8_t levelIdc = 0;
+        uint32_t spsId = 0;
+        uint32_t chromaFormatIdc = 1;
+        uint32_t bitDepthLuma = 8;
+        uint32_t bitDepthChroma = 8;
+        bool frameMbsOnly = true;
+
+        // 宏块对齐的编码尺寸
+        uint32_t codedWidth = 0;
+        uint32_t codedHeight = 0;
+        // 以像素为单位的裁剪量
+        uint32_t cropLeft = 0;
+        uint32_t cropRight = 0;
+        uint32_t cropTop = 0;
+        uint32_t cropBottom = 0;
+        // 裁剪后的显示尺寸
+        uint32_t width = 0;
+        uint32_t height = 0;
+
+        // VUI
+        bool videoFullRange = false;
+        uint32_t sarWidth = 0;
+        uint32_t sarHeight = 0;
+        bool timingInfoPresent = false;
+        uint32_t numUnitsInTick = 0;
+        uint32_t timeScale = 0;
+        bool fixedFrameRate = false;
+
+        // 由 VUI timing 推算的帧率；未知时为 0
+        double frameRate() const {
+            return (timingInfoPresent && numUnitsInTick > 0) ?
+                    static_cast<double>(timeScale) / (2.0 * numUnitsInTick) : 0.0;
+        }
+    };
+
+    // payload 为 SPS NAL 单元 (不含起始码，含 1 字节 NAL 头)，可以包含防竞争字节
+    static status_t parse(const uint8_t* payload, size_t size, SpsInfo* info);
+};
+
+} // namespace camera3
+} // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA_CAMERA3_H264_SPS_PARSER_H
+// 个人修改结束
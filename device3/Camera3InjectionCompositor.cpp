@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#define LOG_TAG "AIDOCK_CAM_INJECT"
+#define ATRACE_TAG ATRACE_TAG_CAMERA
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <utils/Log.h>
+#include <utils/Trace.h>
+
+#include "Camera3InjectionCompositor.h"
+
+namespace android {
+namespace camera3 {
+
+static constexpr nsecs_t kWorkerWaitDuration = 50000000LL; // 50ms
+
+Camera3InjectionCompositor::Camera3InjectionCompositor() :
+        mRejected(0) {
+    for (size_t i = 0; i < kWorkerCount; i++) {
+        sp<Worker> worker = new Worker(i);
+        status_t res = worker->run((std::string("InjectComposite-") + std::to_string(i)).c_str(),
+                PRIORITY_URGENT_DISPLAY);
+        if (res != OK) {
+            ALOGE("标记: 无法启动注入合成线程 %zu: %s (%d)", i, strerror(-res), res);
+            continue;
+        }
+        mWorkers.push_back(worker);
+    }
+}
+
+Camera3InjectionCompositor::~Camera3InjectionCompositor() {
+    for (auto& worker : mWorkers) {
+        worker->requestExit();
+    }
+    std::vector<Job> jobs;
+    for (auto& worker : mWorkers) {
+        worker->join();
+        worker->removePending(nullptr, &jobs);
+    }
+    // 工作线程退出时可能还有排队的任务
+    for (auto& job : jobs) {
+        cancelBuffer(job);
+    }
+}
+
+status_t Camera3InjectionCompositor::submit(Job&& job) {
+    if (mWorkers.empty()) {
+        return NO_INIT;
+    }
+    // 同一输出流固定使用同一个工作线程，保证流内顺序
+    size_t index = static_cast<size_t>(job.streamId < 0 ? 0 : job.streamId) % mWorkers.size();
+    status_t res = mWorkers[index]->enqueue(std::move(job));
+    if (res != OK) {
+        Mutex::Autolock l(mLock);
+        mRejected++;
+    }
+    return res;
+}
+
+std::vector<Camera3InjectionCompositor::Job> Camera3InjectionCompositor::removePending(
+        const Target* target) {
+    std::vector<Job> jobs;
+    for (auto& worker : mWorkers) {
+        worker->removePending(target, &jobs);
+    }
+    return jobs;
+}
+
+void Camera3InjectionCompositor::cancelBuffer(Job& job) {
+    if (job.consumer != nullptr && job.anwBuffer != nullptr) {
+        // cancelBuffer 接管 fence
+        status_t res = job.consumer->cancelBuffer(job.consumer.get(), job.anwBuffer.get(),
+                job.releaseFence);
+        if (res != OK) {
+            ALOGV("%s: Stream %d: Error cancelling buffer: %s (%d)", __FUNCTION__,
+                    job.streamId, strerror(-res), res);
+        }
+    } else if (job.releaseFence >= 0) {
+        close(job.releaseFence);
+    }
+    job.releaseFence = -1;
+}
+
+void Camera3InjectionCompositor::dump(int fd) {
+    {
+        Mutex::Autolock l(mLock);
+        dprintf(fd, "  Async compositor: %zu workers, %" PRIu64 " submissions composited inline"
+                " (worker queue full)\n", mWorkers.size(), mRejected);
+    }
+    for (auto& worker : mWorkers) {
+        worker->dump(fd);
+    }
+}
+
+Camera3InjectionCompositor::Worker::Worker(size_t index) :
+        Thread(/*canCallJava*/false),
+        mIndex(index),
+        mActiveTarget(nullptr),
+        mJobsCompleted(0),
+        mJobsRemoved(0),
+        mStreamsGone(0),
+        mMaxDepth(0) {
+}
+
+status_t Camera3InjectionCompositor::Worker::enqueue(Job&& job) {
+    Mutex::Autolock l(mLock);
+    // 不在结果回调线程上等待，队列满时由调用者同步合成
+    if (mJobs.size() >= kMaxQueuedJobs) {
+        ALOGV("%s: Worker %zu queue full (%zu)", __FUNCTION__, mIndex, mJobs.size());
+        return WOULD_BLOCK;
+    }
+    size_t& pending = mPendingPerTarget[job.target.unsafe_get()];
+    if (pending >= kMaxPendingPerStream) {
+        ALOGV("%s: Stream %d already has %zu buffers pending", __FUNCTION__, job.streamId,
+                pending);
+        return WOULD_BLOCK;
+    }
+    pending++;
+    mJobs.push_back(std::move(job));
+    mMaxDepth = std::max(mMaxDepth, mJobs.size());
+    mJobAvailable.signal();
+    return OK;
+}
+
+void Camera3InjectionCompositor::Worker::removePending(const Target* target,
+        std::vector<Job>* jobs) {
+    Mutex::Autolock l(mLock);
+    for (auto it = mJobs.begin(); it != mJobs.end();) {
+        if (target == nullptr || it->target.unsafe_get() == target) {
+            releasePendingLocked(it->target.unsafe_get());
+            jobs->push_back(std::move(*it));
+            it = mJobs.erase(it);
+            mJobsRemoved++;
+        } else {
+            ++it;
+        }
+    }
+    // 先取走排队的任务，工作线程就不会再开始 target 的任务；
+    // 正在合成的任务可能还会把缓冲区入队给消费者，等它完成
+    while (target != nullptr && mActiveTarget == target) {
+        mJobDone.wait(mLock);
+    }
+}
+
+void Camera3InjectionCompositor::Worker::releasePendingLocked(const Target* target) {
+    auto it = mPendingPerTarget.find(target);
+    if (it != mPendingPerTarget.end() && --it->second == 0) {
+        mPendingPerTarget.erase(it);
+    }
+}
+
+void Camera3InjectionCompositor::Worker::requestExit() {
+    Thread::requestExit();
+    Mutex::Autolock l(mLock);
+    mJobAvailable.signal();
+}
+
+bool Camera3InjectionCompositor::Worker::threadLoop() {
+    Job job;
+    {
+        Mutex::Autolock l(mLock);
+        while (mJobs.empty()) {
+            if (exitPending()) {
+                return false;
+            }
+            mJobAvailable.waitRelative(mLock, kWorkerWaitDuration);
+        }
+        job = std::move(mJobs.front());
+        mJobs.pop_front();
+        mActiveTarget = job.target.unsafe_get();
+    }
+
+    sp<Target> target = job.target.promote();
+    if (target == nullptr) {
+        // 输出流在断开时会取走排队的任务；这里是取出之后才销毁的流
+        ALOGV("%s: Stream %d was destroyed before compositing", __FUNCTION__, job.streamId);
+        cancelBuffer(job);
+    } else {
+        ATRACE_NAME("InjectionComposite");
+        target->compositeAndQueueInjectedBuffer(job);
+    }
+
+    Mutex::Autolock l(mLock);
+    if (target == nullptr) {
+        mStreamsGone++;
+    } else {
+        mJobsCompleted++;
+    }
+    releasePendingLocked(mActiveTarget);
+    mActiveTarget = nullptr;
+    mJobDone.broadcast();
+    return true;
+}
+
+void Camera3InjectionCompositor::Worker::dump(int fd) {
+    Mutex::Autolock l(mLock);
+    dprintf(fd, "    Worker %zu: %zu queued (max %zu), %" PRIu64 " completed, %" PRIu64
+            " cancelled on stream teardown, %" PRIu64 " cancelled for destroyed streams\n",
+            mIndex, mJobs.size(), mMaxDepth, mJobsCompleted, mJobsRemoved, mStreamsGone);
+}
+
+} // namespace camera3
+} // namespace android
+// 个人修改结束
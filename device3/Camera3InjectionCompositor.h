@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#ifndef ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_COMPOSITOR_H
+#define ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_COMPOSITOR_H
+
+#include <deque>
+#include <map>
+#include <vector>
+
+#include <system/window.h>
+#include <utils/Condition.h>
+#include <utils/Mutex.h>
+#include <utils/RefBase.h>
+#include <utils/Thread.h>
+#include <utils/Timers.h>
+
+namespace android {
+namespace camera3 {
+
+/**
+ * 注入帧的异步合成线程池。
+ *
+ * HAL 结果回调线程只把缓冲区交给线程池就返回；工作线程等待 HAL 的 release fence，
+ * 完成旋转/裁剪/缩放 (或占位填充) 后再由所属输出流把缓冲区入队给消费者。
+ * 同一个输出流的缓冲区总是分配给同一个工作线程，从而保持流内的帧顺序。
+ * 每个输出流最多有 kMaxPendingPerStream 个待处理 (排队或正在合成) 的缓冲区，
+ * 它们计入输出流的 cached buffer。超出上限或工作线程队列已满时提交立即失败，
+ * 调用者先用 removePending() 取回该流排队的任务并按顺序同步合成，再合成自己的缓冲区，
+ * 后来的缓冲区不会越过排队的缓冲区；回调线程最多等待该流正在合成的一个任务。
+ */
+class Camera3InjectionCompositor : public virtual RefBase {
+  public:
+    static constexpr size_t kWorkerCount = 2;
+    // 每个输出流最多同时交给合成线程的缓冲区数量
+    static constexpr size_t kMaxPendingPerStream = 2;
+    // 单个工作线程的队列上限 (所有共享该线程的输出流合计)
+    static constexpr size_t kMaxQueuedJobs = 16;
+
+    class Target;
+
+    struct Job {
+        wp<Target> target;
+        int streamId = -1;
+        // 目标已销毁时把缓冲区取消回这个消费者
+        sp<ANativeWindow> consumer;
+        sp<ANativeWindowBuffer> anwBuffer;
+        // HAL release fence，工作线程在写入前等待
+        int releaseFence = -1;
+        nsecs_t timestamp = 0;
+        nsecs_t readoutTimestamp = 0;
+        int32_t transform = 0;
+        std::vector<size_t> surfaceIds;
+        nsecs_t submitTime = 0;
+    };
+
+    // 合成任务的目标 (输出流)
+    class Target : public virtual RefBase {
+      public:
+        // 在工作线程上合成 job 并把缓冲区入队给消费者
+        virtual void compositeAndQueueInjectedBuffer(Job& job) = 0;
+
+      protected:
+        virtual ~Target() {}
+    };
+
+    Camera3InjectionCompositor();
+    virtual ~Camera3InjectionCompositor();
+
+    // 提交一个待合成的缓冲区；该流的待处理任务已达上限或工作线程队列已满时
+    // 立即返回 WOULD_BLOCK，此时 job 的所有权 (包括 fence) 仍归调用者
+    status_t submit(Job&& job);
+
+    // 按提交顺序取出 target 还在排队的任务，并等待它正在合成的任务完成；
+    // 缓冲区和 fence 的所有权交还调用者。返回后工作线程不会再访问 target 的缓冲区，
+    // 直到下一次 submit()。不能在工作线程上或持有 target 合成时需要的锁时调用。
+    // target 为 null 时只取出全部排队的任务，不等待
+    std::vector<Job> removePending(const Target* target);
+
+    // 把 job 的缓冲区连同 fence 取消回 job.consumer；没有消费者时只关闭 fence
+    static void cancelBuffer(Job& job);
+
+    void dump(int fd);
+
+  private:
+    class Worker : public Thread {
+      public:
+        explicit Worker(size_t index);
+
+        status_t enqueue(Job&& job);
+        void removePending(const Target* target, std::vector<Job>* jobs);
+        void requestExit() override;
+        void dump(int fd);
+
+      private:
+        bool threadLoop() override;
+        void releasePendingLocked(const Target* target);
+
+        size_t mIndex;
+        Mutex mLock;
+        Condition mJobAvailable;
+        // 正在合成的任务完成时通知
+        Condition mJobDone;
+        std::deque<Job> mJobs;
+        // 每个输出流排队和正在合成的任务数
+        std::map<const Target*, size_t> mPendingPerTarget;
+        // 正在合成的任务所属的输出流
+        const Target* mActiveTarget;
+        uint64_t mJobsCompleted;
+        uint64_t mJobsRemoved;
+        uint64_t mStreamsGone;
+        size_t mMaxDepth;
+    };
+
+    Mutex mLock;
+    std::vector<sp<Worker>> mWorkers;
+    uint64_t mRejected;
+};
+
+} // namespace camera3
+} // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_COMPOSITOR_H
+// 个人修改结束
@@ -0,0 +1,319 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#define LOG_TAG "AIDOCK_CAM_DECODER"
+#include <algorithm>
+
+#include <utils/Log.h>
+
+#include "Camera3InjectionDecodeQueue.h"
+
+namespace android {
+namespace camera3 {
+
+const char* Camera3InjectionDecodeQueue::dropReasonName(DropReason reason) {
+    switch (reason) {
+        case DropReason::NON_REFERENCE: return "non-reference";
+        case DropReason::SUPERSEDED: return "superseded by IDR";
+        case DropReason::OVERFLOW: return "overflow";
+        case DropReason::WAIT_FOR_KEY_FRAME: return "waiting for IDR";
+        case DropReason::STALE: return "stale";
+        case DropReason::DECODER_BUSY: return "decoder busy";
+        case DropReason::COUNT: break;
+    }
+    return "unknown";
+}
+
+Camera3AccessUnitAssembler::AccessUnit Camera3InjectionDecodeQueue::Entry::accessUnit() const {
+    Camera3AccessUnitAssembler::AccessUnit au;
+    au.data = data.data();
+    au.size = data.size();
+    au.codecConfig = codecConfig;
+    au.keyFrame = keyFrame;
+    au.reference = reference;
+    au.nalCount = nalCount;
+    au.receiveTime = receiveTime;
+    return au;
+}
+
+uint64_t Camera3InjectionDecodeQueue::Stats::totalDrops() const {
+    uint64_t total = 0;
+    for (uint64_t count : drops) {
+        total += count;
+    }
+    return total;
+}
+
+Camera3InjectionDecodeQueue::Camera3InjectionDecodeQueue(size_t capacity) :
+        mCapacity(std::clamp<size_t>(capacity, 1, kMaxCapacity)),
+        mDepth(0),
+        mMaxAge(0),
+        mFinished(false),
+        mWaitingForKeyFrame(false),
+        mLastKeyFrameRequest(0),
+        mMaxDepth(0),
+        mDepthSum(0),
+        mAccessUnitsPushed(0),
+        mAccessUnitsPopped(0),
+        mBytesCopied(0),
+        mDrops(),
+        mKeyFrameRequests(0) {
+}
+
+void Camera3InjectionDecodeQueue::setMaxAge(nsecs_t maxAge) {
+    std::lock_guard<std::mutex> l(mLock);
+    mMaxAge = maxAge;
+}
+
+bool Camera3InjectionDecodeQueue::isDroppable(const Entry& entry) {
+    return entry.type == Entry::Type::ACCESS_UNIT && !entry.codecConfig;
+}
+
+bool Camera3InjectionDecodeQueue::pushAccessUnit(
+        const Camera3AccessUnitAssembler::AccessUnit& au) {
+    std::lock_guard<std::mutex> l(mLock);
+    if (mFinished) {
+        return false;
+    }
+    if (!au.codecConfig) {
+        mAccessUnitsPushed++;
+        mDepthSum += mDepth;
+        if (au.keyFrame) {
+            mWaitingForKeyFrame = false;
+        } else if (mWaitingForKeyFrame) {
+            mDrops[static_cast<size_t>(DropReason::WAIT_FOR_KEY_FRAME)]++;
+            return false;
+        }
+
+        if (mDepth >= mCapacity) {
+            auto victim = mEntries.end();
+            if (au.keyFrame) {
+                // IDR 之后的帧不会参考更早的帧，排队的帧已经没有解码的必要
+                for (size_t i = 0; i < mEntries.size();) {
+                    if (isDroppable(*mEntries[i])) {
+                        dropLocked(mEntries.begin() + i, DropReason::SUPERSEDED);
+                    } else {
+                        i++;
+                    }
+                }
+            } else if (!au.reference) {
+                mDrops[static_cast<size_t>(DropReason::NON_REFERENCE)]++;
+                return false;
+            } else if ((victim = std::find_if(mEntries.begin(), mEntries.end(),
+                    [](const std::unique_ptr<Entry>& entry) {
+                        return isDroppable(*entry) && !entry->reference;
+                    })) != mEntries.end()) {
+                dropLocked(victim, DropReason::NON_REFERENCE);
+            } else {
+                // 排队的参考帧仍可正确解码；丢掉的是新帧，之后的帧都依赖它
+                mDrops[static_cast<size_t>(DropReason::OVERFLOW)]++;
+                startWaitingForKeyFrameLocked(/*dropQueued*/ false);
+                return false;
+            }
+        }
+    }
+
+    std::unique_ptr<Entry> entry = obtainLocked();
+    entry->type = Entry::Type::ACCESS_UNIT;
+    entry->data.assign(au.data, au.data + au.size);
+    entry->codecConfig = au.codecConfig;
+    entry->keyFrame = au.keyFrame;
+    entry->reference = au.reference;
+    entry->nalCount = au.nalCount;
+    entry->receiveTime = au.receiveTime;
+    mBytesCopied += au.size;
+    pushLocked(std::move(entry));
+    return true;
+}
+
+void Camera3InjectionDecodeQueue::pushConfigure(uint32_t width, uint32_t height) {
+    std::lock_guard<std::mutex> l(mLock);
+    if (mFinished) {
+        return;
+    }
+    std::unique_ptr<Entry> entry = obtainLocked();
+    entry->type = Entry::Type::CONFIGURE;
+    entry->data.clear();
+    entry->width = width;
+    entry->height = height;
+    pushLocked(std::move(entry));
+}
+
+void Camera3InjectionDecodeQueue::pushRelease() {
+    std::lock_guard<std::mutex> l(mLock);
+    if (mFinished) {
+        return;
+    }
+    std::unique_ptr<Entry> entry = obtainLocked();
+    entry->type = Entry::Type::RELEASE;
+    entry->data.clear();
+    pushLocked(std::move(entry));
+}
+
+void Camera3InjectionDecodeQueue::finish() {
+    {
+        std::lock_guard<std::mutex> l(mLock);
+        mFinished = true;
+    }
+    mAvailable.notify_all();
+}
+
+bool Camera3InjectionDecodeQueue::pop(std::unique_ptr<Entry>* entry) {
+    std::unique_lock<std::mutex> l(mLock);
+    while (true) {
+        mAvailable.wait(l, [this]() { return !mEntries.empty() || mFinished; });
+        if (mEntries.empty()) {
+            return false;
+        }
+        Entry& front = *mEntries.front();
+        if (isDroppable(front)) {
+            bool stale = mMaxAge > 0 && front.receiveTime > 0 &&
+                    systemTime() - front.receiveTime > mMaxAge;
+            if (stale && !front.keyFrame) {
+                bool reference = front.reference;
+                dropLocked(mEntries.begin(), DropReason::STALE);
+                if (reference) {
+                    startWaitingForKeyFrameLocked(/*dropQueued*/ true);
+                }
+                continue;
+            }
+        }
+        if (isDroppable(front)) {
+            mDepth--;
+            mAccessUnitsPopped++;
+        }
+        *entry = std::move(mEntries.front());
+        mEntries.pop_front();
+        return true;
+    }
+}
+
+void Camera3InjectionDecodeQueue::recycle(std::unique_ptr<Entry> entry) {
+    if (entry == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> l(mLock);
+    // 排队的条目加上解码线程手中的一个
+    if (mFreeEntries.size() < mCapacity + 1) {
+        mFreeEntries.push_back(std::move(entry));
+    }
+}
+
+void Camera3InjectionDecodeQueue::reportDecoderDrop(const Entry& entry) {
+    if (!isDroppable(entry)) {
+        return;
+    }
+    std::lock_guard<std::mutex> l(mLock);
+    mDrops[static_cast<size_t>(DropReason::DECODER_BUSY)]++;
+    // 解码器已经卡住了一段时间，排队的帧都已过时：不论丢的是否为参考帧，都从下一个 IDR 重新开始
+    startWaitingForKeyFrameLocked(/*dropQueued*/ true);
+}
+
+bool Camera3InjectionDecodeQueue::takeKeyFrameRequest(nsecs_t now) {
+    std::lock_guard<std::mutex> l(mLock);
+    if (!mWaitingForKeyFrame ||
+            (mLastKeyFrameRequest > 0 && now - mLastKeyFrameRequest < kKeyFrameRequestInterval)) {
+        return false;
+    }
+    mLastKeyFrameRequest = now;
+    mKeyFrameRequests++;
+    return true;
+}
+
+void Camera3InjectionDecodeQueue::reset() {
+    std::lock_guard<std::mutex> l(mLock);
+    while (!mEntries.empty()) {
+        if (mFreeEntries.size() < mCapacity + 1) {
+            mFreeEntries.push_back(std::move(mEntries.front()));
+        }
+        mEntries.pop_front();
+    }
+    mDepth = 0;
+    mFinished = false;
+    mWaitingForKeyFrame = false;
+    mLastKeyFrameRequest = 0;
+}
+
+Camera3InjectionDecodeQueue::Stats Camera3InjectionDecodeQueue::getStats() const {
+    std::lock_guard<std::mutex> l(mLock);
+    Stats stats;
+    stats.capacity = mCapacity;
+    stats.depth = mDepth;
+    stats.maxDepth = mMaxDepth;
+    stats.depthSum = mDepthSum;
+    stats.accessUnitsPushed = mAccessUnitsPushed;
+    stats.accessUnitsPopped = mAccessUnitsPopped;
+    std::copy(std::begin(mDrops), std::end(mDrops), std::begin(stats.drops));
+    stats.keyFrameRequests = mKeyFrameRequests;
+    stats.bytesCopied = mBytesCopied;
+    stats.waitingForKeyFrame = mWaitingForKeyFrame;
+    return stats;
+}
+
+std::unique_ptr<Camera3InjectionDecodeQueue::Entry> Camera3InjectionDecodeQueue::obtainLocked() {
+    if (mFreeEntries.empty()) {
+        return std::make_unique<Entry>();
+    }
+    std::unique_ptr<Entry> entry = std::move(mFreeEntries.back());
+    mFreeEntries.pop_back();
+    return entry;
+}
+
+void Camera3InjectionDecodeQueue::pushLocked(std::unique_ptr<Entry> entry) {
+    if (isDroppable(*entry)) {
+        mDepth++;
+        mMaxDepth = std::max(mMaxDepth, mDepth);
+    }
+    mEntries.push_back(std::move(entry));
+    mAvailable.notify_one();
+}
+
+void Camera3InjectionDecodeQueue::dropLocked(std::deque<std::unique_ptr<Entry>>::iterator it,
+        DropReason reason) {
+    mDrops[static_cast<size_t>(reason)]++;
+    mDepth--;
+    if (mFreeEntries.size() < mCapacity + 1) {
+        mFreeEntries.push_back(std::move(*it));
+    }
+    mEntries.erase(it);
+}
+
+void Camera3InjectionDecodeQueue::startWaitingForKeyFrameLocked(bool dropQueued) {
+    if (!mWaitingForKeyFrame) {
+        ALOGW("标记: 丢弃帧后无法继续解码，等待下一个 IDR");
+    }
+    mWaitingForKeyFrame = true;
+    if (!dropQueued) {
+        return;
+    }
+    // 排在丢弃点之后的非 IDR 帧同样无法解码；排队中的 IDR 结束等待
+    for (size_t i = 0; i < mEntries.size();) {
+        const Entry& entry = *mEntries[i];
+        if (!isDroppable(entry)) {
+            i++;
+        } else if (entry.keyFrame) {
+            mWaitingForKeyFrame = false;
+            break;
+        } else {
+            dropLocked(mEntries.begin() + i, DropReason::WAIT_FOR_KEY_FRAME);
+        }
+    }
+}
+
+} // namespace camera3
+} // namespace android
+// 个人修改结束
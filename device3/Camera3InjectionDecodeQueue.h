@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#ifndef ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_DECODE_QUEUE_H
+#define ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_DECODE_QUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <utils/Timers.h>
+
+#include "Camera3AccessUnitAssembler.h"
+
+namespace android {
+namespace camera3 {
+
+/**
+ * socket 线程 (生产者) 与解码线程 (消费者) 之间的有界访问单元队列。
+ *
+ * socket 线程按数据到达的速度入队，不再被解码器的输入缓冲区卡住；解码跟不上时
+ * 按参考关系决定丢弃哪些帧，而不是让解码器随机丢掉拿不到输入缓冲区的帧
+ * (丢掉参考帧会花屏到下一个 IDR)：
+ *
+ * 1. 队列满时先丢非参考帧 (nal_ref_idc 为 0)：新来的非参考帧直接丢弃，
+ *    新来的参考帧挤掉队列中最旧的非参考帧。
+ * 2. 新来的 IDR 帧挤掉队列中所有排队的帧 (IDR 之后的帧不再参考它们)。
+ * 3. 队列中全是参考帧时丢弃新来的帧，之后直到下一个 IDR 的帧都无法解码，
+ *    一律丢弃，并请求发送端尽快发送 IDR (见 takeKeyFrameRequest())。
+ *
+ * 出队时超过 maxAge (相对采集时间) 的帧同样丢弃：非参考帧单独丢弃，
+ * 参考帧丢弃后同样等待下一个 IDR。IDR 帧不会因过期而丢弃。
+ *
+ * codec-config (SPS/PPS) 与控制项 (重新配置、释放解码器) 不计入容量，也从不丢弃，
+ * 与访问单元按入队顺序交给解码线程。
+ *
+ * 入队时拷贝访问单元的数据 (接收缓冲区在回调返回后即被复用)，拷贝的字节数计入
+ * Stats::bytesCopied；出队的条目用完后交还 recycle()，稳态下不再分配内存。
+ */
+class Camera3InjectionDecodeQueue {
+  public:
+    static constexpr size_t kDefaultCapacity = 8;
+    static constexpr size_t kMaxCapacity = 64;
+    // 等待 IDR 期间重复请求的间隔 (请求可能丢失，或发送端暂时无法响应)
+    static constexpr nsecs_t kKeyFrameRequestInterval = ms2ns(500);
+
+    enum class DropReason {
+        // 队列满时丢弃的非参考帧
+        NON_REFERENCE,
+        // 被新来的 IDR 挤掉的排队帧
+        SUPERSEDED,
+        // 队列中全是参考帧时丢弃的新帧
+        OVERFLOW,
+        // 丢弃参考帧之后、下一个 IDR 之前的帧
+        WAIT_FOR_KEY_FRAME,
+        // 出队时已经过期
+        STALE,
+        // 解码器一直拿不到输入缓冲区
+        DECODER_BUSY,
+        COUNT,
+    };
+    static constexpr size_t kDropReasonCount = static_cast<size_t>(DropReason::COUNT);
+    static const char* dropReasonName(DropReason reason);
+
+    struct Entry {
+        enum class Type {
+            ACCESS_UNIT,
+            // 按 width x height 初始化或重新配置解码器
+            CONFIGURE,
+            RELEASE,
+        };
+        Type type = Type::ACCESS_UNIT;
+        std::vector<uint8_t> data;
+        bool codecConfig = false;
+        bool keyFrame = false;
+        bool reference = false;
+        size_t nalCount = 0;
+        nsecs_t receiveTime = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+
+        // 指向 data 的访问单元，在条目交还之前有效
+        Camera3AccessUnitAssembler::AccessUnit accessUnit() const;
+    };
+
+    struct Stats {
+        size_t capacity = 0;
+        size_t depth = 0;
+        size_t maxDepth = 0;
+        // 每次入队时的排队深度之和，除以 accessUnitsPushed 得到平均深度
+        uint64_t depthSum = 0;
+        uint64_t accessUnitsPushed = 0;
+        uint64_t accessUnitsPopped = 0;
+        uint64_t drops[kDropReasonCount] = {};
+        uint64_t keyFrameRequests = 0;
+        // 入队时拷贝的访问单元字节数 (含 codec-config)
+        uint64_t bytesCopied = 0;
+        bool waitingForKeyFrame = false;
+
+        uint64_t totalDrops() const;
+    };
+
+    explicit Camera3InjectionDecodeQueue(size_t capacity = kDefaultCapacity);
+
+    // 出队时的过期时长，0 表示不丢弃过期帧
+    void setMaxAge(nsecs_t maxAge);
+
+    // 生产者。访问单元被丢弃 (或队列已 finish()) 时返回 false，否则数据已拷入队列
+    bool pushAccessUnit(const Camera3AccessUnitAssembler::AccessUnit& au);
+    void pushConfigure(uint32_t width, uint32_t height);
+    void pushRelease();
+    // 不再入队；消费者取完剩余条目后 pop() 返回 false
+    void finish();
+
+    // 消费者：阻塞到有可用条目；finish() 之后队列取空时返回 false
+    bool pop(std::unique_ptr<Entry>* entry);
+    void recycle(std::unique_ptr<Entry> entry);
+    // 解码器在期限内没能接收出队的访问单元：丢弃排队的帧并等待 (请求) 下一个 IDR
+    void reportDecoderDrop(const Entry& entry);
+
+    // 正在等待 IDR，且距上次请求已超过 kKeyFrameRequestInterval 时返回 true 并计数，
+    // 由 socket 线程向发送端发出请求
+    bool takeKeyFrameRequest(nsecs_t now);
+
+    // 清空队列并回到初始状态 (新的连接)；统计保留
+    void reset();
+
+    Stats getStats() const;
+
+  private:
+    std::unique_ptr<Entry> obtainLocked();
+    void pushLocked(std::unique_ptr<Entry> entry);
+    void dropLocked(std::deque<std::unique_ptr<Entry>>::iterator it, DropReason reason);
+    // dropQueued 为 true 时丢弃点之前的帧已经出队，排队的帧都在它之后
+    void startWaitingForKeyFrameLocked(bool dropQueued);
+    static bool isDroppable(const Entry& entry);
+
+    const size_t mCapacity;
+
+    mutable std::mutex mLock;
+    std::condition_variable mAvailable;
+    std::deque<std::unique_ptr<Entry>> mEntries;
+    std::vector<std::unique_ptr<Entry>> mFreeEntries;
+    // 排队的访问单元数 (不含 codec-config 和控制项)
+    size_t mDepth;
+    nsecs_t mMaxAge;
+    bool mFinished;
+    bool mWaitingForKeyFrame;
+    nsecs_t mLastKeyFrameRequest;
+
+    size_t mMaxDepth;
+    uint64_t mDepthSum;
+    uint64_t mAccessUnitsPushed;
+    uint64_t mAccessUnitsPopped;
+    uint64_t mBytesCopied;
+    uint64_t mDrops[kDropReasonCount];
+    uint64_t mKeyFrameRequests;
+};
+
+} // namespace camera3
+} // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_DECODE_QUEUE_H
+// 个人修改结束
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#define LOG_TAG "AIDOCK_CAM_DECODER"
+#include <string.h>
+
+#include <cutils/properties.h>
+#include <utils/Log.h>
+
+#include "Camera3H264Decoder.h"
+#include "Camera3InjectionDecoder.h"
+#include "Camera3SoftwareH264Decoder.h"
+
+namespace android {
+namespace camera3 {
+
+Camera3InjectionDecoder::Mode Camera3InjectionDecoder::parseMode(const char* name,
+        Mode fallback) {
+    if (name == nullptr) return fallback;
+    if (strcmp(name, "auto") == 0) return Mode::AUTO;
+    if (strcmp(name, "mediacodec") == 0) return Mode::MEDIACODEC;
+    if (strcmp(name, "software") == 0) return Mode::SOFTWARE;
+    return fallback;
+}
+
+const char* Camera3InjectionDecoder::modeName(Mode mode) {
+    switch (mode) {
+        case Mode::AUTO: return "auto";
+        case Mode::MEDIACODEC: return "mediacodec";
+        case Mode::SOFTWARE: return "software";
+    }
+    return "unknown";
+}
+
+const char* Camera3InjectionDecoder::backendName(Backend backend) {
+    switch (backend) {
+        case Backend::MEDIACODEC: return "MediaCodec";
+        case Backend::SOFTWARE: return "software (libavc)";
+    }
+    return "unknown";
+}
+
+Camera3InjectionDecoder::Mode Camera3InjectionDecoder::getConfiguredMode() {
+    char value[PROPERTY_VALUE_MAX];
+    property_get("persist.camera.injection.decoder", value, "auto");
+    return parseMode(value, Mode::AUTO);
+}
+
+sp<Camera3InjectionDecoder> Camera3InjectionDecoder::create(Backend backend,
+        const sp<Camera3InjectionSource>& source) {
+    switch (backend) {
+        case Backend::MEDIACODEC:
+            return new Camera3H264Decoder(source);
+        case Backend::SOFTWARE:
+            return new Camera3SoftwareH264Decoder(source);
+    }
+    return nullptr;
+}
+
+} // namespace camera3
+} // namespace android
+// 个人修改结束
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#ifndef ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_DECODER_H
+#define ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_DECODER_H
+
+#include <utils/Errors.h>
+#include <utils/RefBase.h>
+
+#include "Camera3AccessUnitAssembler.h"
+
+namespace android {
+namespace camera3 {
+
+class Camera3InjectionSource;
+
+/**
+ * 注入源的 H.264 解码器接口。解码出的帧直接发布到构造时给定的 Camera3InjectionSource。
+ *
+ * 后端由 persist.camera.injection.decoder 选择：
+ * - auto (默认)：优先使用 MediaCodec，初始化失败 (没有硬件解码器的模拟器等) 时
+ *   由 socket 服务器自动改用软件解码器。
+ * - mediacodec：只使用 MediaCodec。
+ * - software：只使用基于 libavc 的软件解码器 (Camera3SoftwareH264Decoder)。
+ *
+ * 连接期间所有方法都在该源的解码线程上调用 (见 Camera3SocketServer)，
+ * 解码线程未运行时由 socket 线程调用；dump() 可在任意线程调用。
+ */
+class Camera3InjectionDecoder : public virtual RefBase {
+  public:
+    enum class Backend {
+        MEDIACODEC,
+        SOFTWARE,
+    };
+
+    enum class Mode {
+        AUTO,
+        MEDIACODEC,
+        SOFTWARE,
+    };
+
+    // "auto" / "mediacodec" / "software"，无法识别时返回 fallback
+    static Mode parseMode(const char* name, Mode fallback);
+    static const char* modeName(Mode mode);
+    static const char* backendName(Backend backend);
+
+    // 读取 persist.camera.injection.decoder
+    static Mode getConfiguredMode();
+
+    static sp<Camera3InjectionDecoder> create(Backend backend,
+            const sp<Camera3InjectionSource>& source);
+
+    virtual ~Camera3InjectionDecoder() = default;
+
+    virtual Backend getBackend() const = 0;
+
+    // 按显示尺寸初始化；已按相同尺寸初始化时直接返回 OK
+    virtual status_t initialize(uint32_t width, uint32_t height) = 0;
+    // 重新按新的宽高配置解码器
+    virtual status_t reconfigure(uint32_t width, uint32_t height) = 0;
+    virtual void release() = 0;
+    virtual bool isInitialized() const = 0;
+
+    // 提交一个完整的访问单元 (或 SPS/PPS codec-config) 进行解码。
+    // 暂时无法接收输入时返回 WOULD_BLOCK，此时数据没有提交，可以重试
+    virtual status_t decodeAccessUnit(const Camera3AccessUnitAssembler::AccessUnit& au) = 0;
+
+    virtual void dump(int fd) = 0;
+};
+
+} // namespace camera3
+} // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_DECODER_H
+// 个人修改结束
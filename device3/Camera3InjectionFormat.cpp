@@ -0,0 +1,316 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#define LOG_TAG "AIDOCK_CAM_INJECT"
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+extern "C" {
+#include <jpeglib.h>
+}
+#include <libyuv.h>
+#include <system/graphics.h>
+#include <utils/Log.h>
+
+#include "Camera3InjectionFormat.h"
+
+namespace android {
+namespace camera3 {
+
+namespace {
+
+// 8 位样本扩展为 P010 的 16 位样本：10 位有效数据放在高位，低 6 位为 0
+inline uint16_t toP010(uint8_t value) {
+    return static_cast<uint16_t>(((value << 8) | value) & 0xFFC0);
+}
+
+struct JpegErrorManager : public jpeg_error_mgr {
+    jmp_buf jumpBuffer;
+    bool overflow;
+};
+
+struct JpegDestination : public jpeg_destination_mgr {
+    uint8_t* buffer;
+    size_t capacity;
+};
+
+void jpegErrorExit(j_common_ptr cinfo) {
+    auto* err = static_cast<JpegErrorManager*>(cinfo->err);
+    if (!err->overflow) {
+        char message[JMSG_LENGTH_MAX];
+        (*cinfo->err->format_message)(cinfo, message);
+        ALOGE("标记: 注入帧 JPEG 编码失败: %s", message);
+    }
+    longjmp(err->jumpBuffer, 1);
+}
+
+void jpegInitDestination(j_compress_ptr cinfo) {
+    auto* dest = static_cast<JpegDestination*>(cinfo->dest);
+    dest->next_output_byte = dest->buffer;
+    dest->free_in_buffer = dest->capacity;
+}
+
+boolean jpegEmptyOutputBuffer(j_compress_ptr cinfo) {
+    // 输出缓冲区大小固定，写满即失败
+    static_cast<JpegErrorManager*>(cinfo->err)->overflow = true;
+    jpegErrorExit(reinterpret_cast<j_common_ptr>(cinfo));
+    return FALSE;
+}
+
+void jpegTermDestination(j_compress_ptr) {
+}
+
+} // namespace
+
+const char* Camera3InjectionFormat::layoutName(Layout layout) {
+    switch (layout) {
+        case Layout::NV21: return "nv21";
+        case Layout::NV12: return "nv12";
+        case Layout::PLANAR: return "planar";
+        case Layout::P010: return "p010";
+        case Layout::FLEXIBLE_YUV: return "flexible-yuv";
+        case Layout::RGBA: return "rgba";
+        case Layout::BGRA: return "bgra";
+        case Layout::Y8: return "y8";
+        case Layout::JPEG: return "jpeg";
+        case Layout::BLANK: return "blank";
+        case Layout::UNSUPPORTED: return "unsupported";
+    }
+    return "unknown";
+}
+
+Camera3InjectionFormat::Layout Camera3InjectionFormat::classify(int32_t format,
+        int32_t dataSpace) {
+    switch (format) {
+        case HAL_PIXEL_FORMAT_YCrCb_420_SP:
+            return Layout::NV21;
+        case HAL_PIXEL_FORMAT_YV12:
+            return Layout::PLANAR;
+        case HAL_PIXEL_FORMAT_YCBCR_P010:
+            return Layout::P010;
+        case HAL_PIXEL_FORMAT_YCBCR_420_888:
+        case HAL_PIXEL_FORMAT_IMPLEMENTATION_DEFINED:
+            return Layout::FLEXIBLE_YUV;
+        case HAL_PIXEL_FORMAT_RGBA_8888:
+        case HAL_PIXEL_FORMAT_RGBX_8888:
+            return Layout::RGBA;
+        case HAL_PIXEL_FORMAT_BGRA_8888:
+            return Layout::BGRA;
+        case HAL_PIXEL_FORMAT_Y8:
+            return Layout::Y8;
+        case HAL_PIXEL_FORMAT_BLOB:
+            return (dataSpace == HAL_DATASPACE_V0_JFIF || dataSpace == HAL_DATASPACE_JFIF) ?
+                    Layout::JPEG : Layout::UNSUPPORTED;
+        case HAL_PIXEL_FORMAT_RAW16:
+        case HAL_PIXEL_FORMAT_RAW10:
+        case HAL_PIXEL_FORMAT_RAW12:
+        case HAL_PIXEL_FORMAT_RAW_OPAQUE:
+            return Layout::BLANK;
+        default:
+            return Layout::UNSUPPORTED;
+    }
+}
+
+bool Camera3InjectionFormat::isYCbCr(Layout layout) {
+    return layout == Layout::NV21 || layout == Layout::NV12 || layout == Layout::PLANAR ||
+            layout == Layout::P010 || layout == Layout::FLEXIBLE_YUV;
+}
+
+Camera3InjectionFormat::Layout Camera3InjectionFormat::classifyPlanes(const Planes& planes,
+        bool tenBit) {
+    if (planes.y == nullptr || planes.cb == nullptr || planes.cr == nullptr) {
+        return Layout::UNSUPPORTED;
+    }
+    if (tenBit) {
+        return (planes.chromaStep == 4 && planes.cr == planes.cb + 2) ?
+                Layout::P010 : Layout::UNSUPPORTED;
+    }
+    if (planes.chromaStep == 1) {
+        return Layout::PLANAR;
+    }
+    if (planes.chromaStep == 2) {
+        if (planes.cb == planes.cr + 1) return Layout::NV21;
+        if (planes.cr == planes.cb + 1) return Layout::NV12;
+    }
+    return Layout::UNSUPPORTED;
+}
+
+bool Camera3InjectionFormat::isDirect(Layout layout, const Planes& planes) {
+    return layout == Layout::NV21 && planes.cStride == planes.yStride;
+}
+
+status_t Camera3InjectionFormat::convert(const Camera3InjectionTransform::Source& src,
+        Layout layout, const Planes& dst) {
+    if (src.y == nullptr || src.uv == nullptr || dst.y == nullptr || src.width <= 0 ||
+            src.height <= 0) {
+        return BAD_VALUE;
+    }
+    const int width = src.width;
+    const int height = src.height;
+    const int chromaWidth = (width + 1) / 2;
+    const int chromaHeight = (height + 1) / 2;
+    const int yStride = static_cast<int>(dst.yStride);
+    const int cStride = static_cast<int>(dst.cStride);
+
+    switch (layout) {
+        case Layout::NV21:
+            libyuv::CopyPlane(src.y, src.stride, dst.y, yStride, width, height);
+            libyuv::CopyPlane(src.uv, src.stride, dst.cr, cStride, chromaWidth * 2,
+                    chromaHeight);
+            return OK;
+        case Layout::NV12:
+            libyuv::CopyPlane(src.y, src.stride, dst.y, yStride, width, height);
+            libyuv::SwapUVPlane(src.uv, src.stride, dst.cb, cStride, chromaWidth, chromaHeight);
+            return OK;
+        case Layout::PLANAR:
+            // NV21 的偶数字节为 V (Cr)
+            libyuv::CopyPlane(src.y, src.stride, dst.y, yStride, width, height);
+            libyuv::SplitUVPlane(src.uv, src.stride, dst.cr, cStride, dst.cb, cStride,
+                    chromaWidth, chromaHeight);
+            return OK;
+        case Layout::P010: {
+            for (int row = 0; row < height; row++) {
+                const uint8_t* in = src.y + static_cast<size_t>(row) * src.stride;
+                uint16_t* out = reinterpret_cast<uint16_t*>(dst.y + row * dst.yStride);
+                for (int col = 0; col < width; col++) {
+                    out[col] = toP010(in[col]);
+                }
+            }
+            for (int row = 0; row < chromaHeight; row++) {
+                const uint8_t* in = src.uv + static_cast<size_t>(row) * src.stride;
+                uint16_t* out = reinterpret_cast<uint16_t*>(dst.cb + row * dst.cStride);
+                for (int col = 0; col < chromaWidth; col++) {
+                    out[col * 2] = toP010(in[col * 2 + 1]);
+                    out[col * 2 + 1] = toP010(in[col * 2]);
+                }
+            }
+            return OK;
+        }
+        case Layout::RGBA:
+            // libyuv 的 ABGR 在内存中按 R、G、B、A 排列
+            return libyuv::NV21ToABGR(src.y, src.stride, src.uv, src.stride, dst.y, yStride,
+                    width, height) == 0 ? OK : UNKNOWN_ERROR;
+        case Layout::BGRA:
+            return libyuv::NV21ToARGB(src.y, src.stride, src.uv, src.stride, dst.y, yStride,
+                    width, height) == 0 ? OK : UNKNOWN_ERROR;
+        case Layout::Y8:
+            libyuv::CopyPlane(src.y, src.stride, dst.y, yStride, width, height);
+            return OK;
+        default:
+            return INVALID_OPERATION;
+    }
+}
+
+status_t Camera3InjectionFormat::encodeJpeg(const Camera3InjectionTransform::Source& src,
+        int quality, uint8_t* out, size_t capacity, size_t* encodedSize) {
+    if (src.y == nullptr || src.uv == nullptr || out == nullptr || encodedSize == nullptr ||
+            src.width <= 0 || src.height <= 0) {
+        return BAD_VALUE;
+    }
+    const size_t width = src.width;
+    const size_t height = src.height;
+    // raw 数据按 MCU (16x16) 读取，宽度补齐到 16 并复制边缘像素，避免读出源帧范围
+    const size_t paddedWidth = (width + 15) & ~static_cast<size_t>(15);
+    const size_t chromaWidth = (width + 1) / 2;
+    const size_t chromaHeight = (height + 1) / 2;
+    std::vector<uint8_t> yStrip(paddedWidth * 16);
+    std::vector<uint8_t> cbStrip(paddedWidth / 2 * 8);
+    std::vector<uint8_t> crStrip(paddedWidth / 2 * 8);
+    JSAMPROW yRows[16];
+    JSAMPROW cbRows[8];
+    JSAMPROW crRows[8];
+    for (size_t i = 0; i < 16; i++) {
+        yRows[i] = yStrip.data() + i * paddedWidth;
+    }
+    for (size_t i = 0; i < 8; i++) {
+        cbRows[i] = cbStrip.data() + i * paddedWidth / 2;
+        crRows[i] = crStrip.data() + i * paddedWidth / 2;
+    }
+    JSAMPARRAY planes[3] = {yRows, cbRows, crRows};
+
+    jpeg_compress_struct cinfo;
+    JpegErrorManager err;
+    JpegDestination dest;
+    cinfo.err = jpeg_std_error(&err);
+    err.error_exit = jpegErrorExit;
+    err.overflow = false;
+    // setjmp 之后不要再构造非平凡对象，longjmp 不会析构它们
+    if (setjmp(err.jumpBuffer)) {
+        bool overflow = err.overflow;
+        jpeg_destroy_compress(&cinfo);
+        return overflow ? NO_MEMORY : UNKNOWN_ERROR;
+    }
+    jpeg_create_compress(&cinfo);
+    dest.buffer = out;
+    dest.capacity = capacity;
+    dest.init_destination = jpegInitDestination;
+    dest.empty_output_buffer = jpegEmptyOutputBuffer;
+    dest.term_destination = jpegTermDestination;
+    cinfo.dest = &dest;
+
+    cinfo.image_width = width;
+    cinfo.image_height = height;
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_YCbCr;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, quality, TRUE);
+    jpeg_set_colorspace(&cinfo, JCS_YCbCr);
+    cinfo.raw_data_in = TRUE;
+    cinfo.dct_method = JDCT_IFAST;
+    cinfo.comp_info[0].h_samp_factor = 2;
+    cinfo.comp_info[0].v_samp_factor = 2;
+    cinfo.comp_info[1].h_samp_factor = 1;
+    cinfo.comp_info[1].v_samp_factor = 1;
+    cinfo.comp_info[2].h_samp_factor = 1;
+    cinfo.comp_info[2].v_samp_factor = 1;
+    jpeg_start_compress(&cinfo, TRUE);
+
+    while (cinfo.next_scanline < cinfo.image_height) {
+        size_t firstRow = cinfo.next_scanline;
+        for (size_t i = 0; i < 16; i++) {
+            size_t row = std::min(firstRow + i, height - 1);
+            uint8_t* dstRow = yRows[i];
+            memcpy(dstRow, src.y + row * src.stride, width);
+            memset(dstRow + width, dstRow[width - 1], paddedWidth - width);
+        }
+        for (size_t i = 0; i < 8; i++) {
+            size_t row = std::min(firstRow / 2 + i, chromaHeight - 1);
+            const uint8_t* vu = src.uv + row * src.stride;
+            uint8_t* cb = cbRows[i];
+            uint8_t* cr = crRows[i];
+            for (size_t col = 0; col < chromaWidth; col++) {
+                cr[col] = vu[col * 2];
+                cb[col] = vu[col * 2 + 1];
+            }
+            memset(cb + chromaWidth, cb[chromaWidth - 1], paddedWidth / 2 - chromaWidth);
+            memset(cr + chromaWidth, cr[chromaWidth - 1], paddedWidth / 2 - chromaWidth);
+        }
+        jpeg_write_raw_data(&cinfo, planes, 16);
+    }
+    jpeg_finish_compress(&cinfo);
+    *encodedSize = capacity - dest.free_in_buffer;
+    jpeg_destroy_compress(&cinfo);
+    return OK;
+}
+
+} // namespace camera3
+} // namespace android
+// 个人修改结束
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#ifndef ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_FORMAT_H
+#define ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <utils/Errors.h>
+
+#include "Camera3InjectionTransform.h"
+
+namespace android {
+namespace camera3 {
+
+/**
+ * 注入帧到各种输出格式的转换。
+ *
+ * 注入帧先按目标尺寸渲染成 NV21 (Camera3InjectionTransform)，再按输出缓冲区的格式写入。
+ * YUV 缓冲区通过 lockYCbCr 得到真实的平面地址和 stride，不再假设 UV 平面紧跟在
+ * stride * height 之后；平面布局与 NV21 一致时由调用者直接渲染进缓冲区，省去一次转换。
+ */
+class Camera3InjectionFormat {
+  public:
+    enum class Layout {
+        // 半平面 VU，与注入帧相同
+        NV21,
+        // 半平面 UV
+        NV12,
+        // Y/Cb/Cr 三个独立平面 (YV12、I420)
+        PLANAR,
+        // 16 位半平面 UV，10 位有效数据在高位
+        P010,
+        // YCbCr_420_888 / IMPLEMENTATION_DEFINED，锁定后由 classifyPlanes 确定实际布局
+        FLEXIBLE_YUV,
+        // 内存中按 R、G、B、A 排列 (RGBA_8888 / RGBX_8888)
+        RGBA,
+        // 内存中按 B、G、R、A 排列
+        BGRA,
+        // 只有亮度
+        Y8,
+        // BLOB + JFIF，编码为 JPEG
+        JPEG,
+        // RAW：无法表示注入画面，清零以免泄露真实画面
+        BLANK,
+        // 深度、HEIC 等其他格式，保持 HAL 的输出不变
+        UNSUPPORTED,
+    };
+
+    // lockYCbCr 返回的平面 (与 android_ycbcr 对应)，stride 与 step 均以字节为单位。
+    // RGBA/BGRA/Y8 只使用 y 与 yStride。
+    struct Planes {
+        uint8_t* y;
+        uint8_t* cb;
+        uint8_t* cr;
+        size_t yStride;
+        size_t cStride;
+        size_t chromaStep;
+    };
+
+    static const char* layoutName(Layout layout);
+
+    // 按流的像素格式与 dataspace 分类
+    static Layout classify(int32_t format, int32_t dataSpace);
+
+    // 是否需要用 lockYCbCr 锁定
+    static bool isYCbCr(Layout layout);
+
+    // 按 lockYCbCr 返回的平面细分 YUV 布局；tenBit 为 P010 格式。无法识别时返回 UNSUPPORTED
+    static Layout classifyPlanes(const Planes& planes, bool tenBit);
+
+    // NV21 布局且 UV 行 stride 与 Y 相同，可以直接作为变换/占位模板的目标
+    static bool isDirect(Layout layout, const Planes& planes);
+
+    // 把目标尺寸的 NV21 帧写入 dst；layout 不能是 FLEXIBLE_YUV/JPEG/BLANK/UNSUPPORTED
+    static status_t convert(const Camera3InjectionTransform::Source& src, Layout layout,
+            const Planes& dst);
+
+    // 把 NV21 帧编码为 JPEG 写入 out，*encodedSize 为编码后的长度；空间不足时返回 NO_MEMORY
+    static status_t encodeJpeg(const Camera3InjectionTransform::Source& src, int quality,
+            uint8_t* out, size_t capacity, size_t* encodedSize);
+};
+
+} // namespace camera3
+} // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_FORMAT_H
+// 个人修改结束
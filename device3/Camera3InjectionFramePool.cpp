@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#define LOG_TAG "AIDOCK_CAM_INJECT"
+#include <inttypes.h>
+#include <stdio.h>
+#include <utils/Log.h>
+
+#include "Camera3InjectionFramePool.h"
+
+namespace android {
+namespace camera3 {
+
+Camera3InjectionFramePool::Camera3InjectionFramePool(size_t slotCount) :
+        mNextSlot(0),
+        mHits(0),
+        mMisses(0),
+        mExhausted(0),
+        mFramesFilled(0),
+        mBytesCopied(0) {
+    mSlots.reserve(slotCount);
+    for (size_t i = 0; i < slotCount; i++) {
+        mSlots.push_back(std::make_shared<DecodedFrame>());
+    }
+}
+
+std::shared_ptr<DecodedFrame> Camera3InjectionFramePool::acquire(uint32_t width,
+        uint32_t height) {
+    size_t frameSize = static_cast<size_t>(width) * height * 3 / 2;
+    std::shared_ptr<DecodedFrame> frame;
+    bool grown = false;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        // 从上次位置开始轮询，保证刚发布的帧最后才被复用
+        for (size_t i = 0; i < mSlots.size(); i++) {
+            size_t index = (mNextSlot + i) % mSlots.size();
+            // 只有池自身持有引用时才是空闲的；其他引用只能通过 acquire 获得，
+            // 所以在持锁期间计数不会从 1 增加
+            if (mSlots[index].use_count() == 1) {
+                frame = mSlots[index];
+                mNextSlot = (index + 1) % mSlots.size();
+                break;
+            }
+        }
+        if (frame == nullptr) {
+            mExhausted++;
+            mMisses++;
+        } else if (frame->data.capacity() < frameSize) {
+            grown = true;
+            mMisses++;
+        } else {
+            mHits++;
+        }
+        mFramesFilled++;
+    }
+
+    if (frame == nullptr) {
+        ALOGW("标记: 注入帧池已耗尽 (%zu 个槽位均被占用)，临时分配新帧", mSlots.size());
+        frame = std::make_shared<DecodedFrame>();
+    } else if (grown) {
+        ALOGI("标记: 注入帧池槽位扩容至 %ux%u", width, height);
+    }
+
+    // 槽位上次可能承载共享内存帧或 gralloc 帧：除像素内存外全部复位，
+    // 同时释放 holder，不再占住上次的共享内存槽位或 AImage
+    std::vector<uint8_t> data = std::move(frame->data);
+    *frame = DecodedFrame();
+    frame->data = std::move(data);
+    // 尺寸不变时 resize 不会分配也不会清零
+    frame->data.resize(frameSize);
+    frame->width = width;
+    frame->height = height;
+    return frame;
+}
+
+void Camera3InjectionFramePool::addBytesCopied(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mLock);
+    mBytesCopied += bytes;
+}
+
+void Camera3InjectionFramePool::dump(int fd) const {
+    std::lock_guard<std::mutex> lock(mLock);
+    size_t inUse = 0;
+    size_t capacity = 0;
+    for (const auto& slot : mSlots) {
+        if (slot.use_count() > 1) inUse++;
+        capacity += slot->data.capacity();
+    }
+    dprintf(fd, "  Frame pool: %zu slots (%zu in use, %zu bytes reserved)\n",
+            mSlots.size(), inUse, capacity);
+    dprintf(fd, "    Hits: %" PRIu64 ", misses: %" PRIu64 " (exhausted: %" PRIu64 ")\n",
+            mHits, mMisses, mExhausted);
+    dprintf(fd, "    Frames filled: %" PRIu64 ", bytes copied: %" PRIu64
+            " (%" PRIu64 " per frame)\n", mFramesFilled, mBytesCopied,
+            mFramesFilled > 0 ? mBytesCopied / mFramesFilled : 0);
+}
+
+} // namespace camera3
+} // namespace android
+// 个人修改结束
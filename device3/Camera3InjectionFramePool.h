@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#ifndef ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_FRAME_POOL_H
+#define ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_FRAME_POOL_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <utils/Timers.h>
+
+struct AHardwareBuffer;
+
+namespace android {
+namespace camera3 {
+
+struct DecodedFrame {
+    uint32_t width;
+    uint32_t height;
+    std::vector<uint8_t> data;
+    nsecs_t timestamp;
+    int format; // HAL_PIXEL_FORMAT_...
+    // 发布时由 Camera3StreamInjectionManager 分配的递增序号，用于识别同一帧
+    uint64_t sequence;
+    // 非空时像素直接引用外部内存 (共享内存环的槽位)，data 不使用；
+    // holder 在帧释放之前保持该内存有效
+    const uint8_t* external;
+    size_t externalSize;
+    std::shared_ptr<const void> holder;
+    // Y/UV 平面的行跨度，0 表示与 width 相同
+    uint32_t stride;
+    // 非空时像素留在解码器输出的 gralloc 缓冲区中 (CPU 不可直接寻址)，data/external 不使用；
+    // 读取方 dup acquireFence 后交给 lock，锁定后图像从 (cropLeft, cropTop) 开始。
+    // 缓冲区与 fence 都由 holder 负责归还和关闭
+    AHardwareBuffer* hardwareBuffer;
+    int acquireFence;
+    uint32_t cropLeft;
+    uint32_t cropTop;
+    // 色度按 U、V 交错 (NV12)；CPU 内存中的帧总是 NV21
+    bool chromaUV;
+
+    DecodedFrame() : width(0), height(0), timestamp(0), format(0), sequence(0),
+            external(nullptr), externalSize(0), stride(0), hardwareBuffer(nullptr),
+            acquireFence(-1), cropLeft(0), cropTop(0), chromaUV(false) {}
+
+    const uint8_t* pixels() const { return external != nullptr ? external : data.data(); }
+    size_t size() const { return external != nullptr ? externalSize : data.size(); }
+    uint32_t rowStride() const { return stride != 0 ? stride : width; }
+    // 有可供合成的图像 (CPU 内存或 gralloc 缓冲区)
+    bool hasImage() const { return hardwareBuffer != nullptr || size() > 0; }
+};
+
+/**
+ * 注入帧的固定大小循环缓冲池。
+ *
+ * 每个槽位是一个预先创建好的 shared_ptr<DecodedFrame>，池本身持有一个引用；
+ * 当 use_count() == 1 时说明没有解码器或输出流在使用它，可以直接复用，
+ * 因此稳态下每帧既不分配 DecodedFrame 也不重新分配像素内存。
+ */
+class Camera3InjectionFramePool {
+public:
+    static constexpr size_t kDefaultSlotCount = 4;
+
+    explicit Camera3InjectionFramePool(size_t slotCount = kDefaultSlotCount);
+
+    // 取得一个可写的 NV12/NV21 帧 (width x height，紧密排列)。
+    // 所有槽位都被借出时退化为一次堆分配，并计为 miss。
+    std::shared_ptr<DecodedFrame> acquire(uint32_t width, uint32_t height);
+
+    // 记录注入路径上拷贝的字节数 (解码队列入队、写入帧、合成；用于统计每帧拷贝量)
+    void addBytesCopied(size_t bytes);
+
+    void dump(int fd) const;
+
+private:
+    mutable std::mutex mLock;
+    std::vector<std::shared_ptr<DecodedFrame>> mSlots;
+    size_t mNextSlot;
+
+    // 复用槽位且无需扩容
+    uint64_t mHits;
+    // 槽位需要扩容，或所有槽位都被借出
+    uint64_t mMisses;
+    uint64_t mExhausted;
+    uint64_t mFramesFilled;
+    uint64_t mBytesCopied;
+};
+
+} // namespace camera3
+} // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_FRAME_POOL_H
+// 个人修改结束
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#define LOG_TAG "AIDOCK_CAM_INJECT"
+#include <string.h>
+
+#include <algorithm>
+
+#include <utils/Log.h>
+
+#include "Camera3InjectionFrameRing.h"
+
+namespace android {
+namespace camera3 {
+
+Camera3InjectionFrameRing::Policy Camera3InjectionFrameRing::parsePolicy(const char* name,
+        Policy fallback) {
+    if (name == nullptr) return fallback;
+    if (strcmp(name, "latest") == 0) return Policy::LATEST;
+    if (strcmp(name, "nearest") == 0) return Policy::NEAREST;
+    if (strcmp(name, "hold") == 0) return Policy::HOLD;
+    return fallback;
+}
+
+const char* Camera3InjectionFrameRing::policyName(Policy policy) {
+    switch (policy) {
+        case Policy::LATEST: return "latest";
+        case Policy::NEAREST: return "nearest";
+        case Policy::HOLD: return "hold";
+    }
+    return "unknown";
+}
+
+Camera3InjectionFrameRing::Camera3InjectionFrameRing(size_t capacity) :
+        mCapacity(std::clamp<size_t>(capacity, 1, kMaxCapacity)),
+        mSnapshot(std::make_shared<const Snapshot>()),
+        mPushed(0),
+        mLastTarget(kNoTarget),
+        mLastIndex(0),
+        mSelections(0),
+        mRepeated(0),
+        mDropped(0) {
+}
+
+std::shared_ptr<const Camera3InjectionFrameRing::Snapshot>
+Camera3InjectionFrameRing::loadSnapshot() const {
+    return std::atomic_load_explicit(&mSnapshot, std::memory_order_acquire);
+}
+
+void Camera3InjectionFrameRing::push(std::shared_ptr<DecodedFrame> frame) {
+    std::shared_ptr<const Snapshot> current = loadSnapshot();
+    auto next = std::make_shared<Snapshot>();
+    // 环满时跳过最旧的一帧；它在仍持有旧快照的读者释放之前不会被帧池复用
+    size_t first = (current->count >= mCapacity) ? current->count - mCapacity + 1 : 0;
+    for (size_t i = first; i < current->count; i++) {
+        next->entries[next->count++] = current->entries[i];
+    }
+    next->entries[next->count++] = {std::move(frame), ++mPushed};
+    std::atomic_store_explicit(&mSnapshot, std::shared_ptr<const Snapshot>(std::move(next)),
+            std::memory_order_release);
+}
+
+std::shared_ptr<DecodedFrame> Camera3InjectionFrameRing::latest() const {
+    std::shared_ptr<const Snapshot> snapshot = loadSnapshot();
+    return snapshot->count == 0 ? nullptr : snapshot->entries[snapshot->count - 1].frame;
+}
+
+size_t Camera3InjectionFrameRing::size() const {
+    return loadSnapshot()->count;
+}
+
+size_t Camera3InjectionFrameRing::selectIndex(const Snapshot& snapshot, Policy policy,
+        nsecs_t targetTime) {
+    size_t newest = snapshot.count - 1;
+    switch (policy) {
+        case Policy::LATEST:
+            return newest;
+        case Policy::NEAREST: {
+            size_t best = newest;
+            nsecs_t bestDistance = INT64_MAX;
+            for (size_t i = 0; i < snapshot.count; i++) {
+                nsecs_t t = snapshot.entries[i].frame->timestamp;
+                nsecs_t distance = (t > targetTime) ? t - targetTime : targetTime - t;
+                // 距离相同时取较新的帧
+                if (distance <= bestDistance) {
+                    bestDistance = distance;
+                    best = i;
+                }
+            }
+            return best;
+        }
+        case Policy::HOLD:
+            for (size_t i = snapshot.count; i > 0; i--) {
+                if (snapshot.entries[i - 1].frame->timestamp <= targetTime) {
+                    return i - 1;
+                }
+            }
+            // 所有帧都晚于目标时间 (环太短或刚连接)，退而取最旧的一帧
+            return 0;
+    }
+    return newest;
+}
+
+void Camera3InjectionFrameRing::updateStats(nsecs_t targetTime, uint64_t index) {
+    // 同一相机帧的其他输出流只读不写，避免争用同一缓存行
+    if (mLastTarget.load(std::memory_order_relaxed) == targetTime) {
+        return;
+    }
+    nsecs_t previousTarget = mLastTarget.exchange(targetTime, std::memory_order_relaxed);
+    if (previousTarget == targetTime) {
+        return;
+    }
+    mSelections.fetch_add(1, std::memory_order_relaxed);
+    uint64_t lastIndex = mLastIndex.load(std::memory_order_relaxed);
+    if (previousTarget != kNoTarget) {
+        if (index == lastIndex) {
+            mRepeated.fetch_add(1, std::memory_order_relaxed);
+        } else if (index > lastIndex + 1) {
+            mDropped.fetch_add(index - lastIndex - 1, std::memory_order_relaxed);
+        }
+    }
+    while (lastIndex < index && !mLastIndex.compare_exchange_weak(lastIndex, index,
+            std::memory_order_relaxed)) {
+    }
+}
+
+std::shared_ptr<DecodedFrame> Camera3InjectionFrameRing::select(Policy policy,
+        nsecs_t targetTime) {
+    std::shared_ptr<const Snapshot> snapshot = loadSnapshot();
+    if (snapshot->count == 0) {
+        return nullptr;
+    }
+    const Entry& entry = snapshot->entries[selectIndex(*snapshot, policy, targetTime)];
+    updateStats(targetTime, entry.index);
+    return entry.frame;
+}
+
+} // namespace camera3
+} // namespace android
+// 个人修改结束
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#ifndef ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_FRAME_RING_H
+#define ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_FRAME_RING_H
+
+#include <atomic>
+#include <limits>
+#include <memory>
+
+#include <utils/Timers.h>
+
+#include "Camera3InjectionFramePool.h"
+
+namespace android {
+namespace camera3 {
+
+/**
+ * 最近发布的若干注入帧，按时间戳为每个相机帧挑选源帧。
+ *
+ * 源帧率和相机帧率不同时 (例如 30 fps 的源、60 fps 的预览)，"总是取最新一帧"
+ * 会随解码完成时间的抖动出现不规则的重复和跳帧。这里改为按相机帧的 sensor 时间戳
+ * 选帧，使同一个源帧在输出中出现的次数保持均匀：
+ *
+ * - LATEST：最新一帧 (旧行为)。
+ * - NEAREST：时间戳与目标时间最接近的帧。
+ * - HOLD：时间戳不晚于目标时间的最新一帧 (采样保持)，不会显示"未来"的帧。
+ *
+ * 帧和目标时间都使用 CLOCK_MONOTONIC。
+ *
+ * 单生产者/多消费者：push() 只能由一个线程 (该源的解码线程) 调用；latest() 和 select()
+ * 可在任意线程调用，不会等待解码线程。每次 push() 生成一份新的只读快照并以原子方式替换
+ * 旧快照，读者拿到的快照在其持有期间保持不变，其中的帧也不会被帧池复用。
+ * 快照的替换和读取使用 shared_ptr 的 atomic_load/atomic_store，libc++ 用一组全局分段
+ * 互斥锁实现，临界区只有引用计数的增减；因此读者不会被 push() 的选帧和拷贝阻塞，但并非无锁。
+ */
+class Camera3InjectionFrameRing {
+  public:
+    static constexpr size_t kDefaultCapacity = 4;
+    static constexpr size_t kMaxCapacity = 16;
+
+    enum class Policy {
+        LATEST,
+        NEAREST,
+        HOLD,
+    };
+
+    // "latest" / "nearest" / "hold"，无法识别时返回 fallback
+    static Policy parsePolicy(const char* name, Policy fallback);
+    static const char* policyName(Policy policy);
+
+    // capacity 限制在 [1, kMaxCapacity]
+    explicit Camera3InjectionFrameRing(size_t capacity = kDefaultCapacity);
+
+    // 加入一帧，环满时挤出最旧的一帧；仅限生产者线程
+    void push(std::shared_ptr<DecodedFrame> frame);
+
+    std::shared_ptr<DecodedFrame> latest() const;
+
+    // 为目标时间的相机帧选帧；同一目标时间的多次调用 (多个输出流) 只计一次统计。
+    // 多个线程同时选取不同目标时间时统计是近似值
+    std::shared_ptr<DecodedFrame> select(Policy policy, nsecs_t targetTime);
+
+    size_t size() const;
+    size_t capacity() const { return mCapacity; }
+
+    // 相机帧数、重复显示的源帧数、从未显示就被跳过的源帧数
+    uint64_t getSelections() const { return mSelections.load(std::memory_order_relaxed); }
+    uint64_t getRepeated() const { return mRepeated.load(std::memory_order_relaxed); }
+    uint64_t getDropped() const { return mDropped.load(std::memory_order_relaxed); }
+
+  private:
+    struct Entry {
+        std::shared_ptr<DecodedFrame> frame;
+        // 本环内的发布序号，用于统计跳过的帧数
+        uint64_t index;
+    };
+
+    static constexpr nsecs_t kNoTarget = std::numeric_limits<nsecs_t>::min();
+
+    // 发布后只读；entries[0] 最旧
+    struct Snapshot {
+        size_t count = 0;
+        Entry entries[kMaxCapacity];
+    };
+
+    std::shared_ptr<const Snapshot> loadSnapshot() const;
+    static size_t selectIndex(const Snapshot& snapshot, Policy policy, nsecs_t targetTime);
+    void updateStats(nsecs_t targetTime, uint64_t index);
+
+    const size_t mCapacity;
+    // 通过 std::atomic_load/atomic_store 访问 (libc++ 内部加全局分段锁，不是无锁的)
+    std::shared_ptr<const Snapshot> mSnapshot;
+    // 仅生产者线程访问
+    uint64_t mPushed;
+
+    // 还没有选过帧时为 kNoTarget
+    std::atomic<nsecs_t> mLastTarget;
+    std::atomic<uint64_t> mLastIndex;
+    std::atomic<uint64_t> mSelections;
+    std::atomic<uint64_t> mRepeated;
+    std::atomic<uint64_t> mDropped;
+};
+
+} // namespace camera3
+} // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_FRAME_RING_H
+// 个人修改结束
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#define LOG_TAG "AIDOCK_CAM_DECODER"
+#include <string.h>
+
+#include <algorithm>
+
+#include <utils/Log.h>
+
+#include "Camera3InjectionIngestBuffer.h"
+
+namespace android {
+namespace camera3 {
+
+Camera3InjectionIngestBuffer::Camera3InjectionIngestBuffer(size_t maxCapacity,
+        size_t initialCapacity) :
+        mMaxCapacity(maxCapacity),
+        mBuffer(std::min(initialCapacity, maxCapacity)),
+        mReadOffset(0),
+        mWriteOffset(0),
+        mCompactions(0),
+        mBytesMoved(0) {
+}
+
+status_t Camera3InjectionIngestBuffer::reserve(size_t minWritable) {
+    if (writable() >= minWritable) {
+        return OK;
+    }
+    size_t pending = readable();
+    if (pending + minWritable > mMaxCapacity) {
+        ALOGE("标记: 接收缓冲区需要 %zu 字节，超过上限 %zu", pending + minWritable,
+                mMaxCapacity);
+        return NO_MEMORY;
+    }
+    if (mReadOffset > 0) {
+        // 只搬移尚未处理完的一帧
+        memmove(mBuffer.data(), mBuffer.data() + mReadOffset, pending);
+        mReadOffset = 0;
+        mWriteOffset = pending;
+        mCompactions++;
+        mBytesMoved += pending;
+    }
+    if (writable() < minWritable) {
+        size_t capacity = std::min(mMaxCapacity,
+                std::max(mBuffer.size() * 2, pending + minWritable));
+        ALOGI("标记: 接收缓冲区扩容 %zu -> %zu 字节", mBuffer.size(), capacity);
+        mBuffer.resize(capacity);
+    }
+    return OK;
+}
+
+void Camera3InjectionIngestBuffer::commit(size_t size) {
+    mWriteOffset += std::min(size, writable());
+}
+
+void Camera3InjectionIngestBuffer::consume(size_t size) {
+    mReadOffset += std::min(size, readable());
+    if (mReadOffset == mWriteOffset) {
+        // 全部处理完，下次从头写入，不需要搬移
+        mReadOffset = 0;
+        mWriteOffset = 0;
+    }
+}
+
+void Camera3InjectionIngestBuffer::clear() {
+    mReadOffset = 0;
+    mWriteOffset = 0;
+}
+
+} // namespace camera3
+} // namespace android
+// 个人修改结束
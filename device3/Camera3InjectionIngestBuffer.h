@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#ifndef ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_INGEST_BUFFER_H
+#define ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_INGEST_BUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include <utils/Errors.h>
+
+namespace android {
+namespace camera3 {
+
+/**
+ * 注入 socket 的接收缓冲区，在连接之间复用。
+ *
+ * socket 数据直接读入写入区 (writeData/commit)，解析方在读取区 (readData) 上原地处理完整的
+ * 帧并 consume；不完整的帧留在缓冲区中，下一次读取的数据紧接在它后面，因此一帧总是连续
+ * 存放，分帧解析和 NAL 切分都直接引用内核写入的这块内存；访问单元在进入解码队列时
+ * 被拷贝一次 (见 Camera3InjectionDecodeQueue)。
+ *
+ * 只有写入区不够时才把剩余的未读数据 (不超过一帧) 移到开头，仍不够时再扩容，
+ * 稳态下每帧最多搬移一次且不分配内存。非线程安全。
+ */
+class Camera3InjectionIngestBuffer {
+  public:
+    static constexpr size_t kDefaultInitialCapacity = 1024 * 1024;
+
+    explicit Camera3InjectionIngestBuffer(size_t maxCapacity,
+            size_t initialCapacity = kDefaultInitialCapacity);
+
+    // 保证写入区至少有 minWritable 字节；未读数据加上 minWritable 超过上限时返回 NO_MEMORY
+    status_t reserve(size_t minWritable);
+
+    uint8_t* writeData() { return mBuffer.data() + mWriteOffset; }
+    size_t writable() const { return mBuffer.size() - mWriteOffset; }
+    // 写入区的前 size 字节已填充
+    void commit(size_t size);
+
+    const uint8_t* readData() const { return mBuffer.data() + mReadOffset; }
+    size_t readable() const { return mWriteOffset - mReadOffset; }
+    // 读取区的前 size 字节已处理；之前通过 readData() 取得的指针随之失效
+    void consume(size_t size);
+
+    // 丢弃所有数据 (新的连接)，保留已分配的内存
+    void clear();
+
+    size_t capacity() const { return mBuffer.size(); }
+    uint64_t getCompactions() const { return mCompactions; }
+    uint64_t getBytesMoved() const { return mBytesMoved; }
+
+  private:
+    const size_t mMaxCapacity;
+    std::vector<uint8_t> mBuffer;
+    size_t mReadOffset;
+    size_t mWriteOffset;
+
+    uint64_t mCompactions;
+    uint64_t mBytesMoved;
+};
+
+} // namespace camera3
+} // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_INGEST_BUFFER_H
+// 个人修改结束
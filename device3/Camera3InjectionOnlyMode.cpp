@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#define LOG_TAG "Camera3-InjectionOnlyMode"
+
+#include "Camera3InjectionOnlyMode.h"
+
+namespace android {
+namespace camera3 {
+
+Camera3InjectionOnlyMode::Transition Camera3InjectionOnlyMode::update(bool eligible,
+        const std::function<bool()>& waitForHalDrained) {
+    bool active = mActive.load(std::memory_order_relaxed);
+    if (eligible == active) {
+        return Transition::NONE;
+    }
+    if (eligible && !waitForHalDrained()) {
+        mDeferredCount.fetch_add(1, std::memory_order_relaxed);
+        return Transition::DEFERRED;
+    }
+    mActive.store(eligible, std::memory_order_relaxed);
+    mSwitchCount.fetch_add(1, std::memory_order_relaxed);
+    return eligible ? Transition::ENTERED : Transition::LEFT;
+}
+
+void Camera3InjectedResultBuilder::fill(CameraMetadata* result, nsecs_t timestamp) {
+    int64_t sensorTimestamp = timestamp;
+    result->update(ANDROID_SENSOR_TIMESTAMP, &sensorTimestamp, 1);
+    uint8_t pipelineDepth = 1;
+    result->update(ANDROID_REQUEST_PIPELINE_DEPTH, &pipelineDepth, 1);
+
+    camera_metadata_entry_t e = result->find(ANDROID_CONTROL_MODE);
+    bool controlOff = e.count > 0 && e.data.u8[0] == ANDROID_CONTROL_MODE_OFF;
+
+    e = result->find(ANDROID_CONTROL_AE_MODE);
+    bool aeOff = controlOff || (e.count > 0 && e.data.u8[0] == ANDROID_CONTROL_AE_MODE_OFF);
+    e = result->find(ANDROID_CONTROL_AE_LOCK);
+    bool aeLocked = e.count > 0 && e.data.u8[0] == ANDROID_CONTROL_AE_LOCK_ON;
+    uint8_t aeState = aeOff ? ANDROID_CONTROL_AE_STATE_INACTIVE :
+            (aeLocked ? ANDROID_CONTROL_AE_STATE_LOCKED : ANDROID_CONTROL_AE_STATE_CONVERGED);
+    result->update(ANDROID_CONTROL_AE_STATE, &aeState, 1);
+
+    e = result->find(ANDROID_CONTROL_AWB_MODE);
+    bool awbOff = controlOff || (e.count > 0 && e.data.u8[0] == ANDROID_CONTROL_AWB_MODE_OFF);
+    e = result->find(ANDROID_CONTROL_AWB_LOCK);
+    bool awbLocked = e.count > 0 && e.data.u8[0] == ANDROID_CONTROL_AWB_LOCK_ON;
+    uint8_t awbState = awbOff ? ANDROID_CONTROL_AWB_STATE_INACTIVE :
+            (awbLocked ? ANDROID_CONTROL_AWB_STATE_LOCKED : ANDROID_CONTROL_AWB_STATE_CONVERGED);
+    result->update(ANDROID_CONTROL_AWB_STATE, &awbState, 1);
+
+    e = result->find(ANDROID_CONTROL_AF_TRIGGER);
+    if (e.count > 0 && e.data.u8[0] == ANDROID_CONTROL_AF_TRIGGER_START) {
+        mAfLocked = true;
+    } else if (e.count > 0 && e.data.u8[0] == ANDROID_CONTROL_AF_TRIGGER_CANCEL) {
+        mAfLocked = false;
+    }
+    e = result->find(ANDROID_CONTROL_AF_MODE);
+    uint8_t afMode = e.count > 0 ? e.data.u8[0] :
+            static_cast<uint8_t>(ANDROID_CONTROL_AF_MODE_OFF);
+    uint8_t afState = ANDROID_CONTROL_AF_STATE_INACTIVE;
+    if (controlOff || afMode == ANDROID_CONTROL_AF_MODE_OFF ||
+            afMode == ANDROID_CONTROL_AF_MODE_EDOF) {
+        mAfLocked = false;
+    } else if (mAfLocked) {
+        afState = ANDROID_CONTROL_AF_STATE_FOCUSED_LOCKED;
+    } else if (afMode == ANDROID_CONTROL_AF_MODE_CONTINUOUS_VIDEO ||
+            afMode == ANDROID_CONTROL_AF_MODE_CONTINUOUS_PICTURE) {
+        afState = ANDROID_CONTROL_AF_STATE_PASSIVE_FOCUSED;
+    }
+    result->update(ANDROID_CONTROL_AF_STATE, &afState, 1);
+}
+
+} // namespace camera3
+} // namespace android
+// 个人修改结束
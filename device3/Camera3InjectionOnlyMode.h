@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#ifndef ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_ONLY_MODE_H
+#define ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_ONLY_MODE_H
+
+#include <atomic>
+#include <functional>
+
+#include <camera/CameraMetadata.h>
+#include <utils/Timers.h>
+
+namespace android {
+namespace camera3 {
+
+/**
+ * 仅注入模式的切换。
+ *
+ * RequestThread 每个批次调用一次 update()，传入本批次能否完全由注入帧完成。
+ * 进入仅注入模式前必须等 HAL 完成所有已提交的请求，否则合成的 shutter 会排在
+ * HAL 未完成的帧之前；等不到时本批次仍交给 HAL，下一个批次再尝试。
+ * 退出时不需要等待：仅注入的请求在提交时就已完成。
+ *
+ * update() 只由 RequestThread 调用；isActive() 和统计可以在其他线程读取。
+ */
+class Camera3InjectionOnlyMode {
+  public:
+    enum class Transition {
+        // 模式不变
+        NONE,
+        // 本批次起不再提交给 HAL
+        ENTERED,
+        // 可以进入，但 HAL 仍有未完成的请求，本批次仍交给 HAL
+        DEFERRED,
+        // 恢复向 HAL 提交；HAL 没有收到仅注入期间的设置
+        LEFT,
+    };
+
+    // waitForHalDrained 只在准备进入仅注入模式时调用，返回 HAL 的请求是否已全部完成
+    Transition update(bool eligible, const std::function<bool()>& waitForHalDrained);
+
+    bool isActive() const { return mActive.load(std::memory_order_relaxed); }
+    int64_t getSwitchCount() const { return mSwitchCount.load(std::memory_order_relaxed); }
+    int64_t getDeferredCount() const { return mDeferredCount.load(std::memory_order_relaxed); }
+
+  private:
+    std::atomic<bool> mActive = false;
+    std::atomic<int64_t> mSwitchCount = 0;
+    std::atomic<int64_t> mDeferredCount = 0;
+};
+
+/**
+ * 为仅注入的请求合成 HAL 会给出的动态结果：sensor 时间戳、pipeline 深度和 3A 状态。
+ *
+ * 没有真实的 3A，按请求的模式报告稳定状态；AF 触发后立即对焦成功并保持锁定，
+ * 直到取消或切换模式，因此锁定状态跨帧保存。不是线程安全的，由调用者串行化。
+ */
+class Camera3InjectedResultBuilder {
+  public:
+    // result 为本帧生效的请求设置，就地补充结果 tag
+    void fill(CameraMetadata* result, nsecs_t timestamp);
+
+    bool isAfLocked() const { return mAfLocked; }
+
+  private:
+    bool mAfLocked = false;
+};
+
+} // namespace camera3
+} // namespace android
+
+#endif
+// 个人修改结束
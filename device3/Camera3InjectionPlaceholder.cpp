@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#define LOG_TAG "AIDOCK_CAM_INJECT"
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <cutils/properties.h>
+#include <utils/Log.h>
+
+#include "Camera3InjectionPlaceholder.h"
+#include "Camera3InjectionTransform.h"
+
+namespace android {
+namespace camera3 {
+
+namespace {
+
+// 绿幕 (与之前逐缓冲区填充的数值相同，UV 按字节交错原样写入)
+constexpr uint8_t kGreenY = 150;
+constexpr uint8_t kGreenUV[2] = {21, 44};
+constexpr uint8_t kBlackY = 16;
+constexpr uint8_t kBlackUV[2] = {128, 128};
+// 占位图像的尺寸上限，防止属性写错时读入过大的文件
+constexpr uint32_t kMaxImageDimension = 8192;
+
+Camera3InjectionPlaceholder::Policy readPolicy() {
+    char value[PROPERTY_VALUE_MAX];
+    property_get("persist.camera.injection.no_signal", value, "placeholder");
+    return Camera3InjectionPlaceholder::parsePolicy(value,
+            Camera3InjectionPlaceholder::Policy::PLACEHOLDER);
+}
+
+std::string readProperty(const char* key) {
+    char value[PROPERTY_VALUE_MAX];
+    property_get(key, value, "");
+    return value;
+}
+
+void fillSolid(std::vector<uint8_t>* data, uint32_t stride, uint32_t height, uint8_t y,
+        const uint8_t uv[2]) {
+    size_t ySize = static_cast<size_t>(stride) * height;
+    memset(data->data(), y, ySize);
+    // 先填好一行 UV，其余行整行拷贝
+    uint8_t* uvPlane = data->data() + ySize;
+    for (uint32_t col = 0; col + 1 < stride; col += 2) {
+        uvPlane[col] = uv[0];
+        uvPlane[col + 1] = uv[1];
+    }
+    for (uint32_t row = 1; row < height / 2; row++) {
+        memcpy(uvPlane + static_cast<size_t>(row) * stride, uvPlane, stride);
+    }
+}
+
+} // namespace
+
+Camera3InjectionPlaceholder::Policy Camera3InjectionPlaceholder::parsePolicy(const char* name,
+        Policy fallback) {
+    if (name == nullptr) return fallback;
+    if (strcmp(name, "hold") == 0) return Policy::HOLD;
+    if (strcmp(name, "black") == 0) return Policy::BLACK;
+    if (strcmp(name, "placeholder") == 0) return Policy::PLACEHOLDER;
+    return fallback;
+}
+
+const char* Camera3InjectionPlaceholder::policyName(Policy policy) {
+    switch (policy) {
+        case Policy::HOLD: return "hold";
+        case Policy::BLACK: return "black";
+        case Policy::PLACEHOLDER: return "placeholder";
+    }
+    return "unknown";
+}
+
+Camera3InjectionPlaceholder::Camera3InjectionPlaceholder() :
+        mPolicy(readPolicy()),
+        mImagePath(readProperty("persist.camera.injection.placeholder_image")),
+        mImageSize(readProperty("persist.camera.injection.placeholder_size")),
+        mImageLoaded(false),
+        mImageWidth(0),
+        mImageHeight(0),
+        mNextId(1),
+        mRenders(0) {
+    ALOGI("标记: 无信号策略: %s", policyName(mPolicy));
+}
+
+std::shared_ptr<const Camera3InjectionPlaceholder::Template>
+Camera3InjectionPlaceholder::getTemplate(uint32_t width, uint32_t height, uint32_t stride) {
+    if (width == 0 || height == 0 || stride < width) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mLock);
+    for (auto it = mTemplates.begin(); it != mTemplates.end(); ++it) {
+        if ((*it)->matches(width, height, stride)) {
+            std::shared_ptr<const Template> found = *it;
+            mTemplates.erase(it);
+            mTemplates.push_back(found);
+            return found;
+        }
+    }
+
+    auto tmpl = std::make_shared<Template>();
+    tmpl->width = width;
+    tmpl->height = height;
+    tmpl->stride = stride;
+    tmpl->id = mNextId++;
+    tmpl->data.resize(static_cast<size_t>(stride) * height * 3 / 2);
+    renderLocked(tmpl.get());
+    mRenders++;
+    if (mTemplates.size() >= kMaxTemplates) {
+        // 输出流仍持有被淘汰的模板，不影响正在进行的填充
+        mTemplates.erase(mTemplates.begin());
+    }
+    mTemplates.push_back(tmpl);
+    ALOGI("标记: 已渲染无信号模板 %" PRIu64 ": %ux%u, stride %u", tmpl->id, width, height,
+            stride);
+    return tmpl;
+}
+
+void Camera3InjectionPlaceholder::renderLocked(Template* tmpl) {
+    if (mPolicy == Policy::BLACK) {
+        fillSolid(&tmpl->data, tmpl->stride, tmpl->height, kBlackY, kBlackUV);
+        return;
+    }
+    loadImageLocked();
+    if (!mImage.empty()) {
+        uint8_t* dstY = tmpl->data.data();
+        Camera3InjectionTransform::Source src = {mImage.data(),
+                mImage.data() + static_cast<size_t>(mImageWidth) * mImageHeight,
+                static_cast<int32_t>(mImageWidth), static_cast<int32_t>(mImageWidth),
+                static_cast<int32_t>(mImageHeight)};
+        Camera3InjectionTransform::Destination dst = {dstY,
+                dstY + static_cast<size_t>(tmpl->stride) * tmpl->height,
+                static_cast<int32_t>(tmpl->stride), static_cast<int32_t>(tmpl->width),
+                static_cast<int32_t>(tmpl->height)};
+        std::vector<uint8_t> scratch;
+        if (Camera3InjectionTransform::apply(src, 0, dst, &scratch) == OK) {
+            return;
+        }
+        ALOGW("标记: 占位图像缩放到 %ux%u 失败，改用绿幕", tmpl->width, tmpl->height);
+    }
+    fillSolid(&tmpl->data, tmpl->stride, tmpl->height, kGreenY, kGreenUV);
+}
+
+void Camera3InjectionPlaceholder::loadImageLocked() {
+    if (mImageLoaded) {
+        return;
+    }
+    mImageLoaded = true;
+    if (mImagePath.empty()) {
+        return;
+    }
+    uint32_t width = 0;
+    uint32_t height = 0;
+    if (sscanf(mImageSize.c_str(), "%ux%u", &width, &height) != 2 || width == 0 ||
+            height == 0 || width % 2 != 0 || height % 2 != 0 ||
+            width > kMaxImageDimension || height > kMaxImageDimension) {
+        ALOGE("标记: 占位图像尺寸无效: \"%s\"", mImageSize.c_str());
+        return;
+    }
+    FILE* file = fopen(mImagePath.c_str(), "rbe");
+    if (file == nullptr) {
+        ALOGE("标记: 无法打开占位图像 %s: %s", mImagePath.c_str(), strerror(errno));
+        return;
+    }
+    std::vector<uint8_t> image(static_cast<size_t>(width) * height * 3 / 2);
+    size_t read = fread(image.data(), 1, image.size(), file);
+    fclose(file);
+    if (read != image.size()) {
+        ALOGE("标记: 占位图像 %s 只有 %zu 字节，%ux%u 的 NV21 需要 %zu 字节",
+                mImagePath.c_str(), read, width, height, image.size());
+        return;
+    }
+    mImage.swap(image);
+    mImageWidth = width;
+    mImageHeight = height;
+    ALOGI("标记: 已加载占位图像 %s (%ux%u)", mImagePath.c_str(), width, height);
+}
+
+void Camera3InjectionPlaceholder::dump(int fd) {
+    std::lock_guard<std::mutex> lock(mLock);
+    dprintf(fd, "  No-signal policy: %s, placeholder image: %s", policyName(mPolicy),
+            mImage.empty() ? "none (green)" : mImagePath.c_str());
+    if (!mImage.empty()) {
+        dprintf(fd, " (%ux%u)", mImageWidth, mImageHeight);
+    }
+    dprintf(fd, "\n    Templates rendered: %" PRIu64 ", cached:", mRenders);
+    for (const auto& tmpl : mTemplates) {
+        dprintf(fd, " %ux%u/%u", tmpl->width, tmpl->height, tmpl->stride);
+    }
+    dprintf(fd, "\n");
+}
+
+} // namespace camera3
+} // namespace android
+// 个人修改结束
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#ifndef ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_PLACEHOLDER_H
+#define ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_PLACEHOLDER_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <utils/Errors.h>
+
+namespace android {
+namespace camera3 {
+
+/**
+ * 没有可用注入帧 (无信号) 时输出缓冲区的填充内容。
+ *
+ * 策略由 persist.camera.injection.no_signal 选择：
+ * - placeholder (默认)：占位画面。persist.camera.injection.placeholder_image 指向一个
+ *   原始 NV21 文件 (尺寸由 persist.camera.injection.placeholder_size 给出，如 "1280x720")
+ *   时显示该图像，否则为绿幕。
+ * - black：黑场。
+ * - hold：源断开后继续显示最后一帧；从未收到过帧时退回占位画面。
+ *
+ * 占位内容按目标几何 (宽、高、stride) 只渲染一次，得到与 gralloc 缓冲区布局完全相同的
+ * 模板 (Y 平面后紧跟 UV 平面)，逐帧只需一次 memcpy。模板以 shared_ptr 交给输出流，
+ * 输出流在几何不变时无需再访问这里。线程安全。
+ */
+class Camera3InjectionPlaceholder {
+  public:
+    static constexpr size_t kMaxTemplates = 4;
+
+    enum class Policy {
+        HOLD,
+        BLACK,
+        PLACEHOLDER,
+    };
+
+    // "hold" / "black" / "placeholder"，无法识别时返回 fallback
+    static Policy parsePolicy(const char* name, Policy fallback);
+    static const char* policyName(Policy policy);
+
+    struct Template {
+        uint32_t width;
+        uint32_t height;
+        uint32_t stride;
+        // 所有模板之间唯一，输出流据此判断缓冲区中是否已经是这份内容
+        uint64_t id;
+        std::vector<uint8_t> data;
+
+        bool matches(uint32_t w, uint32_t h, uint32_t s) const {
+            return width == w && height == h && stride == s;
+        }
+    };
+
+    // 读取上述属性；占位图像在第一次渲染模板时加载
+    Camera3InjectionPlaceholder();
+
+    Policy getPolicy() const { return mPolicy; }
+
+    // 取得 (必要时渲染) 该几何的模板；尺寸无效时返回 nullptr
+    std::shared_ptr<const Template> getTemplate(uint32_t width, uint32_t height,
+            uint32_t stride);
+
+    void dump(int fd);
+
+  private:
+    // 加载 mImagePath 指向的 NV21 图像；失败时退回绿幕
+    void loadImageLocked();
+    void renderLocked(Template* tmpl);
+
+    const Policy mPolicy;
+    const std::string mImagePath;
+    const std::string mImageSize;
+
+    std::mutex mLock;
+    bool mImageLoaded;
+    std::vector<uint8_t> mImage;
+    uint32_t mImageWidth;
+    uint32_t mImageHeight;
+    // 按最近使用排序，最近使用的在末尾
+    std::vector<std::shared_ptr<const Template>> mTemplates;
+    uint64_t mNextId;
+    uint64_t mRenders;
+};
+
+} // namespace camera3
+} // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_PLACEHOLDER_H
+// 个人修改结束
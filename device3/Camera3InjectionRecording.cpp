@@ -0,0 +1,340 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#define LOG_TAG "AIDOCK_CAM_DECODER"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <utils/Log.h>
+
+#include "Camera3InjectionRecording.h"
+
+namespace android {
+namespace camera3 {
+
+namespace {
+
+uint16_t readLe16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t readLe32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+            (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint64_t readLe64(const uint8_t* p) {
+    return static_cast<uint64_t>(readLe32(p)) | (static_cast<uint64_t>(readLe32(p + 4)) << 32);
+}
+
+void writeLe(uint64_t value, size_t bytes, uint8_t* p) {
+    for (size_t i = 0; i < bytes; i++) {
+        p[i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+// 读满 size 字节；返回实际读到的字节数，出错时返回 -1
+ssize_t readFully(int fd, uint8_t* data, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = read(fd, data + done, size - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return -1;
+        if (n == 0) break;
+        done += n;
+    }
+    return done;
+}
+
+} // namespace
+
+Camera3InjectionRecording::Writer::Writer() :
+        mFd(-1), mFirstTime(0), mLastOffset(0), mChunks(0), mBytes(0) {}
+
+Camera3InjectionRecording::Writer::~Writer() {
+    close();
+}
+
+status_t Camera3InjectionRecording::Writer::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+    if (fd < 0) {
+        int err = errno;
+        ALOGE("标记: 无法创建注入录制文件 %s: %s", path.c_str(), strerror(err));
+        return -err;
+    }
+    uint8_t header[kFileHeaderSize] = {};
+    memcpy(header, kMagic, sizeof(kMagic));
+    writeLe(kVersion, 2, header + 4);
+    writeLe(static_cast<uint64_t>(ns2us(systemTime(SYSTEM_TIME_REALTIME))), 8, header + 8);
+    if (write(fd, header, sizeof(header)) != static_cast<ssize_t>(sizeof(header))) {
+        ALOGE("标记: 无法写入注入录制文件头 %s: %s", path.c_str(), strerror(errno));
+        ::close(fd);
+        return UNKNOWN_ERROR;
+    }
+    mFd = fd;
+    mPath = path;
+    mFirstTime = 0;
+    mLastOffset = 0;
+    mChunks = 0;
+    mBytes = 0;
+    return OK;
+}
+
+void Camera3InjectionRecording::Writer::close() {
+    if (mFd >= 0) {
+        ::close(mFd);
+        mFd = -1;
+    }
+}
+
+status_t Camera3InjectionRecording::Writer::append(const uint8_t* data, size_t size,
+        nsecs_t receiveTime) {
+    if (mFd < 0) {
+        return NO_INIT;
+    }
+    if (size == 0) {
+        return OK;
+    }
+    if (size > kMaxChunkSize) {
+        return BAD_VALUE;
+    }
+    if (mChunks == 0) {
+        mFirstTime = receiveTime;
+    }
+    mLastOffset = std::max(mLastOffset, receiveTime - mFirstTime);
+
+    uint8_t header[kChunkHeaderSize];
+    writeLe(static_cast<uint64_t>(mLastOffset), 8, header);
+    writeLe(size, 4, header + 8);
+    struct iovec iov[2] = {
+            {header, sizeof(header)},
+            {const_cast<uint8_t*>(data), size},
+    };
+    size_t total = sizeof(header) + size;
+    ssize_t n;
+    do {
+        n = writev(mFd, iov, 2);
+    } while (n < 0 && errno == EINTR);
+    if (n != static_cast<ssize_t>(total)) {
+        // 文件系统写满等情况：不完整的块会被 Reader 识别为损坏，之后不再写入
+        ALOGE("标记: 注入录制写入失败 (%s)，停止录制 %s", n < 0 ? strerror(errno) : "部分写入",
+                mPath.c_str());
+        close();
+        return UNKNOWN_ERROR;
+    }
+    mChunks++;
+    mBytes += size;
+    return OK;
+}
+
+Camera3InjectionRecording::Reader::Reader() : mFd(-1), mCreatedRealtimeUs(0) {}
+
+Camera3InjectionRecording::Reader::~Reader() {
+    close();
+}
+
+status_t Camera3InjectionRecording::Reader::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        int err = errno;
+        ALOGE("标记: 无法打开注入录制文件 %s: %s", path.c_str(), strerror(err));
+        return -err;
+    }
+    uint8_t header[kFileHeaderSize];
+    if (readFully(fd, header, sizeof(header)) != static_cast<ssize_t>(sizeof(header)) ||
+            memcmp(header, kMagic, sizeof(kMagic)) != 0) {
+        ALOGE("标记: %s 不是注入录制文件", path.c_str());
+        ::close(fd);
+        return BAD_VALUE;
+    }
+    uint16_t version = readLe16(header + 4);
+    if (version != kVersion) {
+        ALOGE("标记: 不支持的注入录制文件版本 %u (%s)", version, path.c_str());
+        ::close(fd);
+        return BAD_VALUE;
+    }
+    mFd = fd;
+    mCreatedRealtimeUs = static_cast<int64_t>(readLe64(header + 8));
+    return OK;
+}
+
+void Camera3InjectionRecording::Reader::close() {
+    if (mFd >= 0) {
+        ::close(mFd);
+        mFd = -1;
+    }
+}
+
+status_t Camera3InjectionRecording::Reader::next(Chunk* chunk) {
+    if (mFd < 0) {
+        return NO_INIT;
+    }
+    uint8_t header[kChunkHeaderSize];
+    ssize_t n = readFully(mFd, header, sizeof(header));
+    if (n == 0) {
+        return NOT_ENOUGH_DATA;
+    }
+    if (n != static_cast<ssize_t>(sizeof(header))) {
+        return BAD_VALUE;
+    }
+    nsecs_t offset = static_cast<nsecs_t>(readLe64(header));
+    uint32_t size = readLe32(header + 8);
+    if (offset < 0 || size == 0 || size > kMaxChunkSize) {
+        return BAD_VALUE;
+    }
+    chunk->offset = offset;
+    chunk->data.resize(size);
+    if (readFully(mFd, chunk->data.data(), size) != static_cast<ssize_t>(size)) {
+        return BAD_VALUE;
+    }
+    return OK;
+}
+
+status_t Camera3InjectionRecording::Reader::rewind() {
+    if (mFd < 0) {
+        return NO_INIT;
+    }
+    if (lseek(mFd, kFileHeaderSize, SEEK_SET) < 0) {
+        return -errno;
+    }
+    return OK;
+}
+
+bool Camera3InjectionRecording::Player::parseSpeed(const char* name, double* speed) {
+    if (name == nullptr) {
+        return false;
+    }
+    if (strcmp(name, "original") == 0) {
+        *speed = 1;
+        return true;
+    }
+    if (strcmp(name, "max") == 0) {
+        *speed = kMaxRate;
+        return true;
+    }
+    char* end = nullptr;
+    double value = strtod(name, &end);
+    if (end == name || value <= 0) {
+        return false;
+    }
+    if (*end == 'x') {
+        end++;
+    }
+    if (*end != '\0') {
+        return false;
+    }
+    *speed = value;
+    return true;
+}
+
+nsecs_t Camera3InjectionRecording::Player::scheduleTime(nsecs_t start, nsecs_t offset,
+        double speed) {
+    if (speed <= kMaxRate) {
+        return start;
+    }
+    return start + static_cast<nsecs_t>(offset / speed);
+}
+
+Camera3InjectionRecording::Player::Player(double speed) : mSpeed(speed) {}
+
+status_t Camera3InjectionRecording::Player::play(Reader& reader, int fd,
+        const SentCallback& onSent, Stats* stats) {
+    nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+    Chunk chunk;
+    status_t res;
+    size_t index = 0;
+    while ((res = reader.next(&chunk)) == OK) {
+        nsecs_t due = scheduleTime(start, chunk.offset, mSpeed);
+        nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+        if (due > now) {
+            usleep(ns2us(due - now));
+        } else {
+            stats->maxLateness = std::max(stats->maxLateness, now - due);
+        }
+        res = writeAll(fd, chunk.data.data(), chunk.data.size(), stats);
+        if (res != OK) {
+            return res;
+        }
+        nsecs_t sentTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        stats->chunks++;
+        stats->bytes += chunk.data.size();
+        if (onSent) {
+            onSent(index, sentTime);
+        }
+        index++;
+    }
+    stats->duration += systemTime(SYSTEM_TIME_MONOTONIC) - start;
+    drainReplies(fd, stats);
+    return res == NOT_ENOUGH_DATA ? OK : res;
+}
+
+status_t Camera3InjectionRecording::Player::writeAll(int fd, const uint8_t* data, size_t size,
+        Stats* stats) {
+    size_t done = 0;
+    while (done < size) {
+        // 服务端的回复可能填满本端的接收缓冲区，可写之前先把它读走
+        struct pollfd pfd = {fd, POLLIN | POLLOUT, 0};
+        if (poll(&pfd, 1, -1) < 0) {
+            if (errno == EINTR) continue;
+            return -errno;
+        }
+        if (pfd.revents & POLLIN) {
+            drainReplies(fd, stats);
+        }
+        if (pfd.revents & (POLLERR | POLLNVAL)) {
+            return DEAD_OBJECT;
+        }
+        if (!(pfd.revents & POLLOUT)) {
+            if (pfd.revents & POLLHUP) return DEAD_OBJECT;
+            continue;
+        }
+        ssize_t n = send(fd, data + done, size - done, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0 && errno == ENOTSOCK) {
+            n = write(fd, data + done, size - done);
+        }
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            return errno == EPIPE ? DEAD_OBJECT : -errno;
+        }
+        done += n;
+    }
+    return OK;
+}
+
+void Camera3InjectionRecording::Player::drainReplies(int fd, Stats* stats) {
+    uint8_t reply[256];
+    while (true) {
+        ssize_t n = recv(fd, reply, sizeof(reply), MSG_DONTWAIT);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+        stats->bytesReceived += n;
+    }
+}
+
+} // namespace camera3
+} // namespace android
+// 个人修改结束
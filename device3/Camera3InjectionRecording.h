@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#ifndef ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_RECORDING_H
+#define ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_RECORDING_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <utils/Errors.h>
+#include <utils/Timers.h>
+
+namespace android {
+namespace camera3 {
+
+/**
+ * 注入 socket 的录制与回放。
+ *
+ * Camera3SocketServer 可以把客户端发来的字节流原样录制到文件 (每次 recv 一块，附带接收时间)，
+ * 之后由本机的替身客户端 (camera_injection_replay) 按原始节奏、加速或尽快地重新写入 socket，
+ * 不再需要真实的发送端就能复现和测量注入管线。
+ *
+ * 文件格式 (所有多字节字段均为小端序)：
+ *
+ *   文件头: magic "AIDR" | u16 version | u16 reserved | i64 createdRealtimeUs
+ *   数据块: i64 offsetNs | u32 size | size 字节的数据
+ *
+ * offsetNs 为该块的接收时间相对第一块的偏移 (CLOCK_MONOTONIC)。
+ * 共享内存模式 (kFlagSharedMemory) 随 SCM_RIGHTS 传递的 fd 无法录制，只记录字节流。
+ */
+class Camera3InjectionRecording {
+  public:
+    static constexpr uint8_t kMagic[4] = {'A', 'I', 'D', 'R'};
+    static constexpr uint16_t kVersion = 1;
+    static constexpr size_t kFileHeaderSize = 16;
+    static constexpr size_t kChunkHeaderSize = 12;
+    // 单块上限，超过时认为文件已损坏
+    static constexpr size_t kMaxChunkSize = 16 * 1024 * 1024;
+
+    struct Chunk {
+        nsecs_t offset = 0;
+        std::vector<uint8_t> data;
+    };
+
+    /**
+     * 录制端：每次 append 以一次 writev 写入文件。
+     * 写入失败后不再写入，由调用者在 append 返回错误时关闭。非线程安全。
+     */
+    class Writer {
+      public:
+        Writer();
+        ~Writer();
+
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        // 创建 (或截断) path 并写入文件头
+        status_t open(const std::string& path);
+        void close();
+        bool isOpen() const { return mFd >= 0; }
+
+        // receiveTime 为 CLOCK_MONOTONIC；早于上一块时按上一块的时间记录
+        status_t append(const uint8_t* data, size_t size, nsecs_t receiveTime);
+
+        const std::string& getPath() const { return mPath; }
+        uint64_t getChunks() const { return mChunks; }
+        uint64_t getBytes() const { return mBytes; }
+
+      private:
+        int mFd;
+        std::string mPath;
+        nsecs_t mFirstTime;
+        nsecs_t mLastOffset;
+        uint64_t mChunks;
+        uint64_t mBytes;
+    };
+
+    /**
+     * 读取端：按顺序逐块读出。非线程安全。
+     */
+    class Reader {
+      public:
+        Reader();
+        ~Reader();
+
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        // 打开并校验文件头；不是录制文件或版本不支持时返回 BAD_VALUE
+        status_t open(const std::string& path);
+        void close();
+
+        // 读出下一块；文件结束时返回 NOT_ENOUGH_DATA，块不完整或已损坏时返回 BAD_VALUE
+        status_t next(Chunk* chunk);
+
+        // 回到第一块，用于循环回放
+        status_t rewind();
+
+        int64_t getCreatedRealtimeUs() const { return mCreatedRealtimeUs; }
+
+      private:
+        int mFd;
+        int64_t mCreatedRealtimeUs;
+    };
+
+    /**
+     * 回放端：把块依次写入 fd (通常是已连接到注入 socket 的客户端)。
+     *
+     * 每块的发送时间为 start + offsetNs / speed；speed 为 kMaxRate 时不等待，尽快发送。
+     * 写入之间顺带读走服务端的回复 (分帧协议的 ack)，避免回放的客户端被自己的接收缓冲区卡住。
+     */
+    class Player {
+      public:
+        static constexpr double kMaxRate = 0;
+
+        struct Stats {
+            uint64_t chunks = 0;
+            uint64_t bytes = 0;
+            // 从服务端读到的字节数
+            uint64_t bytesReceived = 0;
+            // 实际发送时间晚于计划时间的最大值
+            nsecs_t maxLateness = 0;
+            nsecs_t duration = 0;
+        };
+
+        // 每块写完后调用：块的序号 (从 0 开始) 与写完的时间 (CLOCK_MONOTONIC)
+        using SentCallback = std::function<void(size_t index, nsecs_t sentTime)>;
+
+        // "original" (1 倍)、"max" (kMaxRate)，或 "2x"、"0.5" 这样的倍速；无法识别时返回 false
+        static bool parseSpeed(const char* name, double* speed);
+
+        // 录制偏移为 offset 的块在 speed 倍速下的计划发送时间
+        static nsecs_t scheduleTime(nsecs_t start, nsecs_t offset, double speed);
+
+        explicit Player(double speed);
+
+        // 把 reader 中剩余的块全部写入 fd (阻塞)，统计累加到 *stats
+        status_t play(Reader& reader, int fd, const SentCallback& onSent, Stats* stats);
+
+      private:
+        status_t writeAll(int fd, const uint8_t* data, size_t size, Stats* stats);
+        void drainReplies(int fd, Stats* stats);
+
+        const double mSpeed;
+    };
+};
+
+} // namespace camera3
+} // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_RECORDING_H
+// 个人修改结束
@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#define LOG_TAG "AIDOCK_CAM_INJECT"
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <utils/Log.h>
+
+#include "Camera3InjectionRenderCache.h"
+
+namespace android {
+namespace camera3 {
+
+Camera3InjectionRenderCache::Camera3InjectionRenderCache(size_t maxEntries) :
+        mMaxEntries(maxEntries > 0 ? maxEntries : 1),
+        mUseCounter(0),
+        mHits(0),
+        mMisses(0),
+        mDirect(0),
+        mWaits(0),
+        mEvictions(0) {
+}
+
+size_t Camera3InjectionRenderCache::planeSizeY(const Camera3InjectionTransform::Key& key) {
+    return static_cast<size_t>(key.dstStride) * key.dstHeight;
+}
+
+size_t Camera3InjectionRenderCache::planeSizeUV(const Camera3InjectionTransform::Key& key) {
+    return static_cast<size_t>(key.dstStride) * ((key.dstHeight + 1) / 2);
+}
+
+Camera3InjectionRenderCache::Entry* Camera3InjectionRenderCache::findOrCreateLocked(
+        const Camera3InjectionTransform::Key& key) {
+    for (auto& entry : mEntries) {
+        if (entry->key == key) {
+            return entry.get();
+        }
+    }
+
+    if (mEntries.size() >= mMaxEntries) {
+        // 淘汰最久未使用且不在渲染中的结果
+        auto victim = mEntries.end();
+        for (auto it = mEntries.begin(); it != mEntries.end(); it++) {
+            if ((*it)->busy()) continue;
+            if (victim == mEntries.end() || (*it)->lastUse < (*victim)->lastUse) {
+                victim = it;
+            }
+        }
+        if (victim != mEntries.end()) {
+            mEntries.erase(victim);
+            mEvictions++;
+        }
+    }
+
+    mEntries.push_back(std::make_unique<Entry>());
+    Entry* entry = mEntries.back().get();
+    entry->key = key;
+    return entry;
+}
+
+bool Camera3InjectionRenderCache::trackUserLocked(Entry* entry, const void* user,
+        uint64_t frameSequence) {
+    if (frameSequence != entry->recentFrames[0] && frameSequence != entry->recentFrames[1]) {
+        entry->recentFrames[1] = entry->recentFrames[0];
+        entry->recentFrames[0] = frameSequence;
+    }
+    bool found = false;
+    for (auto it = entry->users.begin(); it != entry->users.end();) {
+        if (it->first == user) {
+            it->second = frameSequence;
+            found = true;
+        }
+        // 两帧内没有请求过的流 (已经删除或改了几何) 不再算作共享者
+        if (it->second != entry->recentFrames[0] && it->second != entry->recentFrames[1]) {
+            it = entry->users.erase(it);
+        } else {
+            it++;
+        }
+    }
+    if (!found) {
+        entry->users.emplace_back(user, frameSequence);
+    }
+    return entry->users.size() > 1;
+}
+
+status_t Camera3InjectionRenderCache::render(uint64_t frameSequence,
+        const Camera3InjectionTransform::Key& key, const void* user, uint8_t* dstY,
+        uint8_t* dstUV, const RenderFunc& render, Outcome* outcome) {
+    if (outcome != nullptr) {
+        *outcome = Outcome::RENDERED;
+    }
+    if (dstY == nullptr || dstUV == nullptr || key.dstStride <= 0 || key.dstHeight <= 0) {
+        return BAD_VALUE;
+    }
+    size_t sizeY = planeSizeY(key);
+    size_t sizeUV = planeSizeUV(key);
+
+    std::unique_lock<std::mutex> l(mLock);
+    Entry* entry = findOrCreateLocked(key);
+    entry->lastUse = ++mUseCounter;
+    bool shared = trackUserLocked(entry, user, frameSequence);
+
+    // 其他流正在渲染同一帧时等待其完成，而不是重复计算
+    if (entry->rendering && entry->frameSequence == frameSequence) {
+        mWaits++;
+        entry->waiters++;
+        mRenderDone.wait(l, [entry, frameSequence]() {
+            return !entry->rendering || entry->frameSequence != frameSequence;
+        });
+        entry->waiters--;
+    }
+
+    if (entry->ready && entry->frameSequence == frameSequence) {
+        // 持有结果的引用后在锁外拷贝；下一帧渲染时会改用新的缓冲区
+        std::shared_ptr<std::vector<uint8_t>> data = entry->data;
+        mHits++;
+        l.unlock();
+        memcpy(dstY, data->data(), sizeY);
+        memcpy(dstUV, data->data() + sizeY, sizeUV);
+        if (outcome != nullptr) {
+            *outcome = Outcome::HIT;
+        }
+        return OK;
+    }
+
+    if (!shared) {
+        // 没有其他流会读取这个结果，不必经过缓存
+        mDirect++;
+        l.unlock();
+        return render(dstY, dstUV);
+    }
+
+    if (entry->rendering) {
+        // 另一个流正在渲染其他帧，不抢占它的缓冲区，直接渲染到目标
+        mMisses++;
+        l.unlock();
+        return render(dstY, dstUV);
+    }
+
+    // 结果缓冲区仍被其他流拷贝时另行分配，否则原地复用
+    if (entry->data == nullptr || entry->data.use_count() > 1) {
+        entry->data = std::make_shared<std::vector<uint8_t>>(sizeY + sizeUV);
+    }
+    std::shared_ptr<std::vector<uint8_t>> data = entry->data;
+    entry->frameSequence = frameSequence;
+    entry->ready = false;
+    entry->rendering = true;
+    mMisses++;
+    l.unlock();
+
+    status_t res = render(data->data(), data->data() + sizeY);
+    if (res == OK) {
+        memcpy(dstY, data->data(), sizeY);
+        memcpy(dstUV, data->data() + sizeY, sizeUV);
+        if (outcome != nullptr) {
+            *outcome = Outcome::RENDERED_AND_CACHED;
+        }
+    }
+
+    l.lock();
+    entry->rendering = false;
+    entry->ready = (res == OK);
+    l.unlock();
+    mRenderDone.notify_all();
+    return res;
+}
+
+void Camera3InjectionRenderCache::clear() {
+    std::lock_guard<std::mutex> l(mLock);
+    for (auto it = mEntries.begin(); it != mEntries.end();) {
+        if ((*it)->busy()) {
+            it++;
+        } else {
+            it = mEntries.erase(it);
+        }
+    }
+}
+
+void Camera3InjectionRenderCache::dump(int fd) const {
+    std::lock_guard<std::mutex> l(mLock);
+    dprintf(fd, "  Render cache: %zu/%zu entries, %" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64
+            " rendered directly (single stream), %" PRIu64 " waits, %" PRIu64 " evictions\n",
+            mEntries.size(), mMaxEntries, mHits, mMisses, mDirect, mWaits, mEvictions);
+    for (const auto& entry : mEntries) {
+        dprintf(fd, "    %dx%d stride %d transform %d: frame %" PRIu64 "%s, %zu streams\n",
+                entry->key.dstWidth, entry->key.dstHeight, entry->key.dstStride,
+                entry->key.transform, entry->frameSequence, entry->ready ? "" : " (not ready)",
+                entry->users.size());
+    }
+}
+
+} // namespace camera3
+} // namespace android
+// 个人修改结束
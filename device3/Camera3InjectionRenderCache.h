@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#ifndef ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_RENDER_CACHE_H
+#define ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_RENDER_CACHE_H
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <utils/Errors.h>
+
+#include "Camera3InjectionTransform.h"
+
+namespace android {
+namespace camera3 {
+
+/**
+ * 注入帧渲染结果的备忘缓存，按 (帧序号, 目标几何 + transform) 索引。
+ *
+ * 同一会话中多个尺寸/stride/transform 相同的输出流 (例如预览和同尺寸的 ImageReader)
+ * 对同一帧只做一次旋转 + 缩放：第一个需要该结果的流渲染进缓存，其余的流直接拷贝缓存结果。
+ * 多个流同时请求同一结果时，后到的流等待正在进行的渲染完成，而不是重复计算。
+ *
+ * 经过缓存要多一次整帧拷贝，因此只有最近两帧内有另一个流使用同一几何时才填充缓存；
+ * 只有一个流使用某个几何时 (最常见的情况) 直接渲染进目标缓冲区。
+ */
+class Camera3InjectionRenderCache {
+  public:
+    static constexpr size_t kDefaultMaxEntries = 4;
+
+    // 把一帧渲染到给定的 Y/UV 平面 (布局与 key 的目标尺寸和 stride 一致)
+    using RenderFunc = std::function<status_t(uint8_t* dstY, uint8_t* dstUV)>;
+
+    // 一次 render() 的结果是怎样得到的
+    enum class Outcome {
+        // 直接渲染进目标
+        RENDERED,
+        // 渲染进缓存，再拷贝到目标
+        RENDERED_AND_CACHED,
+        // 从缓存拷贝
+        HIT,
+    };
+
+    explicit Camera3InjectionRenderCache(size_t maxEntries = kDefaultMaxEntries);
+
+    // 将 (frameSequence, key) 的结果写入 dstY/dstUV。user 标识调用的输出流，
+    // 用于判断同一几何是否有多个流在使用。需要渲染时调用 render 一次。
+    // *outcome 可为 nullptr。
+    status_t render(uint64_t frameSequence, const Camera3InjectionTransform::Key& key,
+            const void* user, uint8_t* dstY, uint8_t* dstUV, const RenderFunc& render,
+            Outcome* outcome);
+
+    // 清空所有缓存结果 (例如源断开时)
+    void clear();
+
+    void dump(int fd) const;
+
+  private:
+    struct Entry {
+        Camera3InjectionTransform::Key key;
+        uint64_t frameSequence = 0;
+        // 渲染结果：Y 平面后紧跟 UV 平面，正在被拷贝时不会被覆盖
+        std::shared_ptr<std::vector<uint8_t>> data;
+        bool ready = false;
+        bool rendering = false;
+        // 正在等待渲染完成的流数量；有等待者时不能淘汰
+        int waiters = 0;
+        uint64_t lastUse = 0;
+        // 该几何最近请求过的两个帧序号，以及在这两帧内请求过的流和各自最后请求的帧
+        uint64_t recentFrames[2] = {0, 0};
+        std::vector<std::pair<const void*, uint64_t>> users;
+
+        bool busy() const { return rendering || waiters > 0; }
+    };
+
+    static size_t planeSizeY(const Camera3InjectionTransform::Key& key);
+    static size_t planeSizeUV(const Camera3InjectionTransform::Key& key);
+
+    Entry* findOrCreateLocked(const Camera3InjectionTransform::Key& key);
+    // 记录 user 请求了 frameSequence；返回最近两帧内是否还有其他流使用该几何
+    static bool trackUserLocked(Entry* entry, const void* user, uint64_t frameSequence);
+
+    mutable std::mutex mLock;
+    std::condition_variable mRenderDone;
+    const size_t mMaxEntries;
+    std::vector<std::unique_ptr<Entry>> mEntries;
+    uint64_t mUseCounter;
+
+    uint64_t mHits;
+    uint64_t mMisses;
+    uint64_t mDirect;
+    uint64_t mWaits;
+    uint64_t mEvictions;
+};
+
+} // namespace camera3
+} // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_RENDER_CACHE_H
+// 个人修改结束
@@ -0,0 +1,291 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#define LOG_TAG "AIDOCK_CAM_DECODER"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <new>
+
+#include <utils/Log.h>
+
+#include "Camera3InjectionShmRing.h"
+
+namespace android {
+namespace camera3 {
+
+namespace {
+
+constexpr size_t kPageSize = 4096;
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+size_t Camera3InjectionShmRing::frameSize(const Layout& layout) {
+    size_t lastPlane = layout.format == kFormatI420 ? layout.chroma2Offset : layout.chromaOffset;
+    return lastPlane + static_cast<size_t>(layout.chromaStride) * (layout.height / 2);
+}
+
+Camera3InjectionShmRing::Layout Camera3InjectionShmRing::resolvePlanes(Layout layout) {
+    bool planar = layout.format == kFormatI420;
+    if (layout.chromaStride == 0) {
+        layout.chromaStride = planar ? (layout.stride + 1) / 2 : layout.stride;
+    }
+    if (layout.chromaOffset == 0) {
+        layout.chromaOffset = layout.stride * layout.height;
+    }
+    if (planar && layout.chroma2Offset == 0) {
+        layout.chroma2Offset = layout.chromaOffset + layout.chromaStride * (layout.height / 2);
+    }
+    return layout;
+}
+
+bool Camera3InjectionShmRing::isValidLayout(const Layout& layout) {
+    bool planar;
+    switch (layout.format) {
+        case kFormatNv21:
+        case kFormatNv12:
+            planar = false;
+            break;
+        case kFormatI420:
+            planar = true;
+            break;
+        default:
+            return false;
+    }
+    if (layout.width == 0 || layout.height == 0 || layout.width > kMaxDimension ||
+            layout.height > kMaxDimension || layout.width % 2 != 0 || layout.height % 2 != 0 ||
+            layout.stride < layout.width || layout.stride > kMaxDimension ||
+            layout.slotCount == 0 || layout.slotCount > kMaxSlots) {
+        return false;
+    }
+    // 色度平面在 Y 平面之后且互不重叠；偏移有上限，槽位大小不会溢出
+    size_t chromaPlaneSize = static_cast<size_t>(layout.chromaStride) * (layout.height / 2);
+    size_t maxOffset = static_cast<size_t>(kMaxDimension) * kMaxDimension * 2;
+    return layout.chromaStride >= (planar ? layout.width / 2 : layout.width) &&
+            layout.chromaStride <= kMaxDimension &&
+            layout.chromaOffset >= static_cast<size_t>(layout.stride) * layout.height &&
+            layout.chromaOffset <= maxOffset &&
+            (!planar || (layout.chroma2Offset >= layout.chromaOffset + chromaPlaneSize &&
+                    layout.chroma2Offset <= maxOffset));
+}
+
+status_t Camera3InjectionShmRing::computeOffsets(const Layout& layout, uint32_t* slotSize,
+        uint32_t* dataOffset, size_t* totalSize) {
+    if (!isValidLayout(layout)) {
+        return BAD_VALUE;
+    }
+    *slotSize = alignUp(frameSize(layout), kPageSize);
+    *dataOffset = alignUp(sizeof(ShmHeader), kPageSize);
+    *totalSize = *dataOffset + static_cast<size_t>(*slotSize) * layout.slotCount;
+    return OK;
+}
+
+std::shared_ptr<Camera3InjectionShmRing> Camera3InjectionShmRing::create(
+        const Layout& requested, int* fd) {
+    *fd = -1;
+    uint32_t slotSize;
+    uint32_t dataOffset;
+    size_t totalSize;
+    const Layout layout = resolvePlanes(requested);
+    if (computeOffsets(layout, &slotSize, &dataOffset, &totalSize) != OK) {
+        ALOGE("标记: 共享内存环参数无效 (%ux%u, stride %u, %u 个槽位)", layout.width,
+                layout.height, layout.stride, layout.slotCount);
+        return nullptr;
+    }
+    int memfd = memfd_create("aidock_cam_yuv", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (memfd < 0) {
+        ALOGE("标记: memfd_create 失败: %s", strerror(errno));
+        return nullptr;
+    }
+    if (ftruncate(memfd, totalSize) != 0 ||
+            fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0) {
+        ALOGE("标记: 无法设置共享内存大小或封印: %s", strerror(errno));
+        close(memfd);
+        return nullptr;
+    }
+    void* base = mmap(nullptr, totalSize, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (base == MAP_FAILED) {
+        ALOGE("标记: 共享内存映射失败: %s", strerror(errno));
+        close(memfd);
+        return nullptr;
+    }
+
+    ShmHeader* header = new (base) ShmHeader{};
+    header->magic = kMagic;
+    header->version = kVersion;
+    header->format = layout.format;
+    header->width = layout.width;
+    header->height = layout.height;
+    header->stride = layout.stride;
+    header->slotCount = layout.slotCount;
+    header->chromaStride = layout.chromaStride;
+    header->chromaOffset = layout.chromaOffset;
+    header->chroma2Offset = layout.chroma2Offset;
+    header->slotSize = slotSize;
+    header->dataOffset = dataOffset;
+    header->latestSlot.store(kNoSlot, std::memory_order_release);
+
+    *fd = memfd;
+    return std::shared_ptr<Camera3InjectionShmRing>(new Camera3InjectionShmRing(
+            static_cast<uint8_t*>(base), totalSize, layout, slotSize, dataOffset));
+}
+
+std::shared_ptr<Camera3InjectionShmRing> Camera3InjectionShmRing::attach(int fd,
+        status_t* res) {
+    *res = BAD_VALUE;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(ShmHeader))) {
+        ALOGE("标记: 共享内存 fd 无效或过小");
+        return nullptr;
+    }
+    int seals = fcntl(fd, F_GET_SEALS);
+    if (seals < 0 || (seals & F_SEAL_SHRINK) == 0) {
+        ALOGE("标记: 共享内存缺少 F_SEAL_SHRINK 封印，拒绝映射");
+        return nullptr;
+    }
+    size_t mappedSize = st.st_size;
+    void* base = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        ALOGE("标记: 共享内存映射失败: %s", strerror(errno));
+        *res = NO_MEMORY;
+        return nullptr;
+    }
+
+    // 只读取一次布局参数，之后使用校验过的副本
+    const ShmHeader* header = static_cast<const ShmHeader*>(base);
+    Layout layout;
+    layout.format = static_cast<Format>(header->format);
+    layout.width = header->width;
+    layout.height = header->height;
+    layout.stride = header->stride;
+    layout.slotCount = header->slotCount;
+    layout.chromaStride = header->chromaStride;
+    layout.chromaOffset = header->chromaOffset;
+    layout.chroma2Offset = header->chroma2Offset;
+    layout = resolvePlanes(layout);
+    uint32_t magic = header->magic;
+    uint16_t version = header->version;
+    uint32_t headerSlotSize = header->slotSize;
+    uint32_t headerDataOffset = header->dataOffset;
+
+    uint32_t slotSize;
+    uint32_t dataOffset;
+    size_t totalSize;
+    // 版本 1 的头部没有色度参数，对应位置为 0，按紧密排列推算即是版本 1 的布局
+    if (magic != kMagic || (version != 1 && version != kVersion) ||
+            computeOffsets(layout, &slotSize, &dataOffset, &totalSize) != OK ||
+            headerSlotSize != slotSize || headerDataOffset != dataOffset ||
+            totalSize > mappedSize) {
+        ALOGE("标记: 共享内存环头部无效 (magic 0x%08x, 版本 %u, %ux%u, stride %u, "
+                "%u 个槽位)", magic, version, layout.width, layout.height, layout.stride,
+                layout.slotCount);
+        munmap(base, mappedSize);
+        return nullptr;
+    }
+
+    *res = OK;
+    ALOGI("标记: 已映射共享内存环: 格式 %u, %ux%u, stride %u (色度 %u, 偏移 %u/%u), "
+            "%u 个槽位", layout.format, layout.width, layout.height, layout.stride,
+            layout.chromaStride, layout.chromaOffset, layout.chroma2Offset, layout.slotCount);
+    return std::shared_ptr<Camera3InjectionShmRing>(new Camera3InjectionShmRing(
+            static_cast<uint8_t*>(base), mappedSize, layout, slotSize, dataOffset));
+}
+
+Camera3InjectionShmRing::Camera3InjectionShmRing(uint8_t* base, size_t mappedSize,
+        const Layout& layout, uint32_t slotSize, uint32_t dataOffset) :
+        mBase(base),
+        mMappedSize(mappedSize),
+        mLayout(layout),
+        mSlotSize(slotSize),
+        mDataOffset(dataOffset) {
+}
+
+Camera3InjectionShmRing::~Camera3InjectionShmRing() {
+    munmap(mBase, mMappedSize);
+}
+
+status_t Camera3InjectionShmRing::acquireLatest(uint64_t afterSequence, Frame* frame) {
+    uint32_t slot = header()->latestSlot.load(std::memory_order_acquire);
+    if (slot >= mLayout.slotCount) {
+        return NOT_ENOUGH_DATA;
+    }
+    SlotHeader& slotHeader = header()->slots[slot];
+    uint32_t state = slotHeader.state.fetch_add(1, std::memory_order_acquire);
+    if (state & kWriterBit) {
+        // 读取 latestSlot 之后生产者已经发布了新帧，并开始改写这个槽位
+        releaseSlot(slot);
+        return WOULD_BLOCK;
+    }
+    uint64_t sequence = slotHeader.sequence.load(std::memory_order_acquire);
+    if (sequence <= afterSequence) {
+        releaseSlot(slot);
+        return NOT_ENOUGH_DATA;
+    }
+
+    frame->data = slotData(slot);
+    frame->size = frameSize(mLayout);
+    frame->sequence = sequence;
+    frame->captureTimeUs = slotHeader.captureTimeUs;
+    std::shared_ptr<Camera3InjectionShmRing> self = shared_from_this();
+    frame->hold = std::shared_ptr<const void>(frame->data,
+            [self, slot](const void*) { self->releaseSlot(slot); });
+    return OK;
+}
+
+void Camera3InjectionShmRing::releaseSlot(uint32_t slot) {
+    header()->slots[slot].state.fetch_sub(1, std::memory_order_release);
+}
+
+uint8_t* Camera3InjectionShmRing::beginWrite(uint32_t* slot) {
+    uint32_t latest = header()->latestSlot.load(std::memory_order_relaxed);
+    for (uint32_t i = 1; i <= mLayout.slotCount; i++) {
+        uint32_t candidate = (latest == kNoSlot) ? i - 1 : (latest + i) % mLayout.slotCount;
+        if (candidate == latest) {
+            continue;
+        }
+        uint32_t expected = 0;
+        if (header()->slots[candidate].state.compare_exchange_strong(expected, kWriterBit,
+                std::memory_order_acquire)) {
+            *slot = candidate;
+            return slotData(candidate);
+        }
+    }
+    return nullptr;
+}
+
+uint64_t Camera3InjectionShmRing::publish(uint32_t slot, int64_t captureTimeUs) {
+    SlotHeader& slotHeader = header()->slots[slot];
+    uint64_t sequence = header()->latestSequence.load(std::memory_order_relaxed) + 1;
+    slotHeader.captureTimeUs = captureTimeUs;
+    slotHeader.sequence.store(sequence, std::memory_order_relaxed);
+    slotHeader.state.fetch_and(~kWriterBit, std::memory_order_release);
+    header()->latestSequence.store(sequence, std::memory_order_relaxed);
+    header()->latestSlot.store(slot, std::memory_order_release);
+    return sequence;
+}
+
+} // namespace camera3
+} // namespace android
+// 个人修改结束
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#ifndef ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_SHM_RING_H
+#define ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_SHM_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+
+#include <utils/Errors.h>
+
+namespace android {
+namespace camera3 {
+
+/**
+ * 未压缩 YUV 帧的共享内存环，供本机的生产者绕过 H.264 编解码直接注入。
+ *
+ * 生产者用 memfd 创建该环 (create())，通过注入 socket 把 memfd 和一个 eventfd 门铃
+ * 传给服务端 (见 Camera3InjectionStreamReader::kFlagSharedMemory)，服务端 attach() 后
+ * 每次门铃响起时取最新发布的槽位。
+ *
+ * 内存布局 (ShmHeader 位于偏移 0，槽位 i 的像素位于 dataOffset + i * slotSize)：
+ *
+ *   - 每个槽位的 state：kWriterBit 表示生产者正在写入，低位为服务端持有该槽位的引用数。
+ *     生产者只能用 CAS 把 state 从 0 改为 kWriterBit 来占用槽位；服务端在 state 带有
+ *     kWriterBit 时不读取。服务端持有的槽位 (例如正在合成的帧) 不会被覆盖，因此像素不需要拷贝。
+ *   - latestSlot / latestSequence 指向最近发布的槽位。
+ *
+ * 服务端最多同时持有帧环 (persist.camera.injection.frame_ring_size) 中的帧加上正在合成的帧，
+ * 生产者的槽位数应至少为帧环大小加 3，否则 beginWrite() 可能暂时找不到空闲槽位。
+ *
+ * 色度平面的行跨度和偏移由生产者写在头部 (版本 2)，单独对齐或填充色度平面的生产者
+ * 照实填写即可；为 0 时按紧密排列推算。
+ *
+ * 布局参数在 attach() 时校验并拷贝一份，之后不再信任共享内存中的值；memfd 必须带有
+ * F_SEAL_SHRINK，防止映射后被截断。
+ */
+class Camera3InjectionShmRing : public std::enable_shared_from_this<Camera3InjectionShmRing> {
+  public:
+    static constexpr uint32_t kMagic = 0x59444941; // "AIDY"
+    // 版本 2 增加了色度平面的行跨度和偏移
+    static constexpr uint16_t kVersion = 2;
+    static constexpr uint32_t kMaxSlots = 16;
+    static constexpr uint32_t kMaxDimension = 8192;
+    static constexpr uint32_t kNoSlot = 0xFFFFFFFF;
+    static constexpr uint32_t kWriterBit = 0x80000000;
+
+    enum Format : uint16_t {
+        // 半平面 VU 交错，与解码器输出的帧相同，可零拷贝
+        kFormatNv21 = 1,
+        // 半平面 UV 交错
+        kFormatNv12 = 2,
+        // 三平面 Y/U/V，V 平面位于 U 平面之后
+        kFormatI420 = 3,
+    };
+
+    struct SlotHeader {
+        std::atomic<uint32_t> state;
+        uint32_t reserved;
+        std::atomic<uint64_t> sequence;
+        // 生产者在 hello 中声明的时钟
+        int64_t captureTimeUs;
+    };
+
+    struct ShmHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t format;
+        uint32_t width;
+        uint32_t height;
+        uint32_t stride;
+        uint32_t slotCount;
+        uint32_t slotSize;
+        uint32_t dataOffset;
+        std::atomic<uint32_t> latestSlot;
+        uint32_t reserved;
+        std::atomic<uint64_t> latestSequence;
+        SlotHeader slots[kMaxSlots];
+        // 见 Layout
+        uint32_t chromaStride;
+        uint32_t chromaOffset;
+        uint32_t chroma2Offset;
+        uint32_t reserved2;
+    };
+
+    static_assert(std::atomic<uint32_t>::is_always_lock_free &&
+            std::atomic<uint64_t>::is_always_lock_free,
+            "shared memory atomics must be lock-free");
+
+    struct Layout {
+        Format format;
+        uint32_t width;
+        uint32_t height;
+        uint32_t stride;
+        uint32_t slotCount;
+        // 色度平面的行跨度，及其相对槽位起点的偏移 (I420 为 U 平面)；0 表示按紧密排列推算：
+        // 半平面格式行跨度为 stride，I420 为 (stride + 1) / 2，色度紧跟 Y 平面
+        uint32_t chromaStride = 0;
+        uint32_t chromaOffset = 0;
+        // I420 的 V 平面偏移，0 表示紧跟 U 平面；其他格式不使用
+        uint32_t chroma2Offset = 0;
+    };
+
+    struct Frame {
+        // 槽位的像素，在 hold 释放之前有效
+        const uint8_t* data;
+        size_t size;
+        uint64_t sequence;
+        int64_t captureTimeUs;
+        // 最后一个引用释放时归还槽位
+        std::shared_ptr<const void> hold;
+    };
+
+    // 一帧的字节数 (到最后一个色度平面的末尾)；layout 的色度参数需已推算 (见 getLayout())
+    static size_t frameSize(const Layout& layout);
+
+    // 生产者：创建带封印的 memfd 并初始化布局；*fd 由调用者关闭
+    static std::shared_ptr<Camera3InjectionShmRing> create(const Layout& requested, int* fd);
+
+    // 服务端：映射客户端传来的 memfd；fd 仍由调用者关闭
+    static std::shared_ptr<Camera3InjectionShmRing> attach(int fd, status_t* res);
+
+    ~Camera3InjectionShmRing();
+
+    // 色度参数已推算为实际值
+    const Layout& getLayout() const { return mLayout; }
+
+    // 服务端：取得序号大于 afterSequence 的最新一帧。没有新帧时返回 NOT_ENOUGH_DATA，
+    // 生产者恰好在改写该槽位时返回 WOULD_BLOCK (等下一次门铃)
+    status_t acquireLatest(uint64_t afterSequence, Frame* frame);
+
+    // 生产者：占用一个空闲槽位并返回其像素地址；所有槽位都被占用时返回 nullptr
+    uint8_t* beginWrite(uint32_t* slot);
+    // 生产者：发布写好的槽位，返回其序号 (之后由调用者敲响门铃)
+    uint64_t publish(uint32_t slot, int64_t captureTimeUs);
+
+  private:
+    Camera3InjectionShmRing(uint8_t* base, size_t mappedSize, const Layout& layout,
+            uint32_t slotSize, uint32_t dataOffset);
+
+    static status_t computeOffsets(const Layout& layout, uint32_t* slotSize,
+            uint32_t* dataOffset, size_t* totalSize);
+    static bool isValidLayout(const Layout& layout);
+    // 把为 0 的色度参数替换为紧密排列时的值
+    static Layout resolvePlanes(Layout layout);
+
+    ShmHeader* header() const { return reinterpret_cast<ShmHeader*>(mBase); }
+    uint8_t* slotData(uint32_t slot) const { return mBase + mDataOffset + slot * mSlotSize; }
+    void releaseSlot(uint32_t slot);
+
+    uint8_t* const mBase;
+    const size_t mMappedSize;
+    const Layout mLayout;
+    const uint32_t mSlotSize;
+    const uint32_t mDataOffset;
+};
+
+} // namespace camera3
+} // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_SHM_RING_H
+// 个人修改结束
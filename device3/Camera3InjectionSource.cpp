@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#define LOG_TAG "AIDOCK_CAM_INJECT"
+#include <inttypes.h>
+#include <stdio.h>
+#include <algorithm>
+#include <cutils/properties.h>
+#include <utils/Log.h>
+
+#include "Camera3InjectionSource.h"
+
+namespace android {
+namespace camera3 {
+
+namespace {
+
+// 帧池在帧环之外还需要的槽位：解码器正在写的一帧，以及输出流正在合成的帧
+constexpr size_t kExtraPoolSlots = 3;
+
+Camera3InjectionFrameRing::Policy readFramePolicy() {
+    char value[PROPERTY_VALUE_MAX];
+    property_get("persist.camera.injection.frame_policy", value, "nearest");
+    return Camera3InjectionFrameRing::parsePolicy(value,
+            Camera3InjectionFrameRing::Policy::NEAREST);
+}
+
+size_t readFrameRingSize() {
+    int32_t size = property_get_int32("persist.camera.injection.frame_ring_size",
+            Camera3InjectionFrameRing::kDefaultCapacity);
+    return static_cast<size_t>(std::max(size, 1));
+}
+
+} // namespace
+
+Camera3InjectionSource::Camera3InjectionSource(const std::string& id) :
+        mId(id),
+        mFramePolicy(readFramePolicy()),
+        mFrameDelay(ms2ns(std::max(0,
+                property_get_int32("persist.camera.injection.frame_delay_ms", 0)))),
+        mFrameRing(readFrameRingSize()),
+        mIsInjectionActive(false),
+        mFramesPublished(0),
+        mLastPublishTime(0),
+        mMaxFramesHeld(mFrameRing.capacity() + kExtraPoolSlots),
+        mFramePool(mMaxFramesHeld) {
+    ALOGI("标记: 注入源 \"%s\" 选帧策略: %s, 帧环: %zu, 延迟: %" PRId64 " ms", mId.c_str(),
+            Camera3InjectionFrameRing::policyName(mFramePolicy), mFrameRing.capacity(),
+            ns2ms(mFrameDelay));
+}
+
+Camera3InjectionSource::~Camera3InjectionSource() {
+}
+
+std::shared_ptr<DecodedFrame> Camera3InjectionSource::acquireFrame(uint32_t width,
+        uint32_t height) {
+    return mFramePool.acquire(width, height);
+}
+
+void Camera3InjectionSource::addBytesCopied(size_t bytes) {
+    mFramePool.addBytesCopied(bytes);
+}
+
+void Camera3InjectionSource::updateFrame(std::shared_ptr<DecodedFrame> frame,
+        uint64_t sequence) {
+    if (frame == nullptr) {
+        return;
+    }
+    frame->sequence = sequence;
+    mFrameRing.push(std::move(frame));
+    mLastPublishTime.store(systemTime(), std::memory_order_relaxed);
+    mFramesPublished.fetch_add(1, std::memory_order_relaxed);
+    mIsInjectionActive.store(true, std::memory_order_release);
+}
+
+std::shared_ptr<DecodedFrame> Camera3InjectionSource::getLatestFrame() {
+    return mFrameRing.latest();
+}
+
+std::shared_ptr<DecodedFrame> Camera3InjectionSource::selectFrame(nsecs_t targetTime) {
+    return mFrameRing.select(mFramePolicy, targetTime - mFrameDelay);
+}
+
+void Camera3InjectionSource::setInjectionActive(bool active) {
+    mIsInjectionActive.store(active, std::memory_order_release);
+    ALOGI("标记: 注入源 \"%s\" 状态切换为: %s", mId.c_str(), active ? "激活" : "停止");
+}
+
+bool Camera3InjectionSource::isInjectionActive() {
+    return mIsInjectionActive.load(std::memory_order_acquire);
+}
+
+status_t Camera3InjectionSource::renderFrame(uint64_t frameSequence,
+        const Camera3InjectionTransform::Key& key, const void* user, uint8_t* dstY,
+        uint8_t* dstUV, const Camera3InjectionRenderCache::RenderFunc& render,
+        Camera3InjectionRenderCache::Outcome* outcome) {
+    return mRenderCache.render(frameSequence, key, user, dstY, dstUV, render, outcome);
+}
+
+void Camera3InjectionSource::dump(int fd) {
+    dprintf(fd, "  Source \"%s\": active: %s, frames published: %" PRIu64 "\n",
+            mId.c_str(), isInjectionActive() ? "true" : "false", mFramesPublished.load());
+    std::shared_ptr<DecodedFrame> latest = mFrameRing.latest();
+    if (latest != nullptr) {
+        if (latest->hardwareBuffer != nullptr) {
+            dprintf(fd, "    Latest frame: %ux%u, decoder graphic buffer (%s, stride %u)",
+                    latest->width, latest->height, latest->chromaUV ? "NV12" : "NV21",
+                    latest->stride);
+        } else {
+            dprintf(fd, "    Latest frame: %ux%u, %zu bytes", latest->width, latest->height,
+                    latest->size());
+        }
+        dprintf(fd, ", published %" PRId64 " ms ago\n",
+                ns2ms(systemTime() - mLastPublishTime.load()));
+    }
+    dprintf(fd, "    Frame selection: policy %s, delay %" PRId64 " ms, ring %zu/%zu\n",
+            Camera3InjectionFrameRing::policyName(mFramePolicy), ns2ms(mFrameDelay),
+            mFrameRing.size(), mFrameRing.capacity());
+    dprintf(fd, "    Camera frames: %" PRIu64 ", source frames repeated: %" PRIu64
+            ", skipped: %" PRIu64 "\n", mFrameRing.getSelections(),
+            mFrameRing.getRepeated(), mFrameRing.getDropped());
+    mFramePool.dump(fd);
+    mRenderCache.dump(fd);
+}
+
+} // namespace camera3
+} // namespace android
+// 个人修改结束
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#ifndef ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_SOURCE_H
+#define ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_SOURCE_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include <utils/RefBase.h>
+#include <utils/Timers.h>
+
+#include "Camera3InjectionFramePool.h"
+#include "Camera3InjectionFrameRing.h"
+#include "Camera3InjectionRenderCache.h"
+#include "Camera3InjectionTransform.h"
+
+namespace android {
+namespace camera3 {
+
+/**
+ * 一路注入视频源 (一个 socket 通道)。
+ *
+ * 每个源有自己的帧环、帧池和渲染缓存，由 Camera3StreamInjectionManager 按
+ * 源 ID 管理；源 ID 为空字符串的是默认源，对应 @aidock_cam_h264，
+ * 其余的源 ID 即相机 ID (或自定义通道名)，对应 @aidock_cam_h264.<id>。
+ *
+ * updateFrame 只由该源的解码线程调用；输出流取帧和查询状态的路径不等待解码线程
+ * (帧环快照的读取见 Camera3InjectionFrameRing 中关于 libc++ 分段锁的说明)。
+ */
+class Camera3InjectionSource : public virtual RefBase {
+public:
+    explicit Camera3InjectionSource(const std::string& id);
+    virtual ~Camera3InjectionSource();
+
+    const std::string& getId() const { return mId; }
+
+    // 从帧池中取得一个可写帧，填充完成后通过 updateFrame 发布
+    std::shared_ptr<DecodedFrame> acquireFrame(uint32_t width, uint32_t height);
+    void addBytesCopied(size_t bytes);
+    // 同一时刻最多被帧环和输出流引用的帧数 (即帧池的槽位数)；
+    // 直接发布 gralloc 缓冲区的解码器据此确定需要的输出缓冲区数量
+    size_t getMaxFramesHeld() const { return mMaxFramesHeld; }
+
+    // sequence 由 Camera3StreamInjectionManager 分配，所有源之间唯一
+    void updateFrame(std::shared_ptr<DecodedFrame> frame, uint64_t sequence);
+    std::shared_ptr<DecodedFrame> getLatestFrame();
+    // 按 persist.camera.injection.frame_policy 为 targetTime (CLOCK_MONOTONIC) 的相机帧选帧
+    std::shared_ptr<DecodedFrame> selectFrame(nsecs_t targetTime);
+
+    void setInjectionActive(bool active);
+    bool isInjectionActive();
+
+    // 渲染一帧到输出流缓冲区；多个流 (user) 共用相同 (帧序号, 目标几何, transform) 时
+    // 结果只计算一次
+    status_t renderFrame(uint64_t frameSequence, const Camera3InjectionTransform::Key& key,
+            const void* user, uint8_t* dstY, uint8_t* dstUV,
+            const Camera3InjectionRenderCache::RenderFunc& render,
+            Camera3InjectionRenderCache::Outcome* outcome);
+
+    void dump(int fd);
+
+private:
+    const std::string mId;
+
+    const Camera3InjectionFrameRing::Policy mFramePolicy;
+    // 选帧前从目标时间中减去的延迟，让 HOLD/NEAREST 有足够的帧可选
+    const nsecs_t mFrameDelay;
+
+    Camera3InjectionFrameRing mFrameRing;
+    std::atomic<bool> mIsInjectionActive;
+    std::atomic<uint64_t> mFramesPublished;
+    std::atomic<nsecs_t> mLastPublishTime;
+
+    const size_t mMaxFramesHeld;
+    Camera3InjectionFramePool mFramePool;
+    Camera3InjectionRenderCache mRenderCache;
+};
+
+} // namespace camera3
+} // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_SOURCE_H
+// 个人修改结束
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#define LOG_TAG "AIDOCK_CAM_DECODER"
+#include <string.h>
+
+#include <utils/Log.h>
+
+#include "Camera3InjectionStreamReader.h"
+
+namespace android {
+namespace camera3 {
+
+namespace {
+
+uint16_t readLe16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t readLe32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+            (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint64_t readLe64(const uint8_t* p) {
+    return static_cast<uint64_t>(readLe32(p)) | (static_cast<uint64_t>(readLe32(p + 4)) << 32);
+}
+
+void writeLe16(uint16_t value, uint8_t* p) {
+    p[0] = value & 0xFF;
+    p[1] = (value >> 8) & 0xFF;
+}
+
+} // namespace
+
+Camera3InjectionStreamReader::Camera3InjectionStreamReader(size_t maxPayloadSize) :
+        mMaxPayloadSize(maxPayloadSize) {
+    reset();
+}
+
+void Camera3InjectionStreamReader::reset() {
+    mMode = Mode::UNKNOWN;
+    mHelloDone = false;
+}
+
+status_t Camera3InjectionStreamReader::parse(const uint8_t* data, size_t size,
+        const Callbacks& callbacks, size_t* consumed, size_t* needed) {
+    *consumed = 0;
+    *needed = 0;
+    if (mMode == Mode::UNKNOWN) {
+        // 先攒够 4 个字节再判断是否为握手魔数
+        if (size < sizeof(kMagic)) {
+            *needed = sizeof(kMagic);
+            return OK;
+        }
+        mMode = (memcmp(data, kMagic, sizeof(kMagic)) == 0) ? Mode::FRAMED : Mode::RAW;
+    }
+
+    if (mMode == Mode::RAW) {
+        if (size > 0 && callbacks.onRawData) callbacks.onRawData(data, size);
+        *consumed = size;
+        return OK;
+    }
+
+    size_t pos = 0;
+    while (true) {
+        const uint8_t* unit = data + pos;
+        size_t remaining = size - pos;
+        if (!mHelloDone) {
+            if (remaining < kHelloSize) {
+                *needed = kHelloSize;
+                break;
+            }
+            Hello hello;
+            hello.version = readLe16(unit + 4);
+            uint16_t clock = readLe16(unit + 6);
+            if (clock > kClockBoottime) {
+                ALOGE("标记: 注入协议 hello 中的时钟类型无效: %u", clock);
+                return BAD_VALUE;
+            }
+            hello.clock = static_cast<Clock>(clock);
+            mHelloDone = true;
+            pos += kHelloSize;
+            if (callbacks.onHello) {
+                status_t res = callbacks.onHello(hello);
+                if (res != OK) return res;
+            }
+            continue;
+        }
+
+        if (remaining < kFrameHeaderSize) {
+            *needed = kFrameHeaderSize;
+            break;
+        }
+        size_t payloadSize = readLe32(unit);
+        if (payloadSize > mMaxPayloadSize) {
+            ALOGE("标记: 注入帧大小 %zu 超过上限 %zu", payloadSize, mMaxPayloadSize);
+            return BAD_VALUE;
+        }
+        if (remaining < kFrameHeaderSize + payloadSize) {
+            *needed = kFrameHeaderSize + payloadSize;
+            break;
+        }
+        Frame frame;
+        frame.data = unit + kFrameHeaderSize;
+        frame.size = payloadSize;
+        frame.flags = readLe32(unit + 4);
+        frame.sequence = readLe64(unit + 8);
+        frame.captureTimeUs = static_cast<int64_t>(readLe64(unit + 16));
+        pos += kFrameHeaderSize + payloadSize;
+        if (callbacks.onFrame) callbacks.onFrame(frame);
+    }
+    *consumed = pos;
+    return OK;
+}
+
+void Camera3InjectionStreamReader::writeAck(uint16_t version, uint16_t status, uint8_t* out) {
+    memcpy(out, kMagic, sizeof(kMagic));
+    writeLe16(version, out + 4);
+    writeLe16(status, out + 6);
+}
+
+void Camera3InjectionStreamReader::writeRequest(Request type, uint8_t* out) {
+    memcpy(out, kRequestMagic, sizeof(kRequestMagic));
+    writeLe16(type, out + 4);
+    writeLe16(0, out + 6);
+}
+
+} // namespace camera3
+} // namespace android
+// 个人修改结束
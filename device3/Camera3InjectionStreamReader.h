@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#ifndef ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_STREAM_READER_H
+#define ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_STREAM_READER_H
+
+#include <functional>
+
+#include <utils/Errors.h>
+
+namespace android {
+namespace camera3 {
+
+/**
+ * 注入 socket 的协议解析。
+ *
+ * 连接建立后由客户端发送的前 4 个字节决定模式：
+ *
+ * - 原始模式 (兼容旧客户端)：直接发送 Annex-B 字节流，没有帧边界和时间戳。
+ *   Annex-B 以 0x00 开头，不会与握手的魔数冲突。
+ * - 分帧模式：客户端先发送 8 字节的 hello，服务端回复 8 字节的 ack，
+ *   之后每帧为 24 字节的帧头加上一个完整访问单元的 Annex-B 数据。
+ *
+ * 所有多字节字段均为小端序：
+ *
+ *   hello:  magic "AIDC" | u16 version | u16 clock (kClock*)
+ *   ack:    magic "AIDC" | u16 version | u16 status (0 = OK)
+ *   帧头:   u32 payloadSize | u32 flags (kFlag*) | u64 sequence | i64 captureTimeUs
+ *   请求:   magic "AIDQ" | u16 type (kRequest*) | u16 reserved
+ *
+ * ack 中的 version 为双方都支持的版本 (hello 与服务端版本中较小的一个)。
+ * 版本 2 起，服务端在 ack 之后可以随时向客户端发送请求 (例如解码端丢了参考帧，
+ * 请求尽快发送 IDR)；客户端不认识的请求类型应忽略。
+ *
+ * captureTimeUs 是发送端采集该帧的时间 (hello 中声明的时钟)，用于计算端到端延迟
+ * 和丢弃过期帧；sequence 应逐帧加 1，用于统计发送端或传输中丢失的帧。
+ *
+ * 解析在调用者的缓冲区上原地进行 (见 Camera3InjectionIngestBuffer)：只处理完整的 hello 和帧，
+ * 不完整的部分留给调用者，与后续数据拼接成连续的内存后再次传入，解析器本身不拷贝数据。
+ *
+ * 非线程安全；每个连接开始时调用 reset()。
+ */
+class Camera3InjectionStreamReader {
+  public:
+    static constexpr uint8_t kMagic[4] = {'A', 'I', 'D', 'C'};
+    static constexpr uint16_t kVersion = 2;
+    // 支持服务端请求的最低版本
+    static constexpr uint16_t kVersionRequests = 2;
+    static constexpr uint8_t kRequestMagic[4] = {'A', 'I', 'D', 'Q'};
+    static constexpr size_t kHelloSize = 8;
+    static constexpr size_t kAckSize = 8;
+    static constexpr size_t kFrameHeaderSize = 24;
+    static constexpr size_t kRequestSize = 8;
+    static constexpr size_t kDefaultMaxPayloadSize = 8 * 1024 * 1024;
+
+    // captureTimeUs 所使用的时钟
+    enum Clock : uint16_t {
+        kClockMonotonic = 0,
+        kClockRealtime = 1,
+        kClockBoottime = 2,
+    };
+
+    enum Flags : uint32_t {
+        kFlagKeyFrame = 1 << 0,
+        kFlagCodecConfig = 1 << 1,
+        // 发送端结束推流；服务端在处理完这一帧后关闭连接
+        kFlagEndOfStream = 1 << 2,
+        // 本机生产者改用共享内存传输未压缩的 YUV 帧：帧数据为空，同一次 sendmsg 通过
+        // SCM_RIGHTS 附带 [memfd, eventfd]，memfd 的布局见 Camera3InjectionShmRing，
+        // 之后每发布一帧敲一次 eventfd。
+        kFlagSharedMemory = 1 << 3,
+    };
+
+    // 服务端 -> 客户端的请求
+    enum Request : uint16_t {
+        // 尽快发送一个 IDR (连同 SPS/PPS)
+        kRequestKeyFrame = 1,
+    };
+
+    enum class Mode {
+        UNKNOWN,
+        RAW,
+        FRAMED,
+    };
+
+    struct Hello {
+        uint16_t version;
+        Clock clock;
+    };
+
+    struct Frame {
+        // 指向传入 parse() 的数据，在回调期间有效
+        const uint8_t* data;
+        size_t size;
+        uint32_t flags;
+        uint64_t sequence;
+        int64_t captureTimeUs;
+    };
+
+    struct Callbacks {
+        // 分帧模式握手；返回非 OK 时拒绝该连接
+        std::function<status_t(const Hello&)> onHello;
+        // 原始模式的数据块
+        std::function<void(const uint8_t*, size_t)> onRawData;
+        std::function<void(const Frame&)> onFrame;
+    };
+
+    explicit Camera3InjectionStreamReader(size_t maxPayloadSize = kDefaultMaxPayloadSize);
+
+    // 处理 data 中所有完整的单元；*consumed 为已处理的字节数，其余字节由调用者保留到下次。
+    // *needed 为下一个单元 (从 data + *consumed 算起) 完整所需的字节数，原始模式下为 0。
+    // 协议错误时返回 BAD_VALUE，此后应关闭连接
+    status_t parse(const uint8_t* data, size_t size, const Callbacks& callbacks,
+            size_t* consumed, size_t* needed);
+
+    void reset();
+
+    Mode getMode() const { return mMode; }
+
+    // 一个单元 (帧头加帧数据) 的最大字节数，调用者的缓冲区至少要能放下这么多
+    size_t getMaxUnitSize() const { return kFrameHeaderSize + mMaxPayloadSize; }
+
+    // 把 ack 写入 out (kAckSize 字节)
+    static void writeAck(uint16_t version, uint16_t status, uint8_t* out);
+
+    // 把请求写入 out (kRequestSize 字节)
+    static void writeRequest(Request type, uint8_t* out);
+
+  private:
+    const size_t mMaxPayloadSize;
+    Mode mMode;
+    bool mHelloDone;
+};
+
+} // namespace camera3
+} // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_STREAM_READER_H
+// 个人修改结束
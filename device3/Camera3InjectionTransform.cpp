@@ -0,0 +1,237 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#define LOG_TAG "AIDOCK_CAM_INJECT"
+#include <utils/Log.h>
+#include <system/graphics.h>
+#include <libyuv.h>
+
+#include "Camera3InjectionTransform.h"
+
+namespace android {
+namespace camera3 {
+
+int32_t Camera3InjectionTransform::compensationRotation(int32_t transform) {
+    // 1. 获取系统 transform 要求的旋转角度
+    int32_t transformRotation = 0;
+    if ((transform & 0x07) == HAL_TRANSFORM_ROT_90) transformRotation = 90;
+    else if ((transform & 0x07) == HAL_TRANSFORM_ROT_180) transformRotation = 180;
+    else if ((transform & 0x07) == HAL_TRANSFORM_ROT_270) transformRotation = 270;
+
+    // 2. 补偿角度 = (360 - 系统旋转角度) % 360，用于抵消系统的 transform 变换
+    return (360 - transformRotation) % 360;
+}
+
+Camera3InjectionTransform::Rect Camera3InjectionTransform::computeSourceCrop(
+        int32_t srcWidth, int32_t srcHeight, int32_t rotation,
+        int32_t dstWidth, int32_t dstHeight) {
+    bool swapAxes = (rotation == 90 || rotation == 270);
+    int32_t effectiveW = swapAxes ? srcHeight : srcWidth;
+    int32_t effectiveH = swapAxes ? srcWidth : srcHeight;
+
+    // 在旋转后的坐标系中确定裁剪区域 (以适配目标比例 dstWidth/dstHeight)
+    float dstAspect = (float)dstWidth / dstHeight;
+    int32_t cropW, cropH;
+    int32_t cropX = 0, cropY = 0;
+    if ((float)effectiveW / effectiveH > dstAspect) {
+        // 旋转后依然太宽，裁剪左右
+        cropH = effectiveH;
+        cropW = (int32_t)(effectiveH * dstAspect);
+        cropX = (effectiveW - cropW) / 2;
+    } else {
+        // 旋转后太窄或比例一致，裁剪上下
+        cropW = effectiveW;
+        cropH = (int32_t)(effectiveW / dstAspect);
+        cropY = (effectiveH - cropH) / 2;
+    }
+
+    // 确保对齐到 2
+    cropX = (cropX / 2) * 2;
+    cropY = (cropY / 2) * 2;
+    cropW = (cropW / 2) * 2;
+    cropH = (cropH / 2) * 2;
+
+    // 映射回源帧坐标系 (libyuv 的旋转方向为顺时针)
+    Rect crop;
+    switch (rotation) {
+        case 90:
+            crop = {cropY, srcHeight - cropX - cropW, cropH, cropW};
+            break;
+        case 180:
+            crop = {srcWidth - cropX - cropW, srcHeight - cropY - cropH, cropW, cropH};
+            break;
+        case 270:
+            crop = {srcWidth - cropY - cropH, cropX, cropH, cropW};
+            break;
+        default:
+            crop = {cropX, cropY, cropW, cropH};
+            break;
+    }
+    crop.x &= ~1;
+    crop.y &= ~1;
+    return crop;
+}
+
+Camera3InjectionTransform::Plan::Plan() :
+        mKey{},
+        mHasKey(false),
+        mValid(false),
+        mRotation(0),
+        mCrop{},
+        mSrcYOffset(0),
+        mSrcUVOffset(0),
+        mSrcStride(0),
+        mDstWidth(0),
+        mDstHeight(0),
+        mDstStride(0),
+        mScaledWidth(0),
+        mScaledHeight(0),
+        mScaledStride(0),
+        mSwapChroma(false),
+        mRebuildCount(0) {
+}
+
+bool Camera3InjectionTransform::Plan::update(const Key& key) {
+    // 无效的 key 同样被缓存，避免每帧重复构建失败的计划
+    if (mHasKey && key == mKey) {
+        return false;
+    }
+    mKey = key;
+    mHasKey = true;
+    mRebuildCount++;
+    status_t res = build(compensationRotation(key.transform), key.srcWidth, key.srcHeight,
+            key.srcStride, key.dstWidth, key.dstHeight, key.dstStride);
+    mSwapChroma = key.swapChroma;
+    if (res != OK) {
+        ALOGE("标记: 注入变换计划构建失败 (src %dx%d, dst %dx%d stride %d, transform %d)",
+                key.srcWidth, key.srcHeight, key.dstWidth, key.dstHeight, key.dstStride,
+                key.transform);
+    }
+    return true;
+}
+
+status_t Camera3InjectionTransform::Plan::build(int32_t rotation, int32_t srcWidth,
+        int32_t srcHeight, int32_t srcStride, int32_t dstWidth, int32_t dstHeight,
+        int32_t dstStride) {
+    mValid = false;
+    if (srcWidth <= 0 || srcHeight <= 0 || dstWidth <= 0 || dstHeight <= 0 ||
+            (dstStride & 1) != 0) {
+        ALOGE("标记: 注入变换参数无效 (src %dx%d, dst %dx%d stride %d)", srcWidth, srcHeight,
+                dstWidth, dstHeight, dstStride);
+        return BAD_VALUE;
+    }
+    if (rotation != 0 && rotation != 90 && rotation != 180 && rotation != 270) {
+        ALOGE("标记: 不支持的旋转角度 %d", rotation);
+        return BAD_VALUE;
+    }
+
+    mCrop = computeSourceCrop(srcWidth, srcHeight, rotation, dstWidth, dstHeight);
+    if (mCrop.width <= 0 || mCrop.height <= 0) {
+        return BAD_VALUE;
+    }
+    mRotation = rotation;
+    mSrcStride = srcStride;
+    mSrcYOffset = static_cast<size_t>(mCrop.y) * srcStride + mCrop.x;
+    mSrcUVOffset = static_cast<size_t>(mCrop.y / 2) * srcStride + mCrop.x;
+    mDstWidth = dstWidth;
+    mDstHeight = dstHeight;
+    mDstStride = dstStride;
+
+    if (rotation != 0) {
+        // 先缩放到旋转前的目标尺寸，中间缓冲区按需一次性分配
+        bool swapAxes = (rotation == 90 || rotation == 270);
+        mScaledWidth = swapAxes ? dstHeight : dstWidth;
+        mScaledHeight = swapAxes ? dstWidth : dstHeight;
+        mScaledStride = (mScaledWidth + 1) & ~1;
+        size_t scratchSize = static_cast<size_t>(mScaledStride) *
+                (mScaledHeight + (mScaledHeight + 1) / 2);
+        if (mScratch.size() < scratchSize) {
+            mScratch.resize(scratchSize);
+        }
+    } else {
+        mScaledWidth = mScaledHeight = mScaledStride = 0;
+    }
+    mValid = true;
+    return OK;
+}
+
+status_t Camera3InjectionTransform::Plan::execute(const uint8_t* srcY, const uint8_t* srcUV,
+        uint8_t* dstY, uint8_t* dstUV) {
+    if (!mValid) {
+        return INVALID_OPERATION;
+    }
+    if (srcY == nullptr || srcUV == nullptr || dstY == nullptr || dstUV == nullptr) {
+        return BAD_VALUE;
+    }
+    const uint8_t* cropY = srcY + mSrcYOffset;
+    const uint8_t* cropUV = srcUV + mSrcUVOffset;
+
+    if (mRotation == 0) {
+        // 无需旋转：裁剪区域直接缩放进目标缓冲区
+        int ret = libyuv::NV12Scale(cropY, mSrcStride, cropUV, mSrcStride,
+                mCrop.width, mCrop.height,
+                dstY, mDstStride, dstUV, mDstStride,
+                mDstWidth, mDstHeight, libyuv::kFilterBox);
+        if (ret == 0 && mSwapChroma) {
+            // 原地交换目标的色度平面，比先把整帧源图像转换为 NV21 少读写一次源帧
+            libyuv::SwapUVPlane(dstUV, mDstStride, dstUV, mDstStride,
+                    (mDstWidth + 1) / 2, (mDstHeight + 1) / 2);
+        }
+        return ret == 0 ? OK : UNKNOWN_ERROR;
+    }
+
+    // 先缩放到旋转前的目标尺寸，再用分块 SIMD 转置写入目标缓冲区
+    libyuv::RotationMode rotationMode = static_cast<libyuv::RotationMode>(mRotation);
+    uint8_t* tmpY = mScratch.data();
+    uint8_t* tmpUV = tmpY + static_cast<size_t>(mScaledStride) * mScaledHeight;
+    int ret = libyuv::NV12Scale(cropY, mSrcStride, cropUV, mSrcStride,
+            mCrop.width, mCrop.height,
+            tmpY, mScaledStride, tmpUV, mScaledStride,
+            mScaledWidth, mScaledHeight, libyuv::kFilterBox);
+    if (ret == 0 && mSwapChroma) {
+        libyuv::SwapUVPlane(tmpUV, mScaledStride, tmpUV, mScaledStride,
+                (mScaledWidth + 1) / 2, (mScaledHeight + 1) / 2);
+    }
+    if (ret == 0) {
+        ret = libyuv::RotatePlane(tmpY, mScaledStride, dstY, mDstStride,
+                mScaledWidth, mScaledHeight, rotationMode);
+    }
+    if (ret == 0) {
+        // UV 交错平面按 16 位像素整体旋转，保持 UV 顺序不变
+        ret = libyuv::RotatePlane_16(reinterpret_cast<const uint16_t*>(tmpUV),
+                mScaledStride / 2, reinterpret_cast<uint16_t*>(dstUV), mDstStride / 2,
+                (mScaledWidth + 1) / 2, (mScaledHeight + 1) / 2, rotationMode);
+    }
+    return ret == 0 ? OK : UNKNOWN_ERROR;
+}
+
+status_t Camera3InjectionTransform::apply(const Source& src, int32_t rotation,
+        const Destination& dst, std::vector<uint8_t>* scratch) {
+    Plan plan;
+    plan.mScratch.swap(*scratch);
+    status_t res = plan.build(rotation, src.width, src.height, src.stride,
+            dst.width, dst.height, dst.stride);
+    if (res == OK) {
+        res = plan.execute(src.y, src.uv, dst.y, dst.uv);
+    }
+    plan.mScratch.swap(*scratch);
+    return res;
+}
+
+} // namespace camera3
+} // namespace android
+// 个人修改结束
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#ifndef ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_TRANSFORM_H
+#define ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_TRANSFORM_H
+
+#include <vector>
+
+#include <utils/Errors.h>
+
+namespace android {
+namespace camera3 {
+
+/**
+ * 注入帧的旋转 + 居中裁剪 + 缩放，一步写入目标 gralloc 缓冲区。
+ *
+ * 源帧与目标缓冲区都是半平面 YUV420 (NV12/NV21)，UV 交错顺序原样保留，
+ * 除非 Key::swapChroma 要求在缩放后交换 (只作用于目标大小的色度平面)。
+ * 裁剪区域先在旋转后的坐标系中计算 (与目标宽高比一致)，再映射回源帧坐标，
+ * 因此只需缩放被裁剪的区域，旋转发生在缩放之后，中间缓冲区最多为目标大小，
+ * 而不再是整帧源图像。
+ */
+class Camera3InjectionTransform {
+  public:
+    struct Source {
+        const uint8_t* y;
+        const uint8_t* uv;
+        int32_t stride;
+        int32_t width;
+        int32_t height;
+    };
+
+    struct Destination {
+        uint8_t* y;
+        uint8_t* uv;
+        int32_t stride;
+        int32_t width;
+        int32_t height;
+    };
+
+    struct Rect {
+        int32_t x;
+        int32_t y;
+        int32_t width;
+        int32_t height;
+    };
+
+    // 决定变换计划的全部输入；任何一项变化都需要重建计划
+    struct Key {
+        int32_t srcWidth;
+        int32_t srcHeight;
+        int32_t srcStride;
+        int32_t dstWidth;
+        int32_t dstHeight;
+        int32_t dstStride;
+        int32_t transform;
+        // 源帧色度按 U、V 交错 (NV12，例如直接读取解码器的 gralloc 输出)，写入时交换为 VU
+        bool swapChroma = false;
+
+        bool operator==(const Key& other) const {
+            return srcWidth == other.srcWidth && srcHeight == other.srcHeight &&
+                    srcStride == other.srcStride && dstWidth == other.dstWidth &&
+                    dstHeight == other.dstHeight && dstStride == other.dstStride &&
+                    transform == other.transform && swapChroma == other.swapChroma;
+        }
+        bool operator!=(const Key& other) const { return !(*this == other); }
+    };
+
+    /**
+     * 预先计算好的变换计划 (旋转模式、裁剪区域、平面偏移、中间缓冲区)。
+     *
+     * 这些参数只在流重新配置或源分辨率变化时才会改变，因此每个输出流缓存一份，
+     * 每帧只需执行计划。非线程安全，由调用者加锁。
+     */
+    class Plan {
+      public:
+        Plan();
+
+        // key 变化时重建计划并返回 true；否则直接返回 false
+        bool update(const Key& key);
+
+        // 按当前计划变换一帧，src/dst 的尺寸和 stride 必须与 key 一致
+        status_t execute(const uint8_t* srcY, const uint8_t* srcUV,
+                uint8_t* dstY, uint8_t* dstUV);
+
+        bool isValid() const { return mValid; }
+        int32_t getRotation() const { return mRotation; }
+        uint64_t getRebuildCount() const { return mRebuildCount; }
+        const Key& getKey() const { return mKey; }
+
+      private:
+        friend class Camera3InjectionTransform;
+
+        status_t build(int32_t rotation, int32_t srcWidth, int32_t srcHeight,
+                int32_t srcStride, int32_t dstWidth, int32_t dstHeight, int32_t dstStride);
+
+        Key mKey;
+        bool mHasKey;
+        bool mValid;
+        int32_t mRotation;
+        Rect mCrop;
+        size_t mSrcYOffset;
+        size_t mSrcUVOffset;
+        int32_t mSrcStride;
+        int32_t mDstWidth;
+        int32_t mDstHeight;
+        int32_t mDstStride;
+        // 旋转前的缩放目标尺寸，仅在需要旋转时使用
+        int32_t mScaledWidth;
+        int32_t mScaledHeight;
+        int32_t mScaledStride;
+        bool mSwapChroma;
+        std::vector<uint8_t> mScratch;
+        uint64_t mRebuildCount;
+    };
+
+    // 根据系统要求的 HAL_TRANSFORM_* 计算需要对源帧施加的顺时针补偿角度
+    static int32_t compensationRotation(int32_t transform);
+
+    // 计算源帧坐标系下的裁剪区域 (偶数对齐)
+    static Rect computeSourceCrop(int32_t srcWidth, int32_t srcHeight, int32_t rotation,
+            int32_t dstWidth, int32_t dstHeight);
+
+    // 一次性执行完整的变换 (不缓存计划)。rotation 为 0/90/180/270 (顺时针)。
+    // scratch 仅在需要旋转时使用，大小为目标图像大小，可跨帧复用。
+    static status_t apply(const Source& src, int32_t rotation, const Destination& dst,
+            std::vector<uint8_t>* scratch);
+};
+
+} // namespace camera3
+} // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA_CAMERA3_INJECTION_TRANSFORM_H
+// 个人修改结束
@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#define LOG_TAG "AIDOCK_CAM_DECODER"
+#include <algorithm>
+#include <string.h>
+#include <sys/types.h>
+#include <utils/Log.h>
+
+#include "Camera3NalSplitter.h"
+
+namespace android {
+namespace camera3 {
+
+static const uint8_t kStartCode[4] = {0x00, 0x00, 0x00, 0x01};
+static constexpr size_t kInitialPendingCapacity = 1024 * 1024;
+
+Camera3NalSplitter::Camera3NalSplitter(size_t maxNalSize) :
+        mMaxNalSize(maxNalSize),
+        mInNal(false),
+        mDropping(false),
+        mZeroRun(0),
+        mBytesScanned(0),
+        mNalCount(0),
+        mOversizedCount(0) {
+    mPending.reserve(std::min(kInitialPendingCapacity, maxNalSize));
+}
+
+void Camera3NalSplitter::push(const uint8_t* data, size_t size, const NalCallback& onNal) {
+    if (data == nullptr || size == 0) {
+        return;
+    }
+    mBytesScanned += size;
+
+    // continued: 当前 NAL 单元起始于之前的分片，其已有字节保存在 mPending 中
+    bool continued = mInNal;
+    size_t nalStart = 0;
+    size_t carriedZeros = mZeroRun;
+    mZeroRun = 0;
+
+    size_t pos = 0;
+    while (pos < size) {
+        size_t zeroPos;
+        if (carriedZeros > 0 && pos == 0) {
+            zeroPos = 0;
+        } else {
+            const void* zero = memchr(data + pos, 0x00, size - pos);
+            if (zero == nullptr) {
+                break;
+            }
+            zeroPos = static_cast<const uint8_t*>(zero) - data;
+        }
+
+        size_t runEnd = zeroPos;
+        while (runEnd < size && data[runEnd] == 0x00) {
+            runEnd++;
+        }
+        size_t zeros = (runEnd - zeroPos) + (zeroPos == 0 ? carriedZeros : 0);
+        carriedZeros = 0;
+
+        if (runEnd == size) {
+            // 零字节延续到分片末尾，可能是跨分片起始码的前缀
+            mZeroRun = zeros;
+            break;
+        }
+        if (zeros < 2 || data[runEnd] != 0x01) {
+            pos = runEnd + 1;
+            continue;
+        }
+
+        // runEnd 处为起始码的 0x01；零串的第一个字节即上一个 NAL 单元的结尾
+        size_t startCodeLength = zeros >= 3 ? 4 : 3;
+        ssize_t prevEnd = static_cast<ssize_t>(runEnd) - static_cast<ssize_t>(zeros);
+        if (mInNal) {
+            if (continued) {
+                if (prevEnd < 0) {
+                    // 零串的一部分已经在上一个分片中被追加到 mPending
+                    size_t trim = std::min(static_cast<size_t>(-prevEnd), mPending.size());
+                    mPending.resize(mPending.size() - trim);
+                } else {
+                    appendPending(data + nalStart, prevEnd - nalStart);
+                }
+                if (!mDropping) {
+                    emit(mPending.data(), mPending.size(), onNal);
+                }
+                mPending.clear();
+            } else {
+                emitBounded(data + nalStart, prevEnd - nalStart, onNal);
+            }
+        }
+        mInNal = true;
+        mDropping = false;
+
+        ssize_t startCodePos = static_cast<ssize_t>(runEnd) + 1 -
+                static_cast<ssize_t>(startCodeLength);
+        if (startCodePos < 0) {
+            // 起始码跨分片：在 mPending 中重建起始码
+            mPending.assign(kStartCode + 4 - startCodeLength, kStartCode + 4);
+            continued = true;
+            nalStart = runEnd + 1;
+        } else {
+            continued = false;
+            nalStart = startCodePos;
+        }
+        pos = runEnd + 1;
+    }
+
+    if (mInNal) {
+        if (!continued) {
+            mPending.clear();
+        }
+        appendPending(data + nalStart, size - nalStart);
+    }
+}
+
+void Camera3NalSplitter::flush(const NalCallback& onNal) {
+    if (mInNal && !mDropping) {
+        // 末尾的零字节是 trailing_zero_8bits，不属于 NAL 单元
+        mPending.resize(mPending.size() - std::min(mZeroRun, mPending.size()));
+        emit(mPending.data(), mPending.size(), onNal);
+    }
+    reset();
+}
+
+void Camera3NalSplitter::split(const uint8_t* data, size_t size, const NalCallback& onNal) {
+    if (mInNal || mZeroRun > 0) {
+        flush(onNal);
+    }
+    if (data == nullptr || size == 0) {
+        return;
+    }
+    mBytesScanned += size;
+
+    const uint8_t* nalStart = nullptr;
+    size_t pos = 0;
+    while (pos < size) {
+        const void* zero = memchr(data + pos, 0x00, size - pos);
+        if (zero == nullptr) {
+            break;
+        }
+        size_t zeroPos = static_cast<const uint8_t*>(zero) - data;
+        size_t runEnd = zeroPos;
+        while (runEnd < size && data[runEnd] == 0x00) {
+            runEnd++;
+        }
+        if (runEnd == size) {
+            break;
+        }
+        size_t zeros = runEnd - zeroPos;
+        if (zeros < 2 || data[runEnd] != 0x01) {
+            pos = runEnd + 1;
+            continue;
+        }
+        if (nalStart != nullptr) {
+            emitBounded(nalStart, data + zeroPos - nalStart, onNal);
+        }
+        nalStart = data + runEnd + 1 - (zeros >= 3 ? 4 : 3);
+        pos = runEnd + 1;
+    }
+
+    if (nalStart != nullptr) {
+        // 末尾的零字节是 trailing_zero_8bits，不属于 NAL 单元
+        const uint8_t* end = data + size;
+        while (end > nalStart && end[-1] == 0x00) {
+            end--;
+        }
+        emitBounded(nalStart, end - nalStart, onNal);
+    }
+}
+
+void Camera3NalSplitter::reset() {
+    mPending.clear();
+    mInNal = false;
+    mDropping = false;
+    mZeroRun = 0;
+}
+
+void Camera3NalSplitter::emit(const uint8_t* data, size_t size, const NalCallback& onNal) {
+    if (size < 4) {
+        return;
+    }
+    NalUnit nal;
+    nal.data = data;
+    nal.size = size;
+    nal.startCodeLength = (data[2] == 0x01) ? 3 : 4;
+    if (nal.size <= nal.startCodeLength) {
+        // 只有起始码的空 NAL 单元
+        return;
+    }
+    mNalCount++;
+    onNal(nal);
+}
+
+void Camera3NalSplitter::emitBounded(const uint8_t* data, size_t size,
+        const NalCallback& onNal) {
+    if (size > mMaxNalSize) {
+        ALOGW("标记: NAL 单元超过 %zu 字节上限，丢弃", mMaxNalSize);
+        mOversizedCount++;
+        return;
+    }
+    emit(data, size, onNal);
+}
+
+void Camera3NalSplitter::appendPending(const uint8_t* data, size_t size) {
+    if (mDropping || size == 0) {
+        return;
+    }
+    if (mPending.size() + size > mMaxNalSize) {
+        ALOGW("标记: NAL 单元超过 %zu 字节上限，丢弃到下一个起始码", mMaxNalSize);
+        mOversizedCount++;
+        mDropping = true;
+        mPending.clear();
+        return;
+    }
+    mPending.insert(mPending.end(), data, data + size);
+}
+
+void Camera3NalSplitter::extractRbsp(const uint8_t* payload, size_t size,
+        std::vector<uint8_t>* rbsp) {
+    rbsp->clear();
+    rbsp->reserve(size);
+    size_t zeros = 0;
+    for (size_t i = 0; i < size; i++) {
+        uint8_t b = payload[i];
+        if (zeros >= 2 && b == 0x03) {
+            // 防竞争字节
+            zeros = 0;
+            continue;
+        }
+        rbsp->push_back(b);
+        zeros = (b == 0x00) ? zeros + 1 : 0;
+    }
+}
+
+} // namespace camera3
+} // namespace android
+// 个人修改结束
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#ifndef ANDROID_SERVERS_CAMERA_CAMERA3_NAL_SPLITTER_H
+#define ANDROID_SERVERS_CAMERA_CAMERA3_NAL_SPLITTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <vector>
+
+namespace android {
+namespace camera3 {
+
+/**
+ * H.264 Annex-B 字节流的流式 NAL 单元切分器。
+ *
+ * 输入可以按任意边界分片 (例如每次 socket read 的结果)，起始码 (00 00 01 或 00 00 00 01)
+ * 跨分片时同样能识别。扫描时用 memchr (libc 中为 SIMD 实现) 跳到下一个 0x00，
+ * 只在零字节处检查起始码，因此对压缩数据的扫描接近内存带宽。
+ * 完整落在一个分片内的 NAL 单元直接以指向输入的指针回调，不做拷贝；
+ * 只有跨分片的 NAL 单元才会被缓存拼接。
+ *
+ * 起始码之前多余的 trailing_zero_8bits 不计入上一个 NAL 单元。
+ * 由于防竞争字节 (emulation prevention, 00 00 03) 的存在，NAL 载荷中不会出现起始码，
+ * 切分本身无需去除防竞争字节；需要解析 RBSP (例如 SPS) 时使用 extractRbsp()。
+ *
+ * 每个连接使用一个实例；非线程安全。
+ */
+class Camera3NalSplitter {
+  public:
+    // 单个 NAL 单元的上限，超过时丢弃该单元直到下一个起始码
+    static constexpr size_t kDefaultMaxNalSize = 4 * 1024 * 1024;
+
+    struct NalUnit {
+        // 指向起始码；size 包含起始码
+        const uint8_t* data;
+        size_t size;
+        // 3 或 4
+        size_t startCodeLength;
+
+        const uint8_t* payload() const { return data + startCodeLength; }
+        size_t payloadSize() const { return size - startCodeLength; }
+        // nal_unit_type (低 5 位)
+        uint8_t type() const { return payload()[0] & 0x1F; }
+        // nal_ref_idc (forbidden_zero_bit 之后的 2 位)，非 0 表示会被其他图像参考
+        uint8_t refIdc() const { return (payload()[0] >> 5) & 0x3; }
+    };
+
+    // 回调中的 NalUnit 只在回调期间有效
+    using NalCallback = std::function<void(const NalUnit&)>;
+
+    explicit Camera3NalSplitter(size_t maxNalSize = kDefaultMaxNalSize);
+
+    // 输入一段字节流；每切分出一个完整的 NAL 单元回调一次
+    void push(const uint8_t* data, size_t size, const NalCallback& onNal);
+
+    // 输入结束 (连接断开)：输出最后一个未被后续起始码终结的 NAL 单元，并重置状态
+    void flush(const NalCallback& onNal);
+
+    // 输入是一段完整的数据 (例如分帧协议的一帧)，最后一个 NAL 单元以输入末尾为界。
+    // 所有 NAL 单元都直接指向输入，不做拷贝；之前 push() 未完成的数据会先被 flush。
+    void split(const uint8_t* data, size_t size, const NalCallback& onNal);
+
+    // 丢弃所有未完成的数据，准备处理新的连接
+    void reset();
+
+    uint64_t getBytesScanned() const { return mBytesScanned; }
+    uint64_t getNalCount() const { return mNalCount; }
+    uint64_t getOversizedCount() const { return mOversizedCount; }
+
+    // 去除 NAL 载荷中的防竞争字节 (00 00 03 -> 00 00)，得到 RBSP
+    static void extractRbsp(const uint8_t* payload, size_t size, std::vector<uint8_t>* rbsp);
+
+  private:
+    void emit(const uint8_t* data, size_t size, const NalCallback& onNal);
+    // 完整位于一次输入中的 NAL 单元：超过 mMaxNalSize 时丢弃并计数
+    void emitBounded(const uint8_t* data, size_t size, const NalCallback& onNal);
+    void appendPending(const uint8_t* data, size_t size);
+
+    const size_t mMaxNalSize;
+    // 跨分片的当前 NAL 单元 (含起始码)
+    std::vector<uint8_t> mPending;
+    // 是否已经遇到过起始码；第一个起始码之前的字节被丢弃
+    bool mInNal;
+    // 当前 NAL 单元超过上限，丢弃到下一个起始码为止
+    bool mDropping;
+    // 上一个分片末尾连续零字节的个数 (可能是下一个起始码的前缀)
+    size_t mZeroRun;
+
+    uint64_t mBytesScanned;
+    uint64_t mNalCount;
+    uint64_t mOversizedCount;
+};
+
+} // namespace camera3
+} // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA_CAMERA3_NAL_SPLITTER_H
+// 个人修改结束
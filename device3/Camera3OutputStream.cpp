@@ -44,7 +44,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <map>
-#include <libyuv.h>
+#include <android/hardware_buffer.h>
 #include "Camera3StreamInjectionManager.h"
 // 个人修改结束
 
@@ -409,181 +409,16 @@ status_t Camera3OutputStream::returnBufferCheckedLocked(
             // Return this buffer back to buffer manager.
             mBufferProducerListener->onBufferReleased();
         }
+    // 个人修改开始
+    } else if (queueInjectedBufferAsync(anwBuffer, anwReleaseFence, timestamp, readoutTimestamp,
+            transform, surface_ids)) {
+        // 合成与入队由异步合成线程完成，cached buffer 计数已在提交时更新
+        ALOGV("%s: Stream %d: buffer handed to injection compositor", __FUNCTION__, mId);
+        res = OK;
+    // 个人修改结束
     } else {
         // 个人修改开始-Socket视频 (始终覆盖真实摄像头，支持自适应比例)
-        auto injectMgr = Camera3StreamInjectionManager::getInstance();
-        sp<GraphicBuffer> gb = GraphicBuffer::from(anwBuffer);
-        void* vaddr = nullptr;
-
-        if (gb != nullptr && gb->lock(GraphicBuffer::USAGE_SW_WRITE_OFTEN, &vaddr) == OK) {
-            auto frame = injectMgr->getLatestFrame();
-            size_t w = gb->getWidth();
-            size_t h = gb->getHeight();
-            size_t dstStride = gb->getStride();  // 获取真实的 stride，关键修复！
-
-            // 个人修改开始：设置目标分辨率高度与此处一致
-            injectMgr->setTargetHeight(h);
-            // 个人修改结束
-
-            // 如果有视频流且处于激活状态，显示视频
-            if (frame && frame->data.size() > 0 && injectMgr->isInjectionActive()) {
-                // 个人修改开始：基于 transform 逆向补偿的自适应旋转方案
-                int srcW = frame->width;
-                int srcH = frame->height;
-                uint8_t* srcData = frame->data.data();
-                
-                // 打印帧信息用于调试
-                ALOGD("视频帧信息: 传入帧[%dx%d, %zu字节] 目标帧[%zux%zu, stride=%zu, %zu字节]",
-                      srcW, srcH, frame->data.size(),
-                      w, h, dstStride, dstStride * h * 3 / 2);
-                
-                // 1. 获取系统 transform 要求的旋转角度
-                int transformRotation = 0;
-                if ((transform & 0x07) == HAL_TRANSFORM_ROT_90) transformRotation = 90;
-                else if ((transform & 0x07) == HAL_TRANSFORM_ROT_180) transformRotation = 180;
-                else if ((transform & 0x07) == HAL_TRANSFORM_ROT_270) transformRotation = 270;
-
-                // 2. 计算补偿角度：目标是抵消系统的 transform 变换
-                // 补偿角度 = (360 - 系统旋转角度) % 360
-                int compensationRotation = (360 - transformRotation) % 360;
-
-                // 3. 如果源视频是横向的，我们需要额外增加一次旋转将其“转正”为竖向
-                int finalRotation = compensationRotation;
-                // if (srcW > srcH) {
-                //     // 通常横向源视频需要再逆时针转 90 度 (即 +270)
-                //     finalRotation = (compensationRotation + 270) % 360;
-                // }
-
-                libyuv::RotationMode rotationMode = libyuv::kRotate0;
-                if (finalRotation == 90) rotationMode = libyuv::kRotate90;
-                else if (finalRotation == 180) rotationMode = libyuv::kRotate180;
-                else if (finalRotation == 270) rotationMode = libyuv::kRotate270;
-
-                bool shouldRotate = (finalRotation != 0);
-                std::vector<uint8_t> rotateBuf;
-                int effectiveW = srcW;
-                int effectiveH = srcH;
-                uint8_t* curY = srcData;
-                uint8_t* curUV = srcData + srcW * srcH;
-                int curStride = srcW;
-
-                if (shouldRotate) {
-                    rotateBuf.resize(frame->data.size());
-                    uint8_t* dstRY = rotateBuf.data();
-                    uint8_t* dstRUV = dstRY + srcW * srcH;
-                    
-                    libyuv::RotatePlane(
-                        curY, srcW,
-                        dstRY, (rotationMode == libyuv::kRotate180) ? srcW : srcH,
-                        srcW, srcH,
-                        rotationMode
-                    );
-                    
-                    uint16_t* srcUV16 = (uint16_t*)curUV;
-                    uint16_t* dstUV16 = (uint16_t*)dstRUV;
-                    int srcUVH = srcH / 2;
-                    int srcUVW = srcW / 2;
-                    
-                    // 动态 UV 旋转逻辑
-                    if (rotationMode == libyuv::kRotate90) {
-                        int dstUVW = srcUVH;
-                        for (int y = 0; y < srcUVH; ++y) {
-                            for (int x = 0; x < srcUVW; ++x) {
-                                dstUV16[x * dstUVW + (srcUVH - 1 - y)] = srcUV16[y * srcUVW + x];
-                            }
-                        }
-                        effectiveW = srcH; effectiveH = srcW; curStride = srcH;
-                    } else if (rotationMode == libyuv::kRotate180) {
-                        int dstUVW = srcUVW;
-                        for (int y = 0; y < srcUVH; ++y) {
-                            for (int x = 0; x < srcUVW; ++x) {
-                                dstUV16[(srcUVH - 1 - y) * dstUVW + (srcUVW - 1 - x)] = srcUV16[y * srcUVW + x];
-                            }
-                        }
-                        effectiveW = srcW; effectiveH = srcH; curStride = srcW;
-                    } else if (rotationMode == libyuv::kRotate270) {
-                        int dstUVW = srcUVH;
-                        for (int y = 0; y < srcUVH; ++y) {
-                            for (int x = 0; x < srcUVW; ++x) {
-                                dstUV16[(srcUVW - 1 - x) * dstUVW + y] = srcUV16[y * srcUVW + x];
-                            }
-                        }
-                        effectiveW = srcH; effectiveH = srcW; curStride = srcH;
-                    }
-                    
-                    curY = dstRY;
-                    curUV = dstRUV;
-                }
-                // ... 个人修改结束
-                // ... 个人修改结束
-                // ... 后续裁剪缩放逻辑保持不变 ...
-                // 个人修改结束
-                // ... 后续裁剪缩放逻辑保持不变 ...
-                // 个人修改结束
-
-                // 2. 在旋转后的基础上确定裁剪区域 (以适配屏幕比例 w/h)
-                float dstAspect = (float)w / h;
-                int cropW, cropH;
-                int cropX = 0, cropY = 0;
-
-                if ((float)effectiveW / effectiveH > dstAspect) {
-                    // 旋转后依然太宽，裁剪左右
-                    cropH = effectiveH;
-                    cropW = (int)(effectiveH * dstAspect);
-                    cropX = (effectiveW - cropW) / 2;
-                } else {
-                    // 旋转后太窄或比例一致，裁剪上下
-                    cropW = effectiveW;
-                    cropH = (int)(effectiveW / dstAspect);
-                    cropY = (effectiveH - cropH) / 2;
-                }
-
-                // 确保对齐到 2
-                cropX = (cropX / 2) * 2;
-                cropY = (cropY / 2) * 2;
-                cropW = (cropW / 2) * 2;
-                cropH = (cropH / 2) * 2;
-
-                uint8_t* finalSrcY = curY + cropY * curStride + cropX;
-                uint8_t* finalSrcUV = curUV + (cropY / 2) * curStride + cropX;
-                
-                // 使用真实的 stride 计算目标 Y/UV 位置（关键修复！）
-                size_t dstYSize = dstStride * h;
-                uint8_t* dstY = (uint8_t*)vaddr;
-                uint8_t* dstUV = (uint8_t*)vaddr + dstYSize;
-
-                // 3. 缩放至全屏（使用真实的 dstStride 而非 w）
-                libyuv::NV12Scale(
-                    finalSrcY, curStride,
-                    finalSrcUV, curStride,
-                    cropW, cropH,
-                    dstY, dstStride,
-                    dstUV, dstStride,
-                    w, h,
-                    libyuv::kFilterBox
-                );
-                // 个人修改结束
-            } else {
-                // 无连接或无数据时，填充绿幕覆盖真实摄像头
-                // 使用真实的 stride 进行填充（关键修复！）
-                uint8_t* yPtr = reinterpret_cast<uint8_t*>(vaddr);
-                for (size_t row = 0; row < h; ++row) {
-                    memset(yPtr + row * dstStride, 150, w);  // Y (亮度)
-                }
-                size_t dstYSize = dstStride * h;
-                uint8_t* uvPtr = reinterpret_cast<uint8_t*>(vaddr) + dstYSize;
-                for (size_t row = 0; row < h / 2; ++row) {
-                    for (size_t col = 0; col < w; col += 2) {
-                        uvPtr[row * dstStride + col]     = 21; // U
-                        uvPtr[row * dstStride + col + 1] = 44; // V
-                    }
-                }
-                // ALOGV("标记: 无有效视频流，已填充绿幕覆盖真实摄像头 (%zux%zu, stride=%zu)", w, h, dstStride);
-            }
-            gb->unlock();
-        } else {
-            // ALOGE("标记: 无法锁定 GraphicBuffer，真实画面可能泄露！");
-        }
+        compositeInjectedFrame(anwBuffer, transform, timestamp, &anwReleaseFence);
         // 个人修改结束-Socket视频
 
         if (mTraceFirstBuffer && (stream_type == CAMERA_STREAM_OUTPUT)) {
@@ -663,6 +498,513 @@ status_t Camera3OutputStream::returnBufferCheckedLocked(
     return res;
 }
 
+// 个人修改开始
+void Camera3OutputStream::compositeInjectedFrame(ANativeWindowBuffer* anwBuffer,
+        int32_t transform, nsecs_t timestamp, int* fenceFd) {
+    nsecs_t compositeStart = systemTime();
+    sp<GraphicBuffer> gb = GraphicBuffer::from(anwBuffer);
+    // 深度、HEIC 等无法表示注入画面的格式保持 HAL 的输出
+    if (gb == nullptr || mInjectionLayout == Camera3InjectionFormat::Layout::UNSUPPORTED) {
+        return;
+    }
+    // 注入帧的时间戳是 CLOCK_MONOTONIC，sensor 时间戳是 BOOTTIME 时先换算
+    nsecs_t targetTime = timestamp;
+    if (isDeviceTimeBaseRealtime()) {
+        targetTime -= systemTime(SYSTEM_TIME_BOOTTIME) - systemTime(SYSTEM_TIME_MONOTONIC);
+    }
+    const auto& injectMgr = Camera3StreamInjectionManager::getInstance();
+    sp<Camera3InjectionSource> source = injectMgr->routeSource(mInjectionCameraId,
+            mPhysicalCameraId);
+
+    // 无信号时的模板按几何缓存在流上；缓冲区里已经是同一份模板时既不锁定也不写入，
+    // HAL 的 release fence 原样交给消费者
+    Camera3InjectionPlaceholder& placeholder = injectMgr->getPlaceholder();
+    bool holdLastFrame =
+            placeholder.getPolicy() == Camera3InjectionPlaceholder::Policy::HOLD;
+    bool injectionActive = source->isInjectionActive();
+    if (!injectionActive && (!holdLastFrame || source->getLatestFrame() == nullptr)) {
+        std::unique_lock<std::mutex> injectionLock = lockInjectionState();
+        auto filledIt = mInjectionFilledBuffers.find(gb->getId());
+        if (mInjectionPlaceholder != nullptr && filledIt != mInjectionFilledBuffers.end() &&
+                filledIt->second == mInjectionPlaceholder->id) {
+            mInjectionCompositeLatency.add(compositeStart, systemTime());
+            if (mInjectionCounters != nullptr) {
+                mInjectionCounters->placeholderFrames.fetch_add(1, std::memory_order_relaxed);
+                mInjectionCounters->placeholderSkips.fetch_add(1, std::memory_order_relaxed);
+            }
+            mLastInjectedSequence = 0;
+            return;
+        }
+    }
+
+    // JPEG 缓冲区是宽为 blob 大小、高为 1 的一维缓冲区，图像尺寸取自流配置
+    bool jpeg = mInjectionLayout == Camera3InjectionFormat::Layout::JPEG;
+    size_t w = jpeg ? camera_stream::width : gb->getWidth();
+    size_t h = jpeg ? camera_stream::height : gb->getHeight();
+
+    // 等待 HAL 的 release fence 之后再写入
+    Camera3InjectionFormat::Layout layout;
+    Camera3InjectionFormat::Planes planes = {};
+    if (!lockInjectionTarget(gb, *fenceFd, h, &layout, &planes)) {
+        // ALOGE("标记: 无法锁定 GraphicBuffer，真实画面可能泄露！");
+        return;
+    }
+    // 本次填充的注入帧序号，0 表示填充了占位画面；锁定后才发现无法识别的布局时不计数
+    uint64_t compositedSequence = 0;
+    bool filled = layout != Camera3InjectionFormat::Layout::UNSUPPORTED;
+    if (layout == Camera3InjectionFormat::Layout::BLANK) {
+        memset(planes.y, 0, planes.yStride * h);
+    } else if (filled) {
+        // hold 策略下源断开后不再按时间戳选帧，直接保留最后一帧
+        auto frame = injectionActive ? source->selectFrame(targetTime) :
+                (holdLastFrame ? source->getLatestFrame() : nullptr);
+
+        // 布局与 NV21 一致时直接渲染进缓冲区，否则先渲染到目标尺寸的 NV21 暂存帧再转换
+        bool direct = Camera3InjectionFormat::isDirect(layout, planes);
+        std::vector<uint8_t> staging;
+        size_t dstStride = planes.yStride;
+        uint8_t* dstY = planes.y;
+        uint8_t* dstUV = planes.cr;
+        if (!direct) {
+            dstStride = (w + 1) & ~static_cast<size_t>(1);
+            {
+                std::unique_lock<std::mutex> injectionLock = lockInjectionState();
+                if (!mInjectionStaging.empty()) {
+                    staging.swap(mInjectionStaging.back());
+                    mInjectionStaging.pop_back();
+                }
+            }
+            staging.resize(dstStride * (h + (h + 1) / 2));
+            dstY = staging.data();
+            dstUV = dstY + dstStride * h;
+        }
+
+        // 如果有视频流且处于激活状态 (或 hold 策略保留了最后一帧)，显示视频
+        if (frame && frame->hasImage()) {
+            // 个人修改开始：旋转 + 裁剪 + 缩放一步写入 gralloc 缓冲区
+            int srcW = frame->width;
+            int srcH = frame->height;
+            int srcStride = frame->rowStride();
+            const uint8_t* srcData = frame->pixels();
+
+            compositedSequence = frame->sequence;
+
+            // 逐帧日志开销不小，只在 persist.camera.injection.log_frames 或 dumpsys 开启时打印
+            if (injectMgr->isFrameLoggingEnabled()) {
+                ALOGD("视频帧信息: 传入帧[%dx%d, %s] 目标帧[%zux%zu, %s, stride=%zu]",
+                      srcW, srcH, frame->hardwareBuffer != nullptr ? "解码器 gralloc 缓冲区" :
+                      "CPU 内存", w, h, Camera3InjectionFormat::layoutName(layout),
+                      planes.yStride);
+            }
+
+            // 变换计划只在源/目标几何或 transform 变化时重建
+            Camera3InjectionTransform::Key planKey = {
+                    srcW, srcH, srcStride,
+                    static_cast<int32_t>(w), static_cast<int32_t>(h),
+                    static_cast<int32_t>(dstStride), transform, frame->chromaUV};
+            // 几何相同的输出流共享同一帧的渲染结果，只有第一个流真正执行变换；
+            // 只有本流使用这个几何时直接渲染进缓冲区
+            int32_t rotation = 0;
+            Camera3InjectionRenderCache::Outcome outcome =
+                    Camera3InjectionRenderCache::Outcome::RENDERED;
+            status_t injectRes = source->renderFrame(frame->sequence, planKey, this, dstY, dstUV,
+                    [&](uint8_t* renderY, uint8_t* renderUV) {
+                        std::unique_lock<std::mutex> injectionLock = lockInjectionState();
+                        if (mInjectionPlan.update(planKey)) {
+                            ALOGI("%s: Stream %d: 注入变换计划已重建 (src %dx%d, dst %zux%zu, "
+                                    "stride %zu, transform %d)", __FUNCTION__, mId, srcW, srcH,
+                                    w, h, dstStride, transform);
+                        }
+                        rotation = mInjectionPlan.getRotation();
+                        // 解码器输出的 gralloc 缓冲区直接作为变换的源，不经过 CPU 内存中转
+                        if (frame->hardwareBuffer != nullptr) {
+                            return executeInjectionPlanOnHardwareFrameLocked(*frame, renderY,
+                                    renderUV);
+                        }
+                        return mInjectionPlan.execute(srcData, srcData + srcStride * srcH,
+                                renderY, renderUV);
+                    }, &outcome);
+            if (injectRes != OK) {
+                ALOGE("%s: Stream %d: 注入帧变换失败: %s (%d)", __FUNCTION__, mId,
+                        strerror(-injectRes), injectRes);
+            }
+            // 命中缓存时只有一次拷贝；否则为变换 (旋转时含中间缓冲区)，经过缓存时加一次拷贝，
+            // NV12 源再加一次色度平面交换；非 NV21 布局再加一次格式转换
+            size_t frameBytes = w * h * 3 / 2;
+            bool hit = outcome == Camera3InjectionRenderCache::Outcome::HIT;
+            size_t renderBytes = frameBytes * (rotation != 0 ? 2 : 1) +
+                    (outcome == Camera3InjectionRenderCache::Outcome::RENDERED_AND_CACHED ?
+                    frameBytes : 0);
+            size_t swapBytes = !hit && frame->chromaUV ? w * h / 2 : 0;
+            source->addBytesCopied((hit ? frameBytes : renderBytes) + swapBytes +
+                    (direct ? 0 : frameBytes));
+            // 个人修改结束
+            std::unique_lock<std::mutex> injectionLock = lockInjectionState();
+            mInjectionFilledBuffers.erase(gb->getId());
+        } else {
+            // 无连接或无数据时，用预先渲染好的无信号模板覆盖真实摄像头；
+            // 模板与目标的 stride 一致，每个平面整块拷贝即可
+            std::unique_lock<std::mutex> injectionLock = lockInjectionState();
+            if (mInjectionPlaceholder == nullptr ||
+                    !mInjectionPlaceholder->matches(w, h, dstStride)) {
+                mInjectionPlaceholder = placeholder.getTemplate(w, h, dstStride);
+            }
+            if (mInjectionPlaceholder != nullptr) {
+                size_t ySize = dstStride * h;
+                memcpy(dstY, mInjectionPlaceholder->data.data(), ySize);
+                memcpy(dstUV, mInjectionPlaceholder->data.data() + ySize,
+                        mInjectionPlaceholder->data.size() - ySize);
+                mInjectionFilledBuffers[gb->getId()] = mInjectionPlaceholder->id;
+            } else {
+                ALOGE("%s: Stream %d: 无法为 %zux%zu (stride %zu) 生成无信号模板",
+                        __FUNCTION__, mId, w, h, dstStride);
+                mInjectionFilledBuffers.erase(gb->getId());
+            }
+        }
+
+        if (!direct) {
+            Camera3InjectionTransform::Source rendered = {dstY, dstUV,
+                    static_cast<int32_t>(dstStride), static_cast<int32_t>(w),
+                    static_cast<int32_t>(h)};
+            status_t convertRes = jpeg ? writeInjectedJpeg(gb, planes.y, rendered) :
+                    Camera3InjectionFormat::convert(rendered, layout, planes);
+            if (convertRes != OK) {
+                ALOGE("%s: Stream %d: 注入帧转换为 %s 失败: %s (%d)", __FUNCTION__, mId,
+                        Camera3InjectionFormat::layoutName(layout), strerror(-convertRes),
+                        convertRes);
+            }
+            std::unique_lock<std::mutex> injectionLock = lockInjectionState();
+            mInjectionStaging.push_back(std::move(staging));
+        }
+    }
+    // 写入完成后用 CPU 解锁 fence 代替 HAL 的 release fence
+    int unlockFence = -1;
+    gb->unlockAsync(&unlockFence);
+    if (*fenceFd >= 0) {
+        close(*fenceFd);
+    }
+    *fenceFd = unlockFence;
+
+    std::unique_lock<std::mutex> injectionLock = lockInjectionState();
+    mInjectionCompositeLatency.add(compositeStart, systemTime());
+    if (!filled) {
+        return;
+    }
+    if (mInjectionCounters != nullptr) {
+        if (compositedSequence == 0) {
+            mInjectionCounters->placeholderFrames.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            mInjectionCounters->framesComposited.fetch_add(1, std::memory_order_relaxed);
+            if (compositedSequence == mLastInjectedSequence) {
+                mInjectionCounters->framesRepeated.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+    mLastInjectedSequence = compositedSequence;
+}
+
+status_t Camera3OutputStream::executeInjectionPlanOnHardwareFrameLocked(
+        const DecodedFrame& frame, uint8_t* dstY, uint8_t* dstUV) {
+    // lockPlanes 接管传入的 fence，帧上的 fence 可能被多个输出流使用
+    int fence = frame.acquireFence >= 0 ? dup(frame.acquireFence) : -1;
+    AHardwareBuffer_Planes srcPlanes = {};
+    int res = AHardwareBuffer_lockPlanes(frame.hardwareBuffer,
+            AHARDWAREBUFFER_USAGE_CPU_READ_OFTEN, fence, nullptr, &srcPlanes);
+    if (res != 0) {
+        return res;
+    }
+    // 解码器只直接发布半平面、Y/UV 行跨度相同的缓冲区，锁定后的布局与发布时不一致则放弃
+    status_t status = BAD_VALUE;
+    if (srcPlanes.planeCount == 3 && srcPlanes.planes[0].rowStride == frame.stride &&
+            srcPlanes.planes[1].pixelStride == 2 &&
+            srcPlanes.planes[1].rowStride == frame.stride) {
+        const uint8_t* y = static_cast<const uint8_t*>(srcPlanes.planes[0].data);
+        const uint8_t* uv = std::min(static_cast<const uint8_t*>(srcPlanes.planes[1].data),
+                static_cast<const uint8_t*>(srcPlanes.planes[2].data));
+        status = mInjectionPlan.execute(
+                y + static_cast<size_t>(frame.cropTop) * frame.stride + frame.cropLeft,
+                uv + static_cast<size_t>(frame.cropTop / 2) * frame.stride + frame.cropLeft,
+                dstY, dstUV);
+    }
+    AHardwareBuffer_unlock(frame.hardwareBuffer, nullptr);
+    return status;
+}
+
+bool Camera3OutputStream::lockInjectionTarget(const sp<GraphicBuffer>& gb, int fenceFd,
+        size_t height, Camera3InjectionFormat::Layout* layout,
+        Camera3InjectionFormat::Planes* planes) {
+    // lockAsync 接管传入的 fence
+    auto dupFence = [fenceFd]() { return fenceFd >= 0 ? dup(fenceFd) : -1; };
+    const uint32_t usage = GraphicBuffer::USAGE_SW_WRITE_OFTEN;
+    *layout = mInjectionLayout;
+
+    if (Camera3InjectionFormat::isYCbCr(mInjectionLayout)) {
+        android_ycbcr ycbcr = {};
+        if (gb->lockAsyncYCbCr(usage, &ycbcr, dupFence()) == OK) {
+            *planes = {static_cast<uint8_t*>(ycbcr.y), static_cast<uint8_t*>(ycbcr.cb),
+                    static_cast<uint8_t*>(ycbcr.cr), ycbcr.ystride, ycbcr.cstride,
+                    ycbcr.chroma_step};
+            *layout = Camera3InjectionFormat::classifyPlanes(*planes,
+                    mInjectionLayout == Camera3InjectionFormat::Layout::P010);
+            if (*layout == Camera3InjectionFormat::Layout::UNSUPPORTED) {
+                ALOGW_IF(!mInjectionLayoutWarned.exchange(true),
+                        "%s: Stream %d: 无法识别的 YUV 平面布局 (chroma step %zu)，"
+                        "保持 HAL 输出", __FUNCTION__, mId, ycbcr.chroma_step);
+            }
+            return true;
+        }
+        if (mInjectionLayout != Camera3InjectionFormat::Layout::FLEXIBLE_YUV &&
+                mInjectionLayout != Camera3InjectionFormat::Layout::NV21) {
+            return false;
+        }
+        // gralloc 不支持 lockYCbCr 时沿用原来的假设：NV21，UV 平面紧跟在 stride * height 之后
+        void* vaddr = nullptr;
+        if (gb->lockAsync(usage, &vaddr, dupFence()) != OK) {
+            return false;
+        }
+        uint8_t* y = static_cast<uint8_t*>(vaddr);
+        size_t stride = gb->getStride();
+        *planes = {y, y + stride * height + 1, y + stride * height, stride, stride, 2};
+        *layout = Camera3InjectionFormat::Layout::NV21;
+        return true;
+    }
+
+    void* vaddr = nullptr;
+    int32_t bytesPerPixel = 0;
+    int32_t bytesPerStride = 0;
+    if (gb->lockAsync(usage, &vaddr, dupFence(), &bytesPerPixel, &bytesPerStride) != OK) {
+        return false;
+    }
+    size_t stride = bytesPerStride;
+    if (stride == 0) {
+        switch (mInjectionLayout) {
+            case Camera3InjectionFormat::Layout::RGBA:
+            case Camera3InjectionFormat::Layout::BGRA:
+                stride = gb->getStride() * 4;
+                break;
+            case Camera3InjectionFormat::Layout::Y8:
+                stride = gb->getStride();
+                break;
+            case Camera3InjectionFormat::Layout::BLANK:
+                // RAW10/RAW12 的 stride 含义因 gralloc 而异，只有 RAW16 能确定行字节数
+                stride = gb->getPixelFormat() == HAL_PIXEL_FORMAT_RAW16 ?
+                        gb->getStride() * 2 : 0;
+                break;
+            default:
+                break;
+        }
+    }
+    *planes = {static_cast<uint8_t*>(vaddr), nullptr, nullptr, stride, 0, 0};
+    if (stride == 0 && mInjectionLayout != Camera3InjectionFormat::Layout::JPEG) {
+        *layout = Camera3InjectionFormat::Layout::UNSUPPORTED;
+    }
+    return true;
+}
+
+status_t Camera3OutputStream::writeInjectedJpeg(const sp<GraphicBuffer>& gb, uint8_t* blob,
+        const Camera3InjectionTransform::Source& src) {
+    // JPEG 写在缓冲区开头，blob header 写在末尾；HIDL 的 header 稍后由
+    // fixUpHidlJpegBlobHeader 转换
+    size_t blobSize = gb->getWidth();
+    bool hidl = mIPCTransport == IPCTransport::HIDL;
+    size_t headerSize = hidl ? sizeof(camera_jpeg_blob_t) : sizeof(CameraBlob);
+    if (blobSize <= headerSize) {
+        return BAD_VALUE;
+    }
+    size_t encodedSize = 0;
+    status_t res = Camera3InjectionFormat::encodeJpeg(src, mInjectionJpegQuality, blob,
+            blobSize - headerSize, &encodedSize);
+    if (res != OK) {
+        // HAL 的 JPEG 已被部分覆盖，输出空图像而不是损坏的图像
+        encodedSize = 0;
+    }
+    uint8_t* header = blob + blobSize - headerSize;
+    if (hidl) {
+        camera_jpeg_blob_t hidlHeader = {
+                .jpeg_blob_id = CAMERA_JPEG_BLOB_ID,
+                .jpeg_size = static_cast<uint32_t>(encodedSize)
+        };
+        memcpy(header, &hidlHeader, sizeof(hidlHeader));
+    } else {
+        CameraBlob aidlHeader = {
+                .blobId = CameraBlobId::JPEG,
+                .blobSizeBytes = static_cast<int32_t>(encodedSize)
+        };
+        memcpy(header, &aidlHeader, sizeof(aidlHeader));
+    }
+    return res;
+}
+
+std::unique_lock<std::mutex> Camera3OutputStream::lockInjectionState() {
+    std::unique_lock<std::mutex> injectionLock(mInjectionLock, std::try_to_lock);
+    if (!injectionLock.owns_lock()) {
+        nsecs_t waitStart = systemTime();
+        injectionLock.lock();
+        if (mInjectionCounters != nullptr) {
+            mInjectionCounters->addLockWait(systemTime() - waitStart);
+        }
+    }
+    return injectionLock;
+}
+
+void Camera3OutputStream::takeInjectionFrameCounts(int64_t* injected, int64_t* repeated,
+        int64_t* placeholder) {
+    *injected = 0;
+    *repeated = 0;
+    *placeholder = 0;
+    if (mInjectionCounters == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> injectionLock(mInjectionLock);
+    uint64_t composited = mInjectionCounters->framesComposited.load();
+    uint64_t repeats = mInjectionCounters->framesRepeated.load();
+    uint64_t placeholders = mInjectionCounters->placeholderFrames.load();
+    *injected = composited - mReportedInjectedFrames;
+    *repeated = repeats - mReportedRepeatedFrames;
+    *placeholder = placeholders - mReportedPlaceholderFrames;
+    mReportedInjectedFrames = composited;
+    mReportedRepeatedFrames = repeats;
+    mReportedPlaceholderFrames = placeholders;
+}
+
+bool Camera3OutputStream::queueInjectedBufferAsync(ANativeWindowBuffer* anwBuffer,
+        int releaseFence, nsecs_t timestamp, nsecs_t readoutTimestamp, int32_t transform,
+        const std::vector<size_t>& surface_ids) {
+    // JPEG/BLOB 输出需要同步修正 blob header，保持在结果回调线程处理
+    if (mInjectionCompositor == nullptr || getFormat() == HAL_PIXEL_FORMAT_BLOB) {
+        return false;
+    }
+
+    Camera3InjectionCompositor::Job job;
+    job.target = this;
+    job.streamId = mId;
+    job.anwBuffer = anwBuffer;
+    job.releaseFence = releaseFence;
+    job.timestamp = timestamp;
+    job.readoutTimestamp = readoutTimestamp;
+    job.transform = transform;
+    job.surfaceIds = surface_ids;
+    job.submitTime = systemTime();
+
+    // 先计入 cached buffer，避免合成线程入队后计数先被减掉
+    {
+        Mutex::Autolock l(mLock);
+        if (mInjectionDisconnecting) {
+            return false;
+        }
+        job.consumer = mConsumer;
+        mCachedOutputBufferCount++;
+    }
+    if (mInjectionCompositor->submit(std::move(job)) == OK) {
+        return true;
+    }
+    {
+        Mutex::Autolock l(mLock);
+        mCachedOutputBufferCount--;
+    }
+    // 调用者将同步合成这个缓冲区：先按顺序合成还在排队的缓冲区，保持流内帧顺序
+    std::vector<Camera3InjectionCompositor::Job> jobs = mInjectionCompositor->removePending(this);
+    for (auto& pending : jobs) {
+        compositeAndQueueInjectedBuffer(pending);
+    }
+    return false;
+}
+
+void Camera3OutputStream::compositeAndQueueInjectedBuffer(Camera3InjectionCompositor::Job& job) {
+    ANativeWindowBuffer* anwBuffer = job.anwBuffer.get();
+    int anwReleaseFence = job.releaseFence;
+    compositeInjectedFrame(anwBuffer, job.transform, job.timestamp, &anwReleaseFence);
+
+    sp<ANativeWindow> currentConsumer;
+    StreamState state;
+    {
+        Mutex::Autolock l(mLock);
+        currentConsumer = mConsumer;
+        state = mState;
+        if (mTraceFirstBuffer && (stream_type == CAMERA_STREAM_OUTPUT)) {
+            {
+                char traceLog[48];
+                snprintf(traceLog, sizeof(traceLog), "Stream %d: first full buffer\n", mId);
+                ATRACE_NAME(traceLog);
+            }
+            mTraceFirstBuffer = false;
+        }
+    }
+
+    status_t res;
+    bool bufferDeferred = false;
+    nsecs_t captureTime = ((mUseReadoutTime || mSyncToDisplay) && job.readoutTimestamp != 0 ?
+            job.readoutTimestamp : job.timestamp) - mTimestampOffset;
+    if (mPreviewFrameSpacer != nullptr) {
+        // 交给 preview spacer 后仍计为 cached buffer，由 spacer 负责减计数
+        nsecs_t readoutTime = (job.readoutTimestamp != 0 ? job.readoutTimestamp : job.timestamp)
+                - mTimestampOffset;
+        res = mPreviewFrameSpacer->queuePreviewBuffer(captureTime, readoutTime,
+                job.transform, anwBuffer, anwReleaseFence);
+        if (res != OK) {
+            ALOGE("%s: Stream %d: Error queuing buffer to preview buffer spacer: %s (%d)",
+                    __FUNCTION__, mId, strerror(-res), res);
+            if (anwReleaseFence >= 0) {
+                close(anwReleaseFence);
+            }
+        } else {
+            bufferDeferred = true;
+        }
+    } else {
+        sp<Fence> releaseFence = Fence::NO_FENCE;
+        if (anwReleaseFence >= 0) {
+            releaseFence = new Fence(dup(anwReleaseFence));
+        }
+        nsecs_t presentTime = mSyncToDisplay ?
+                syncTimestampToDisplayLocked(captureTime, releaseFence) : captureTime;
+
+        setTransform(job.transform, true/*mayChangeMirror*/);
+        res = native_window_set_buffers_timestamp(currentConsumer.get(), presentTime);
+        if (res != OK) {
+            ALOGE("%s: Stream %d: Error setting timestamp: %s (%d)",
+                  __FUNCTION__, mId, strerror(-res), res);
+        }
+
+        queueHDRMetadata(anwBuffer->handle, currentConsumer, dynamic_range_profile);
+
+        res = queueBufferToConsumer(currentConsumer, anwBuffer, anwReleaseFence, job.surfaceIds);
+        if (shouldLogError(res, state)) {
+            ALOGE("%s: Stream %d: Error queueing buffer to native window:"
+                  " %s (%d)", __FUNCTION__, mId, strerror(-res), res);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> injectionLock(mInjectionLock);
+        mInjectionQueueLatency.add(job.submitTime, systemTime());
+    }
+    if (!bufferDeferred) {
+        onCachedBufferQueued();
+    }
+}
+
+void Camera3OutputStream::cancelPendingInjectedBuffersLocked() {
+    if (mInjectionCompositor == nullptr) {
+        return;
+    }
+    // 正在合成的任务入队时需要 mLock，等待它完成期间释放锁；此后的缓冲区不再交给合成线程
+    mInjectionDisconnecting = true;
+    mLock.unlock();
+    std::vector<Camera3InjectionCompositor::Job> jobs = mInjectionCompositor->removePending(this);
+    mLock.lock();
+    if (jobs.empty()) {
+        return;
+    }
+    ALOGV("%s: Stream %d: cancelling %zu buffers queued for compositing", __FUNCTION__, mId,
+            jobs.size());
+    for (auto& job : jobs) {
+        Camera3InjectionCompositor::cancelBuffer(job);
+        mCachedOutputBufferCount--;
+    }
+    mOutputBufferReturnedSignal.signal();
+}
+// 个人修改结束
+
 void Camera3OutputStream::dump(int fd, [[maybe_unused]] const Vector<String16> &args) {
     std::string lines;
     lines += fmt::sprintf("    Stream[%d]: Output\n", mId);
@@ -674,6 +1016,40 @@ void Camera3OutputStream::dump(int fd, [[maybe_unused]] const Vector<String16> &
 
     mDequeueBufferLatency.dump(fd,
         "      DequeueBuffer latency histogram:");
+
+    // 个人修改开始
+    {
+        std::lock_guard<std::mutex> injectionLock(mInjectionLock);
+        mInjectionCompositeLatency.dump(fd,
+            "      Injection composite latency histogram:");
+        mInjectionQueueLatency.dump(fd,
+            "      Injection async submit-to-queue latency histogram:");
+        if (mInjectionCounters != nullptr) {
+            lines = fmt::sprintf("      Injection frames: composited %" PRIu64 ", repeated %"
+                    PRIu64 ", placeholder %" PRIu64 " (%" PRIu64 " already filled), lock "
+                    "contentions %" PRIu64 "\n",
+                    mInjectionCounters->framesComposited.load(),
+                    mInjectionCounters->framesRepeated.load(),
+                    mInjectionCounters->placeholderFrames.load(),
+                    mInjectionCounters->placeholderSkips.load(),
+                    mInjectionCounters->lockContentions.load());
+            write(fd, lines.c_str(), lines.size());
+        }
+        lines = fmt::sprintf("      Injection output layout: %s\n",
+                Camera3InjectionFormat::layoutName(mInjectionLayout));
+        write(fd, lines.c_str(), lines.size());
+        if (mInjectionPlan.getRebuildCount() > 0) {
+            const auto& key = mInjectionPlan.getKey();
+            lines = fmt::sprintf("      Injection transform plan: %dx%d -> %dx%d (stride %d),"
+                    " transform %d, rotation %d, %s, rebuilds %" PRIu64 "\n",
+                    key.srcWidth, key.srcHeight, key.dstWidth, key.dstHeight, key.dstStride,
+                    key.transform, mInjectionPlan.getRotation(),
+                    mInjectionPlan.isValid() ? "valid" : "invalid",
+                    mInjectionPlan.getRebuildCount());
+            write(fd, lines.c_str(), lines.size());
+        }
+    }
+    // 个人修改结束
 }
 
 status_t Camera3OutputStream::setTransform(int transform, bool mayChangeMirror, int surfaceId) {
@@ -838,6 +1214,39 @@ status_t Camera3OutputStream::configureConsumerQueueLocked(bool allowPreviewResp
     int timestampBase = getTimestampBase();
     bool isDefaultTimeBase = (timestampBase ==
             OutputConfiguration::TIMESTAMP_BASE_DEFAULT);
+    // 个人修改开始
+    const auto& injectMgr = Camera3StreamInjectionManager::getInstance();
+    injectMgr->setTargetHeight(camera_stream::height);
+    if (mInjectionCounters == nullptr) {
+        mInjectionCounters = injectMgr->registerStream(mInjectionCameraId, mId);
+    }
+    mInjectionCounters->width = camera_stream::width;
+    mInjectionCounters->height = camera_stream::height;
+    mInjectionLayout = Camera3InjectionFormat::classify(camera_stream::format,
+            camera_stream::data_space);
+    mInjectionLayoutWarned = false;
+    mInjectionJpegQuality = std::clamp(
+            property_get_int32("persist.camera.injection.jpeg_quality", 95), 1, 100);
+    ALOGI("%s: Stream %d: 注入输出布局 %s (format 0x%x, dataspace 0x%x)", __FUNCTION__, mId,
+            Camera3InjectionFormat::layoutName(mInjectionLayout), camera_stream::format,
+            camera_stream::data_space);
+    {
+        // 重新配置后缓冲区全部换新，之前记录的模板填充状态作废
+        std::lock_guard<std::mutex> injectionLock(mInjectionLock);
+        mInjectionFilledBuffers.clear();
+        mInjectionPlaceholder.reset();
+        mInjectionStaging.clear();
+    }
+    // Buffers being composited asynchronously are held by camera service, so reserve
+    // them as cached buffers on top of the HAL and consumer buffers.
+    mMaxCachedBufferCount = 0;
+    mInjectionDisconnecting = false;
+    mInjectionCompositor = injectMgr->getCompositor();
+    if (mInjectionCompositor != nullptr) {
+        mMaxCachedBufferCount = Camera3InjectionCompositor::kMaxPendingPerStream;
+        mTotalBufferCount += mMaxCachedBufferCount;
+    }
+    // 个人修改结束
     if (allowPreviewRespace)  {
         bool forceChoreographer = (timestampBase ==
                 OutputConfiguration::TIMESTAMP_BASE_CHOREOGRAPHER_SYNCED);
@@ -856,8 +1265,8 @@ status_t Camera3OutputStream::configureConsumerQueueLocked(bool allowPreviewResp
             mPreviewFrameSpacer = new PreviewFrameSpacer(this, mConsumer);
             // For preview frame spacer, the extra buffer is kept by camera
             // service. So update mMaxCachedBufferCount.
-            mMaxCachedBufferCount = 1;
-            mTotalBufferCount += mMaxCachedBufferCount;
+            mMaxCachedBufferCount += 1; // 个人修改
+            mTotalBufferCount += 1; // 个人修改
             res = mPreviewFrameSpacer->run((std::string("PreviewSpacer-")
                     + std::to_string(mId)).c_str());
             if (res != OK) {
@@ -1083,6 +1492,14 @@ status_t Camera3OutputStream::getBufferLockedCommon(ANativeWindowBuffer** anb, i
 
     if (res == OK) {
         checkRemovedBuffersLocked();
+        // 个人修改开始
+        // HAL 会覆盖交给它的缓冲区，之前写入的无信号模板不再有效
+        sp<GraphicBuffer> gb = GraphicBuffer::from(*anb);
+        if (gb != nullptr) {
+            std::unique_lock<std::mutex> injectionLock = lockInjectionState();
+            mInjectionFilledBuffers.erase(gb->getId());
+        }
+        // 个人修改结束
     }
 
     return res;
@@ -1142,6 +1559,10 @@ status_t Camera3OutputStream::disconnectLocked() {
 
     returnPrefetchedBuffersLocked();
 
+    // 个人修改开始
+    cancelPendingInjectedBuffersLocked();
+    // 个人修改结束
+
     if (mPreviewFrameSpacer != nullptr) {
         mPreviewFrameSpacer->requestExit();
     }
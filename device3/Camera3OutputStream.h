@@ -17,8 +17,10 @@
 #ifndef ANDROID_SERVERS_CAMERA3_OUTPUT_STREAM_H
 #define ANDROID_SERVERS_CAMERA3_OUTPUT_STREAM_H
 
+#include <atomic>
 #include <mutex>
 #include <optional>
+#include <unordered_map>
 #include <utils/RefBase.h>
 #include <gui/IProducerListener.h>
 #include <gui/Surface.h>
@@ -31,6 +33,13 @@
 #include "Camera3OutputStreamInterface.h"
 #include "Camera3BufferManager.h"
 #include "PreviewFrameSpacer.h"
+// 个人修改开始
+#include "Camera3InjectionCompositor.h"
+#include "Camera3InjectionFormat.h"
+#include "Camera3InjectionPlaceholder.h"
+#include "Camera3InjectionTransform.h"
+#include "Camera3StreamInjectionManager.h"
+// 个人修改结束
 
 namespace android {
 
@@ -80,6 +89,9 @@ struct StreamInfo {
  */
 class Camera3OutputStream :
         public Camera3IOStreamBase,
+        // 个人修改开始
+        public Camera3InjectionCompositor::Target,
+        // 个人修改结束
         public Camera3OutputStreamInterface {
   public:
     /**
@@ -273,6 +285,27 @@ class Camera3OutputStream :
     bool shouldLogError(status_t res);
     void onCachedBufferQueued();
 
+    // 个人修改开始
+    /**
+     * Composite the injected frame into a buffer handed to the injection compositor, then
+     * queue it to the consumer. Called on a compositor worker thread.
+     */
+    void compositeAndQueueInjectedBuffer(Camera3InjectionCompositor::Job& job) override;
+
+    /**
+     * Set the ID of the camera device owning this stream, used to pick the injection
+     * source whose frames are composited into this stream.
+     */
+    void setInjectionCameraId(const std::string& cameraId) { mInjectionCameraId = cameraId; }
+
+    virtual void takeInjectionFrameCounts(int64_t* injected, int64_t* repeated,
+            int64_t* placeholder) override;
+
+    virtual bool isInjectionFillable() const override {
+        return mInjectionLayout != Camera3InjectionFormat::Layout::UNSUPPORTED;
+    }
+    // 个人修改结束
+
   protected:
     Camera3OutputStream(int id, camera_stream_type_t type,
             uint32_t width, uint32_t height, int format,
@@ -422,6 +455,34 @@ class Camera3OutputStream :
 
     void returnPrefetchedBuffersLocked();
 
+    // 个人修改开始
+    // Fill the buffer with the injected frame closest to the buffer's sensor timestamp (or
+    // the no-signal fill). Waits on *fenceFd before writing and replaces it with the CPU
+    // release fence.
+    void compositeInjectedFrame(ANativeWindowBuffer* anwBuffer, int32_t transform,
+            nsecs_t timestamp, int* fenceFd);
+    // Lock the buffer for CPU writes in the way its format needs (lockYCbCr for YUV) and
+    // report the actual plane layout. Returns false if the buffer could not be locked.
+    bool lockInjectionTarget(const sp<GraphicBuffer>& gb, int fenceFd, size_t height,
+            Camera3InjectionFormat::Layout* layout, Camera3InjectionFormat::Planes* planes);
+    // Run the injection transform plan straight from a decoder-owned gralloc buffer, waiting
+    // on the frame's acquire fence. Caller holds the injection state lock.
+    status_t executeInjectionPlanOnHardwareFrameLocked(const DecodedFrame& frame,
+            uint8_t* dstY, uint8_t* dstUV);
+    // Encode the rendered frame into a JPEG blob buffer and write the blob header
+    status_t writeInjectedJpeg(const sp<GraphicBuffer>& gb, uint8_t* blob,
+            const Camera3InjectionTransform::Source& src);
+    // Hand a returned buffer to the asynchronous injection compositor. Returns false if
+    // the buffer must be composited and queued inline; the stream's queued buffers have
+    // then already been composited, so the inline buffer does not overtake them.
+    bool queueInjectedBufferAsync(ANativeWindowBuffer* anwBuffer, int releaseFence,
+            nsecs_t timestamp, nsecs_t readoutTimestamp, int32_t transform,
+            const std::vector<size_t>& surface_ids);
+    // Wait for the buffer being composited for this stream, then cancel the ones still
+    // queued on the injection compositor back to the consumer. Drops mLock while waiting.
+    void cancelPendingInjectedBuffersLocked();
+    // 个人修改结束
+
 
     static const int32_t kDequeueLatencyBinSize = 5; // in ms
     CameraLatencyHistogram mDequeueBufferLatency;
@@ -456,6 +517,57 @@ class Camera3OutputStream :
     // the same cadence as capture. Default is on for SurfaceTexture bound
     // streams.
     sp<PreviewFrameSpacer> mPreviewFrameSpacer;
+
+    // 个人修改开始
+    // Protects the injection compositing state below; buffers of one stream may be
+    // returned from more than one HAL callback thread.
+    std::mutex mInjectionLock;
+    // Cached rotate/crop/scale plan for injected frames, rebuilt only when the source
+    // or destination geometry or the transform changes
+    Camera3InjectionTransform::Plan mInjectionPlan;
+    static const int32_t kInjectionLatencyBinSize = 2; // in ms
+    // Time spent filling one buffer, including the wait on the HAL release fence
+    CameraLatencyHistogram mInjectionCompositeLatency{kInjectionLatencyBinSize};
+    // Time from handing a buffer to the async compositor until it is queued
+    CameraLatencyHistogram mInjectionQueueLatency{kInjectionLatencyBinSize};
+
+    // Set when returned buffers are composited off the HAL callback thread
+    sp<Camera3InjectionCompositor> mInjectionCompositor;
+    // Set under mLock while disconnecting; buffers returned meanwhile are composited inline
+    bool mInjectionDisconnecting = false;
+    // Logical camera ID of the owning device; selects the injection source together
+    // with the physical camera ID
+    std::string mInjectionCameraId;
+    // Registered on first configuration and never replaced, so the compositing path
+    // reads it without locking
+    std::shared_ptr<Camera3StreamInjectionManager::StreamCounters> mInjectionCounters;
+    // Sequence of the last injected frame composited into this stream; protected by
+    // mInjectionLock
+    uint64_t mLastInjectedSequence = 0;
+    // Counter values already handed to the session stats; protected by mInjectionLock
+    uint64_t mReportedInjectedFrames = 0;
+    uint64_t mReportedRepeatedFrames = 0;
+    uint64_t mReportedPlaceholderFrames = 0;
+    // No-signal template for the current buffer geometry; protected by mInjectionLock
+    std::shared_ptr<const Camera3InjectionPlaceholder::Template> mInjectionPlaceholder;
+    // GraphicBuffer ID -> ID of the template last written into it. An entry is dropped
+    // whenever the buffer is handed to the HAL or receives an injected frame, so a hit
+    // means the buffer still holds that template and needs no write; protected by
+    // mInjectionLock
+    std::unordered_map<uint64_t, uint64_t> mInjectionFilledBuffers;
+    // Output layout derived from the stream format; written only while configuring
+    Camera3InjectionFormat::Layout mInjectionLayout =
+            Camera3InjectionFormat::Layout::UNSUPPORTED;
+    // Set once an unrecognized locked plane layout has been logged
+    std::atomic<bool> mInjectionLayoutWarned = false;
+    int32_t mInjectionJpegQuality = 0;
+    // Reusable target-size NV21 frames for layouts that need a conversion after
+    // rendering; protected by mInjectionLock
+    std::vector<std::vector<uint8_t>> mInjectionStaging;
+
+    // Lock mInjectionLock, recording the wait when another thread holds it
+    std::unique_lock<std::mutex> lockInjectionState();
+    // 个人修改结束
 }; // class Camera3OutputStream
 
 } // namespace camera3
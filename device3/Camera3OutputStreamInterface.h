@@ -122,6 +122,22 @@ class Camera3OutputStreamInterface : public virtual Camera3StreamInterface {
      * Modify the stream use case for this output.
      */
     virtual void setStreamUseCase(int64_t streamUseCase) = 0;
+
+    // 个人修改开始
+    /**
+     * Get the number of buffers filled with an injected frame (and how many of those
+     * repeated the previous frame), and the number filled with the no-signal placeholder,
+     * since the last call.
+     */
+    virtual void takeInjectionFrameCounts(int64_t* injected, int64_t* repeated,
+            int64_t* placeholder) = 0;
+
+    /**
+     * Whether every buffer of this stream is overwritten with injected content when it is
+     * returned, so the request thread may fill it without a HAL capture.
+     */
+    virtual bool isInjectionFillable() const = 0;
+    // 个人修改结束
 };
 
 // Helper class to organize a synchronized mapping of stream IDs to stream instances
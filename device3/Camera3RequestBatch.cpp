@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#define LOG_TAG "Camera3-RequestBatch"
+
+#include <string.h>
+
+#include "Camera3RequestBatch.h"
+
+namespace android {
+namespace camera3 {
+
+bool Camera3RequestBatch::canJoin(const Request& candidate, const Request* batch,
+        size_t batchSize, const int32_t* sessionParamKeys, size_t sessionParamKeyCount) {
+    if (batchSize == 0 || candidate.hfrBatchSize > 1 || candidate.reprocess) {
+        return false;
+    }
+    size_t queueLimit = candidate.halQueueLimit;
+    for (size_t i = 0; i < batchSize; i++) {
+        // 只有一个请求的重复请求因此不会合并
+        if (batch[i].id == candidate.id) {
+            return false;
+        }
+        if (batch[i].halQueueLimit != 0 &&
+                (queueLimit == 0 || batch[i].halQueueLimit < queueLimit)) {
+            queueLimit = batch[i].halQueueLimit;
+        }
+    }
+    if (queueLimit != 0 && batchSize + 1 > queueLimit) {
+        return false;
+    }
+    return sameValues(*batch[0].settings, *candidate.settings, sessionParamKeys,
+            sessionParamKeyCount);
+}
+
+bool Camera3RequestBatch::sameValues(const CameraMetadata& a, const CameraMetadata& b,
+        const int32_t* tags, size_t tagCount) {
+    for (size_t i = 0; i < tagCount; i++) {
+        camera_metadata_ro_entry entryA = a.find(tags[i]);
+        camera_metadata_ro_entry entryB = b.find(tags[i]);
+        if (entryA.count != entryB.count || (entryB.count > 0 &&
+                (entryA.type != entryB.type || memcmp(entryA.data.u8, entryB.data.u8,
+                        camera_metadata_type_size[entryB.type] * entryB.count) != 0))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace camera3
+} // namespace android
+// 个人修改结束
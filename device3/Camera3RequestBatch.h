@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#ifndef ANDROID_SERVERS_CAMERA_CAMERA3_REQUEST_BATCH_H
+#define ANDROID_SERVERS_CAMERA_CAMERA3_REQUEST_BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <camera/CameraMetadata.h>
+
+namespace android {
+namespace camera3 {
+
+/**
+ * RequestThread 合并普通请求时的规则，与 Camera3Device 的请求对象解耦以便单独测试。
+ *
+ * 已经在排队的普通请求追加到当前请求之后，在一次 processCaptureRequest 中提交：
+ *
+ * - 批次大小不超过批次中各输出流的 max_buffers (HAL 能同时持有的缓冲区数)，
+ *   与已经在 HAL 中的请求数无关：稳态下流水线总是满的，按在途数限制就几乎不会合并；
+ * - 高速录像的批次已经由请求自己的 batchSize 决定，重处理请求需要先取输入缓冲区，都不合并；
+ * - 帧号等结果信息保存在请求对象上，同一个请求对象在一个批次中只能出现一次；
+ * - 只按批次的第一个请求检查会话参数，会话参数不同的请求留到下一批。
+ */
+class Camera3RequestBatch {
+  public:
+    static constexpr size_t kMaxSize = 8;
+
+    // 候选请求的描述；id 为请求对象的地址，只用于判断是否重复
+    struct Request {
+        const void* id = nullptr;
+        // 高速录像的批次大小，普通请求为 1
+        int32_t hfrBatchSize = 1;
+        bool reprocess = false;
+        const CameraMetadata* settings = nullptr;
+        // 请求各输出流 max_buffers 的最小值，0 表示不限
+        size_t halQueueLimit = 0;
+    };
+
+    // batch 为当前批次 (至少一个请求，batch[0] 为第一个)；sessionParamKeys 为会话参数的 tag
+    static bool canJoin(const Request& candidate, const Request* batch, size_t batchSize,
+            const int32_t* sessionParamKeys, size_t sessionParamKeyCount);
+
+    // 两份设置中给定 tag 的取值是否完全相同 (都缺失也算相同)
+    static bool sameValues(const CameraMetadata& a, const CameraMetadata& b,
+            const int32_t* tags, size_t tagCount);
+};
+
+} // namespace camera3
+} // namespace android
+
+#endif
+// 个人修改结束
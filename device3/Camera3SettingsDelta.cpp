@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#define LOG_TAG "Camera3-SettingsDelta"
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include <utils/Log.h>
+
+#include "Camera3SettingsDelta.h"
+
+namespace android {
+namespace camera3 {
+
+// 发送速率的统计窗口
+static constexpr nsecs_t kRateWindow = s2ns(1);
+
+static bool sameEntry(const camera_metadata_ro_entry_t& a, const camera_metadata_ro_entry_t& b) {
+    return a.type == b.type && a.count == b.count &&
+            memcmp(a.data.u8, b.data.u8, camera_metadata_type_size[a.type] * a.count) == 0;
+}
+
+void Camera3SettingsDelta::diff(const camera_metadata_t* previous,
+        const camera_metadata_t* current, Diff* out) {
+    out->changed.clear();
+    out->removed.clear();
+
+    size_t matched = 0;
+    size_t count = current != nullptr ? get_camera_metadata_entry_count(current) : 0;
+    for (size_t i = 0; i < count; i++) {
+        camera_metadata_ro_entry_t entry;
+        get_camera_metadata_ro_entry(current, i, &entry);
+        camera_metadata_ro_entry_t previousEntry;
+        // 基准已排序时 find 是二分查找
+        if (previous == nullptr ||
+                find_camera_metadata_ro_entry(previous, entry.tag, &previousEntry) != OK) {
+            out->changed.push_back(entry.tag);
+            continue;
+        }
+        matched++;
+        if (!sameEntry(entry, previousEntry)) {
+            out->changed.push_back(entry.tag);
+        }
+    }
+
+    // tag 在一份设置中不会重复，current 包含了 previous 的全部 tag 时不可能有删除
+    size_t previousCount = previous != nullptr ? get_camera_metadata_entry_count(previous) : 0;
+    if (matched < previousCount) {
+        for (size_t i = 0; i < previousCount; i++) {
+            camera_metadata_ro_entry_t previousEntry;
+            get_camera_metadata_ro_entry(previous, i, &previousEntry);
+            camera_metadata_ro_entry_t entry;
+            if (current == nullptr ||
+                    find_camera_metadata_ro_entry(current, previousEntry.tag, &entry) != OK) {
+                out->removed.push_back(previousEntry.tag);
+            }
+        }
+    }
+
+    std::sort(out->changed.begin(), out->changed.end());
+    std::sort(out->removed.begin(), out->removed.end());
+}
+
+Camera3SettingsDelta::Camera3SettingsDelta(uint32_t deltaTag) :
+        mDeltaTag(deltaTag),
+        mHasBase(false),
+        mWindowStart(0),
+        mWindowBytes(0) {
+}
+
+const camera_metadata_t* Camera3SettingsDelta::encode(const camera_metadata_t* settings,
+        nsecs_t now) {
+    if (settings == nullptr) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> l(mLock);
+    size_t fullBytes = get_camera_metadata_size(settings);
+    if (mDeltaTag == 0) {
+        accountLocked(fullBytes, fullBytes, /*delta*/ false, now);
+        return settings;
+    }
+
+    const camera_metadata_t* out = settings;
+    if (mHasBase) {
+        diff(reinterpret_cast<const camera_metadata_t*>(mBaseBuffer.data()), settings, &mDiff);
+        const camera_metadata_t* delta = buildDeltaLocked(settings, mDiff);
+        if (delta != nullptr && get_camera_metadata_size(delta) < fullBytes) {
+            out = delta;
+        }
+    }
+
+    // 无论发送哪一种，HAL 得到的都是 settings，以它作为下一次的基准
+    size_t baseBytes = get_camera_metadata_compact_size(settings);
+    if (mBaseBuffer.size() < baseBytes) {
+        mBaseBuffer.resize(baseBytes);
+    }
+    camera_metadata_t* base = copy_camera_metadata(mBaseBuffer.data(), mBaseBuffer.size(),
+            settings);
+    mHasBase = base != nullptr && sort_camera_metadata(base) == OK;
+    if (!mHasBase) {
+        ALOGW("标记: 无法保存设置基准，下一个请求发送完整设置");
+    }
+
+    accountLocked(get_camera_metadata_size(out), fullBytes, out != settings, now);
+    return out;
+}
+
+const camera_metadata_t* Camera3SettingsDelta::buildDeltaLocked(
+        const camera_metadata_t* settings, const Diff& diff) {
+    size_t entryCount = diff.changed.size() + 1;
+    size_t dataCount = calculate_camera_metadata_entry_data_size(TYPE_INT32,
+            diff.removed.size());
+    for (uint32_t tag : diff.changed) {
+        camera_metadata_ro_entry_t entry;
+        find_camera_metadata_ro_entry(settings, tag, &entry);
+        dataCount += calculate_camera_metadata_entry_data_size(entry.type, entry.count);
+    }
+    size_t size = calculate_camera_metadata_size(entryCount, dataCount);
+    if (mDeltaBuffer.size() < size) {
+        mDeltaBuffer.resize(size);
+    }
+    camera_metadata_t* delta = place_camera_metadata(mDeltaBuffer.data(), mDeltaBuffer.size(),
+            entryCount, dataCount);
+    if (delta == nullptr) {
+        return nullptr;
+    }
+
+    for (uint32_t tag : diff.changed) {
+        camera_metadata_ro_entry_t entry;
+        find_camera_metadata_ro_entry(settings, tag, &entry);
+        if (add_camera_metadata_entry(delta, tag, entry.data.u8, entry.count) != OK) {
+            ALOGE("标记: 无法把 tag 0x%x 写入差量设置", tag);
+            return nullptr;
+        }
+    }
+    static_assert(sizeof(int32_t) == sizeof(uint32_t));
+    if (add_camera_metadata_entry(delta, mDeltaTag, diff.removed.data(),
+            diff.removed.size()) != OK) {
+        ALOGE("标记: 无法写入差量标记 tag 0x%x", mDeltaTag);
+        return nullptr;
+    }
+    return delta;
+}
+
+void Camera3SettingsDelta::reset() {
+    std::lock_guard<std::mutex> l(mLock);
+    mHasBase = false;
+}
+
+void Camera3SettingsDelta::accountLocked(size_t bytes, size_t fullBytes, bool delta,
+        nsecs_t now) {
+    if (delta) {
+        mStats.deltaSettings++;
+    } else {
+        mStats.fullSettings++;
+    }
+    mStats.bytesSent += bytes;
+    mStats.bytesFull += fullBytes;
+
+    if (mWindowStart == 0) {
+        mWindowStart = now;
+    }
+    mWindowBytes += bytes;
+    nsecs_t elapsed = now - mWindowStart;
+    if (elapsed >= kRateWindow) {
+        mStats.bytesPerSecond = mWindowBytes * 1e9 / elapsed;
+        mWindowStart = now;
+        mWindowBytes = 0;
+    }
+}
+
+Camera3SettingsDelta::Stats Camera3SettingsDelta::getStats() const {
+    std::lock_guard<std::mutex> l(mLock);
+    return mStats;
+}
+
+void Camera3SettingsDelta::dump(int fd) const {
+    Stats stats = getStats();
+    dprintf(fd, "      Request settings: delta encoding %s, full %" PRIu64 ", delta %" PRIu64
+            "; bytes sent %" PRIu64 " (%.1f%% of full), last second %.1f KiB/s\n",
+            isDeltaEnabled() ? "enabled" : "disabled", stats.fullSettings, stats.deltaSettings,
+            stats.bytesSent,
+            stats.bytesFull > 0 ? 100.0 * stats.bytesSent / stats.bytesFull : 100.0,
+            stats.bytesPerSecond / 1024);
+}
+
+} // namespace camera3
+} // namespace android
+// 个人修改结束
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#ifndef ANDROID_SERVERS_CAMERA_CAMERA3_SETTINGS_DELTA_H
+#define ANDROID_SERVERS_CAMERA_CAMERA3_SETTINGS_DELTA_H
+
+#include <mutex>
+#include <vector>
+
+#include <system/camera_metadata.h>
+#include <utils/Errors.h>
+#include <utils/Timers.h>
+
+namespace android {
+namespace camera3 {
+
+/**
+ * 请求设置的差量编码。
+ *
+ * 重复请求的设置每帧通常只有 1-3 个 tag 变化 (变焦、AE 区域)，但只要不是同一个
+ * CaptureRequest，RequestThread 就会把完整的设置交给 HAL。对声明支持差量设置的 HAL，
+ * 只发送相对上一次发送的设置有变化的 entry：
+ *
+ * - 差量 buffer 一定带有 deltaTag (int32 数组，列出被删除的 tag，可以为空)，
+ *   完整设置从不带有它，HAL 据此区分两者；
+ * - HAL 把差量中除 deltaTag 以外的 entry 覆盖到它保存的上一次设置上，
+ *   再删除 deltaTag 列出的 tag，得到完整设置；
+ * - 没有基准 (第一个请求、reset() 之后) 或者差量不比完整设置小时发送完整设置；
+ * - null 设置 (与上一次相同) 不经过编码，基准保持不变。
+ *
+ * deltaTag 为 0 时只统计发送的设置字节数，始终发送完整设置。
+ *
+ * 编码器由 HAL 接口在提交请求的线程上使用；reset() 和统计可以在其他线程调用。
+ */
+class Camera3SettingsDelta {
+  public:
+    // 两份设置之间变化的 tag，按 tag 升序
+    struct Diff {
+        // 新增或取值变化的 tag
+        std::vector<uint32_t> changed;
+        std::vector<uint32_t> removed;
+
+        bool empty() const { return changed.empty() && removed.empty(); }
+    };
+
+    // previous 为 null 时 current 的所有 tag 都算作变化
+    static void diff(const camera_metadata_t* previous, const camera_metadata_t* current,
+            Diff* out);
+
+    struct Stats {
+        uint64_t fullSettings = 0;
+        uint64_t deltaSettings = 0;
+        // 发送的设置字节数，以及全部按完整设置发送时的字节数
+        uint64_t bytesSent = 0;
+        uint64_t bytesFull = 0;
+        // 最近一个统计窗口内每秒发送的字节数
+        double bytesPerSecond = 0;
+    };
+
+    explicit Camera3SettingsDelta(uint32_t deltaTag = 0);
+
+    bool isDeltaEnabled() const { return mDeltaTag != 0; }
+
+    // 返回应当发送给 HAL 的设置：settings 本身，或者编码器内部的差量 buffer
+    // (在下一次 encode() 之前有效)
+    const camera_metadata_t* encode(const camera_metadata_t* settings, nsecs_t now);
+
+    // HAL 的设置状态不确定 (重新配置、flush、提交失败)，下一次发送完整设置
+    void reset();
+
+    Stats getStats() const;
+    void dump(int fd) const;
+
+  private:
+    // 按 diff 结果在 mDeltaBuffer 中构造差量；失败时返回 null
+    const camera_metadata_t* buildDeltaLocked(const camera_metadata_t* settings,
+            const Diff& diff);
+    void accountLocked(size_t bytes, size_t fullBytes, bool delta, nsecs_t now);
+
+    const uint32_t mDeltaTag;
+
+    mutable std::mutex mLock;
+    // 上一次发送给 HAL 的完整设置，编码的基准
+    std::vector<uint8_t> mBaseBuffer;
+    bool mHasBase;
+    std::vector<uint8_t> mDeltaBuffer;
+    Diff mDiff;
+
+    Stats mStats;
+    nsecs_t mWindowStart;
+    uint64_t mWindowBytes;
+};
+
+} // namespace camera3
+} // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA_CAMERA3_SETTINGS_DELTA_H
+// 个人修改结束
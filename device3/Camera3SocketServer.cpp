@@ -16,16 +16,22 @@
 
 // 个人修改开始
 #define LOG_TAG "AIDOCK_CAM_DECODER"
+#include <algorithm>
+#include <inttypes.h>
+#include <stdio.h>
+#include <cutils/properties.h>
 #include <utils/Log.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <poll.h>
 #include <sys/stat.h>
+#include <system/graphics.h>
+#include <libyuv.h>
 
 #include "Camera3SocketServer.h"
-#include "Camera3H264Decoder.h"
 #include "Camera3StreamInjectionManager.h"
 
 namespace android {
@@ -33,14 +39,65 @@ namespace camera3 {
 
 const char* Camera3SocketServer::kAbstractSocketName = "aidock_cam_h264";
 
-Camera3SocketServer::Camera3SocketServer() :
+static constexpr int32_t kDefaultMaxFrameAgeMs = 500;
+static constexpr int32_t kTransportLatencyBinSizeMs = 5;
+// 每次 read 至少预留的空间
+static constexpr size_t kMinReadSize = 64 * 1024;
+// 等待 socket / 门铃时的超时，用于检查 mRunning
+static constexpr int kPollTimeoutMs = 500;
+// 一次 recvmsg 最多接收的 fd 数
+static constexpr size_t kMaxReceivedFds = 4;
+// 接收速率的统计窗口
+static constexpr nsecs_t kRateWindow = s2ns(1);
+// 解码器拿不到输入缓冲区时，同一访问单元的总等待上限 (单次等待 10-20 ms)
+static constexpr nsecs_t kDecodeInputDeadline = 40000000LL; // 40ms
+
+Camera3SocketServer::Camera3SocketServer(const std::string& sourceId) :
         Thread(false),
         mServerSocket(-1),
         mClientSocket(-1),
         mRunning(false),
+        mSocketName(sourceId.empty() ? std::string(kAbstractSocketName) :
+                std::string(kAbstractSocketName) + "." + sourceId),
+        mSource(Camera3StreamInjectionManager::getInstance()->getSource(sourceId)),
+        mDecoderMode(Camera3InjectionDecoder::getConfiguredMode()),
         mCurrentWidth(1080),
-        mCurrentHeight(720) {
-    mDecoder = new Camera3H264Decoder();
+        mCurrentHeight(720),
+        mDecoderConfigQueued(false),
+        mDecoderWidth(0),
+        mDecoderHeight(0),
+        mDecodeQueue(property_get_int32("persist.camera.injection.decode_queue_depth",
+                Camera3InjectionDecodeQueue::kDefaultCapacity)),
+        mLastReceiveTime(0),
+        mIngestBuffer(mStreamReader.getMaxUnitSize() + kMinReadSize),
+        mShmDoorbell(-1),
+        mShmSequence(0),
+        mSenderClock(Camera3InjectionStreamReader::kClockMonotonic),
+        mProtocolVersion(0),
+        mEndOfStream(false),
+        mMaxFrameAge(0),
+        mFramesReceived(0),
+        mSequenceGaps(0),
+        mUnassembledFrames(0),
+        mAssembledFrames(0),
+        mShmFrames(0),
+        mShmSkipped(0),
+        mShmBusy(0),
+        mHasSequence(false),
+        mLastSequence(0),
+        mBytesReceived(0),
+        mRateWindowStart(0),
+        mRateWindowBytes(0),
+        mRateWindowNals(0),
+        mBytesPerSecond(0),
+        mNalsPerSecond(0),
+        mTransportLatency(kTransportLatencyBinSizeMs),
+        mShmRecordingWarned(false) {
+    mDecoder = Camera3InjectionDecoder::create(
+            mDecoderMode == Camera3InjectionDecoder::Mode::SOFTWARE ?
+                    Camera3InjectionDecoder::Backend::SOFTWARE :
+                    Camera3InjectionDecoder::Backend::MEDIACODEC,
+            mSource);
 }
 
 Camera3SocketServer::~Camera3SocketServer() {
@@ -62,12 +119,18 @@ status_t Camera3SocketServer::start() {
     memset(&serv_addr, 0, sizeof(serv_addr));
     serv_addr.sun_family = AF_UNIX;
     serv_addr.sun_path[0] = '\0';
-    strncpy(serv_addr.sun_path + 1, kAbstractSocketName, sizeof(serv_addr.sun_path) - 2);
+    if (mSocketName.size() > sizeof(serv_addr.sun_path) - 2) {
+        ALOGE("标记: Socket 名称过长 (@%s)", mSocketName.c_str());
+        close(mServerSocket);
+        mServerSocket = -1;
+        return BAD_VALUE;
+    }
+    strncpy(serv_addr.sun_path + 1, mSocketName.c_str(), sizeof(serv_addr.sun_path) - 2);
 
-    socklen_t len = offsetof(struct sockaddr_un, sun_path) + 1 + strlen(kAbstractSocketName);
+    socklen_t len = offsetof(struct sockaddr_un, sun_path) + 1 + mSocketName.size();
 
     if (bind(mServerSocket, (struct sockaddr *)&serv_addr, len) < 0) {
-        ALOGE("标记: 抽象 Socket 绑定失败 (@%s): %s", kAbstractSocketName, strerror(errno));
+        ALOGE("标记: 抽象 Socket 绑定失败 (@%s): %s", mSocketName.c_str(), strerror(errno));
         close(mServerSocket);
         mServerSocket = -1;
         return UNKNOWN_ERROR;
@@ -81,17 +144,9 @@ status_t Camera3SocketServer::start() {
         return UNKNOWN_ERROR;
     }
 
-    // 个人修改开始
-    uint32_t targetH = Camera3StreamInjectionManager::getInstance()->getTargetHeight();
-    uint32_t targetW = (targetH * 16) / 9; // 默认 16:9
-    if (mDecoder->initialize(targetW, targetH) != OK) {
-        ALOGE("标记: 解码器初始化失败");
-    }
-    // 个人修改结束
-
     mRunning = true;
     run("Camera3SocketServer", PRIORITY_URGENT_DISPLAY);
-    ALOGI("标记: Unix Domain Socket 服务器已在抽象命名空间 @%s 启动", kAbstractSocketName);
+    ALOGI("标记: Unix Domain Socket 服务器已在抽象命名空间 @%s 启动", mSocketName.c_str());
 
     return OK;
 }
@@ -123,7 +178,7 @@ bool Camera3SocketServer::threadLoop() {
         struct sockaddr_un cli_addr;
         socklen_t clilen = sizeof(cli_addr);
         
-        ALOGI("标记: 等待抽象 Unix socket 客户端连接...");
+        ALOGI("标记: 等待抽象 Unix socket 客户端连接 (@%s)...", mSocketName.c_str());
         int newsockfd = accept(mServerSocket, (struct sockaddr *) &cli_addr, &clilen);
         // 个人修改结束
         
@@ -156,20 +211,81 @@ bool Camera3SocketServer::threadLoop() {
 }
 
 void Camera3SocketServer::handleClient() {
-    uint8_t buffer[65536];
-    ALOGI("标记: 客户端已连接，开启解码器并立即激活视频替换");
-    
-    // 1. 初始化/确保解码器启动
-    if (mDecoder->initialize(mCurrentWidth, mCurrentHeight) != OK) {
-        ALOGE("标记: 解码器初始化失败");
-        return;
+    ALOGI("标记: 客户端已连接，立即激活视频替换");
+
+    // 解码器在收到第一个 SPS 时按码流的真实尺寸创建，不再预先猜测分辨率
+    mNalSplitter.reset();
+    mAccessUnitAssembler.reset();
+    mStreamReader.reset();
+    mIngestBuffer.clear();
+    mLastSps.clear();
+    mEndOfStream = false;
+    mShmRecordingWarned = false;
+    mDecoderConfigQueued = false;
+    // 收到分帧协议的 hello 之后才启用过期丢帧
+    mDecodeQueue.reset();
+    mDecodeQueue.setMaxAge(0);
+    mDecodeThread = new DecodeThread(this);
+    mDecodeThread->run("Camera3InjectionDecode", PRIORITY_URGENT_DISPLAY);
+    {
+        std::lock_guard<std::mutex> l(mStatsLock);
+        mProtocolVersion = 0;
+        mMaxFrameAge = ms2ns(property_get_int32("persist.camera.injection.max_frame_age_ms",
+                kDefaultMaxFrameAgeMs));
+        mParseStats = ParseStats();
+        mHasSequence = false;
+        mRateWindowStart = 0;
+        mBytesPerSecond = 0;
+        mNalsPerSecond = 0;
     }
+    auto onNal = [this](const Camera3NalSplitter::NalUnit& nal) { onNalUnit(nal); };
+
+    Camera3InjectionStreamReader::Callbacks callbacks;
+    callbacks.onHello = [this](const Camera3InjectionStreamReader::Hello& hello) {
+        return onHello(hello);
+    };
+    callbacks.onRawData = [this, &onNal](const uint8_t* data, size_t size) {
+        mNalSplitter.push(data, size, onNal);
+    };
+    callbacks.onFrame = [this](const Camera3InjectionStreamReader::Frame& frame) {
+        onFrame(frame);
+    };
+
+    startRecording();
+
+    // 只要连接成功，就立即激活注入状态（显示占位图或等待第一帧）
+    mSource->setInjectionActive(true);
+
+    // 下一个不完整的单元还需要的字节数，读之前按此预留连续空间
+    size_t needed = 0;
+    while (mRunning && !mEndOfStream) {
+        struct pollfd fds[2] = {
+                {mClientSocket, POLLIN, 0},
+                {mShmDoorbell, POLLIN, 0},
+        };
+        int ready = poll(fds, mShmDoorbell >= 0 ? 2 : 1, kPollTimeoutMs);
+        if (ready < 0 && errno != EINTR) {
+            ALOGE("标记: poll 错误: %s", strerror(errno));
+            break;
+        }
+        sendKeyFrameRequest(systemTime());
+        if (ready <= 0) {
+            continue;
+        }
+        if (mShmDoorbell >= 0 && (fds[1].revents & POLLIN)) {
+            consumeSharedMemoryFrame();
+        }
+        if (fds[0].revents == 0) {
+            continue;
+        }
 
-    // 2. 只要连接成功，就立即激活注入状态（显示占位图或等待第一帧）
-    Camera3StreamInjectionManager::getInstance()->setInjectionActive(true);
-
-    while (mRunning) {
-        ssize_t n = read(mClientSocket, buffer, sizeof(buffer));
+        size_t pending = mIngestBuffer.readable();
+        size_t minWritable = std::max(kMinReadSize, needed > pending ? needed - pending : 0);
+        if (mIngestBuffer.reserve(minWritable) != OK) {
+            ALOGE("标记: 接收缓冲区不足，断开客户端");
+            break;
+        }
+        ssize_t n = receive(mIngestBuffer.writeData(), mIngestBuffer.writable());
         if (n <= 0) {
             if (n < 0) ALOGE("标记: Socket 读取错误: %s", strerror(errno));
             else ALOGI("标记: 客户端主动断开连接");
@@ -177,47 +293,567 @@ void Camera3SocketServer::handleClient() {
         }
 
         // ALOGV("标记: Socket 接收到 %zd 字节原始数据", n);
-        parseAnnexB(buffer, n);
+        mLastReceiveTime = systemTime();
+        if (mRecorder.isOpen()) {
+            std::lock_guard<std::mutex> l(mRecorderLock);
+            mRecorder.append(mIngestBuffer.writeData(), n, mLastReceiveTime);
+        }
+        mIngestBuffer.commit(n);
+        size_t consumed = 0;
+        status_t res = mStreamReader.parse(mIngestBuffer.readData(), mIngestBuffer.readable(),
+                callbacks, &consumed, &needed);
+        mIngestBuffer.consume(consumed);
+        updateReceiveStats(mLastReceiveTime, n);
+        if (res != OK) {
+            ALOGE("标记: 注入协议错误，断开客户端");
+            break;
+        }
     }
+    // 连接结束时送出最后一个 NAL 单元和最后一帧
+    mNalSplitter.flush(onNal);
+    mAccessUnitAssembler.flush(
+            [this](const Camera3AccessUnitAssembler::AccessUnit& au) { onAccessUnit(au); });
+    // 解码线程处理完队列中剩余的条目后退出
+    mDecodeQueue.finish();
+    mDecodeThread->requestExitAndWait();
+    mDecodeThread.clear();
 
     // 客户端断开，立即释放解码器并停止注入
     ALOGI("标记: 客户端断开，正在清理资源...");
     mDecoder->release();
-    Camera3StreamInjectionManager::getInstance()->setInjectionActive(false);
-}
-
-bool Camera3SocketServer::parseAnnexB(uint8_t* buffer, size_t size) {
-    static std::vector<uint8_t> frameBuffer;
-    if (frameBuffer.capacity() < 1024 * 1024) frameBuffer.reserve(1024 * 1024);
-
-    size_t lastPos = 0;
-    for (size_t i = 0; i <= (size >= 4 ? size - 4 : 0); ++i) {
-        if (buffer[i] == 0x00 && buffer[i+1] == 0x00 && buffer[i+2] == 0x00 && buffer[i+3] == 0x01) {
-            if (i > lastPos || !frameBuffer.empty()) {
-                frameBuffer.insert(frameBuffer.end(), buffer + lastPos, buffer + i);
-                if (frameBuffer.size() > 4) {
-                    detectResolutionChange(frameBuffer.data(), frameBuffer.size());
-                    mDecoder->decode(frameBuffer.data(), frameBuffer.size());
-                }
-                frameBuffer.clear();
+    releaseSharedMemory();
+    mSource->setInjectionActive(false);
+    stopRecording();
+}
+
+void Camera3SocketServer::startRecording() {
+    char dir[PROPERTY_VALUE_MAX];
+    property_get("persist.camera.injection.record_dir", dir, "");
+    if (dir[0] == '\0') {
+        return;
+    }
+    std::string path = std::string(dir) + "/" + mSocketName + "-" +
+            std::to_string(ns2s(systemTime(SYSTEM_TIME_REALTIME))) + ".aidrec";
+    std::lock_guard<std::mutex> l(mRecorderLock);
+    if (mRecorder.open(path) == OK) {
+        ALOGI("标记: 正在录制注入字节流到 %s", path.c_str());
+    }
+}
+
+void Camera3SocketServer::stopRecording() {
+    std::lock_guard<std::mutex> l(mRecorderLock);
+    if (!mRecorder.isOpen()) {
+        return;
+    }
+    ALOGI("标记: 注入录制结束: %s, %" PRIu64 " 块, %" PRIu64 " 字节",
+            mRecorder.getPath().c_str(), mRecorder.getChunks(), mRecorder.getBytes());
+    mRecorder.close();
+}
+
+status_t Camera3SocketServer::onHello(const Camera3InjectionStreamReader::Hello& hello) {
+    uint16_t status = (hello.version >= 1) ? 0 : 1;
+    // 旧客户端看到的仍是它自己的版本
+    uint16_t version = std::min(hello.version, Camera3InjectionStreamReader::kVersion);
+    uint8_t ack[Camera3InjectionStreamReader::kAckSize];
+    Camera3InjectionStreamReader::writeAck(version, status, ack);
+    // 在接收/轮询线程上发送，不能阻塞：客户端不读取时 (EAGAIN 或只发出一部分) 直接断开
+    ssize_t sent = send(mClientSocket, ack, sizeof(ack), MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (sent != static_cast<ssize_t>(sizeof(ack))) {
+        ALOGE("标记: 无法发送注入协议 ack，断开客户端: %s",
+                sent < 0 ? strerror(errno) : "partial write");
+        return UNKNOWN_ERROR;
+    }
+    if (status != 0) {
+        ALOGE("标记: 不支持的注入协议版本 %u", hello.version);
+        return BAD_VALUE;
+    }
+    mSenderClock = hello.clock;
+    {
+        std::lock_guard<std::mutex> l(mStatsLock);
+        mProtocolVersion = version;
+    }
+    // 分帧协议的帧整帧到达，时间戳是发送端的采集时间 (或整帧收齐的时间)，可以判断是否过期
+    mDecodeQueue.setMaxAge(mMaxFrameAge);
+    ALOGI("标记: 客户端使用分帧协议 (版本 %u, 时钟 %u)", hello.version, hello.clock);
+    return OK;
+}
+
+ssize_t Camera3SocketServer::receive(uint8_t* data, size_t size) {
+    struct iovec iov = {data, size};
+    alignas(struct cmsghdr) uint8_t control[CMSG_SPACE(sizeof(int) * kMaxReceivedFds)];
+    struct msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t n;
+    do {
+        n = recvmsg(mClientSocket, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        return n;
+    }
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+            cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+            continue;
+        }
+        size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        const uint8_t* fdData = CMSG_DATA(cmsg);
+        for (size_t i = 0; i < count; i++) {
+            int receivedFd;
+            memcpy(&receivedFd, fdData + i * sizeof(int), sizeof(int));
+            mReceivedFds.push_back(receivedFd);
+        }
+    }
+    if (msg.msg_flags & MSG_CTRUNC) {
+        ALOGW("标记: 客户端一次发送的 fd 过多，部分 fd 已被截断");
+    }
+    return n;
+}
+
+status_t Camera3SocketServer::attachSharedMemory() {
+    if (mReceivedFds.size() < 2) {
+        ALOGE("标记: 共享内存帧缺少 memfd 和 eventfd (收到 %zu 个 fd)", mReceivedFds.size());
+        return BAD_VALUE;
+    }
+    int memfd = mReceivedFds[0];
+    int doorbell = mReceivedFds[1];
+    mReceivedFds.erase(mReceivedFds.begin(), mReceivedFds.begin() + 2);
+
+    status_t res;
+    std::shared_ptr<Camera3InjectionShmRing> ring = Camera3InjectionShmRing::attach(memfd, &res);
+    // 映射之后不再需要 memfd
+    close(memfd);
+    if (ring == nullptr) {
+        close(doorbell);
+        return res;
+    }
+
+    // 生产者可以重新发送新的环 (例如分辨率变化)
+    releaseSharedMemory();
+    mShmRing = std::move(ring);
+    mShmDoorbell = doorbell;
+    mShmSequence = 0;
+    // 共享内存模式不经过解码器；之后若恢复 H.264 推流再重新配置
+    mDecodeQueue.pushRelease();
+    mDecoderConfigQueued = false;
+    return OK;
+}
+
+void Camera3SocketServer::consumeSharedMemoryFrame() {
+    uint64_t rings;
+    if (read(mShmDoorbell, &rings, sizeof(rings)) != static_cast<ssize_t>(sizeof(rings))) {
+        return;
+    }
+    Camera3InjectionShmRing::Frame shmFrame;
+    status_t res = mShmRing->acquireLatest(mShmSequence, &shmFrame);
+    if (res != OK) {
+        if (res == WOULD_BLOCK) {
+            std::lock_guard<std::mutex> l(mStatsLock);
+            mShmBusy++;
+        }
+        return;
+    }
+
+    nsecs_t receiveTime = systemTime();
+    nsecs_t captureTime = toLocalTime(shmFrame.captureTimeUs, receiveTime);
+    updateReceiveStats(receiveTime, shmFrame.size);
+    {
+        std::lock_guard<std::mutex> l(mStatsLock);
+        mFramesReceived++;
+        mShmFrames++;
+        if (mShmSequence > 0 && shmFrame.sequence > mShmSequence + 1) {
+            mShmSkipped += shmFrame.sequence - mShmSequence - 1;
+        }
+        mTransportLatency.add(captureTime, receiveTime);
+    }
+    mShmSequence = shmFrame.sequence;
+
+    // 色度平面的行跨度和偏移取自头部 (attach 时已校验)，不按 stride 推算
+    const Camera3InjectionShmRing::Layout& layout = mShmRing->getLayout();
+    const uint8_t* srcY = shmFrame.data;
+    const uint8_t* srcUV = srcY + layout.chromaOffset;
+    std::shared_ptr<DecodedFrame> frame;
+    bool packedNv21 = layout.format == Camera3InjectionShmRing::kFormatNv21 &&
+            layout.chromaStride == layout.stride &&
+            layout.chromaOffset == static_cast<size_t>(layout.stride) * layout.height;
+    if (packedNv21) {
+        // 与解码器输出的格式相同：直接引用槽位，合成完成之前生产者不会覆盖它
+        frame = std::make_shared<DecodedFrame>();
+        frame->width = layout.width;
+        frame->height = layout.height;
+        frame->stride = layout.stride;
+        frame->external = shmFrame.data;
+        frame->externalSize = shmFrame.size;
+        frame->holder = std::move(shmFrame.hold);
+    } else {
+        // 注入管线只处理 NV21，其他格式转换一次写入帧池
+        frame = mSource->acquireFrame(layout.width, layout.height);
+        uint8_t* dstY = frame->data.data();
+        uint8_t* dstVU = dstY + layout.width * layout.height;
+        if (layout.format == Camera3InjectionShmRing::kFormatNv21) {
+            // 色度平面单独对齐的 NV21：按平面拷贝成帧池的紧密排列
+            libyuv::CopyPlane(srcY, layout.stride, dstY, layout.width, layout.width,
+                    layout.height);
+            libyuv::CopyPlane(srcUV, layout.chromaStride, dstVU, layout.width, layout.width,
+                    layout.height / 2);
+        } else if (layout.format == Camera3InjectionShmRing::kFormatNv12) {
+            // 交换 UV 顺序，NV12 -> NV21 与 NV21 -> NV12 是同一个操作
+            libyuv::NV21ToNV12(srcY, layout.stride, srcUV, layout.chromaStride,
+                    dstY, layout.width, dstVU, layout.width, layout.width, layout.height);
+        } else {
+            const uint8_t* srcV = srcY + layout.chroma2Offset;
+            libyuv::I420ToNV21(srcY, layout.stride, srcUV, layout.chromaStride,
+                    srcV, layout.chromaStride, dstY, layout.width, dstVU, layout.width,
+                    layout.width, layout.height);
+        }
+        mSource->addBytesCopied(frame->data.size());
+    }
+    frame->timestamp = captureTime;
+    frame->format = HAL_PIXEL_FORMAT_YCrCb_420_SP; // NV21
+    Camera3StreamInjectionManager::getInstance()->publishFrame(mSource, std::move(frame));
+}
+
+void Camera3SocketServer::releaseSharedMemory() {
+    // 已发布的帧各自持有槽位的引用，映射在它们释放后才解除
+    mShmRing.reset();
+    if (mShmDoorbell >= 0) {
+        close(mShmDoorbell);
+        mShmDoorbell = -1;
+    }
+    for (int receivedFd : mReceivedFds) {
+        close(receivedFd);
+    }
+    mReceivedFds.clear();
+}
+
+void Camera3SocketServer::updateReceiveStats(nsecs_t now, size_t bytes) {
+    std::lock_guard<std::mutex> l(mStatsLock);
+    mParseStats.mode = mStreamReader.getMode();
+    mParseStats.bytesScanned = mNalSplitter.getBytesScanned();
+    mParseStats.nalCount = mNalSplitter.getNalCount();
+    mParseStats.oversizedNals = mNalSplitter.getOversizedCount();
+    mParseStats.ingestCapacity = mIngestBuffer.capacity();
+    mParseStats.ingestCompactions = mIngestBuffer.getCompactions();
+    mParseStats.ingestBytesMoved = mIngestBuffer.getBytesMoved();
+    mBytesReceived += bytes;
+    nsecs_t elapsed = now - mRateWindowStart;
+    if (elapsed < kRateWindow) {
+        return;
+    }
+    uint64_t nals = mParseStats.nalCount;
+    if (mRateWindowStart > 0) {
+        double seconds = static_cast<double>(elapsed) / s2ns(1);
+        mBytesPerSecond = (mBytesReceived - mRateWindowBytes) / seconds;
+        mNalsPerSecond = (nals - mRateWindowNals) / seconds;
+    }
+    mRateWindowStart = now;
+    mRateWindowBytes = mBytesReceived;
+    mRateWindowNals = nals;
+}
+
+nsecs_t Camera3SocketServer::toLocalTime(int64_t captureTimeUs, nsecs_t fallback) const {
+    if (captureTimeUs <= 0) {
+        return fallback;
+    }
+    nsecs_t captureTime = us2ns(captureTimeUs);
+    switch (mSenderClock) {
+        case Camera3InjectionStreamReader::kClockRealtime:
+            captureTime += systemTime(SYSTEM_TIME_MONOTONIC) - systemTime(SYSTEM_TIME_REALTIME);
+            break;
+        case Camera3InjectionStreamReader::kClockBoottime:
+            captureTime += systemTime(SYSTEM_TIME_MONOTONIC) - systemTime(SYSTEM_TIME_BOOTTIME);
+            break;
+        default:
+            break;
+    }
+    // 发送端时钟不同步时，不让采集时间晚于接收时间
+    return std::min(captureTime, fallback);
+}
+
+void Camera3SocketServer::onFrame(const Camera3InjectionStreamReader::Frame& frame) {
+    if (frame.flags & Camera3InjectionStreamReader::kFlagSharedMemory) {
+        if (mRecorder.isOpen() && !mShmRecordingWarned) {
+            ALOGW("标记: 共享内存帧随 fd 传递，无法录制和回放");
+            mShmRecordingWarned = true;
+        }
+        if (attachSharedMemory() != OK) {
+            ALOGE("标记: 无法使用客户端的共享内存环，断开客户端");
+            mEndOfStream = true;
+        }
+        return;
+    }
+
+    nsecs_t receiveTime = mLastReceiveTime;
+    nsecs_t captureTime = toLocalTime(frame.captureTimeUs, receiveTime);
+    {
+        std::lock_guard<std::mutex> l(mStatsLock);
+        mFramesReceived++;
+        if (mHasSequence && frame.sequence > mLastSequence + 1) {
+            mSequenceGaps += frame.sequence - mLastSequence - 1;
+        }
+        mHasSequence = true;
+        mLastSequence = frame.sequence;
+        mTransportLatency.add(captureTime, receiveTime);
+    }
+
+    // 帧边界已知：整帧切分完后立即送出访问单元，不必等下一帧的起始码
+    mLastReceiveTime = captureTime;
+    submitFrame(frame, captureTime);
+    mLastReceiveTime = receiveTime;
+
+    if (frame.flags & Camera3InjectionStreamReader::kFlagEndOfStream) {
+        ALOGI("标记: 客户端发送了结束标记 (序号 %" PRIu64 ")", frame.sequence);
+        mEndOfStream = true;
+    }
+}
+
+void Camera3SocketServer::submitFrame(const Camera3InjectionStreamReader::Frame& frame,
+        nsecs_t captureTime) {
+    // 整帧连续存放在接收缓冲区中，切分出的 NAL 单元都直接指向它
+    mFrameNals.clear();
+    mNalSplitter.split(frame.data, frame.size,
+            [&](const Camera3NalSplitter::NalUnit& nal) { mFrameNals.push_back(nal); });
+    if (mFrameNals.empty()) {
+        return;
+    }
+
+    Camera3AccessUnitAssembler::AccessUnit au{};
+    if (Camera3AccessUnitAssembler::wrapFrame(mFrameNals, captureTime, &au)) {
+        // 不经过 assembler 的拼接，整帧由解码队列从接收缓冲区拷贝一次
+        {
+            std::lock_guard<std::mutex> l(mStatsLock);
+            mUnassembledFrames++;
+        }
+        onAccessUnit(au);
+        return;
+    }
+
+    // SPS/PPS 需要单独作为 codec-config 提交，并可能触发解码器重新配置
+    {
+        std::lock_guard<std::mutex> l(mStatsLock);
+        mAssembledFrames++;
+    }
+    for (const auto& nal : mFrameNals) {
+        onNalUnit(nal);
+    }
+    mAccessUnitAssembler.flush(
+            [this](const Camera3AccessUnitAssembler::AccessUnit& au) { onAccessUnit(au); });
+}
+
+void Camera3SocketServer::onNalUnit(const Camera3NalSplitter::NalUnit& nal) {
+    // SPS 进入 assembler 时会先把上一帧送给旧的解码器，之后再按新的 SPS 重新配置，
+    // 新的 SPS/PPS 则随下一帧提交给新的解码器
+    mAccessUnitAssembler.push(nal,
+            [this](const Camera3AccessUnitAssembler::AccessUnit& au) { onAccessUnit(au); },
+            mLastReceiveTime);
+    detectResolutionChange(nal);
+}
+
+void Camera3SocketServer::onAccessUnit(const Camera3AccessUnitAssembler::AccessUnit& au) {
+    if (!mDecoderConfigQueued) {
+        // 码流没有以可解析的 SPS 开头时，按上一次已知的尺寸启动解码器
+        mDecodeQueue.pushConfigure(mCurrentWidth, mCurrentHeight);
+        mDecoderConfigQueued = true;
+    }
+    // 接收缓冲区在回调返回后即被复用，解码队列入队时拷贝访问单元
+    if (mDecodeQueue.pushAccessUnit(au)) {
+        mSource->addBytesCopied(au.size);
+    }
+}
+
+bool Camera3SocketServer::DecodeThread::threadLoop() {
+    return mServer->decodeNext();
+}
+
+bool Camera3SocketServer::decodeNext() {
+    std::unique_ptr<Camera3InjectionDecodeQueue::Entry> entry;
+    if (!mDecodeQueue.pop(&entry)) {
+        return false;
+    }
+    switch (entry->type) {
+        case Camera3InjectionDecodeQueue::Entry::Type::CONFIGURE: {
+            mDecoderWidth = entry->width;
+            mDecoderHeight = entry->height;
+            status_t res = configureDecoder(mDecoderWidth, mDecoderHeight);
+            if (res != OK) {
+                ALOGE("标记: 按 %ux%u 配置解码器失败: %d", mDecoderWidth, mDecoderHeight, res);
             }
-            frameBuffer.insert(frameBuffer.end(), {0x00, 0x00, 0x00, 0x01});
-            i += 3;
-            lastPos = i + 1;
+            break;
         }
+        case Camera3InjectionDecodeQueue::Entry::Type::RELEASE:
+            mDecoder->release();
+            break;
+        case Camera3InjectionDecodeQueue::Entry::Type::ACCESS_UNIT:
+            decodeAccessUnit(*entry);
+            break;
     }
-    if (lastPos < size) frameBuffer.insert(frameBuffer.end(), buffer + lastPos, buffer + size);
+    mDecodeQueue.recycle(std::move(entry));
     return true;
 }
 
-void Camera3SocketServer::detectResolutionChange(uint8_t* nalData, size_t size) {
-    if (size < 5) return;
-    uint8_t nalType = nalData[4] & 0x1F;
-    if (nalType == 7) { // SPS (Sequence Parameter Set)
-        // 这是一个简化的解析，实际中需要完整的 H.264 bitstream 解析。
-        // 这里我们主要依赖 MediaCodec 的 INFO_OUTPUT_FORMAT_CHANGED。
-        // 但为了 FR-004，我们可以在这里做初步标记。
+void Camera3SocketServer::decodeAccessUnit(const Camera3InjectionDecodeQueue::Entry& entry) {
+    if (!mDecoder->isInitialized()) {
+        // 上一次配置失败时按同样的尺寸重试
+        if (configureDecoder(mDecoderWidth, mDecoderHeight) != OK) {
+            ALOGE("标记: 解码器初始化失败");
+            return;
+        }
+    }
+    // 解码器暂时没有空闲的输入缓冲区时在期限内重试同一帧；其间 socket 线程照常入队，
+    // 由队列的丢帧策略决定丢哪些帧。超过期限后丢弃这一帧并请求 IDR，不再重试
+    Camera3AccessUnitAssembler::AccessUnit au = entry.accessUnit();
+    nsecs_t deadline = systemTime() + kDecodeInputDeadline;
+    do {
+        if (mDecoder->decodeAccessUnit(au) != WOULD_BLOCK) {
+            return;
+        }
+    } while (systemTime() < deadline);
+    ALOGW("标记: 解码器 %" PRId64 " ms 内没有空闲的输入缓冲区，丢弃%s帧并请求 IDR",
+            ns2ms(kDecodeInputDeadline), au.reference ? "参考" : "非参考");
+    mDecodeQueue.reportDecoderDrop(entry);
+}
+
+void Camera3SocketServer::sendKeyFrameRequest(nsecs_t now) {
+    if (mProtocolVersion < Camera3InjectionStreamReader::kVersionRequests ||
+            !mDecodeQueue.takeKeyFrameRequest(now)) {
+        return;
+    }
+    uint8_t request[Camera3InjectionStreamReader::kRequestSize];
+    Camera3InjectionStreamReader::writeRequest(Camera3InjectionStreamReader::kRequestKeyFrame,
+            request);
+    // 请求很小，客户端不读取时宁可丢掉也不阻塞接收
+    if (send(mClientSocket, request, sizeof(request), MSG_DONTWAIT | MSG_NOSIGNAL) !=
+            static_cast<ssize_t>(sizeof(request))) {
+        ALOGW("标记: 无法向客户端发送 IDR 请求: %s", strerror(errno));
+        return;
+    }
+    ALOGI("标记: 已请求客户端发送 IDR");
+}
+
+void Camera3SocketServer::dump(int fd) {
+    dprintf(fd, "\n== Camera injection socket (@%s): ==\n\n", mSocketName.c_str());
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        dprintf(fd, "  Running: %s, client connected: %s\n", mRunning ? "true" : "false",
+                mClientSocket != -1 ? "true" : "false");
+        if (mLastSpsInfo.width > 0) {
+            dprintf(fd, "  Last SPS: profile %u level %u, %ux%u (coded %ux%u), %.2f fps, "
+                    "%s range\n", mLastSpsInfo.profileIdc, mLastSpsInfo.levelIdc,
+                    mLastSpsInfo.width, mLastSpsInfo.height, mLastSpsInfo.codedWidth,
+                    mLastSpsInfo.codedHeight, mLastSpsInfo.frameRate(),
+                    mLastSpsInfo.videoFullRange ? "full" : "limited");
+        }
+    }
+    {
+        std::lock_guard<std::mutex> l(mStatsLock);
+        const ParseStats& parse = mParseStats;
+        dprintf(fd, "  Bytes scanned: %" PRIu64 ", NAL units: %" PRIu64 ", oversized NAL units: %"
+                PRIu64 "\n", parse.bytesScanned, parse.nalCount, parse.oversizedNals);
+        dprintf(fd, "  Protocol: %s (version %u), max frame age: %" PRId64 " ms (framed only)\n",
+                parse.mode == Camera3InjectionStreamReader::Mode::FRAMED ? "framed" :
+                parse.mode == Camera3InjectionStreamReader::Mode::RAW ? "raw Annex-B" :
+                "unknown", mProtocolVersion, ns2ms(mMaxFrameAge));
+        dprintf(fd, "  Bytes received: %" PRIu64 ", last second: %.1f KiB/s, %.1f NAL units/s\n",
+                mBytesReceived, mBytesPerSecond / 1024, mNalsPerSecond);
+        dprintf(fd, "  Frames received: %" PRIu64 ", sequence gaps: %" PRIu64 "\n",
+                mFramesReceived, mSequenceGaps);
+        dprintf(fd, "  Frames bypassing the assembler: %" PRIu64 ", via assembler: %" PRIu64
+                "\n", mUnassembledFrames, mAssembledFrames);
+        dprintf(fd, "  Shared memory frames: %" PRIu64 ", overwritten before pickup: %" PRIu64
+                ", slot busy: %" PRIu64 "\n", mShmFrames, mShmSkipped, mShmBusy);
+        mTransportLatency.dump(fd, "Sender capture to socket receive latency");
+        dprintf(fd, "  Ingest buffer: %zu KiB, compactions: %" PRIu64 ", bytes moved: %" PRIu64
+                "\n", parse.ingestCapacity / 1024, parse.ingestCompactions,
+                parse.ingestBytesMoved);
+    }
+    {
+        // 最多等待一次正在进行的录制写入
+        std::lock_guard<std::mutex> l(mRecorderLock);
+        if (mRecorder.isOpen()) {
+            dprintf(fd, "  Recording to %s: %" PRIu64 " chunks, %" PRIu64 " bytes\n",
+                    mRecorder.getPath().c_str(), mRecorder.getChunks(), mRecorder.getBytes());
+        }
+    }
+    Camera3InjectionDecodeQueue::Stats queue = mDecodeQueue.getStats();
+    dprintf(fd, "  Decode queue: depth %zu/%zu, max %zu, avg %.2f; access units queued: %" PRIu64
+            ", decoded: %" PRIu64 ", bytes copied in: %" PRIu64 "%s\n", queue.depth,
+            queue.capacity, queue.maxDepth,
+            queue.accessUnitsPushed > 0 ? (double)queue.depthSum / queue.accessUnitsPushed : 0.0,
+            queue.accessUnitsPushed, queue.accessUnitsPopped, queue.bytesCopied,
+            queue.waitingForKeyFrame ? ", waiting for IDR" : "");
+    dprintf(fd, "  Decode queue drops: %" PRIu64, queue.totalDrops());
+    for (size_t i = 0; i < Camera3InjectionDecodeQueue::kDropReasonCount; i++) {
+        dprintf(fd, "%s%s %" PRIu64, i == 0 ? " (" : ", ",
+                Camera3InjectionDecodeQueue::dropReasonName(
+                        static_cast<Camera3InjectionDecodeQueue::DropReason>(i)),
+                queue.drops[i]);
+    }
+    dprintf(fd, "), IDR requests: %" PRIu64 "\n", queue.keyFrameRequests);
+    sp<Camera3InjectionDecoder> decoder;
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        decoder = mDecoder;
+    }
+    dprintf(fd, "  Decoder mode: %s, backend: %s\n",
+            Camera3InjectionDecoder::modeName(mDecoderMode),
+            Camera3InjectionDecoder::backendName(decoder->getBackend()));
+    decoder->dump(fd);
+}
+
+void Camera3SocketServer::detectResolutionChange(const Camera3NalSplitter::NalUnit& nal) {
+    if (nal.type() != 7) { // SPS (Sequence Parameter Set)
+        return;
+    }
+    // 编码器通常在每个 IDR 前重复 SPS，字节完全相同时跳过解析
+    if (mLastSps.size() == nal.payloadSize() &&
+            memcmp(mLastSps.data(), nal.payload(), nal.payloadSize()) == 0) {
+        return;
+    }
+
+    Camera3H264SpsParser::SpsInfo info;
+    if (Camera3H264SpsParser::parse(nal.payload(), nal.payloadSize(), &info) != OK) {
+        ALOGW("标记: 无法解析 SPS (%zu 字节)，保持当前解码器配置", nal.payloadSize());
+        return;
+    }
+    mLastSps.assign(nal.payload(), nal.payload() + nal.payloadSize());
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mLastSpsInfo = info;
+    }
+    ALOGI("标记: SPS: profile %u level %u, %ux%u (编码尺寸 %ux%u), %.2f fps",
+            info.profileIdc, info.levelIdc, info.width, info.height, info.codedWidth,
+            info.codedHeight, info.frameRate());
+
+    // 只有显示尺寸真正变化时才重建解码器；其他参数变化由解码器自己处理
+    if (mDecoderConfigQueued && info.width == mCurrentWidth &&
+            info.height == mCurrentHeight) {
+        return;
+    }
+    mCurrentWidth = info.width;
+    mCurrentHeight = info.height;
+    mDecodeQueue.pushConfigure(mCurrentWidth, mCurrentHeight);
+    mDecoderConfigQueued = true;
+}
+
+status_t Camera3SocketServer::configureDecoder(uint32_t width, uint32_t height) {
+    status_t res = mDecoder->isInitialized() ? mDecoder->reconfigure(width, height) :
+            mDecoder->initialize(width, height);
+    if (res == OK || mDecoderMode != Camera3InjectionDecoder::Mode::AUTO ||
+            mDecoder->getBackend() != Camera3InjectionDecoder::Backend::MEDIACODEC) {
+        return res;
+    }
+    // 没有可用的硬件解码器 (例如模拟器)，本服务器之后一直使用软件解码
+    ALOGW("标记: MediaCodec 解码器不可用 (%d)，改用软件解码器", res);
+    mDecoder->release();
+    sp<Camera3InjectionDecoder> decoder = Camera3InjectionDecoder::create(
+            Camera3InjectionDecoder::Backend::SOFTWARE, mSource);
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mDecoder = decoder;
     }
+    return mDecoder->initialize(width, height);
 }
 
 } // namespace camera3
@@ -21,28 +21,61 @@
 #include <utils/Thread.h>
 #include <utils/RefBase.h>
 #include <utils/StrongPointer.h>
+#include <string>
 #include <vector>
 #include <mutex>
 #include <sys/un.h> // 为 Unix Domain Socket 添加头文件
 
+#include "utils/LatencyHistogram.h"
+
+#include "Camera3AccessUnitAssembler.h"
+#include "Camera3H264SpsParser.h"
+#include "Camera3InjectionDecodeQueue.h"
+#include "Camera3InjectionDecoder.h"
+#include "Camera3InjectionIngestBuffer.h"
+#include "Camera3InjectionRecording.h"
+#include "Camera3InjectionShmRing.h"
+#include "Camera3InjectionStreamReader.h"
+#include "Camera3NalSplitter.h"
+
 namespace android {
 namespace camera3 {
 
-class Camera3H264Decoder;
+class Camera3InjectionSource;
 
 /**
  * 一个简单的 Unix Domain Socket 服务器，用于接收 H.264 视频流。
+ *
+ * 每个服务器对应一路注入源：默认源监听 @aidock_cam_h264，
+ * 相机 (或自定义通道) 的源监听 @aidock_cam_h264.<sourceId>。
+ * 每个服务器有自己的解码器，多个服务器可以同时各自接收一个客户端。
+ * 解码器后端见 Camera3InjectionDecoder；auto 模式下 MediaCodec 不可用时自动改用软件解码。
+ *
+ * 客户端可以直接发送 Annex-B 字节流，也可以使用带时间戳的分帧协议
+ * (见 Camera3InjectionStreamReader)。本机的生产者还可以在分帧协议中传来共享内存环
+ * (kFlagSharedMemory)，之后直接发布未压缩的 YUV 帧，完全绕过解码器。
+ *
+ * 解码在每个连接独立的解码线程上进行：socket 线程把访问单元放入有界队列
+ * (Camera3InjectionDecodeQueue，深度由 persist.camera.injection.decode_queue_depth 设置)，
+ * 解码跟不上时由队列按参考关系丢帧；丢了参考帧时通过分帧协议请求发送端发送 IDR。
+ *
+ * 设置 persist.camera.injection.record_dir 后，每个连接收到的字节流连同接收时间
+ * 录制到该目录 (见 Camera3InjectionRecording)，可用 camera_injection_replay 回放。
  */
 class Camera3SocketServer : public Thread {
 public:
-    Camera3SocketServer();
+    explicit Camera3SocketServer(const std::string& sourceId);
     virtual ~Camera3SocketServer();
 
+    const std::string& getSocketName() const { return mSocketName; }
+
     // 启动服务器
     status_t start();
     // 停止服务器
     void stop();
 
+    void dump(int fd);
+
 protected:
     virtual bool threadLoop() override;
 
@@ -57,13 +90,136 @@ private:
     static const char* kAbstractSocketName;
     // 个人修改结束
 
-    sp<Camera3H264Decoder> mDecoder;
+    // kAbstractSocketName，非默认源再加上 ".<sourceId>"
+    const std::string mSocketName;
+    const sp<Camera3InjectionSource> mSource;
+    const Camera3InjectionDecoder::Mode mDecoderMode;
+    // 连接期间只由解码线程使用和替换 (auto 模式下回退到软件解码)，替换时持有 mLock
+    // 以便 dump 读取；解码线程未运行时由 socket 线程释放
+    sp<Camera3InjectionDecoder> mDecoder;
+    // 码流的显示尺寸 (socket 线程)；按此向解码线程提交配置
     uint32_t mCurrentWidth;
     uint32_t mCurrentHeight;
+    // 当前连接已向解码线程提交过配置 (socket 线程)
+    bool mDecoderConfigQueued;
+    // 解码器最近一次配置的尺寸 (解码线程)
+    uint32_t mDecoderWidth;
+    uint32_t mDecoderHeight;
+
+    class DecodeThread : public Thread {
+      public:
+        explicit DecodeThread(Camera3SocketServer* server) :
+                Thread(/*canCallJava*/false), mServer(server) {}
+      private:
+        bool threadLoop() override;
+        Camera3SocketServer* mServer;
+    };
+    // socket 线程与解码线程之间的访问单元队列
+    Camera3InjectionDecodeQueue mDecodeQueue;
+    sp<DecodeThread> mDecodeThread;
+
+    // 每个连接独立的 Annex-B 切分状态，在 handleClient 开始时重置
+    Camera3NalSplitter mNalSplitter;
+    // 把 NAL 单元聚合为完整的帧后再提交给解码器
+    Camera3AccessUnitAssembler mAccessUnitAssembler;
+    // 最近一次 read 返回的时间，作为其中 NAL 单元的接收时间；
+    // 分帧模式下为换算到本地 CLOCK_MONOTONIC 的发送端采集时间
+    nsecs_t mLastReceiveTime;
+
+    // 原始模式 / 分帧模式的判断和分帧解析，每个连接开始时重置
+    Camera3InjectionStreamReader mStreamReader;
+    // socket 数据直接读入这里，分帧解析原地引用其中的数据，解码队列入队时从这里拷贝
+    Camera3InjectionIngestBuffer mIngestBuffer;
+    // 当前帧切分出的 NAL 单元 (指向 mIngestBuffer)
+    std::vector<Camera3NalSplitter::NalUnit> mFrameNals;
+    // 随 socket 数据通过 SCM_RIGHTS 收到、尚未使用的 fd，连接结束时关闭
+    std::vector<int> mReceivedFds;
+    // 共享内存模式：映射的 YUV 环、门铃 eventfd 和已取走的最新帧序号
+    std::shared_ptr<Camera3InjectionShmRing> mShmRing;
+    int mShmDoorbell;
+    uint64_t mShmSequence;
+    Camera3InjectionStreamReader::Clock mSenderClock;
+    // 分帧协议协商的版本，原始模式下为 0；socket 线程在 mStatsLock 下写入
+    uint16_t mProtocolVersion;
+    bool mEndOfStream;
+    // 出队时早于该时长 (相对采集时间) 的非关键帧直接丢弃，0 表示不丢弃。
+    // 只对分帧协议生效：原始码流的访问单元要等下一帧的第一个 slice 到达才输出，
+    // 其接收时间包含一整个帧间隔。socket 线程在 mStatsLock 下写入
+    nsecs_t mMaxFrameAge;
+
+    std::mutex mStatsLock;
+    uint64_t mFramesReceived;
+    uint64_t mSequenceGaps;
+    // 分帧模式下不经过 assembler 拼接的帧 / 含 SPS/PPS 而经过 assembler 的帧。
+    // 两者入队时都会被解码队列拷贝一次 (见 Camera3InjectionDecodeQueue)
+    uint64_t mUnassembledFrames;
+    uint64_t mAssembledFrames;
+    // 共享内存模式下发布的帧 / 生产者发布但被更新的帧覆盖而未取走的帧 /
+    // 门铃响起时槽位恰好正在被改写
+    uint64_t mShmFrames;
+    uint64_t mShmSkipped;
+    uint64_t mShmBusy;
+    bool mHasSequence;
+    uint64_t mLastSequence;
+    uint64_t mBytesReceived;
+    // 接收速率按秒统计：窗口起点、起点时的累计字节数和 NAL 单元数，以及上一个完整窗口的速率
+    nsecs_t mRateWindowStart;
+    uint64_t mRateWindowBytes;
+    uint64_t mRateWindowNals;
+    double mBytesPerSecond;
+    double mNalsPerSecond;
+    // 发送端采集 -> socket 接收
+    CameraLatencyHistogram mTransportLatency;
+    // 当前连接最近一次的 SPS (原始字节)；重复的 SPS 不再解析
+    std::vector<uint8_t> mLastSps;
+    // 由 mLock 保护，供 dump 使用
+    Camera3H264SpsParser::SpsInfo mLastSpsInfo;
+    // 当前连接的录制，只由 socket 线程打开、写入和关闭。socket 线程读取时不加锁，
+    // 修改时持有 mRecorderLock 供 dump 读取；写文件不占用 mStatsLock
+    std::mutex mRecorderLock;
+    Camera3InjectionRecording::Writer mRecorder;
+    // 本连接已经提示过共享内存帧无法录制；socket 线程独占
+    bool mShmRecordingWarned;
+    // socket 线程独占的解析状态的快照，由 mStatsLock 保护，供 dump 使用
+    struct ParseStats {
+        Camera3InjectionStreamReader::Mode mode = Camera3InjectionStreamReader::Mode::UNKNOWN;
+        uint64_t bytesScanned = 0;
+        uint64_t nalCount = 0;
+        uint64_t oversizedNals = 0;
+        size_t ingestCapacity = 0;
+        uint64_t ingestCompactions = 0;
+        uint64_t ingestBytesMoved = 0;
+    };
+    ParseStats mParseStats;
 
     void handleClient();
-    bool parseAnnexB(uint8_t* buffer, size_t size);
-    void detectResolutionChange(uint8_t* nalData, size_t size);
+    // 按 persist.camera.injection.record_dir 为新连接开始录制
+    void startRecording();
+    void stopRecording();
+    // 累计接收字节、更新每秒速率，并刷新 mParseStats
+    void updateReceiveStats(nsecs_t now, size_t bytes);
+    // recvmsg 读入接收缓冲区，附带的 fd 追加到 mReceivedFds
+    ssize_t receive(uint8_t* data, size_t size);
+    status_t attachSharedMemory();
+    void consumeSharedMemoryFrame();
+    void releaseSharedMemory();
+    status_t onHello(const Camera3InjectionStreamReader::Hello& hello);
+    void onFrame(const Camera3InjectionStreamReader::Frame& frame);
+    void submitFrame(const Camera3InjectionStreamReader::Frame& frame, nsecs_t captureTime);
+    // 把发送端时钟的采集时间换算为本地 CLOCK_MONOTONIC；缺失时返回 fallback
+    nsecs_t toLocalTime(int64_t captureTimeUs, nsecs_t fallback) const;
+    void onNalUnit(const Camera3NalSplitter::NalUnit& nal);
+    // 把访问单元交给解码线程
+    void onAccessUnit(const Camera3AccessUnitAssembler::AccessUnit& au);
+    // 解码线程：处理一个队列条目；队列结束时返回 false
+    bool decodeNext();
+    void decodeAccessUnit(const Camera3InjectionDecodeQueue::Entry& entry);
+    // 队列等待 IDR 时向发送端发出请求 (仅限支持请求的分帧协议客户端)
+    void sendKeyFrameRequest(nsecs_t now);
+    void detectResolutionChange(const Camera3NalSplitter::NalUnit& nal);
+    // 按 width x height 初始化或重新配置解码器；auto 模式下 MediaCodec 失败时改用软件解码器。
+    // 在解码线程上调用
+    status_t configureDecoder(uint32_t width, uint32_t height);
 };
 
 } // namespace camera3
@@ -0,0 +1,299 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#define LOG_TAG "AIDOCK_CAM_DECODER"
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include <utils/Log.h>
+
+#include "ih264_typedefs.h"
+#include "iv.h"
+#include "ivd.h"
+#include "ih264d.h"
+
+#include "Camera3SoftwareH264Codec.h"
+
+namespace android {
+namespace camera3 {
+
+namespace {
+
+void* alignedAlloc(void* /*ctxt*/, WORD32 alignment, WORD32 size) {
+    void* buf = nullptr;
+    if (posix_memalign(&buf, alignment, size) != 0) {
+        return nullptr;
+    }
+    return buf;
+}
+
+void alignedFree(void* /*ctxt*/, void* buf) {
+    free(buf);
+}
+
+iv_obj_t* handleOf(void* handle) {
+    return static_cast<iv_obj_t*>(handle);
+}
+
+} // namespace
+
+Camera3SoftwareH264Codec::Camera3SoftwareH264Codec() :
+        mHandle(nullptr),
+        mWidth(0),
+        mHeight(0),
+        mThreads(1),
+        mTimestamps{},
+        mNextTimestamp(0) {
+}
+
+Camera3SoftwareH264Codec::~Camera3SoftwareH264Codec() {
+    release();
+}
+
+status_t Camera3SoftwareH264Codec::initialize(uint32_t width, uint32_t height,
+        uint32_t threads) {
+    threads = std::clamp(threads, 1u, kMaxThreads);
+    if (mHandle != nullptr && width == mWidth && height == mHeight && threads == mThreads) {
+        return OK;
+    }
+    release();
+    if (width == 0 || height == 0 || width % 2 != 0 || height % 2 != 0) {
+        ALOGE("标记: 软件解码器尺寸无效: %ux%u", width, height);
+        return BAD_VALUE;
+    }
+
+    ih264d_create_ip_t createIp = {};
+    ih264d_create_op_t createOp = {};
+    createIp.s_ivd_create_ip_t.u4_size = sizeof(ih264d_create_ip_t);
+    createIp.s_ivd_create_ip_t.e_cmd = IVD_CMD_CREATE;
+    createIp.s_ivd_create_ip_t.u4_share_disp_buf = 0;
+    // 直接输出 NV21，与注入帧池的格式一致
+    createIp.s_ivd_create_ip_t.e_output_format = IV_YUV_420SP_VU;
+    createIp.s_ivd_create_ip_t.pf_aligned_alloc = alignedAlloc;
+    createIp.s_ivd_create_ip_t.pf_aligned_free = alignedFree;
+    createIp.s_ivd_create_ip_t.pv_mem_ctxt = nullptr;
+    // 帧间保持解码线程，避免每帧重新唤醒线程池
+    createIp.u4_keep_threads_active = 1;
+    createOp.s_ivd_create_op_t.u4_size = sizeof(ih264d_create_op_t);
+    if (ih264d_api_function(nullptr, &createIp, &createOp) != IV_SUCCESS) {
+        ALOGE("标记: 无法创建 H.264 软件解码器: 0x%x",
+                createOp.s_ivd_create_op_t.u4_error_code);
+        return NO_INIT;
+    }
+    iv_obj_t* handle = static_cast<iv_obj_t*>(createOp.s_ivd_create_op_t.pv_handle);
+    handle->pv_fxns = reinterpret_cast<void*>(ih264d_api_function);
+    handle->u4_size = sizeof(iv_obj_t);
+    mHandle = handle;
+    mWidth = width;
+    mHeight = height;
+    mThreads = threads;
+    mNextTimestamp = 0;
+
+    status_t res = setNumCores();
+    if (res == OK) {
+        res = setParams();
+    }
+    if (res != OK) {
+        release();
+        return res;
+    }
+    ALOGI("标记: H.264 软件解码器已启动: %ux%u, %u 个线程", width, height, threads);
+    return OK;
+}
+
+void Camera3SoftwareH264Codec::release() {
+    if (mHandle == nullptr) {
+        return;
+    }
+    ih264d_delete_ip_t deleteIp = {};
+    ih264d_delete_op_t deleteOp = {};
+    deleteIp.s_ivd_delete_ip_t.u4_size = sizeof(ih264d_delete_ip_t);
+    deleteIp.s_ivd_delete_ip_t.e_cmd = IVD_CMD_DELETE;
+    deleteOp.s_ivd_delete_op_t.u4_size = sizeof(ih264d_delete_op_t);
+    if (ih264d_api_function(handleOf(mHandle), &deleteIp, &deleteOp) != IV_SUCCESS) {
+        ALOGW("标记: 删除 H.264 软件解码器失败: 0x%x",
+                deleteOp.s_ivd_delete_op_t.u4_error_code);
+    }
+    mHandle = nullptr;
+}
+
+status_t Camera3SoftwareH264Codec::setNumCores() {
+    ih264d_ctl_set_num_cores_ip_t ip = {};
+    ih264d_ctl_set_num_cores_op_t op = {};
+    ip.u4_size = sizeof(ih264d_ctl_set_num_cores_ip_t);
+    ip.e_cmd = IVD_CMD_VIDEO_CTL;
+    ip.e_sub_cmd = static_cast<IVD_CONTROL_API_COMMAND_TYPE_T>(IH264D_CMD_CTL_SET_NUM_CORES);
+    ip.u4_num_cores = mThreads;
+    op.u4_size = sizeof(ih264d_ctl_set_num_cores_op_t);
+    if (ih264d_api_function(handleOf(mHandle), &ip, &op) != IV_SUCCESS) {
+        ALOGE("标记: 无法设置软件解码线程数 %u: 0x%x", mThreads, op.u4_error_code);
+        return UNKNOWN_ERROR;
+    }
+    return OK;
+}
+
+status_t Camera3SoftwareH264Codec::setParams() {
+    ih264d_ctl_set_config_ip_t ip = {};
+    ih264d_ctl_set_config_op_t op = {};
+    ivd_ctl_set_config_ip_t* config = &ip.s_ivd_ctl_set_config_ip_t;
+    config->u4_size = sizeof(ih264d_ctl_set_config_ip_t);
+    config->e_cmd = IVD_CMD_VIDEO_CTL;
+    config->e_sub_cmd = IVD_CMD_CTL_SETPARAMS;
+    // 输出 stride 等于宽度，解码结果就是紧凑排列的帧池布局
+    config->u4_disp_wd = mWidth;
+    config->e_frm_skip_mode = IVD_SKIP_NONE;
+    config->e_frm_out_mode = IVD_DISPLAY_FRAME_OUT;
+    config->e_vid_dec_mode = IVD_DECODE_FRAME;
+    op.s_ivd_ctl_set_config_op_t.u4_size = sizeof(ih264d_ctl_set_config_op_t);
+    if (ih264d_api_function(handleOf(mHandle), &ip, &op) != IV_SUCCESS) {
+        ALOGE("标记: 无法设置软件解码器参数: 0x%x", op.s_ivd_ctl_set_config_op_t.u4_error_code);
+        return UNKNOWN_ERROR;
+    }
+    return OK;
+}
+
+status_t Camera3SoftwareH264Codec::reset() {
+    ivd_ctl_reset_ip_t ip = {};
+    ivd_ctl_reset_op_t op = {};
+    ip.u4_size = sizeof(ivd_ctl_reset_ip_t);
+    ip.e_cmd = IVD_CMD_VIDEO_CTL;
+    ip.e_sub_cmd = IVD_CMD_CTL_RESET;
+    op.u4_size = sizeof(ivd_ctl_reset_op_t);
+    if (ih264d_api_function(handleOf(mHandle), &ip, &op) != IV_SUCCESS) {
+        ALOGE("标记: 软件解码器复位失败: 0x%x", op.u4_error_code);
+        return UNKNOWN_ERROR;
+    }
+    // 复位会清除线程数和输出参数
+    status_t res = setNumCores();
+    return res == OK ? setParams() : res;
+}
+
+status_t Camera3SoftwareH264Codec::decode(const uint8_t* data, size_t size, int64_t timestampUs,
+        uint8_t* out, size_t outSize, Picture* picture) {
+    *picture = Picture();
+    if (mHandle == nullptr) {
+        ALOGE("标记: 软件解码器未初始化，拒绝解码请求");
+        return INVALID_OPERATION;
+    }
+    if (outSize < frameSize(mWidth, mHeight)) {
+        return BAD_VALUE;
+    }
+    uint32_t slot = mNextTimestamp;
+    mTimestamps[slot] = timestampUs;
+    mNextTimestamp = (mNextTimestamp + 1) % kMaxTimestamps;
+
+    // 一次调用最多解码一幅图像；SPS/PPS 和图像在同一个访问单元里时需要多次调用
+    size_t offset = 0;
+    while (offset < size) {
+        size_t consumed = 0;
+        Picture output;
+        status_t res = runDecode(data + offset, size - offset, slot, out, outSize, &consumed,
+                &output);
+        if (res != OK) {
+            return res;
+        }
+        if (output.present) {
+            *picture = output;
+        }
+        if (consumed == 0) {
+            break;
+        }
+        offset += consumed;
+    }
+    return OK;
+}
+
+status_t Camera3SoftwareH264Codec::drain(uint8_t* out, size_t outSize, Picture* picture) {
+    *picture = Picture();
+    if (mHandle == nullptr) {
+        return INVALID_OPERATION;
+    }
+    if (outSize < frameSize(mWidth, mHeight)) {
+        return BAD_VALUE;
+    }
+    ivd_ctl_flush_ip_t ip = {};
+    ivd_ctl_flush_op_t op = {};
+    ip.u4_size = sizeof(ivd_ctl_flush_ip_t);
+    ip.e_cmd = IVD_CMD_VIDEO_CTL;
+    ip.e_sub_cmd = IVD_CMD_CTL_FLUSH;
+    op.u4_size = sizeof(ivd_ctl_flush_op_t);
+    if (ih264d_api_function(handleOf(mHandle), &ip, &op) != IV_SUCCESS) {
+        ALOGE("标记: 软件解码器 flush 失败: 0x%x", op.u4_error_code);
+        return UNKNOWN_ERROR;
+    }
+    // flush 模式下没有剩余帧时解码调用返回失败，以是否有输出为准
+    size_t consumed;
+    runDecode(nullptr, 0, 0, out, outSize, &consumed, picture);
+    return OK;
+}
+
+status_t Camera3SoftwareH264Codec::runDecode(const uint8_t* data, size_t size,
+        uint32_t timestampSlot, uint8_t* out, size_t outSize, size_t* consumed,
+        Picture* picture) {
+    const size_t lumaSize = static_cast<size_t>(mWidth) * mHeight;
+    ih264d_video_decode_ip_t ip = {};
+    ih264d_video_decode_op_t op = {};
+    ivd_video_decode_ip_t* decodeIp = &ip.s_ivd_video_decode_ip_t;
+    ivd_video_decode_op_t* decodeOp = &op.s_ivd_video_decode_op_t;
+    decodeIp->u4_size = sizeof(ih264d_video_decode_ip_t);
+    decodeIp->e_cmd = IVD_CMD_VIDEO_DECODE;
+    decodeIp->u4_ts = timestampSlot;
+    decodeIp->pv_stream_buffer = const_cast<uint8_t*>(data);
+    decodeIp->u4_num_Bytes = size;
+    // 解码器按这里给出的最小尺寸校验输出缓冲区
+    decodeIp->s_out_buffer.u4_min_out_buf_size[0] = lumaSize;
+    decodeIp->s_out_buffer.u4_min_out_buf_size[1] = outSize - lumaSize;
+    decodeIp->s_out_buffer.pu1_bufs[0] = out;
+    decodeIp->s_out_buffer.pu1_bufs[1] = out + lumaSize;
+    decodeIp->s_out_buffer.u4_num_bufs = 2;
+    decodeOp->u4_size = sizeof(ih264d_video_decode_op_t);
+
+    IV_API_CALL_STATUS_T status = ih264d_api_function(handleOf(mHandle), &ip, &op);
+    *consumed = decodeOp->u4_num_bytes_consumed;
+    if (status != IV_SUCCESS && size > 0) {
+        uint32_t error = decodeOp->u4_error_code;
+        if ((error & IVD_ERROR_MASK) == IVD_RES_CHANGED) {
+            ALOGW("标记: 码流尺寸与软件解码器配置 (%ux%u) 不符，解码器已复位", mWidth,
+                    mHeight);
+            reset();
+            return BAD_VALUE;
+        }
+        if ((error >> IVD_FATALERROR) & 1) {
+            ALOGE("标记: 软件解码器致命错误: 0x%x", error);
+            return UNKNOWN_ERROR;
+        }
+        // 非致命错误 (例如缺少参考帧的 slice) 只丢弃这部分数据，解码器会自行隐藏错误
+        ALOGV("标记: 软件解码器非致命错误: 0x%x", error);
+    }
+    if (decodeOp->u4_output_present) {
+        if (decodeOp->u4_pic_wd != mWidth || decodeOp->u4_pic_ht != mHeight) {
+            ALOGW("标记: 软件解码输出尺寸 %ux%u 与配置 %ux%u 不符，丢弃", decodeOp->u4_pic_wd,
+                    decodeOp->u4_pic_ht, mWidth, mHeight);
+            return OK;
+        }
+        picture->present = true;
+        picture->width = decodeOp->u4_pic_wd;
+        picture->height = decodeOp->u4_pic_ht;
+        picture->timestampUs = mTimestamps[decodeOp->u4_ts % kMaxTimestamps];
+    }
+    return OK;
+}
+
+} // namespace camera3
+} // namespace android
+// 个人修改结束
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#ifndef ANDROID_SERVERS_CAMERA_CAMERA3_SOFTWARE_H264_CODEC_H
+#define ANDROID_SERVERS_CAMERA_CAMERA3_SOFTWARE_H264_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <utils/Errors.h>
+
+namespace android {
+namespace camera3 {
+
+/**
+ * 基于 libavc (ih264d) 的 H.264 软件解码器，不依赖 MediaCodec 和任何设备服务，
+ * 可以在主机测试和没有硬件解码器的模拟器上运行。
+ *
+ * 解码结果直接写入调用方提供的 NV21 缓冲区 (stride 等于宽度)，不经过中间拷贝。
+ * libavc 按 slice/宏块行把解码和去块滤波分给多个线程，线程数由 initialize() 指定。
+ *
+ * 非线程安全：所有调用必须来自同一个线程 (注入源的 socket 线程)。
+ */
+class Camera3SoftwareH264Codec {
+  public:
+    static constexpr uint32_t kMaxThreads = 4;
+
+    struct Picture {
+        bool present = false;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        // decode() 传入的时间戳，按解码输出顺序对应
+        int64_t timestampUs = 0;
+    };
+
+    // width x height 的 NV21 帧所需的字节数
+    static size_t frameSize(uint32_t width, uint32_t height) {
+        return static_cast<size_t>(width) * height * 3 / 2;
+    }
+
+    Camera3SoftwareH264Codec();
+    ~Camera3SoftwareH264Codec();
+
+    Camera3SoftwareH264Codec(const Camera3SoftwareH264Codec&) = delete;
+    Camera3SoftwareH264Codec& operator=(const Camera3SoftwareH264Codec&) = delete;
+
+    // 按显示尺寸创建解码器实例；threads 限制在 [1, kMaxThreads]
+    status_t initialize(uint32_t width, uint32_t height, uint32_t threads);
+    void release();
+    bool isInitialized() const { return mHandle != nullptr; }
+
+    // 解码一个访问单元 (可以包含 SPS/PPS)，有输出时写入 out 并填写 picture。
+    // outSize 不小于 frameSize(width, height)。码流尺寸与配置不符时不会输出；
+    // libavc 报告分辨率变化时返回 BAD_VALUE 并复位，需要按新尺寸重新 initialize()
+    status_t decode(const uint8_t* data, size_t size, int64_t timestampUs, uint8_t* out,
+            size_t outSize, Picture* picture);
+
+    // 取出解码器内部因显示重排而延后的一帧；没有剩余帧时 picture->present 为 false
+    status_t drain(uint8_t* out, size_t outSize, Picture* picture);
+
+    uint32_t getWidth() const { return mWidth; }
+    uint32_t getHeight() const { return mHeight; }
+    uint32_t getThreads() const { return mThreads; }
+
+  private:
+    // libavc 的时间戳只有 32 位，这里用槽位编号代替，按槽位取回 64 位时间戳
+    static constexpr uint32_t kMaxTimestamps = 32;
+
+    status_t setNumCores();
+    status_t setParams();
+    status_t reset();
+    status_t runDecode(const uint8_t* data, size_t size, uint32_t timestampSlot, uint8_t* out,
+            size_t outSize, size_t* consumed, Picture* picture);
+
+    // libavc 的 iv_obj_t (匿名结构体，无法前向声明)
+    void* mHandle;
+    uint32_t mWidth;
+    uint32_t mHeight;
+    uint32_t mThreads;
+
+    int64_t mTimestamps[kMaxTimestamps];
+    uint32_t mNextTimestamp;
+};
+
+} // namespace camera3
+} // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA_CAMERA3_SOFTWARE_H264_CODEC_H
+// 个人修改结束
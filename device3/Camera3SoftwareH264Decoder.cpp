@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#define LOG_TAG "AIDOCK_CAM_DECODER"
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <algorithm>
+
+#include <cutils/properties.h>
+#include <system/graphics.h>
+#include <utils/Log.h>
+#include <utils/Timers.h>
+
+#include "Camera3InjectionSource.h"
+#include "Camera3SoftwareH264Decoder.h"
+#include "Camera3StreamInjectionManager.h"
+
+namespace android {
+namespace camera3 {
+
+static constexpr int32_t kLatencyBinSizeMs = 5;
+
+Camera3SoftwareH264Decoder::Camera3SoftwareH264Decoder(const sp<Camera3InjectionSource>& source) :
+        mSource(source),
+        mWidth(0),
+        mHeight(0),
+        mThreads(0),
+        mAccessUnitsDecoded(0),
+        mFramesPublished(0),
+        mDecodeErrors(0),
+        mEndToEndLatency(kLatencyBinSizeMs),
+        mDecodeLatency(kLatencyBinSizeMs) {
+}
+
+Camera3SoftwareH264Decoder::~Camera3SoftwareH264Decoder() {
+    release();
+}
+
+status_t Camera3SoftwareH264Decoder::initialize(uint32_t width, uint32_t height) {
+    uint32_t threads = static_cast<uint32_t>(std::max(1,
+            property_get_int32("persist.camera.injection.decoder_threads",
+                    Camera3SoftwareH264Codec::kMaxThreads)));
+    status_t res = mCodec.initialize(width, height, threads);
+    if (res != OK) {
+        return res;
+    }
+    std::lock_guard<std::mutex> l(mStatsLock);
+    mWidth = mCodec.getWidth();
+    mHeight = mCodec.getHeight();
+    mThreads = mCodec.getThreads();
+    return OK;
+}
+
+status_t Camera3SoftwareH264Decoder::reconfigure(uint32_t width, uint32_t height) {
+    ALOGI("标记: 正在重新配置软件解码器: %ux%u", width, height);
+    release();
+    return initialize(width, height);
+}
+
+void Camera3SoftwareH264Decoder::release() {
+    if (!mCodec.isInitialized()) return;
+    mCodec.release();
+    ALOGI("标记: H.264 软件解码器已释放资源");
+}
+
+status_t Camera3SoftwareH264Decoder::decodeAccessUnit(
+        const Camera3AccessUnitAssembler::AccessUnit& au) {
+    if (!mCodec.isInitialized()) {
+        ALOGE("标记: 解码器未初始化，拒绝解码请求");
+        return INVALID_OPERATION;
+    }
+    // 直接解码到帧池中的槽位；没有输出时 (包括只含 SPS/PPS 的访问单元) 槽位随 frame 释放回池中
+    std::shared_ptr<DecodedFrame> frame =
+            mSource->acquireFrame(mCodec.getWidth(), mCodec.getHeight());
+
+    nsecs_t decodeStart = systemTime();
+    int64_t timestampUs = (au.receiveTime > 0 ? au.receiveTime : decodeStart) / 1000;
+    Camera3SoftwareH264Codec::Picture picture;
+    status_t res = mCodec.decode(au.data, au.size, timestampUs, frame->data.data(),
+            frame->data.size(), &picture);
+    nsecs_t now = systemTime();
+    if (res != OK) {
+        std::lock_guard<std::mutex> l(mStatsLock);
+        mDecodeErrors++;
+        return res;
+    }
+    if (picture.present) {
+        frame->timestamp = picture.timestampUs * 1000;
+        frame->format = HAL_PIXEL_FORMAT_YCrCb_420_SP; // NV21
+        Camera3StreamInjectionManager::getInstance()->publishFrame(mSource, std::move(frame));
+    }
+
+    std::lock_guard<std::mutex> l(mStatsLock);
+    if (!au.codecConfig) {
+        mAccessUnitsDecoded++;
+        mDecodeLatency.add(decodeStart, now);
+    }
+    if (picture.present) {
+        mFramesPublished++;
+        mEndToEndLatency.add(picture.timestampUs * 1000, now);
+    }
+    return OK;
+}
+
+void Camera3SoftwareH264Decoder::dump(int fd) {
+    std::lock_guard<std::mutex> l(mStatsLock);
+    dprintf(fd, "  H.264 software decoder (libavc): %s, %ux%u, %u threads\n",
+            mCodec.isInitialized() ? "running" : "stopped", mWidth, mHeight, mThreads);
+    dprintf(fd, "    Access units decoded: %" PRIu64 ", frames published: %" PRIu64
+            ", decode errors: %" PRIu64 "\n", mAccessUnitsDecoded, mFramesPublished,
+            mDecodeErrors);
+    mEndToEndLatency.dump(fd, "Capture (or socket receive) to frame published latency");
+    mDecodeLatency.dump(fd, "Access unit decode latency");
+}
+
+} // namespace camera3
+} // namespace android
+// 个人修改结束
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+#ifndef ANDROID_SERVERS_CAMERA_CAMERA3_SOFTWARE_H264_DECODER_H
+#define ANDROID_SERVERS_CAMERA_CAMERA3_SOFTWARE_H264_DECODER_H
+
+#include <mutex>
+
+#include "utils/LatencyHistogram.h"
+
+#include "Camera3InjectionDecoder.h"
+#include "Camera3SoftwareH264Codec.h"
+
+namespace android {
+namespace camera3 {
+
+/**
+ * 软件解码后端：在 socket 线程上同步调用 Camera3SoftwareH264Codec，
+ * 解码结果直接写入帧池中的槽位并发布，整个过程没有额外的拷贝。
+ *
+ * 解码线程数由 persist.camera.injection.decoder_threads 指定 (默认 kMaxThreads)。
+ */
+class Camera3SoftwareH264Decoder : public Camera3InjectionDecoder {
+  public:
+    explicit Camera3SoftwareH264Decoder(const sp<Camera3InjectionSource>& source);
+    virtual ~Camera3SoftwareH264Decoder();
+
+    Backend getBackend() const override { return Backend::SOFTWARE; }
+
+    status_t initialize(uint32_t width, uint32_t height) override;
+    status_t reconfigure(uint32_t width, uint32_t height) override;
+    void release() override;
+    bool isInitialized() const override { return mCodec.isInitialized(); }
+
+    status_t decodeAccessUnit(const Camera3AccessUnitAssembler::AccessUnit& au) override;
+
+    void dump(int fd) override;
+
+  private:
+    const sp<Camera3InjectionSource> mSource;
+    Camera3SoftwareH264Codec mCodec;
+
+    std::mutex mStatsLock;
+    uint32_t mWidth;
+    uint32_t mHeight;
+    uint32_t mThreads;
+    uint64_t mAccessUnitsDecoded;
+    uint64_t mFramesPublished;
+    uint64_t mDecodeErrors;
+    // 发送端采集 (原始模式下为 socket 接收) -> 帧发布到注入源
+    CameraLatencyHistogram mEndToEndLatency;
+    // 单个访问单元的解码耗时
+    CameraLatencyHistogram mDecodeLatency;
+};
+
+} // namespace camera3
+} // namespace android
+
+#endif // ANDROID_SERVERS_CAMERA_CAMERA3_SOFTWARE_H264_DECODER_H
+// 个人修改结束
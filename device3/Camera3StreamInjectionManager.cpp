@@ -16,66 +16,169 @@
 
 // 个人修改开始
 #define LOG_TAG "AIDOCK_CAM_INJECT"
+#include <inttypes.h>
+#include <stdio.h>
+#include <algorithm>
+#include <cutils/properties.h>
 #include <utils/Log.h>
 #include "Camera3StreamInjectionManager.h"
 
 namespace android {
 namespace camera3 {
 
-Mutex Camera3StreamInjectionManager::sLock;
-sp<Camera3StreamInjectionManager> Camera3StreamInjectionManager::sInstance = nullptr;
+const std::string Camera3StreamInjectionManager::kDefaultSourceId = "";
 
-sp<Camera3StreamInjectionManager> Camera3StreamInjectionManager::getInstance() {
-    AutoMutex lock(sLock);
-    if (sInstance == nullptr) {
-        sInstance = new Camera3StreamInjectionManager();
-    }
+const sp<Camera3StreamInjectionManager>& Camera3StreamInjectionManager::getInstance() {
+    static const sp<Camera3StreamInjectionManager> sInstance =
+            new Camera3StreamInjectionManager();
     return sInstance;
 }
 
 Camera3StreamInjectionManager::Camera3StreamInjectionManager() :
-        mIsInjectionActive(false),
-        mTargetHeight(720) { // 个人修改
+        mSources(std::make_shared<const SourceMap>(
+                SourceMap{{kDefaultSourceId, new Camera3InjectionSource(kDefaultSourceId)}})),
+        mDefaultSource(mSources->at(kDefaultSourceId)),
+        mFramesPublished(0),
+        mTargetHeight(720), // 个人修改
+        mLogFrames(property_get_bool("persist.camera.injection.log_frames", false)) {
     ALOGI("个人修改: Camera3StreamInjectionManager 已初始化");
 }
 
 Camera3StreamInjectionManager::~Camera3StreamInjectionManager() {
 }
 
-void Camera3StreamInjectionManager::updateFrame(std::shared_ptr<DecodedFrame> frame) {
-    AutoMutex lock(mFrameLock);
-    mLatestFrame = frame;
-    mIsInjectionActive = true;
+std::shared_ptr<const Camera3StreamInjectionManager::SourceMap>
+Camera3StreamInjectionManager::loadSources() const {
+    return std::atomic_load_explicit(&mSources, std::memory_order_acquire);
 }
 
-std::shared_ptr<DecodedFrame> Camera3StreamInjectionManager::getLatestFrame() {
-    AutoMutex lock(mFrameLock);
-    return mLatestFrame;
+sp<Camera3InjectionSource> Camera3StreamInjectionManager::getSource(
+        const std::string& sourceId) {
+    AutoMutex lock(mSourcesLock);
+    std::shared_ptr<const SourceMap> current = loadSources();
+    auto it = current->find(sourceId);
+    if (it != current->end()) {
+        return it->second;
+    }
+    sp<Camera3InjectionSource> source = new Camera3InjectionSource(sourceId);
+    auto next = std::make_shared<SourceMap>(*current);
+    next->emplace(sourceId, source);
+    std::atomic_store_explicit(&mSources, std::shared_ptr<const SourceMap>(std::move(next)),
+            std::memory_order_release);
+    ALOGI("标记: 已创建注入源 \"%s\"", sourceId.c_str());
+    return source;
 }
 
-void Camera3StreamInjectionManager::setInjectionActive(bool active) {
-    AutoMutex lock(mFrameLock);
-    mIsInjectionActive = active;
-    ALOGI("标记: StreamInjectionManager 注入状态切换为: %s", active ? "激活" : "停止");
+sp<Camera3InjectionSource> Camera3StreamInjectionManager::routeSource(
+        const std::string& cameraId, const std::string& physicalCameraId) {
+    std::shared_ptr<const SourceMap> sources = loadSources();
+    if (sources->size() == 1) {
+        return mDefaultSource;
+    }
+    if (!physicalCameraId.empty()) {
+        auto physical = sources->find(physicalCameraId);
+        if (physical != sources->end() && physical->second->isInjectionActive()) {
+            return physical->second;
+        }
+    }
+    auto logical = sources->find(cameraId);
+    if (logical != sources->end() && logical->second->isInjectionActive()) {
+        return logical->second;
+    }
+    return mDefaultSource;
 }
 
-bool Camera3StreamInjectionManager::isInjectionActive() {
-    AutoMutex lock(mFrameLock);
-    return mIsInjectionActive;
+void Camera3StreamInjectionManager::publishFrame(const sp<Camera3InjectionSource>& source,
+        std::shared_ptr<DecodedFrame> frame) {
+    uint64_t sequence = mFramesPublished.fetch_add(1, std::memory_order_relaxed) + 1;
+    source->updateFrame(std::move(frame), sequence);
 }
 
 // 个人修改开始
 void Camera3StreamInjectionManager::setTargetHeight(uint32_t height) {
-    AutoMutex lock(mFrameLock);
-    mTargetHeight = height;
+    mTargetHeight.store(height, std::memory_order_relaxed);
 }
 
 uint32_t Camera3StreamInjectionManager::getTargetHeight() {
-    AutoMutex lock(mFrameLock);
-    return mTargetHeight;
+    return mTargetHeight.load(std::memory_order_relaxed);
 }
 // 个人修改结束
 
+void Camera3StreamInjectionManager::StreamCounters::addLockWait(nsecs_t waitNs) {
+    lockContentions.fetch_add(1, std::memory_order_relaxed);
+    lockWaitNs.fetch_add(waitNs, std::memory_order_relaxed);
+    int64_t max = maxLockWaitNs.load(std::memory_order_relaxed);
+    while (waitNs > max &&
+            !maxLockWaitNs.compare_exchange_weak(max, waitNs, std::memory_order_relaxed)) {
+    }
+}
+
+std::shared_ptr<Camera3StreamInjectionManager::StreamCounters>
+Camera3StreamInjectionManager::registerStream(const std::string& cameraId, int streamId) {
+    auto counters = std::make_shared<StreamCounters>(cameraId, streamId);
+    AutoMutex lock(mStreamsLock);
+    mStreams.erase(std::remove_if(mStreams.begin(), mStreams.end(),
+            [](const std::weak_ptr<StreamCounters>& stream) { return stream.expired(); }),
+            mStreams.end());
+    mStreams.push_back(counters);
+    return counters;
+}
+
+void Camera3StreamInjectionManager::setFrameLogging(bool enabled) {
+    mLogFrames.store(enabled, std::memory_order_relaxed);
+    ALOGI("标记: 逐帧注入日志已%s", enabled ? "开启" : "关闭");
+}
+
+sp<Camera3InjectionCompositor> Camera3StreamInjectionManager::getCompositor() {
+    if (!property_get_bool("persist.camera.injection.async_composite", true)) {
+        return nullptr;
+    }
+    AutoMutex lock(mCompositorLock);
+    if (mCompositor == nullptr) {
+        mCompositor = new Camera3InjectionCompositor();
+    }
+    return mCompositor;
+}
+
+void Camera3StreamInjectionManager::dump(int fd) {
+    dprintf(fd, "\n== Camera stream injection: ==\n\n");
+    dprintf(fd, "  Target height: %u, frames published (all sources): %" PRIu64 "\n",
+            getTargetHeight(), mFramesPublished.load());
+    dprintf(fd, "  Per-buffer frame logging: %s\n",
+            isFrameLoggingEnabled() ? "enabled" : "disabled");
+    mPlaceholder.dump(fd);
+    std::shared_ptr<const SourceMap> sources = loadSources();
+    for (const auto& entry : *sources) {
+        entry.second->dump(fd);
+    }
+
+    {
+        AutoMutex lock(mStreamsLock);
+        for (const auto& weakStream : mStreams) {
+            std::shared_ptr<StreamCounters> stream = weakStream.lock();
+            if (stream == nullptr) {
+                continue;
+            }
+            uint64_t contentions = stream->lockContentions.load();
+            dprintf(fd, "  Camera %s stream %d (%ux%u): composited %" PRIu64 ", repeated %"
+                    PRIu64 ", placeholder %" PRIu64 " (%" PRIu64 " already filled)\n",
+                    stream->cameraId.c_str(), stream->streamId, stream->width.load(),
+                    stream->height.load(), stream->framesComposited.load(),
+                    stream->framesRepeated.load(), stream->placeholderFrames.load(),
+                    stream->placeholderSkips.load());
+            dprintf(fd, "    Composite lock contended %" PRIu64 " times, avg wait %.1f us, "
+                    "max %.1f us\n", contentions,
+                    contentions > 0 ? stream->lockWaitNs.load() / 1000.0 / contentions : 0.0,
+                    stream->maxLockWaitNs.load() / 1000.0);
+        }
+    }
+
+    AutoMutex lock(mCompositorLock);
+    if (mCompositor != nullptr) {
+        mCompositor->dump(fd);
+    }
+}
+
 } // namespace camera3
 } // namespace android
 // 个人修改结束
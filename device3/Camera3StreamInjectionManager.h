@@ -21,51 +21,134 @@
 #include <utils/Mutex.h>
 #include <utils/RefBase.h>
 #include <utils/Timers.h>
-#include <vector>
+#include <atomic>
+#include <map>
 #include <memory>
+#include <string>
+#include <vector>
+
+#include "Camera3InjectionCompositor.h"
+#include "Camera3InjectionPlaceholder.h"
+#include "Camera3InjectionSource.h"
 
 namespace android {
 namespace camera3 {
 
-struct DecodedFrame {
-    uint32_t width;
-    uint32_t height;
-    std::vector<uint8_t> data;
-    nsecs_t timestamp;
-    int format; // HAL_PIXEL_FORMAT_...
-
-    DecodedFrame() : width(0), height(0), timestamp(0), format(0) {}
-};
-
+/**
+ * 注入视频源的注册表。
+ *
+ * 每路源 (Camera3InjectionSource) 有独立的帧槽位；输出流按所属的相机 ID 选择源，
+ * 没有对应的已激活源时回退到默认源 (kDefaultSourceId)。
+ *
+ * 每个输出缓冲区都会经过 getInstance()、routeSource() 和 publishFrame()，这些路径不会
+ * 等待 mSourcesLock：源表在新增源时整体复制后原子替换 (写少读多)，帧序号为原子计数。
+ * 注意快照通过 shared_ptr 的 atomic_load/atomic_store 读写，libc++ 用一组全局分段互斥锁
+ * 实现这两个重载，读者会短暂持有其中一把 (只覆盖引用计数的增减)，并非无锁。
+ */
 class Camera3StreamInjectionManager : public virtual RefBase {
 public:
-    static sp<Camera3StreamInjectionManager> getInstance();
+    // 默认源，对应不带相机 ID 后缀的 socket
+    static const std::string kDefaultSourceId;
+
+    // dumpsys media.camera --injection [--log-frames 0|1]：只输出注入管线的统计，
+    // 不等待 CameraService 的锁
+    static constexpr const char* kDumpOption = "--injection";
+    static constexpr const char* kLogFramesOption = "--log-frames";
+
+    // 一个输出流的注入统计；输出流持有，逐帧只做原子累加，dump 时通过弱引用读取
+    struct StreamCounters {
+        const std::string cameraId;
+        const int streamId;
+        std::atomic<uint32_t> width;
+        std::atomic<uint32_t> height;
+        // 合成了注入帧的缓冲区 / 其中与该流上一个缓冲区是同一帧的 /
+        // 没有可用注入帧而填充占位画面的缓冲区 / 其中缓冲区已经是该占位画面而跳过写入的
+        std::atomic<uint64_t> framesComposited;
+        std::atomic<uint64_t> framesRepeated;
+        std::atomic<uint64_t> placeholderFrames;
+        std::atomic<uint64_t> placeholderSkips;
+        // 合成时 mInjectionLock 被其他线程持有的次数和等待时间
+        std::atomic<uint64_t> lockContentions;
+        std::atomic<int64_t> lockWaitNs;
+        std::atomic<int64_t> maxLockWaitNs;
+
+        StreamCounters(const std::string& cameraId, int streamId) :
+                cameraId(cameraId), streamId(streamId), width(0), height(0),
+                framesComposited(0), framesRepeated(0), placeholderFrames(0),
+                placeholderSkips(0), lockContentions(0), lockWaitNs(0), maxLockWaitNs(0) {}
+
+        void addLockWait(nsecs_t waitNs);
+    };
+
+    // 首次调用时创建 (线程安全的函数内静态变量)，之后不再变化
+    static const sp<Camera3StreamInjectionManager>& getInstance();
 
-    void updateFrame(std::shared_ptr<DecodedFrame> frame);
-    std::shared_ptr<DecodedFrame> getLatestFrame();
-    
-    void setInjectionActive(bool active);
-    bool isInjectionActive();
+    // 取得 (必要时创建) 指定 ID 的源；源创建后一直保留到进程退出
+    sp<Camera3InjectionSource> getSource(const std::string& sourceId);
+
+    // 为相机的输出流选择源：依次尝试物理相机 ID、逻辑相机 ID 对应的已激活源，
+    // 都没有时返回默认源
+    sp<Camera3InjectionSource> routeSource(const std::string& cameraId,
+            const std::string& physicalCameraId);
+
+    // 发布一帧到指定源，并分配在所有源之间唯一的帧序号 (渲染缓存以此识别同一帧)
+    void publishFrame(const sp<Camera3InjectionSource>& source,
+            std::shared_ptr<DecodedFrame> frame);
 
     // 个人修改开始
+    // 最近配置的输出流高度，仅用于 dump；在流配置时更新，不在逐帧路径上写入
     void setTargetHeight(uint32_t height);
     uint32_t getTargetHeight();
     // 个人修改结束
 
+    // 无信号时的填充策略和按几何缓存的占位模板
+    Camera3InjectionPlaceholder& getPlaceholder() { return mPlaceholder; }
+
+    // 异步合成线程池；通过 persist.camera.injection.async_composite 关闭时返回 nullptr
+    sp<Camera3InjectionCompositor> getCompositor();
+
+    // 输出流配置时登记统计；同一个流重新配置时应复用已有的计数器
+    std::shared_ptr<StreamCounters> registerStream(const std::string& cameraId, int streamId);
+
+    // 逐帧调试日志，初值来自 persist.camera.injection.log_frames，可通过 dumpsys 切换
+    bool isFrameLoggingEnabled() const {
+        return mLogFrames.load(std::memory_order_relaxed);
+    }
+    void setFrameLogging(bool enabled);
+
+    void dump(int fd);
+
 private:
     Camera3StreamInjectionManager();
     virtual ~Camera3StreamInjectionManager();
 
-    static Mutex sLock;
-    static sp<Camera3StreamInjectionManager> sInstance;
+    using SourceMap = std::map<std::string, sp<Camera3InjectionSource>>;
+
+    std::shared_ptr<const SourceMap> loadSources() const;
+
+    // 只串行化写者 (新增源)；读者通过 loadSources() 取得只读快照
+    Mutex mSourcesLock;
+    // 通过 std::atomic_load/atomic_store 访问 (libc++ 内部加全局分段锁，不是无锁的)
+    std::shared_ptr<const SourceMap> mSources;
+    // 缓存默认源，避免每帧查找
+    const sp<Camera3InjectionSource> mDefaultSource;
+
+    std::atomic<uint64_t> mFramesPublished;
+
+    Mutex mCompositorLock;
+    sp<Camera3InjectionCompositor> mCompositor;
+
+    Camera3InjectionPlaceholder mPlaceholder;
 
-    Mutex mFrameLock;
-    std::shared_ptr<DecodedFrame> mLatestFrame;
-    bool mIsInjectionActive;
-    
     // 个人修改开始
-    uint32_t mTargetHeight;
+    std::atomic<uint32_t> mTargetHeight;
     // 个人修改结束
+
+    std::atomic<bool> mLogFrames;
+
+    // 只在流配置和 dump 时访问；已销毁的流在下次登记或 dump 时移除
+    Mutex mStreamsLock;
+    std::vector<std::weak_ptr<StreamCounters>> mStreams;
 };
 
 } // namespace camera3
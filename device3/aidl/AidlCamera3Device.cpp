@@ -56,6 +56,9 @@
 #include <android/binder_ibinder_platform.h>
 #include <android/hardware/camera2/ICameraDeviceUser.h>
 #include <camera/StringUtils.h>
+// 个人修改开始
+#include <camera/VendorTagDescriptor.h>
+// 个人修改结束
 #include <com_android_internal_camera_flags.h>
 
 #include "utils/CameraTraces.h"
@@ -180,6 +183,44 @@ AidlCamera3Device::AidlCamera3Device(
     mCallbacks = ndk::SharedRefBase::make<AidlCameraDeviceCallbacks>(this);
 }
 
+// 个人修改开始
+// HAL 在静态信息中把 kDeltaSettingsAvailableTag 设为 1 表示接受差量设置，
+// 差量设置以 kDeltaSettingsTag 标记 (见 Camera3SettingsDelta)
+static constexpr char kDeltaSettingsAvailableTag[] = "com.aidock.request.deltaSettingsAvailable";
+static constexpr char kDeltaSettingsTag[] = "com.aidock.request.deltaSettings";
+
+// 返回差量设置的标记 tag；HAL 不支持时返回 0
+static uint32_t lookupSettingsDeltaTag(const CameraMetadata& deviceInfo,
+        metadata_vendor_id_t vendorTagId) {
+    sp<VendorTagDescriptor> vTags = VendorTagDescriptor::getGlobalVendorTagDescriptor();
+    if ((nullptr == vTags.get()) || (0 >= vTags->getTagCount())) {
+        sp<VendorTagDescriptorCache> cache = VendorTagDescriptorCache::getGlobalVendorTagCache();
+        if (cache.get()) {
+            cache->getVendorTagDescriptor(vendorTagId, &vTags);
+        }
+    }
+    if (vTags.get() == nullptr) {
+        return 0;
+    }
+
+    uint32_t availableTag, deltaTag;
+    if (CameraMetadata::getTagFromName(kDeltaSettingsAvailableTag, vTags.get(),
+            &availableTag) != OK ||
+            CameraMetadata::getTagFromName(kDeltaSettingsTag, vTags.get(), &deltaTag) != OK) {
+        return 0;
+    }
+    camera_metadata_ro_entry_t entry = deviceInfo.find(availableTag);
+    if (entry.count == 0 || entry.type != TYPE_BYTE || entry.data.u8[0] != 1) {
+        return 0;
+    }
+    if (vTags->getTagType(deltaTag) != TYPE_INT32) {
+        ALOGW("标记: %s 不是 int32 类型，不使用差量设置", kDeltaSettingsTag);
+        return 0;
+    }
+    return deltaTag;
+}
+// 个人修改结束
+
 status_t AidlCamera3Device::initialize(sp<CameraProviderManager> manager,
         const std::string& monitorTags) {
     ATRACE_CALL();
@@ -309,9 +350,14 @@ status_t AidlCamera3Device::initialize(sp<CameraProviderManager> manager,
         }
     }
 
+    // 个人修改开始
+    uint32_t settingsDeltaTag = lookupSettingsDeltaTag(mDeviceInfo,
+            manager->getProviderTagIdLocked(mId));
+    ALOGI_IF(settingsDeltaTag != 0, "标记: Camera %s: HAL 接受差量请求设置", mId.c_str());
     mInterface =
             new AidlHalInterface(session, queue, mUseHalBufManager, mSupportOfflineProcessing,
-                    mSessionHalBufManager);
+                    mSessionHalBufManager, settingsDeltaTag);
+    // 个人修改结束
 
     std::string providerType;
     mVendorTagId = manager->getProviderTagIdLocked(mId);
@@ -738,15 +784,18 @@ status_t AidlCamera3Device::switchToOffline(
     return ::ndk::ScopedAStatus::ok();
 }
 
+// 个人修改开始
 AidlCamera3Device::AidlHalInterface::AidlHalInterface(
             std::shared_ptr<aidl::android::hardware::camera::device::ICameraDeviceSession> &session,
             std::shared_ptr<AidlRequestMetadataQueue> queue,
             bool useHalBufManager, bool supportOfflineProcessing,
-            bool supportSessionHalBufManager) :
+            bool supportSessionHalBufManager, uint32_t settingsDeltaTag) :
         HalInterface(useHalBufManager, supportOfflineProcessing),
         mAidlSession(session),
         mRequestMetadataQueue(queue),
-        mSupportSessionHalBufManager(supportSessionHalBufManager) { }
+        mSupportSessionHalBufManager(supportSessionHalBufManager),
+        mSettingsDelta(settingsDeltaTag) { }
+// 个人修改结束
 
 AidlCamera3Device::AidlHalInterface::AidlHalInterface(
             std::shared_ptr<aidl::android::hardware::camera::device::ICameraDeviceSession>
@@ -773,6 +822,10 @@ status_t AidlCamera3Device::AidlHalInterface::flush() {
     ATRACE_NAME("CameraHal::flush");
     if (!valid()) return INVALID_OPERATION;
     status_t res = OK;
+    // 个人修改开始
+    // 不确定 HAL 在 flush 之后保留哪一份设置
+    mSettingsDelta.reset();
+    // 个人修改结束
 
     auto err = mAidlSession->flush();
     if (!err.isOk()) {
@@ -783,12 +836,16 @@ status_t AidlCamera3Device::AidlHalInterface::flush() {
     return res;
 }
 
-status_t AidlCamera3Device::AidlHalInterface::dump(int /*fd*/) {
+status_t AidlCamera3Device::AidlHalInterface::dump(int fd) {
     ATRACE_NAME("CameraHal::dump");
     if (!valid()) return INVALID_OPERATION;
 
     // Handled by CameraProviderManager::dump
 
+    // 个人修改开始
+    mSettingsDelta.dump(fd);
+    // 个人修改结束
+
     return OK;
 }
 
@@ -1014,6 +1071,11 @@ status_t AidlCamera3Device::AidlHalInterface::configureStreams(
         return AidlProviderInfo::mapToStatusT(err);
     }
 
+    // 个人修改开始
+    // 新的配置之后 HAL 不再保留之前的设置
+    mSettingsDelta.reset();
+    // 个人修改结束
+
     std::set<int32_t> halBufferManagedStreamIds;
     for (const auto &halStream: finalConfiguration) {
         if ((interfaceVersion >= AIDL_DEVICE_SESSION_V3 &&
@@ -1256,28 +1318,32 @@ status_t AidlCamera3Device::AidlHalInterface::processBatchCaptureRequests(
     *numRequestProcessed = 0;
 
     // Write metadata to FMQ.
+    // 个人修改开始
+    nsecs_t now = systemTime();
+    // 个人修改结束
     for (size_t i = 0; i < batchSize; i++) {
         camera_capture_request_t* request = requests[i];
         camera::device::CaptureRequest* captureRequest;
         captureRequest = &captureRequests[i];
 
-        if (request->settings != nullptr) {
-            size_t settingsSize = get_camera_metadata_size(request->settings);
+        // 个人修改开始
+        // 支持差量设置的 HAL 只收到相对上一次设置变化的 tag
+        const camera_metadata_t* settings = mSettingsDelta.encode(request->settings, now);
+        if (settings != nullptr) {
+            size_t settingsSize = get_camera_metadata_size(settings);
             if (mRequestMetadataQueue != nullptr && mRequestMetadataQueue->write(
-                    reinterpret_cast<const int8_t*>(request->settings), settingsSize)) {
+                    reinterpret_cast<const int8_t*>(settings), settingsSize)) {
                 captureRequest->settings.metadata.resize(0);
                 captureRequest->fmqSettingsSize = settingsSize;
             } else {
                 if (mRequestMetadataQueue != nullptr) {
                     ALOGW("%s: couldn't utilize fmq, fallback to hwbinder", __FUNCTION__);
                 }
-                uint8_t *settingsP =
-                        reinterpret_cast<uint8_t*>(
-                                const_cast<camera_metadata_t*>(request->settings));
-                size_t settingsSize =  get_camera_metadata_size(request->settings);
+                const uint8_t *settingsP = reinterpret_cast<const uint8_t*>(settings);
                 captureRequest->settings.metadata.assign(settingsP, settingsP + settingsSize);
                 captureRequest->fmqSettingsSize = 0u;
             }
+        // 个人修改结束
         } else {
             // A null request settings maps to a size-0 CameraMetadata
             captureRequest->settings.metadata.resize(0);
@@ -1344,6 +1410,10 @@ status_t AidlCamera3Device::AidlHalInterface::processBatchCaptureRequests(
         ALOGE("%s Error with processCaptureRequest %s ", __FUNCTION__, retS.getMessage());
         mBufferRecords.popInflightBuffers(inflightBuffers);
         cleanupNativeHandles(&handlesCreated);
+        // 个人修改开始
+        // HAL 未必收到了本批次的全部设置，下一个请求发送完整设置
+        mSettingsDelta.reset();
+        // 个人修改结束
     }
     return res;
 }
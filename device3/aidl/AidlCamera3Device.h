@@ -18,6 +18,9 @@
 #define ANDROID_SERVERS_AIDLCAMERA3DEVICE_H
 
 #include "../Camera3Device.h"
+// 个人修改开始
+#include "../Camera3SettingsDelta.h"
+// 个人修改结束
 #include "AidlCamera3OutputUtils.h"
 #include <fmq/AidlMessageQueue.h>
 
@@ -78,11 +81,15 @@ class AidlCamera3Device :
 
     class AidlHalInterface : public Camera3Device::HalInterface {
      public:
+        // 个人修改开始
+        // settingsDeltaTag: the vendor tag marking delta settings, or 0 if the HAL only
+        // accepts full settings (see Camera3SettingsDelta)
         AidlHalInterface(std::shared_ptr<
                 aidl::android::hardware::camera::device::ICameraDeviceSession> &session,
                 std::shared_ptr<AidlRequestMetadataQueue> queue,
                 bool useHalBufManager, bool supportOfflineProcessing,
-                bool supportSessionHalBufManager);
+                bool supportSessionHalBufManager, uint32_t settingsDeltaTag = 0);
+        // 个人修改结束
         AidlHalInterface(
                 std::shared_ptr<aidl::android::hardware::camera::device::ICameraDeviceSession>
                     &deviceSession,
@@ -160,6 +167,11 @@ class AidlCamera3Device :
 
         std::shared_ptr<AidlRequestMetadataQueue> mRequestMetadataQueue;
         bool mSupportSessionHalBufManager = false;
+
+        // 个人修改开始
+        // Encodes request settings against the last settings sent to the HAL
+        camera3::Camera3SettingsDelta mSettingsDelta;
+        // 个人修改结束
     }; // class AidlHalInterface
 
     /**
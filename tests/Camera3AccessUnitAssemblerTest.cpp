@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "Camera3AccessUnitAssemblerTest"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../device3/Camera3AccessUnitAssembler.h"
+
+using namespace android::camera3;
+
+namespace {
+
+using Bytes = std::vector<uint8_t>;
+
+struct Unit {
+    Bytes data;
+    bool codecConfig;
+    bool keyFrame;
+    bool reference;
+    size_t nalCount;
+};
+
+// Feeds a concatenated Annex-B stream through the splitter and the assembler.
+std::vector<Unit> assemble(const Bytes& stream) {
+    Camera3NalSplitter splitter;
+    Camera3AccessUnitAssembler assembler;
+    std::vector<Unit> units;
+    auto onAccessUnit = [&units](const Camera3AccessUnitAssembler::AccessUnit& au) {
+        units.push_back({Bytes(au.data, au.data + au.size), au.codecConfig, au.keyFrame,
+                au.reference, au.nalCount});
+    };
+    auto onNal = [&](const Camera3NalSplitter::NalUnit& nal) {
+        assembler.push(nal, onAccessUnit);
+    };
+    splitter.push(stream.data(), stream.size(), onNal);
+    splitter.flush(onNal);
+    assembler.flush(onAccessUnit);
+    return units;
+}
+
+Bytes nal(std::initializer_list<uint8_t> payload) {
+    Bytes out = {0x00, 0x00, 0x00, 0x01};
+    out.insert(out.end(), payload);
+    return out;
+}
+
+Bytes concat(const std::vector<Bytes>& parts) {
+    Bytes out;
+    for (const auto& part : parts) out.insert(out.end(), part.begin(), part.end());
+    return out;
+}
+
+// Slice NAL units; the second byte's top bit set means first_mb_in_slice == 0.
+const Bytes kSps = nal({0x67, 0x42, 0xc0, 0x1f});
+const Bytes kPps = nal({0x68, 0xce, 0x3c, 0x80});
+const Bytes kAud = nal({0x09, 0xf0});
+const Bytes kSei = nal({0x06, 0x05, 0x01, 0x80});
+const Bytes kIdrFirst = nal({0x65, 0x88, 0x11});
+const Bytes kIdrSecond = nal({0x65, 0x2a, 0x22});
+const Bytes kSliceFirst = nal({0x41, 0x9a, 0x33});
+const Bytes kSliceSecond = nal({0x41, 0x05, 0x44});
+// nal_ref_idc 0: a picture no other picture predicts from.
+const Bytes kNonReferenceSlice = nal({0x01, 0x9a, 0x55});
+
+} // namespace
+
+TEST(Camera3AccessUnitAssemblerTest, ConfigSeparatedAndSlicesAggregated) {
+    auto units = assemble(concat({kSps, kPps, kIdrFirst, kIdrSecond, kSliceFirst,
+            kSliceSecond}));
+
+    ASSERT_EQ(3u, units.size());
+    EXPECT_TRUE(units[0].codecConfig);
+    EXPECT_EQ(concat({kSps, kPps}), units[0].data);
+    EXPECT_EQ(2u, units[0].nalCount);
+
+    EXPECT_FALSE(units[1].codecConfig);
+    EXPECT_TRUE(units[1].keyFrame);
+    EXPECT_EQ(concat({kIdrFirst, kIdrSecond}), units[1].data);
+    EXPECT_EQ(2u, units[1].nalCount);
+
+    EXPECT_FALSE(units[2].keyFrame);
+    EXPECT_EQ(concat({kSliceFirst, kSliceSecond}), units[2].data);
+}
+
+TEST(Camera3AccessUnitAssemblerTest, AudAndSeiStartNewAccessUnit) {
+    auto units = assemble(concat({kAud, kSps, kPps, kSei, kIdrFirst, kAud, kSliceFirst,
+            kSliceSecond}));
+
+    ASSERT_EQ(3u, units.size());
+    EXPECT_TRUE(units[0].codecConfig);
+    EXPECT_EQ(concat({kSps, kPps}), units[0].data);
+    EXPECT_EQ(concat({kAud, kSei, kIdrFirst}), units[1].data);
+    EXPECT_EQ(3u, units[1].nalCount);
+    EXPECT_EQ(concat({kAud, kSliceFirst, kSliceSecond}), units[2].data);
+}
+
+TEST(Camera3AccessUnitAssemblerTest, SingleSlicePictures) {
+    auto units = assemble(concat({kSliceFirst, kSliceFirst, kSliceFirst}));
+
+    ASSERT_EQ(3u, units.size());
+    for (const auto& unit : units) {
+        EXPECT_EQ(kSliceFirst, unit.data);
+        EXPECT_EQ(1u, unit.nalCount);
+    }
+}
+
+TEST(Camera3AccessUnitAssemblerTest, RepeatedConfigBeforeEachKeyFrame) {
+    auto units = assemble(concat({kSps, kPps, kIdrFirst, kSliceFirst, kSps, kPps, kIdrFirst}));
+
+    ASSERT_EQ(5u, units.size());
+    EXPECT_TRUE(units[0].codecConfig);
+    EXPECT_TRUE(units[1].keyFrame);
+    EXPECT_FALSE(units[2].keyFrame);
+    EXPECT_TRUE(units[3].codecConfig);
+    EXPECT_TRUE(units[4].keyFrame);
+}
+
+TEST(Camera3AccessUnitAssemblerTest, ReferenceFlagFollowsNalRefIdc) {
+    auto units = assemble(concat({kSps, kPps, kIdrFirst, kSliceFirst, kNonReferenceSlice}));
+
+    ASSERT_EQ(4u, units.size());
+    EXPECT_FALSE(units[0].reference);
+    EXPECT_TRUE(units[1].reference);
+    EXPECT_TRUE(units[2].reference);
+    EXPECT_FALSE(units[3].reference);
+    EXPECT_FALSE(units[3].keyFrame);
+}
+
+TEST(Camera3AccessUnitAssemblerTest, EndOfSequenceCompletesAccessUnit) {
+    Camera3AccessUnitAssembler assembler;
+    Camera3NalSplitter splitter;
+    size_t emitted = 0;
+    auto onAccessUnit = [&emitted](const Camera3AccessUnitAssembler::AccessUnit&) {
+        emitted++;
+    };
+    Bytes stream = concat({kSliceFirst, nal({0x0a}), kSliceFirst});
+    splitter.push(stream.data(), stream.size(), [&](const Camera3NalSplitter::NalUnit& nal) {
+        assembler.push(nal, onAccessUnit);
+    });
+    // The end-of-sequence NAL is only split out once the next start code is seen, and it
+    // completes the first picture without waiting for the next one.
+    EXPECT_EQ(1u, emitted);
+}
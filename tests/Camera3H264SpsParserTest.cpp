@@ -0,0 +1,265 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "Camera3H264SpsParserTest"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../device3/Camera3H264SpsParser.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+// Writes an SPS NAL unit bit by bit, then escapes it like an encoder would.
+class SpsWriter {
+  public:
+    void bits(uint32_t value, size_t count) {
+        for (size_t i = count; i > 0; i--) bit((value >> (i - 1)) & 0x01);
+    }
+    void bit(uint32_t b) {
+        if (mBitPos == 0) mRbsp.push_back(0);
+        if (b) mRbsp.back() |= (0x80 >> mBitPos);
+        mBitPos = (mBitPos + 1) % 8;
+    }
+    void ue(uint32_t value) {
+        uint32_t codeNum = value + 1;
+        size_t length = 0;
+        while ((codeNum >> length) > 1) length++;
+        bits(0, length);
+        bits(codeNum, length + 1);
+    }
+    void se(int32_t value) {
+        ue(value > 0 ? 2 * value - 1 : -2 * value);
+    }
+
+    // NAL header + escaped RBSP with rbsp_trailing_bits.
+    std::vector<uint8_t> finish() {
+        bit(1);
+        while (mBitPos != 0) bit(0);
+        std::vector<uint8_t> nal = {0x67};
+        size_t zeros = 0;
+        for (uint8_t b : mRbsp) {
+            if (zeros >= 2 && b <= 0x03) {
+                nal.push_back(0x03);
+                zeros = 0;
+            }
+            nal.push_back(b);
+            zeros = (b == 0) ? zeros + 1 : 0;
+        }
+        return nal;
+    }
+
+  private:
+    std::vector<uint8_t> mRbsp;
+    size_t mBitPos = 0;
+};
+
+struct SpsParams {
+    uint8_t profileIdc = 100;
+    uint32_t chromaFormatIdc = 1;
+    bool scalingMatrix = false;
+    uint32_t pocType = 0;
+    uint32_t widthInMbs = 120;
+    uint32_t heightInMapUnits = 68;
+    bool frameMbsOnly = true;
+    uint32_t crop[4] = {0, 0, 0, 4}; // left, right, top, bottom in crop units
+    bool vui = true;
+    bool timing = true;
+    uint32_t numUnitsInTick = 1;
+    uint32_t timeScale = 60;
+};
+
+std::vector<uint8_t> writeSps(const SpsParams& p) {
+    SpsWriter w;
+    w.bits(p.profileIdc, 8);
+    w.bits(0, 8); // constraint flags
+    w.bits(40, 8); // level_idc
+    w.ue(0); // seq_parameter_set_id
+    if (p.profileIdc == 100) {
+        w.ue(p.chromaFormatIdc);
+        w.ue(0); // bit_depth_luma_minus8
+        w.ue(0); // bit_depth_chroma_minus8
+        w.bit(0); // qpprime_y_zero_transform_bypass_flag
+        w.bit(p.scalingMatrix);
+        if (p.scalingMatrix) {
+            for (int i = 0; i < 8; i++) {
+                w.bit(i == 0 || i == 6);
+                if (i == 0) {
+                    for (int j = 0; j < 16; j++) w.se(j == 0 ? 8 : 0);
+                } else if (i == 6) {
+                    w.se(-8); // nextScale == 0 ends the list early
+                }
+            }
+        }
+    }
+    w.ue(0); // log2_max_frame_num_minus4
+    w.ue(p.pocType);
+    if (p.pocType == 0) {
+        w.ue(2);
+    } else if (p.pocType == 1) {
+        w.bit(0);
+        w.se(-1);
+        w.se(3);
+        w.ue(2);
+        w.se(5);
+        w.se(-7);
+    }
+    w.ue(4); // max_num_ref_frames
+    w.bit(0);
+    w.ue(p.widthInMbs - 1);
+    w.ue(p.heightInMapUnits - 1);
+    w.bit(p.frameMbsOnly);
+    if (!p.frameMbsOnly) w.bit(1);
+    w.bit(1); // direct_8x8_inference_flag
+    bool cropping = p.crop[0] || p.crop[1] || p.crop[2] || p.crop[3];
+    w.bit(cropping);
+    if (cropping) {
+        for (uint32_t c : p.crop) w.ue(c);
+    }
+    w.bit(p.vui);
+    if (p.vui) {
+        w.bit(1); // aspect_ratio_info_present_flag
+        w.bits(255, 8);
+        w.bits(4, 16);
+        w.bits(3, 16);
+        w.bit(0); // overscan_info_present_flag
+        w.bit(1); // video_signal_type_present_flag
+        w.bits(5, 3);
+        w.bit(1); // video_full_range_flag
+        w.bit(1); // colour_description_present_flag
+        w.bits(1, 8);
+        w.bits(1, 8);
+        w.bits(1, 8);
+        w.bit(0); // chroma_loc_info_present_flag
+        w.bit(p.timing);
+        if (p.timing) {
+            w.bits(p.numUnitsInTick, 32);
+            w.bits(p.timeScale, 32);
+            w.bit(1);
+        }
+        w.bit(0); // nal_hrd_parameters_present_flag
+        w.bit(0); // vcl_hrd_parameters_present_flag
+        w.bit(0); // pic_struct_present_flag
+        w.bit(0); // bitstream_restriction_flag
+    }
+    return w.finish();
+}
+
+} // namespace
+
+TEST(Camera3H264SpsParserTest, HighProfile1080pWithCropAndTiming) {
+    std::vector<uint8_t> nal = writeSps(SpsParams());
+    Camera3H264SpsParser::SpsInfo info;
+    ASSERT_EQ(OK, Camera3H264SpsParser::parse(nal.data(), nal.size(), &info));
+
+    EXPECT_EQ(100, info.profileIdc);
+    EXPECT_EQ(40, info.levelIdc);
+    EXPECT_EQ(1920u, info.codedWidth);
+    EXPECT_EQ(1088u, info.codedHeight);
+    EXPECT_EQ(8u, info.cropBottom);
+    EXPECT_EQ(1920u, info.width);
+    EXPECT_EQ(1080u, info.height);
+    EXPECT_TRUE(info.videoFullRange);
+    EXPECT_EQ(4u, info.sarWidth);
+    EXPECT_EQ(3u, info.sarHeight);
+    EXPECT_TRUE(info.timingInfoPresent);
+    EXPECT_DOUBLE_EQ(30.0, info.frameRate());
+}
+
+TEST(Camera3H264SpsParserTest, EmulationPreventionBytesAreRemoved) {
+    // num_units_in_tick = 1 produces runs of zero bytes that must be escaped.
+    std::vector<uint8_t> nal = writeSps(SpsParams());
+    bool escaped = false;
+    for (size_t i = 2; i < nal.size(); i++) {
+        if (nal[i - 2] == 0 && nal[i - 1] == 0 && nal[i] == 0x03) escaped = true;
+    }
+    ASSERT_TRUE(escaped);
+
+    Camera3H264SpsParser::SpsInfo info;
+    ASSERT_EQ(OK, Camera3H264SpsParser::parse(nal.data(), nal.size(), &info));
+    EXPECT_EQ(1u, info.numUnitsInTick);
+    EXPECT_EQ(60u, info.timeScale);
+}
+
+TEST(Camera3H264SpsParserTest, BaselineWithoutCropOrVui) {
+    SpsParams p;
+    p.profileIdc = 66;
+    p.widthInMbs = 40;
+    p.heightInMapUnits = 30;
+    p.crop[3] = 0;
+    p.vui = false;
+    std::vector<uint8_t> nal = writeSps(p);
+    Camera3H264SpsParser::SpsInfo info;
+    ASSERT_EQ(OK, Camera3H264SpsParser::parse(nal.data(), nal.size(), &info));
+
+    EXPECT_EQ(640u, info.width);
+    EXPECT_EQ(480u, info.height);
+    EXPECT_EQ(1u, info.chromaFormatIdc);
+    EXPECT_FALSE(info.timingInfoPresent);
+    EXPECT_DOUBLE_EQ(0.0, info.frameRate());
+}
+
+TEST(Camera3H264SpsParserTest, ScalingMatrixAndPocType1) {
+    SpsParams p;
+    p.scalingMatrix = true;
+    p.pocType = 1;
+    p.widthInMbs = 80;
+    p.heightInMapUnits = 45;
+    p.crop[3] = 0;
+    std::vector<uint8_t> nal = writeSps(p);
+    Camera3H264SpsParser::SpsInfo info;
+    ASSERT_EQ(OK, Camera3H264SpsParser::parse(nal.data(), nal.size(), &info));
+
+    EXPECT_EQ(1280u, info.width);
+    EXPECT_EQ(720u, info.height);
+    EXPECT_DOUBLE_EQ(30.0, info.frameRate());
+}
+
+TEST(Camera3H264SpsParserTest, FieldCodingDoublesHeightAndCropUnit) {
+    SpsParams p;
+    p.frameMbsOnly = false;
+    p.heightInMapUnits = 34;
+    p.crop[3] = 2; // CropUnitY = 2 * 2 for 4:2:0 field coding
+    std::vector<uint8_t> nal = writeSps(p);
+    Camera3H264SpsParser::SpsInfo info;
+    ASSERT_EQ(OK, Camera3H264SpsParser::parse(nal.data(), nal.size(), &info));
+
+    EXPECT_FALSE(info.frameMbsOnly);
+    EXPECT_EQ(1088u, info.codedHeight);
+    EXPECT_EQ(1080u, info.height);
+}
+
+TEST(Camera3H264SpsParserTest, RejectsInvalidInput) {
+    std::vector<uint8_t> nal = writeSps(SpsParams());
+    Camera3H264SpsParser::SpsInfo info;
+
+    EXPECT_EQ(BAD_VALUE, Camera3H264SpsParser::parse(nal.data(), 8, &info));
+    EXPECT_EQ(BAD_VALUE, Camera3H264SpsParser::parse(nullptr, nal.size(), &info));
+
+    std::vector<uint8_t> pps = nal;
+    pps[0] = 0x68;
+    EXPECT_EQ(BAD_VALUE, Camera3H264SpsParser::parse(pps.data(), pps.size(), &info));
+
+    SpsParams p;
+    p.crop[1] = 960; // crops away the whole width
+    nal = writeSps(p);
+    EXPECT_EQ(BAD_VALUE, Camera3H264SpsParser::parse(nal.data(), nal.size(), &info));
+}
@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "Camera3InjectionCompositorTest"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../device3/Camera3InjectionCompositor.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+using Job = Camera3InjectionCompositor::Job;
+
+// Records the jobs it composites; can hold the worker inside a job until unblocked.
+class FakeTarget : public Camera3InjectionCompositor::Target {
+  public:
+    explicit FakeTarget(bool blocked) : mBlocked(blocked) {}
+
+    void compositeAndQueueInjectedBuffer(Job& job) override {
+        std::unique_lock<std::mutex> l(mLock);
+        mStarted++;
+        mChanged.notify_all();
+        mChanged.wait(l, [this]() { return !mBlocked; });
+        mComposited.push_back(job.timestamp);
+        if (job.releaseFence >= 0) {
+            close(job.releaseFence);
+        }
+    }
+
+    bool waitForStarted(size_t count) {
+        std::unique_lock<std::mutex> l(mLock);
+        return mChanged.wait_for(l, std::chrono::seconds(1),
+                [&]() { return mStarted >= count; });
+    }
+
+    void unblock() {
+        std::lock_guard<std::mutex> l(mLock);
+        mBlocked = false;
+        mChanged.notify_all();
+    }
+
+    std::vector<nsecs_t> composited() {
+        std::lock_guard<std::mutex> l(mLock);
+        return mComposited;
+    }
+
+  private:
+    std::mutex mLock;
+    std::condition_variable mChanged;
+    bool mBlocked;
+    size_t mStarted = 0;
+    std::vector<nsecs_t> mComposited;
+};
+
+// Stream IDs 0 and 2 share the first worker.
+Job makeJob(const sp<FakeTarget>& target, int streamId, nsecs_t timestamp, int fence = -1) {
+    Job job;
+    job.target = target.get();
+    job.streamId = streamId;
+    job.timestamp = timestamp;
+    job.releaseFence = fence;
+    return job;
+}
+
+// A readable fd standing in for a release fence.
+int makeFence() {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return -1;
+    }
+    close(fds[1]);
+    return fds[0];
+}
+
+bool isOpen(int fd) {
+    return fcntl(fd, F_GETFD) != -1;
+}
+
+} // namespace
+
+TEST(Camera3InjectionCompositorTest, TeardownCancelsQueuedJobs) {
+    sp<Camera3InjectionCompositor> compositor = new Camera3InjectionCompositor();
+    sp<FakeTarget> stream = new FakeTarget(/*blocked*/ true);
+    sp<FakeTarget> other = new FakeTarget(/*blocked*/ false);
+
+    ASSERT_EQ(OK, compositor->submit(makeJob(stream, 0, 1)));
+    ASSERT_TRUE(stream->waitForStarted(1));
+    int fence = makeFence();
+    ASSERT_EQ(OK, compositor->submit(makeJob(stream, 0, 2, fence)));
+    ASSERT_EQ(OK, compositor->submit(makeJob(other, 2, 10)));
+
+    // Teardown waits for the job being composited, so nothing reaches the consumer after
+    // it returns; the queued job comes back with its fence still open.
+    std::thread unblocker([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        stream->unblock();
+    });
+    std::vector<Job> jobs = compositor->removePending(stream.get());
+    EXPECT_EQ((std::vector<nsecs_t>{1}), stream->composited());
+    unblocker.join();
+    ASSERT_EQ(1u, jobs.size());
+    EXPECT_EQ(2, jobs[0].timestamp);
+    EXPECT_TRUE(isOpen(fence));
+    Camera3InjectionCompositor::cancelBuffer(jobs[0]);
+    EXPECT_EQ(-1, jobs[0].releaseFence);
+    EXPECT_FALSE(isOpen(fence));
+    EXPECT_TRUE(compositor->removePending(stream.get()).empty());
+
+    ASSERT_TRUE(other->waitForStarted(1));
+    compositor.clear();
+    EXPECT_EQ((std::vector<nsecs_t>{1}), stream->composited());
+    EXPECT_EQ((std::vector<nsecs_t>{10}), other->composited());
+}
+
+TEST(Camera3InjectionCompositorTest, StreamPendingLimitKeepsOrder) {
+    sp<Camera3InjectionCompositor> compositor = new Camera3InjectionCompositor();
+    sp<FakeTarget> stream = new FakeTarget(/*blocked*/ true);
+    sp<FakeTarget> other = new FakeTarget(/*blocked*/ false);
+
+    ASSERT_EQ(OK, compositor->submit(makeJob(stream, 0, 0)));
+    ASSERT_TRUE(stream->waitForStarted(1));
+    for (size_t i = 1; i < Camera3InjectionCompositor::kMaxPendingPerStream; i++) {
+        ASSERT_EQ(OK, compositor->submit(makeJob(stream, 0, i)));
+    }
+    const nsecs_t next = Camera3InjectionCompositor::kMaxPendingPerStream;
+
+    // The limit is per stream: another stream on the same worker is still accepted.
+    int fence = makeFence();
+    EXPECT_EQ(WOULD_BLOCK, compositor->submit(makeJob(stream, 0, next, fence)));
+    EXPECT_TRUE(isOpen(fence));
+    close(fence);
+    EXPECT_EQ(OK, compositor->submit(makeJob(other, 2, 100)));
+
+    // The caller drains the stream before compositing its buffer inline, so the inline
+    // buffer lands after every queued one.
+    stream->unblock();
+    std::vector<Job> jobs = compositor->removePending(stream.get());
+    for (auto& job : jobs) {
+        stream->compositeAndQueueInjectedBuffer(job);
+    }
+    Job inline_ = makeJob(stream, 0, next);
+    stream->compositeAndQueueInjectedBuffer(inline_);
+    std::vector<nsecs_t> expected;
+    for (nsecs_t i = 0; i <= next; i++) {
+        expected.push_back(i);
+    }
+    EXPECT_EQ(expected, stream->composited());
+
+    // Drained jobs no longer count against the limit.
+    EXPECT_EQ(OK, compositor->submit(makeJob(stream, 0, next + 1)));
+    compositor.clear();
+}
+
+TEST(Camera3InjectionCompositorTest, FullWorkerRejectsWithoutWaiting) {
+    sp<Camera3InjectionCompositor> compositor = new Camera3InjectionCompositor();
+    sp<FakeTarget> busy = new FakeTarget(/*blocked*/ true);
+    std::vector<sp<FakeTarget>> streams;
+
+    ASSERT_EQ(OK, compositor->submit(makeJob(busy, 0, 0)));
+    ASSERT_TRUE(busy->waitForStarted(1));
+    // Even stream IDs share the first worker; fill its queue one job per stream.
+    for (size_t i = 0; i < Camera3InjectionCompositor::kMaxQueuedJobs; i++) {
+        streams.push_back(new FakeTarget(/*blocked*/ false));
+        ASSERT_EQ(OK, compositor->submit(makeJob(streams.back(), 2 * (i + 1), i + 1)));
+    }
+
+    // The caller composites inline instead of blocking the result thread.
+    sp<FakeTarget> late = new FakeTarget(/*blocked*/ false);
+    int fence = makeFence();
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(WOULD_BLOCK, compositor->submit(makeJob(late, 100, 100, fence)));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(5));
+    EXPECT_TRUE(isOpen(fence));
+    close(fence);
+
+    busy->unblock();
+    compositor.clear();
+}
+
+TEST(Camera3InjectionCompositorTest, DestroyedTargetCancelsBuffer) {
+    sp<Camera3InjectionCompositor> compositor = new Camera3InjectionCompositor();
+    sp<FakeTarget> stream = new FakeTarget(/*blocked*/ true);
+    sp<FakeTarget> destroyed = new FakeTarget(/*blocked*/ false);
+
+    ASSERT_EQ(OK, compositor->submit(makeJob(stream, 0, 1)));
+    ASSERT_TRUE(stream->waitForStarted(1));
+    int fence = makeFence();
+    ASSERT_EQ(OK, compositor->submit(makeJob(destroyed, 2, 2, fence)));
+    destroyed.clear();
+
+    stream->unblock();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (isOpen(fence) && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_FALSE(isOpen(fence));
+    compositor.clear();
+}
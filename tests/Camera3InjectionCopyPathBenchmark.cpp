@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <libyuv.h>
+#include <system/graphics.h>
+
+#include "../device3/Camera3InjectionTransform.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+// A 1080p decoder output: NV12, macroblock-aligned height, display crop to 1080 rows.
+constexpr int32_t kDecodeWidth = 1920;
+constexpr int32_t kDecodeHeight = 1088;
+constexpr int32_t kDecodeStride = 2048;
+constexpr int32_t kFrameWidth = 1920;
+constexpr int32_t kFrameHeight = 1080;
+
+struct DecoderOutput {
+    std::vector<uint8_t> data;
+    const uint8_t* y;
+    const uint8_t* uv;
+
+    DecoderOutput() : data(static_cast<size_t>(kDecodeStride) * kDecodeHeight * 3 / 2) {
+        for (size_t i = 0; i < data.size(); i++) {
+            data[i] = static_cast<uint8_t>(i * 7 + i / kDecodeStride);
+        }
+        y = data.data();
+        uv = y + static_cast<size_t>(kDecodeStride) * kDecodeHeight;
+    }
+};
+
+struct StreamBuffer {
+    int32_t width;
+    int32_t height;
+    int32_t stride;
+    std::vector<uint8_t> data;
+
+    StreamBuffer(int32_t w, int32_t h) : width(w), height(h), stride((w + 63) & ~63),
+            data(static_cast<size_t>(stride) * h * 3 / 2) {}
+
+    uint8_t* y() { return data.data(); }
+    uint8_t* uv() { return data.data() + static_cast<size_t>(stride) * height; }
+};
+
+size_t yuvBytes(int32_t width, int32_t height) {
+    return static_cast<size_t>(width) * height * 3 / 2;
+}
+
+// CPU bytes read plus written by the transform into the stream buffer.
+size_t transformBytes(const Camera3InjectionTransform::Key& key) {
+    int32_t rotation = Camera3InjectionTransform::compensationRotation(key.transform);
+    Camera3InjectionTransform::Rect crop = Camera3InjectionTransform::computeSourceCrop(
+            key.srcWidth, key.srcHeight, rotation, key.dstWidth, key.dstHeight);
+    size_t dstBytes = yuvBytes(key.dstWidth, key.dstHeight);
+    size_t bytes = yuvBytes(crop.width, crop.height) + dstBytes;
+    if (rotation != 0) {
+        // Scaled into scratch, then read back by the rotation.
+        bytes += 2 * dstBytes;
+    }
+    if (key.swapChroma) {
+        bytes += static_cast<size_t>(key.dstWidth) * key.dstHeight;
+    }
+    return bytes;
+}
+
+void reportBytes(benchmark::State& state, size_t bytesPerFrame) {
+    state.counters["cpu_bytes_per_frame"] = static_cast<double>(bytesPerFrame);
+    state.SetBytesProcessed(state.iterations() * bytesPerFrame);
+}
+
+// Decoder output in CPU memory: every frame is copied into the frame pool (swapping NV12
+// to NV21 on the way) and the output stream transforms the pooled copy.
+void BM_BufferOutputPath(benchmark::State& state) {
+    DecoderOutput output;
+    StreamBuffer stream(state.range(0), state.range(1));
+    std::vector<uint8_t> pooled(yuvBytes(kFrameWidth, kFrameHeight));
+    uint8_t* pooledY = pooled.data();
+    uint8_t* pooledUV = pooledY + kFrameWidth * kFrameHeight;
+
+    Camera3InjectionTransform::Key key = {kFrameWidth, kFrameHeight, kFrameWidth,
+            stream.width, stream.height, stream.stride, static_cast<int32_t>(state.range(2))};
+    Camera3InjectionTransform::Plan plan;
+    plan.update(key);
+    for (auto _ : state) {
+        libyuv::NV21ToNV12(output.y, kDecodeStride, output.uv, kDecodeStride,
+                pooledY, kFrameWidth, pooledUV, kFrameWidth, kFrameWidth, kFrameHeight);
+        plan.execute(pooledY, pooledUV, stream.y(), stream.uv());
+        benchmark::ClobberMemory();
+    }
+    reportBytes(state, 2 * yuvBytes(kFrameWidth, kFrameHeight) + transformBytes(key));
+}
+
+// Decoder output in a gralloc buffer: the output stream transforms straight from the
+// decoder's buffer and swaps the chroma of the (smaller) stream-sized result.
+void BM_GraphicOutputPath(benchmark::State& state) {
+    DecoderOutput output;
+    StreamBuffer stream(state.range(0), state.range(1));
+
+    Camera3InjectionTransform::Key key = {kFrameWidth, kFrameHeight, kDecodeStride,
+            stream.width, stream.height, stream.stride, static_cast<int32_t>(state.range(2)),
+            /*swapChroma*/ true};
+    Camera3InjectionTransform::Plan plan;
+    plan.update(key);
+    for (auto _ : state) {
+        plan.execute(output.y, output.uv, stream.y(), stream.uv());
+        benchmark::ClobberMemory();
+    }
+    reportBytes(state, transformBytes(key));
+}
+
+void StreamArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"width", "height", "transform"});
+    b->Args({1920, 1080, 0});
+    b->Args({1280, 720, 0});
+    b->Args({640, 480, 0});
+    b->Args({720, 1280, HAL_TRANSFORM_ROT_90});
+}
+
+BENCHMARK(BM_BufferOutputPath)->Apply(StreamArgs);
+BENCHMARK(BM_GraphicOutputPath)->Apply(StreamArgs);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,302 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "Camera3InjectionDecodeQueueTest"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../device3/Camera3InjectionDecodeQueue.h"
+#include "../device3/Camera3NalSplitter.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+using Queue = Camera3InjectionDecodeQueue;
+using DropReason = Queue::DropReason;
+
+enum class Kind { CONFIG, IDR, REFERENCE, NON_REFERENCE };
+
+// Pushes a one-byte access unit whose payload identifies it.
+bool push(Queue* queue, Kind kind, uint8_t id, nsecs_t receiveTime = 0) {
+    Camera3AccessUnitAssembler::AccessUnit au{};
+    au.data = &id;
+    au.size = 1;
+    au.codecConfig = kind == Kind::CONFIG;
+    au.keyFrame = kind == Kind::IDR;
+    au.reference = kind == Kind::IDR || kind == Kind::REFERENCE;
+    au.nalCount = 1;
+    au.receiveTime = receiveTime;
+    return queue->pushAccessUnit(au);
+}
+
+// A framed-protocol frame: one slice NAL unit whose last byte identifies it. The NAL header
+// carries nal_ref_idc and nal_unit_type; 0x80 starts the slice header at first_mb_in_slice 0.
+std::vector<uint8_t> makeFrame(uint8_t nalHeader, uint8_t id) {
+    return {0, 0, 0, 1, nalHeader, 0x80, id};
+}
+
+// Splits a frame and wraps it the way Camera3SocketServer::submitFrame does.
+bool wrapFrame(const std::vector<uint8_t>& frame, Camera3AccessUnitAssembler::AccessUnit* au) {
+    Camera3NalSplitter splitter;
+    std::vector<Camera3NalSplitter::NalUnit> nals;
+    splitter.split(frame.data(), frame.size(),
+            [&](const Camera3NalSplitter::NalUnit& nal) { nals.push_back(nal); });
+    return Camera3AccessUnitAssembler::wrapFrame(nals, /*receiveTime*/ 0, au);
+}
+
+bool pushFrame(Queue* queue, uint8_t nalHeader, uint8_t id) {
+    std::vector<uint8_t> frame = makeFrame(nalHeader, id);
+    Camera3AccessUnitAssembler::AccessUnit au{};
+    EXPECT_TRUE(wrapFrame(frame, &au));
+    return queue->pushAccessUnit(au);
+}
+
+// Drains the queue, returning the ids (last byte) of access units and 0xC0 / 0xEE for
+// configure / release entries.
+std::vector<uint8_t> drain(Queue* queue) {
+    queue->finish();
+    std::vector<uint8_t> ids;
+    std::unique_ptr<Queue::Entry> entry;
+    while (queue->pop(&entry)) {
+        switch (entry->type) {
+            case Queue::Entry::Type::ACCESS_UNIT: ids.push_back(entry->data.back()); break;
+            case Queue::Entry::Type::CONFIGURE: ids.push_back(0xC0); break;
+            case Queue::Entry::Type::RELEASE: ids.push_back(0xEE); break;
+        }
+        queue->recycle(std::move(entry));
+    }
+    return ids;
+}
+
+uint64_t drops(const Queue& queue, DropReason reason) {
+    return queue.getStats().drops[static_cast<size_t>(reason)];
+}
+
+} // namespace
+
+TEST(Camera3InjectionDecodeQueueTest, KeepsOrderOfEntries) {
+    Queue queue(4);
+    queue.pushConfigure(640, 480);
+    push(&queue, Kind::CONFIG, 1);
+    push(&queue, Kind::IDR, 2);
+    push(&queue, Kind::REFERENCE, 3);
+    queue.pushRelease();
+    EXPECT_EQ(2u, queue.getStats().depth);
+
+    EXPECT_EQ((std::vector<uint8_t>{0xC0, 1, 2, 3, 0xEE}), drain(&queue));
+    Queue::Stats stats = queue.getStats();
+    EXPECT_EQ(0u, stats.depth);
+    EXPECT_EQ(2u, stats.maxDepth);
+    EXPECT_EQ(2u, stats.accessUnitsPushed);
+    EXPECT_EQ(2u, stats.accessUnitsPopped);
+    EXPECT_EQ(0u, stats.totalDrops());
+}
+
+TEST(Camera3InjectionDecodeQueueTest, OverflowDropsNonReferenceFirst) {
+    Queue queue(3);
+    push(&queue, Kind::IDR, 1);
+    push(&queue, Kind::NON_REFERENCE, 2);
+    push(&queue, Kind::REFERENCE, 3);
+    // Full: an incoming non-reference frame is dropped...
+    push(&queue, Kind::NON_REFERENCE, 4);
+    // ...and an incoming reference frame evicts the oldest queued non-reference one.
+    push(&queue, Kind::REFERENCE, 5);
+    // Codec config never counts against the capacity.
+    push(&queue, Kind::CONFIG, 6);
+
+    EXPECT_EQ(2u, drops(queue, DropReason::NON_REFERENCE));
+    EXPECT_FALSE(queue.getStats().waitingForKeyFrame);
+    EXPECT_EQ((std::vector<uint8_t>{1, 3, 5, 6}), drain(&queue));
+}
+
+TEST(Camera3InjectionDecodeQueueTest, OverflowOfReferenceFramesSkipsToNextIdr) {
+    Queue queue(2);
+    push(&queue, Kind::IDR, 1);
+    push(&queue, Kind::REFERENCE, 2);
+    push(&queue, Kind::REFERENCE, 3);
+    EXPECT_EQ(1u, drops(queue, DropReason::OVERFLOW));
+    EXPECT_TRUE(queue.getStats().waitingForKeyFrame);
+
+    // Nothing up to the next IDR can be decoded.
+    push(&queue, Kind::NON_REFERENCE, 4);
+    push(&queue, Kind::REFERENCE, 5);
+    EXPECT_EQ(2u, drops(queue, DropReason::WAIT_FOR_KEY_FRAME));
+
+    // The sender is asked for an IDR, then again only after the request interval.
+    nsecs_t now = s2ns(100);
+    EXPECT_TRUE(queue.takeKeyFrameRequest(now));
+    EXPECT_FALSE(queue.takeKeyFrameRequest(now + ms2ns(10)));
+    EXPECT_TRUE(queue.takeKeyFrameRequest(now + Queue::kKeyFrameRequestInterval));
+    EXPECT_EQ(2u, queue.getStats().keyFrameRequests);
+
+    // The IDR arrives on a full queue and supersedes the frames still queued.
+    push(&queue, Kind::CONFIG, 6);
+    push(&queue, Kind::IDR, 7);
+    EXPECT_EQ(2u, drops(queue, DropReason::SUPERSEDED));
+    EXPECT_FALSE(queue.getStats().waitingForKeyFrame);
+    EXPECT_FALSE(queue.takeKeyFrameRequest(now + s2ns(10)));
+    push(&queue, Kind::REFERENCE, 8);
+
+    EXPECT_EQ((std::vector<uint8_t>{6, 7, 8}), drain(&queue));
+}
+
+TEST(Camera3InjectionDecodeQueueTest, FramedReferenceFramesOnFullQueue) {
+    // NAL headers: IDR slice with nal_ref_idc 3, and non-IDR slices with nal_ref_idc 2 and 0.
+    constexpr uint8_t kIdr = 0x65;
+    constexpr uint8_t kReferenceP = 0x41;
+    constexpr uint8_t kNonReferenceP = 0x01;
+
+    Camera3AccessUnitAssembler::AccessUnit au{};
+    ASSERT_TRUE(wrapFrame(makeFrame(kReferenceP, 1), &au));
+    EXPECT_TRUE(au.reference);
+    EXPECT_FALSE(au.keyFrame);
+    ASSERT_TRUE(wrapFrame(makeFrame(kNonReferenceP, 1), &au));
+    EXPECT_FALSE(au.reference);
+    ASSERT_TRUE(wrapFrame(makeFrame(kIdr, 1), &au));
+    EXPECT_TRUE(au.reference);
+    EXPECT_TRUE(au.keyFrame);
+    // Frames carrying SPS/PPS go through the assembler instead.
+    std::vector<uint8_t> withSps = {0, 0, 0, 1, 0x67, 0x42, 0, 0, 0, 1, kIdr, 0x80, 1};
+    EXPECT_FALSE(wrapFrame(withSps, &au));
+
+    Queue queue(2);
+    EXPECT_TRUE(pushFrame(&queue, kIdr, 1));
+    EXPECT_TRUE(pushFrame(&queue, kReferenceP, 2));
+
+    // The queue is full of reference frames: an incoming non-reference P-frame is dropped and
+    // the queued P-frame is kept.
+    EXPECT_FALSE(pushFrame(&queue, kNonReferenceP, 3));
+    EXPECT_EQ(1u, drops(queue, DropReason::NON_REFERENCE));
+    EXPECT_FALSE(queue.getStats().waitingForKeyFrame);
+
+    // An incoming reference P-frame cannot evict anything, so decoding skips to the next IDR.
+    EXPECT_FALSE(pushFrame(&queue, kReferenceP, 4));
+    EXPECT_EQ(1u, drops(queue, DropReason::OVERFLOW));
+    EXPECT_TRUE(queue.getStats().waitingForKeyFrame);
+    EXPECT_EQ((std::vector<uint8_t>{1, 2}), drain(&queue));
+}
+
+TEST(Camera3InjectionDecodeQueueTest, CountsBytesCopiedIn) {
+    Queue queue(1);
+    EXPECT_TRUE(push(&queue, Kind::CONFIG, 1));
+    EXPECT_TRUE(pushFrame(&queue, 0x65, 2));
+    // Dropped access units are never copied.
+    EXPECT_FALSE(push(&queue, Kind::NON_REFERENCE, 3));
+    EXPECT_EQ(1u + makeFrame(0x65, 2).size(), queue.getStats().bytesCopied);
+    EXPECT_EQ((std::vector<uint8_t>{1, 2}), drain(&queue));
+    EXPECT_FALSE(push(&queue, Kind::IDR, 4));
+}
+
+TEST(Camera3InjectionDecodeQueueTest, StaleFramesDroppedOnPop) {
+    Queue queue(8);
+    queue.setMaxAge(ms2ns(100));
+    nsecs_t old = systemTime() - ms2ns(500);
+    nsecs_t fresh = systemTime();
+    push(&queue, Kind::NON_REFERENCE, 1, old);
+    push(&queue, Kind::REFERENCE, 2, fresh);
+    push(&queue, Kind::IDR, 3, old);
+    push(&queue, Kind::REFERENCE, 4, old);
+    push(&queue, Kind::NON_REFERENCE, 5, fresh);
+    push(&queue, Kind::REFERENCE, 6, fresh);
+    push(&queue, Kind::IDR, 7, fresh);
+
+    // A stale non-reference frame goes alone; a stale IDR is still decoded; a stale
+    // reference frame takes every frame up to the next IDR with it.
+    EXPECT_EQ((std::vector<uint8_t>{2, 3, 7}), drain(&queue));
+    EXPECT_EQ(2u, drops(queue, DropReason::STALE));
+    EXPECT_EQ(2u, drops(queue, DropReason::WAIT_FOR_KEY_FRAME));
+    EXPECT_FALSE(queue.getStats().waitingForKeyFrame);
+}
+
+TEST(Camera3InjectionDecodeQueueTest, DecoderDropOfReferenceFrameWaitsForIdr) {
+    Queue queue(8);
+    push(&queue, Kind::REFERENCE, 1);
+    push(&queue, Kind::REFERENCE, 2);
+
+    std::unique_ptr<Queue::Entry> entry;
+    ASSERT_TRUE(queue.pop(&entry));
+    queue.reportDecoderDrop(*entry);
+    queue.recycle(std::move(entry));
+
+    Queue::Stats stats = queue.getStats();
+    EXPECT_EQ(1u, stats.drops[static_cast<size_t>(DropReason::DECODER_BUSY)]);
+    EXPECT_EQ(1u, stats.drops[static_cast<size_t>(DropReason::WAIT_FOR_KEY_FRAME)]);
+    EXPECT_TRUE(stats.waitingForKeyFrame);
+    EXPECT_TRUE(queue.takeKeyFrameRequest(s2ns(1)));
+    EXPECT_TRUE(drain(&queue).empty());
+}
+
+TEST(Camera3InjectionDecodeQueueTest, DecoderDropOfNonReferenceFrameRequestsIdr) {
+    Queue queue(8);
+    push(&queue, Kind::NON_REFERENCE, 1);
+    push(&queue, Kind::REFERENCE, 2);
+
+    std::unique_ptr<Queue::Entry> entry;
+    ASSERT_TRUE(queue.pop(&entry));
+    queue.reportDecoderDrop(*entry);
+    queue.recycle(std::move(entry));
+
+    // The decoder stalled past its deadline: the backlog is stale, resume at the next IDR.
+    EXPECT_TRUE(queue.getStats().waitingForKeyFrame);
+    EXPECT_TRUE(queue.takeKeyFrameRequest(s2ns(1)));
+    EXPECT_TRUE(drain(&queue).empty());
+    EXPECT_EQ(1u, drops(queue, DropReason::DECODER_BUSY));
+    EXPECT_EQ(1u, drops(queue, DropReason::WAIT_FOR_KEY_FRAME));
+}
+
+TEST(Camera3InjectionDecodeQueueTest, ResetStartsNewConnection) {
+    Queue queue(2);
+    push(&queue, Kind::IDR, 1);
+    push(&queue, Kind::REFERENCE, 2);
+    push(&queue, Kind::REFERENCE, 3);
+    EXPECT_TRUE(queue.getStats().waitingForKeyFrame);
+    queue.finish();
+
+    queue.reset();
+    Queue::Stats stats = queue.getStats();
+    EXPECT_EQ(0u, stats.depth);
+    EXPECT_FALSE(stats.waitingForKeyFrame);
+    EXPECT_EQ(1u, stats.drops[static_cast<size_t>(DropReason::OVERFLOW)]);
+    push(&queue, Kind::REFERENCE, 4);
+    EXPECT_EQ((std::vector<uint8_t>{4}), drain(&queue));
+}
+
+TEST(Camera3InjectionDecodeQueueTest, PopBlocksUntilPushOrFinish) {
+    Queue queue;
+    std::vector<uint8_t> ids;
+    bool finished = false;
+    std::thread consumer([&]() {
+        std::unique_ptr<Queue::Entry> entry;
+        while (queue.pop(&entry)) {
+            ids.push_back(entry->data[0]);
+            queue.recycle(std::move(entry));
+        }
+        finished = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    push(&queue, Kind::IDR, 9);
+    queue.finish();
+    consumer.join();
+    EXPECT_TRUE(finished);
+    EXPECT_EQ((std::vector<uint8_t>{9}), ids);
+}
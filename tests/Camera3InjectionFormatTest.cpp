@@ -0,0 +1,265 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "Camera3InjectionFormatTest"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <system/graphics.h>
+
+extern "C" {
+#include <jpeglib.h>
+}
+
+#include "../device3/Camera3InjectionFormat.h"
+
+using namespace android;
+using namespace android::camera3;
+
+using Layout = Camera3InjectionFormat::Layout;
+
+namespace {
+
+// An NV21 frame with a distinct value at every Y and chroma sample.
+struct Nv21Frame {
+    Nv21Frame(int32_t width, int32_t height, int32_t stride) :
+            width(width), height(height), stride(stride),
+            data(static_cast<size_t>(stride) * (height + (height + 1) / 2)) {
+        for (int32_t row = 0; row < height; row++) {
+            for (int32_t col = 0; col < width; col++) {
+                y()[row * stride + col] = static_cast<uint8_t>(row * 7 + col * 3);
+            }
+        }
+        for (int32_t row = 0; row < (height + 1) / 2; row++) {
+            for (int32_t col = 0; col < (width + 1) / 2; col++) {
+                vu()[row * stride + col * 2] = static_cast<uint8_t>(100 + row + col);
+                vu()[row * stride + col * 2 + 1] = static_cast<uint8_t>(20 + row * 2 + col);
+            }
+        }
+    }
+
+    uint8_t* y() { return data.data(); }
+    uint8_t* vu() { return data.data() + static_cast<size_t>(stride) * height; }
+    uint8_t v(int32_t col, int32_t row) { return vu()[row * stride + col * 2]; }
+    uint8_t u(int32_t col, int32_t row) { return vu()[row * stride + col * 2 + 1]; }
+    Camera3InjectionTransform::Source source() { return {y(), vu(), stride, width, height}; }
+
+    int32_t width;
+    int32_t height;
+    int32_t stride;
+    std::vector<uint8_t> data;
+};
+
+// Decodes a JPEG to its Y channel.
+std::vector<uint8_t> decodeJpegLuma(const uint8_t* data, size_t size, size_t* width,
+        size_t* height) {
+    jpeg_decompress_struct cinfo;
+    jpeg_error_mgr err;
+    cinfo.err = jpeg_std_error(&err);
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, data, size);
+    jpeg_read_header(&cinfo, TRUE);
+    cinfo.out_color_space = JCS_YCbCr;
+    jpeg_start_decompress(&cinfo);
+    *width = cinfo.output_width;
+    *height = cinfo.output_height;
+    std::vector<uint8_t> row(cinfo.output_width * cinfo.output_components);
+    std::vector<uint8_t> luma;
+    while (cinfo.output_scanline < cinfo.output_height) {
+        JSAMPROW rowPointer = row.data();
+        jpeg_read_scanlines(&cinfo, &rowPointer, 1);
+        for (size_t col = 0; col < cinfo.output_width; col++) {
+            luma.push_back(row[col * cinfo.output_components]);
+        }
+    }
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    return luma;
+}
+
+} // namespace
+
+TEST(Camera3InjectionFormatTest, ClassifiesStreamFormats) {
+    EXPECT_EQ(Layout::NV21, Camera3InjectionFormat::classify(HAL_PIXEL_FORMAT_YCrCb_420_SP, 0));
+    EXPECT_EQ(Layout::PLANAR, Camera3InjectionFormat::classify(HAL_PIXEL_FORMAT_YV12, 0));
+    EXPECT_EQ(Layout::P010, Camera3InjectionFormat::classify(HAL_PIXEL_FORMAT_YCBCR_P010, 0));
+    EXPECT_EQ(Layout::FLEXIBLE_YUV,
+            Camera3InjectionFormat::classify(HAL_PIXEL_FORMAT_IMPLEMENTATION_DEFINED, 0));
+    EXPECT_EQ(Layout::RGBA, Camera3InjectionFormat::classify(HAL_PIXEL_FORMAT_RGBX_8888, 0));
+    EXPECT_EQ(Layout::JPEG, Camera3InjectionFormat::classify(HAL_PIXEL_FORMAT_BLOB,
+            HAL_DATASPACE_V0_JFIF));
+    EXPECT_EQ(Layout::UNSUPPORTED, Camera3InjectionFormat::classify(HAL_PIXEL_FORMAT_BLOB,
+            HAL_DATASPACE_DEPTH));
+    EXPECT_EQ(Layout::BLANK, Camera3InjectionFormat::classify(HAL_PIXEL_FORMAT_RAW16, 0));
+    EXPECT_TRUE(Camera3InjectionFormat::isYCbCr(Layout::FLEXIBLE_YUV));
+    EXPECT_FALSE(Camera3InjectionFormat::isYCbCr(Layout::RGBA));
+}
+
+TEST(Camera3InjectionFormatTest, ClassifiesLockedPlanes) {
+    uint8_t buffer[64] = {};
+    Camera3InjectionFormat::Planes planes = {buffer, buffer + 33, buffer + 32, 16, 16, 2};
+    EXPECT_EQ(Layout::NV21, Camera3InjectionFormat::classifyPlanes(planes, false));
+    EXPECT_TRUE(Camera3InjectionFormat::isDirect(Layout::NV21, planes));
+    // Chroma rows padded differently from luma rows need a conversion.
+    planes.cStride = 32;
+    EXPECT_FALSE(Camera3InjectionFormat::isDirect(Layout::NV21, planes));
+
+    planes = {buffer, buffer + 32, buffer + 33, 16, 16, 2};
+    EXPECT_EQ(Layout::NV12, Camera3InjectionFormat::classifyPlanes(planes, false));
+    planes = {buffer, buffer + 48, buffer + 32, 16, 8, 1};
+    EXPECT_EQ(Layout::PLANAR, Camera3InjectionFormat::classifyPlanes(planes, false));
+    planes = {buffer, buffer + 32, buffer + 34, 16, 16, 4};
+    EXPECT_EQ(Layout::P010, Camera3InjectionFormat::classifyPlanes(planes, true));
+    EXPECT_EQ(Layout::UNSUPPORTED, Camera3InjectionFormat::classifyPlanes(planes, false));
+    planes.cr = nullptr;
+    EXPECT_EQ(Layout::UNSUPPORTED, Camera3InjectionFormat::classifyPlanes(planes, true));
+}
+
+TEST(Camera3InjectionFormatTest, ConvertsToNv12WithChromaOffset) {
+    Nv21Frame frame(20, 10, 20);
+    // Luma stride 32, chroma plane starting past a 64-byte alignment gap.
+    std::vector<uint8_t> buffer(32 * 10 + 64 + 32 * 5, 0xEE);
+    Camera3InjectionFormat::Planes planes = {buffer.data(), buffer.data() + 32 * 10 + 64,
+            buffer.data() + 32 * 10 + 65, 32, 32, 2};
+    ASSERT_EQ(OK, Camera3InjectionFormat::convert(frame.source(), Layout::NV12, planes));
+    for (int32_t row = 0; row < 10; row++) {
+        for (int32_t col = 0; col < 20; col++) {
+            ASSERT_EQ(frame.y()[row * 20 + col], planes.y[row * 32 + col]);
+        }
+        EXPECT_EQ(0xEE, planes.y[row * 32 + 20]) << "luma padding overwritten";
+    }
+    for (int32_t row = 0; row < 5; row++) {
+        for (int32_t col = 0; col < 10; col++) {
+            ASSERT_EQ(frame.u(col, row), planes.cb[row * 32 + col * 2]);
+            ASSERT_EQ(frame.v(col, row), planes.cr[row * 32 + col * 2]);
+        }
+    }
+    // The alignment gap between the planes is left alone.
+    EXPECT_EQ(0xEE, buffer[32 * 10]);
+}
+
+TEST(Camera3InjectionFormatTest, ConvertsToYv12) {
+    Nv21Frame frame(16, 8, 16);
+    // YV12: Y, then Cr, then Cb, chroma stride half the luma stride.
+    std::vector<uint8_t> buffer(16 * 8 * 3 / 2);
+    uint8_t* cr = buffer.data() + 16 * 8;
+    uint8_t* cb = cr + 8 * 4;
+    Camera3InjectionFormat::Planes planes = {buffer.data(), cb, cr, 16, 8, 1};
+    ASSERT_EQ(Layout::PLANAR, Camera3InjectionFormat::classifyPlanes(planes, false));
+    ASSERT_EQ(OK, Camera3InjectionFormat::convert(frame.source(), Layout::PLANAR, planes));
+    EXPECT_EQ(0, memcmp(frame.y(), buffer.data(), 16 * 8));
+    for (int32_t row = 0; row < 4; row++) {
+        for (int32_t col = 0; col < 8; col++) {
+            ASSERT_EQ(frame.u(col, row), cb[row * 8 + col]);
+            ASSERT_EQ(frame.v(col, row), cr[row * 8 + col]);
+        }
+    }
+}
+
+TEST(Camera3InjectionFormatTest, ConvertsToP010) {
+    Nv21Frame frame(8, 4, 8);
+    std::vector<uint16_t> buffer(8 * 4 + 8 * 2);
+    uint8_t* base = reinterpret_cast<uint8_t*>(buffer.data());
+    Camera3InjectionFormat::Planes planes = {base, base + 8 * 4 * 2, base + 8 * 4 * 2 + 2,
+            16, 16, 4};
+    ASSERT_EQ(OK, Camera3InjectionFormat::convert(frame.source(), Layout::P010, planes));
+    for (int32_t i = 0; i < 8 * 4; i++) {
+        uint16_t sample = buffer[i];
+        EXPECT_EQ(0, sample & 0x3F);
+        EXPECT_EQ(frame.y()[i], sample >> 8);
+    }
+    const uint16_t* chroma = buffer.data() + 8 * 4;
+    for (int32_t row = 0; row < 2; row++) {
+        for (int32_t col = 0; col < 4; col++) {
+            EXPECT_EQ(frame.u(col, row), chroma[row * 8 + col * 2] >> 8);
+            EXPECT_EQ(frame.v(col, row), chroma[row * 8 + col * 2 + 1] >> 8);
+        }
+    }
+
+    // Full scale maps to the largest 10-bit code.
+    Nv21Frame white(2, 2, 2);
+    memset(white.data.data(), 0xFF, white.data.size());
+    std::vector<uint16_t> out(6);
+    uint8_t* whiteBase = reinterpret_cast<uint8_t*>(out.data());
+    planes = {whiteBase, whiteBase + 8, whiteBase + 10, 4, 4, 4};
+    ASSERT_EQ(OK, Camera3InjectionFormat::convert(white.source(), Layout::P010, planes));
+    EXPECT_EQ(0xFFC0, out[0]);
+    EXPECT_EQ(0xFFC0, out[5]);
+}
+
+TEST(Camera3InjectionFormatTest, ConvertsToRgbaByteOrder) {
+    // Saturated red in BT.601: Y 81, U 90, V 240.
+    Nv21Frame frame(4, 2, 4);
+    memset(frame.y(), 81, 8);
+    for (int32_t col = 0; col < 2; col++) {
+        frame.vu()[col * 2] = 240;
+        frame.vu()[col * 2 + 1] = 90;
+    }
+    std::vector<uint8_t> rgba(8 * 2 * 4);
+    Camera3InjectionFormat::Planes planes = {rgba.data(), nullptr, nullptr, 8 * 4, 0, 0};
+    ASSERT_EQ(OK, Camera3InjectionFormat::convert(frame.source(), Layout::RGBA, planes));
+    EXPECT_GT(rgba[0], 230);
+    EXPECT_LT(rgba[1], 30);
+    EXPECT_LT(rgba[2], 30);
+    EXPECT_EQ(255, rgba[3]);
+
+    std::vector<uint8_t> bgra(rgba.size());
+    planes.y = bgra.data();
+    ASSERT_EQ(OK, Camera3InjectionFormat::convert(frame.source(), Layout::BGRA, planes));
+    EXPECT_EQ(rgba[0], bgra[2]);
+    EXPECT_EQ(rgba[2], bgra[0]);
+}
+
+TEST(Camera3InjectionFormatTest, EncodesJpegOfFrameSize) {
+    // Not a multiple of the 16x16 MCU, so the padding path is covered.
+    Nv21Frame frame(100, 58, 104);
+    std::vector<uint8_t> jpeg(64 * 1024);
+    size_t encodedSize = 0;
+    ASSERT_EQ(OK, Camera3InjectionFormat::encodeJpeg(frame.source(), 90, jpeg.data(),
+            jpeg.size(), &encodedSize));
+    ASSERT_GT(encodedSize, 0u);
+    ASSERT_LT(encodedSize, jpeg.size());
+    EXPECT_EQ(0xFF, jpeg[0]);
+    EXPECT_EQ(0xD8, jpeg[1]);
+    EXPECT_EQ(0xFF, jpeg[encodedSize - 2]);
+    EXPECT_EQ(0xD9, jpeg[encodedSize - 1]);
+
+    size_t width = 0, height = 0;
+    std::vector<uint8_t> luma = decodeJpegLuma(jpeg.data(), encodedSize, &width, &height);
+    ASSERT_EQ(100u, width);
+    ASSERT_EQ(58u, height);
+    // Lossy, but the decoded luma must follow the source closely, including the
+    // right and bottom edges that fall into padded MCUs.
+    int64_t totalError = 0;
+    for (int32_t row = 0; row < 58; row++) {
+        for (int32_t col = 0; col < 100; col++) {
+            totalError += std::abs(luma[row * 100 + col] - frame.y()[row * 104 + col]);
+        }
+    }
+    EXPECT_LT(totalError / (100 * 58), 6);
+}
+
+TEST(Camera3InjectionFormatTest, JpegFailsCleanlyWhenBufferTooSmall) {
+    Nv21Frame frame(64, 48, 64);
+    std::vector<uint8_t> jpeg(64);
+    size_t encodedSize = 0;
+    EXPECT_EQ(NO_MEMORY, Camera3InjectionFormat::encodeJpeg(frame.source(), 90, jpeg.data(),
+            jpeg.size(), &encodedSize));
+}
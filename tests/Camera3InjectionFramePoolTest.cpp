@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "Camera3InjectionFramePoolTest"
+
+#include <gtest/gtest.h>
+
+#include "../device3/Camera3InjectionFramePool.h"
+
+using namespace android;
+using namespace android::camera3;
+
+TEST(Camera3InjectionFramePoolTest, ReusedSlotDropsPreviousFrame) {
+    Camera3InjectionFramePool pool(/*slotCount*/ 1);
+    uint8_t shm[64] = {};
+    std::weak_ptr<const void> pinned;
+    const uint8_t* storage;
+    {
+        std::shared_ptr<DecodedFrame> frame = pool.acquire(4, 4);
+        storage = frame->data.data();
+        // Last use of the slot: a shared-memory frame with a padded NV12 layout.
+        auto holder = std::make_shared<int>(0);
+        pinned = holder;
+        frame->holder = holder;
+        frame->external = shm;
+        frame->externalSize = sizeof(shm);
+        frame->sequence = 7;
+        frame->stride = 8;
+        frame->chromaUV = true;
+        frame->acquireFence = 3;
+        frame->cropLeft = 1;
+        frame->cropTop = 2;
+        frame->timestamp = 100;
+    }
+
+    std::shared_ptr<DecodedFrame> frame = pool.acquire(4, 4);
+    EXPECT_TRUE(pinned.expired());
+    EXPECT_EQ(nullptr, frame->external);
+    EXPECT_EQ(0u, frame->externalSize);
+    EXPECT_EQ(nullptr, frame->hardwareBuffer);
+    EXPECT_EQ(-1, frame->acquireFence);
+    EXPECT_EQ(0u, frame->sequence);
+    EXPECT_EQ(0u, frame->stride);
+    EXPECT_EQ(0u, frame->cropLeft);
+    EXPECT_EQ(0u, frame->cropTop);
+    EXPECT_FALSE(frame->chromaUV);
+    EXPECT_EQ(0, frame->timestamp);
+    EXPECT_EQ(4u, frame->width);
+    EXPECT_EQ(4u, frame->rowStride());
+    // The pixel storage is kept.
+    EXPECT_EQ(storage, frame->pixels());
+    EXPECT_EQ(24u, frame->size());
+}
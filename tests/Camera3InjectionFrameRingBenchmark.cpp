@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "../device3/Camera3InjectionFrameRing.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+using Policy = Camera3InjectionFrameRing::Policy;
+
+// One camera frame per ~16 ms, one source frame every other camera frame.
+constexpr nsecs_t kCameraPeriod = 16666667;
+constexpr int kSelectsPerPush = 2;
+constexpr size_t kFrameCount = 64;
+
+const std::vector<std::shared_ptr<DecodedFrame>>& testFrames() {
+    static const std::vector<std::shared_ptr<DecodedFrame>> frames = [] {
+        std::vector<std::shared_ptr<DecodedFrame>> v;
+        for (size_t i = 0; i < kFrameCount; i++) {
+            auto frame = std::make_shared<DecodedFrame>();
+            frame->timestamp = i * kSelectsPerPush * kCameraPeriod;
+            frame->sequence = i + 1;
+            v.push_back(frame);
+        }
+        return v;
+    }();
+    return frames;
+}
+
+// Models the result path: thread 0 is the decoder publishing frames and also composites
+// one stream, every other thread composites another stream of the same camera.
+template <typename Ring>
+void runContended(benchmark::State& state, Ring& ring) {
+    const auto& frames = testFrames();
+    size_t cameraFrame = 0;
+    for (auto _ : state) {
+        if (state.thread_index() == 0 && cameraFrame % kSelectsPerPush == 0) {
+            ring.push(frames[cameraFrame / kSelectsPerPush]);
+        }
+        benchmark::DoNotOptimize(ring.select(Policy::NEAREST, cameraFrame * kCameraPeriod));
+        cameraFrame = (cameraFrame + 1) % (kFrameCount * kSelectsPerPush);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// The previous design: the latest-frame slot behind the source's frame mutex.
+class LockedRing {
+  public:
+    void push(std::shared_ptr<DecodedFrame> frame) {
+        std::lock_guard<std::mutex> lock(mLock);
+        mRing.push(std::move(frame));
+    }
+    std::shared_ptr<DecodedFrame> select(Policy policy, nsecs_t targetTime) {
+        std::lock_guard<std::mutex> lock(mLock);
+        return mRing.select(policy, targetTime);
+    }
+
+  private:
+    std::mutex mLock;
+    Camera3InjectionFrameRing mRing;
+};
+
+void BM_FrameRingSelect(benchmark::State& state) {
+    static Camera3InjectionFrameRing ring;
+    runContended(state, ring);
+}
+BENCHMARK(BM_FrameRingSelect)->ThreadRange(1, 8)->UseRealTime();
+
+void BM_LockedFrameRingSelect(benchmark::State& state) {
+    static LockedRing ring;
+    runContended(state, ring);
+}
+BENCHMARK(BM_LockedFrameRingSelect)->ThreadRange(1, 8)->UseRealTime();
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "Camera3InjectionFrameRingTest"
+
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../device3/Camera3InjectionFrameRing.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+using Ring = Camera3InjectionFrameRing;
+using Policy = Camera3InjectionFrameRing::Policy;
+
+std::shared_ptr<DecodedFrame> frameAt(nsecs_t timestamp, uint64_t sequence) {
+    auto frame = std::make_shared<DecodedFrame>();
+    frame->timestamp = timestamp;
+    frame->sequence = sequence;
+    return frame;
+}
+
+} // namespace
+
+TEST(Camera3InjectionFrameRingTest, EmptyRing) {
+    Ring ring;
+    EXPECT_EQ(nullptr, ring.latest());
+    EXPECT_EQ(nullptr, ring.select(Policy::NEAREST, 0));
+    EXPECT_EQ(0u, ring.getSelections());
+}
+
+TEST(Camera3InjectionFrameRingTest, PushEvictsOldest) {
+    Ring ring(2);
+    auto oldest = frameAt(10, 1);
+    ring.push(oldest);
+    ring.push(frameAt(20, 2));
+    ring.push(frameAt(30, 3));
+    EXPECT_EQ(2u, ring.size());
+    EXPECT_EQ(3u, ring.latest()->sequence);
+    // The oldest remaining frame is the fallback for targets before every frame.
+    EXPECT_EQ(2u, ring.select(Policy::HOLD, 0)->sequence);
+    // The ring no longer references the evicted frame.
+    EXPECT_EQ(1, oldest.use_count());
+}
+
+TEST(Camera3InjectionFrameRingTest, ReaderSnapshotOutlivesPush) {
+    Ring ring(1);
+    ring.push(frameAt(10, 1));
+    auto held = ring.latest();
+    ring.push(frameAt(20, 2));
+    // A frame handed to a reader stays valid after the producer replaces it.
+    EXPECT_EQ(1u, held->sequence);
+    EXPECT_EQ(2u, ring.latest()->sequence);
+    EXPECT_EQ(1u, ring.capacity());
+    EXPECT_EQ(Ring::kMaxCapacity, Ring(1000).capacity());
+}
+
+TEST(Camera3InjectionFrameRingTest, Policies) {
+    Ring ring(4);
+    ring.push(frameAt(100, 1));
+    ring.push(frameAt(200, 2));
+    ring.push(frameAt(300, 3));
+
+    EXPECT_EQ(3u, ring.select(Policy::LATEST, 110)->sequence);
+
+    EXPECT_EQ(1u, ring.select(Policy::NEAREST, 120)->sequence);
+    EXPECT_EQ(2u, ring.select(Policy::NEAREST, 180)->sequence);
+    // Ties go to the newer frame.
+    EXPECT_EQ(3u, ring.select(Policy::NEAREST, 250)->sequence);
+    EXPECT_EQ(3u, ring.select(Policy::NEAREST, 1000)->sequence);
+
+    EXPECT_EQ(1u, ring.select(Policy::HOLD, 199)->sequence);
+    EXPECT_EQ(2u, ring.select(Policy::HOLD, 200)->sequence);
+    EXPECT_EQ(3u, ring.select(Policy::HOLD, 1000)->sequence);
+    // Every frame is in the future: fall back to the oldest one.
+    EXPECT_EQ(1u, ring.select(Policy::HOLD, 50)->sequence);
+}
+
+TEST(Camera3InjectionFrameRingTest, ParsePolicy) {
+    EXPECT_EQ(Policy::LATEST, Ring::parsePolicy("latest", Policy::NEAREST));
+    EXPECT_EQ(Policy::NEAREST, Ring::parsePolicy("nearest", Policy::LATEST));
+    EXPECT_EQ(Policy::HOLD, Ring::parsePolicy("hold", Policy::LATEST));
+    EXPECT_EQ(Policy::LATEST, Ring::parsePolicy("bogus", Policy::LATEST));
+    EXPECT_EQ(Policy::HOLD, Ring::parsePolicy(nullptr, Policy::HOLD));
+    EXPECT_STREQ("nearest", Ring::policyName(Policy::NEAREST));
+}
+
+TEST(Camera3InjectionFrameRingTest, HalfRateSourceRepeatsEvenly) {
+    // 30 fps source shown on a 60 fps stream: every source frame is shown exactly twice.
+    const nsecs_t cameraPeriod = 16666667;
+    const nsecs_t sourcePeriod = 2 * cameraPeriod;
+    Ring ring(4);
+    uint64_t sequence = 0;
+    nsecs_t nextSource = 0;
+    std::vector<uint64_t> shown;
+    for (int i = 0; i < 20; i++) {
+        nsecs_t cameraTime = i * cameraPeriod;
+        while (nextSource <= cameraTime) {
+            ring.push(frameAt(nextSource, ++sequence));
+            nextSource += sourcePeriod;
+        }
+        shown.push_back(ring.select(Policy::HOLD, cameraTime)->sequence);
+    }
+    for (size_t i = 0; i < shown.size(); i++) {
+        EXPECT_EQ(i / 2 + 1, shown[i]) << "camera frame " << i;
+    }
+    EXPECT_EQ(20u, ring.getSelections());
+    EXPECT_EQ(10u, ring.getRepeated());
+    EXPECT_EQ(0u, ring.getDropped());
+}
+
+TEST(Camera3InjectionFrameRingTest, CountsSkippedFrames) {
+    Ring ring(4);
+    ring.push(frameAt(100, 1));
+    ring.select(Policy::LATEST, 100);
+    ring.push(frameAt(200, 2));
+    ring.push(frameAt(300, 3));
+    ring.push(frameAt(400, 4));
+    ring.select(Policy::LATEST, 400);
+    EXPECT_EQ(2u, ring.getDropped());
+
+    // Several streams compositing the same camera frame count once.
+    ring.select(Policy::LATEST, 400);
+    ring.select(Policy::LATEST, 400);
+    EXPECT_EQ(2u, ring.getSelections());
+    EXPECT_EQ(0u, ring.getRepeated());
+
+    // Falling back to an older frame is neither a repeat nor a skip.
+    ring.select(Policy::NEAREST, 210);
+    EXPECT_EQ(3u, ring.getSelections());
+    EXPECT_EQ(2u, ring.getDropped());
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "Camera3InjectionIngestBufferTest"
+
+#include <string.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../device3/Camera3InjectionIngestBuffer.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+void write(Camera3InjectionIngestBuffer* buffer, const std::vector<uint8_t>& data) {
+    ASSERT_EQ(OK, buffer->reserve(data.size()));
+    memcpy(buffer->writeData(), data.data(), data.size());
+    buffer->commit(data.size());
+}
+
+} // namespace
+
+TEST(Camera3InjectionIngestBufferTest, FullyConsumedDataRewinds) {
+    Camera3InjectionIngestBuffer buffer(64, 16);
+    write(&buffer, {1, 2, 3, 4, 5, 6});
+    const uint8_t* start = buffer.readData();
+    buffer.consume(6);
+    EXPECT_EQ(0u, buffer.readable());
+    write(&buffer, {7, 8});
+    // Nothing was pending, so the next read lands at the start without moving anything.
+    EXPECT_EQ(start, buffer.readData());
+    EXPECT_EQ(0u, buffer.getCompactions());
+}
+
+TEST(Camera3InjectionIngestBufferTest, PartialUnitStaysContiguous) {
+    Camera3InjectionIngestBuffer buffer(64, 16);
+    write(&buffer, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12});
+    buffer.consume(10);
+    // 4 writable bytes left; asking for 8 moves the 2 pending bytes to the front.
+    write(&buffer, {13, 14, 15, 16, 17, 18, 19, 20});
+    EXPECT_EQ(16u, buffer.capacity());
+    EXPECT_EQ(1u, buffer.getCompactions());
+    EXPECT_EQ(2u, buffer.getBytesMoved());
+    ASSERT_EQ(10u, buffer.readable());
+    std::vector<uint8_t> expected = {11, 12, 13, 14, 15, 16, 17, 18, 19, 20};
+    EXPECT_EQ(expected, std::vector<uint8_t>(buffer.readData(),
+            buffer.readData() + buffer.readable()));
+}
+
+TEST(Camera3InjectionIngestBufferTest, GrowsForLargeUnitsUpToTheLimit) {
+    Camera3InjectionIngestBuffer buffer(64, 16);
+    write(&buffer, std::vector<uint8_t>(12, 0xAA));
+    write(&buffer, std::vector<uint8_t>(20, 0xBB));
+    EXPECT_EQ(32u, buffer.capacity());
+    EXPECT_EQ(32u, buffer.readable());
+    EXPECT_EQ(0xAA, buffer.readData()[0]);
+    EXPECT_EQ(0xBB, buffer.readData()[31]);
+
+    EXPECT_EQ(NO_MEMORY, buffer.reserve(33));
+    EXPECT_EQ(OK, buffer.reserve(32));
+    EXPECT_EQ(64u, buffer.capacity());
+
+    buffer.clear();
+    EXPECT_EQ(0u, buffer.readable());
+    EXPECT_EQ(64u, buffer.writable());
+}
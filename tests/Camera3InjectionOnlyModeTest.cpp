@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "Camera3InjectionOnlyModeTest"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "../device3/Camera3InjectionOnlyMode.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+using Transition = Camera3InjectionOnlyMode::Transition;
+
+// Stands in for Camera3Device's in-flight map: captures submitted to the HAL that complete
+// on another thread, and a drain wait woken by the last completion.
+class FakeHal {
+  public:
+    explicit FakeHal(size_t inFlight) : mInFlight(inFlight) {}
+
+    void completeCapture() {
+        std::lock_guard<std::mutex> l(mLock);
+        if (--mInFlight == 0) {
+            mDrained.notify_all();
+        }
+    }
+
+    bool waitForDrained(std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> l(mLock);
+        mWaits++;
+        return mDrained.wait_for(l, timeout, [this]() { return mInFlight == 0; });
+    }
+
+    size_t waits() {
+        std::lock_guard<std::mutex> l(mLock);
+        return mWaits;
+    }
+
+  private:
+    std::mutex mLock;
+    std::condition_variable mDrained;
+    size_t mInFlight;
+    size_t mWaits = 0;
+};
+
+uint8_t getU8(CameraMetadata& metadata, uint32_t tag) {
+    camera_metadata_entry_t e = metadata.find(tag);
+    EXPECT_EQ(1u, e.count) << "tag " << tag;
+    return e.count > 0 ? e.data.u8[0] : 0xff;
+}
+
+CameraMetadata makeSettings(uint8_t afMode, uint8_t afTrigger = ANDROID_CONTROL_AF_TRIGGER_IDLE) {
+    CameraMetadata settings;
+    uint8_t controlMode = ANDROID_CONTROL_MODE_AUTO;
+    settings.update(ANDROID_CONTROL_MODE, &controlMode, 1);
+    uint8_t aeMode = ANDROID_CONTROL_AE_MODE_ON;
+    settings.update(ANDROID_CONTROL_AE_MODE, &aeMode, 1);
+    uint8_t awbMode = ANDROID_CONTROL_AWB_MODE_AUTO;
+    settings.update(ANDROID_CONTROL_AWB_MODE, &awbMode, 1);
+    settings.update(ANDROID_CONTROL_AF_MODE, &afMode, 1);
+    settings.update(ANDROID_CONTROL_AF_TRIGGER, &afTrigger, 1);
+    return settings;
+}
+
+uint8_t fillAfState(Camera3InjectedResultBuilder& builder, uint8_t afMode, uint8_t afTrigger) {
+    CameraMetadata result = makeSettings(afMode, afTrigger);
+    builder.fill(&result, 0);
+    return getU8(result, ANDROID_CONTROL_AF_STATE);
+}
+
+} // namespace
+
+TEST(Camera3InjectionOnlyModeTest, SwitchWaitsForHalCapturesInFlight) {
+    Camera3InjectionOnlyMode mode;
+    FakeHal hal(/*inFlight*/ 2);
+    auto drain = [&]() { return hal.waitForDrained(std::chrono::milliseconds(10)); };
+
+    // The HAL still owes two results: the batch goes to the HAL and the switch is retried.
+    EXPECT_EQ(Transition::DEFERRED, mode.update(true, drain));
+    EXPECT_FALSE(mode.isActive());
+    EXPECT_EQ(0, mode.getSwitchCount());
+    EXPECT_EQ(1, mode.getDeferredCount());
+
+    // The captures complete while the next batch waits; the wait ends on the last completion.
+    std::thread completer([&]() {
+        while (hal.waits() < 2) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        hal.completeCapture();
+        hal.completeCapture();
+    });
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(Transition::ENTERED,
+            mode.update(true, [&]() { return hal.waitForDrained(std::chrono::seconds(5)); }));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+    completer.join();
+    EXPECT_TRUE(mode.isActive());
+    EXPECT_EQ(1, mode.getSwitchCount());
+    EXPECT_EQ(1, mode.getDeferredCount());
+}
+
+TEST(Camera3InjectionOnlyModeTest, DrainWaitOnlyOnEntry) {
+    Camera3InjectionOnlyMode mode;
+    size_t waits = 0;
+    auto drain = [&]() { waits++; return true; };
+
+    EXPECT_EQ(Transition::NONE, mode.update(false, drain));
+    EXPECT_EQ(0u, waits);
+    EXPECT_EQ(Transition::ENTERED, mode.update(true, drain));
+    EXPECT_EQ(1u, waits);
+
+    // Injected requests complete at submission, so staying in or leaving never waits.
+    EXPECT_EQ(Transition::NONE, mode.update(true, drain));
+    EXPECT_EQ(Transition::LEFT, mode.update(false, drain));
+    EXPECT_EQ(1u, waits);
+    EXPECT_FALSE(mode.isActive());
+
+    EXPECT_EQ(Transition::ENTERED, mode.update(true, drain));
+    EXPECT_EQ(2u, waits);
+    EXPECT_EQ(3, mode.getSwitchCount());
+    EXPECT_EQ(0, mode.getDeferredCount());
+}
+
+TEST(Camera3InjectionOnlyModeTest, ResultCarriesTimestampAndPipelineDepth) {
+    Camera3InjectedResultBuilder builder;
+    CameraMetadata result = makeSettings(ANDROID_CONTROL_AF_MODE_OFF);
+    builder.fill(&result, 123456789);
+
+    camera_metadata_entry_t e = result.find(ANDROID_SENSOR_TIMESTAMP);
+    ASSERT_EQ(1u, e.count);
+    EXPECT_EQ(123456789, e.data.i64[0]);
+    EXPECT_EQ(1, getU8(result, ANDROID_REQUEST_PIPELINE_DEPTH));
+    EXPECT_EQ(ANDROID_CONTROL_AE_STATE_CONVERGED, getU8(result, ANDROID_CONTROL_AE_STATE));
+    EXPECT_EQ(ANDROID_CONTROL_AWB_STATE_CONVERGED, getU8(result, ANDROID_CONTROL_AWB_STATE));
+    EXPECT_EQ(ANDROID_CONTROL_AF_STATE_INACTIVE, getU8(result, ANDROID_CONTROL_AF_STATE));
+}
+
+TEST(Camera3InjectionOnlyModeTest, AeAndAwbStatesFollowModeAndLock) {
+    Camera3InjectedResultBuilder builder;
+
+    CameraMetadata locked = makeSettings(ANDROID_CONTROL_AF_MODE_OFF);
+    uint8_t on = ANDROID_CONTROL_AE_LOCK_ON;
+    locked.update(ANDROID_CONTROL_AE_LOCK, &on, 1);
+    uint8_t awbOn = ANDROID_CONTROL_AWB_LOCK_ON;
+    locked.update(ANDROID_CONTROL_AWB_LOCK, &awbOn, 1);
+    builder.fill(&locked, 0);
+    EXPECT_EQ(ANDROID_CONTROL_AE_STATE_LOCKED, getU8(locked, ANDROID_CONTROL_AE_STATE));
+    EXPECT_EQ(ANDROID_CONTROL_AWB_STATE_LOCKED, getU8(locked, ANDROID_CONTROL_AWB_STATE));
+
+    CameraMetadata aeOff = makeSettings(ANDROID_CONTROL_AF_MODE_OFF);
+    uint8_t off = ANDROID_CONTROL_AE_MODE_OFF;
+    aeOff.update(ANDROID_CONTROL_AE_MODE, &off, 1);
+    builder.fill(&aeOff, 0);
+    EXPECT_EQ(ANDROID_CONTROL_AE_STATE_INACTIVE, getU8(aeOff, ANDROID_CONTROL_AE_STATE));
+    EXPECT_EQ(ANDROID_CONTROL_AWB_STATE_CONVERGED, getU8(aeOff, ANDROID_CONTROL_AWB_STATE));
+
+    // android.control.mode OFF turns every routine off, whatever the per-routine modes say.
+    CameraMetadata controlOff = makeSettings(ANDROID_CONTROL_AF_MODE_CONTINUOUS_PICTURE);
+    uint8_t controlMode = ANDROID_CONTROL_MODE_OFF;
+    controlOff.update(ANDROID_CONTROL_MODE, &controlMode, 1);
+    builder.fill(&controlOff, 0);
+    EXPECT_EQ(ANDROID_CONTROL_AE_STATE_INACTIVE, getU8(controlOff, ANDROID_CONTROL_AE_STATE));
+    EXPECT_EQ(ANDROID_CONTROL_AWB_STATE_INACTIVE, getU8(controlOff, ANDROID_CONTROL_AWB_STATE));
+    EXPECT_EQ(ANDROID_CONTROL_AF_STATE_INACTIVE, getU8(controlOff, ANDROID_CONTROL_AF_STATE));
+}
+
+TEST(Camera3InjectionOnlyModeTest, AfTriggerLocksAcrossFramesUntilCancel) {
+    Camera3InjectedResultBuilder builder;
+    const uint8_t kAuto = ANDROID_CONTROL_AF_MODE_AUTO;
+    const uint8_t kContinuous = ANDROID_CONTROL_AF_MODE_CONTINUOUS_PICTURE;
+
+    EXPECT_EQ(ANDROID_CONTROL_AF_STATE_INACTIVE,
+            fillAfState(builder, kAuto, ANDROID_CONTROL_AF_TRIGGER_IDLE));
+    EXPECT_EQ(ANDROID_CONTROL_AF_STATE_PASSIVE_FOCUSED,
+            fillAfState(builder, kContinuous, ANDROID_CONTROL_AF_TRIGGER_IDLE));
+
+    EXPECT_EQ(ANDROID_CONTROL_AF_STATE_FOCUSED_LOCKED,
+            fillAfState(builder, kContinuous, ANDROID_CONTROL_AF_TRIGGER_START));
+    // The trigger is only set on one request; the lock holds for the frames after it.
+    EXPECT_EQ(ANDROID_CONTROL_AF_STATE_FOCUSED_LOCKED,
+            fillAfState(builder, kContinuous, ANDROID_CONTROL_AF_TRIGGER_IDLE));
+    EXPECT_EQ(ANDROID_CONTROL_AF_STATE_FOCUSED_LOCKED,
+            fillAfState(builder, kAuto, ANDROID_CONTROL_AF_TRIGGER_IDLE));
+
+    EXPECT_EQ(ANDROID_CONTROL_AF_STATE_PASSIVE_FOCUSED,
+            fillAfState(builder, kContinuous, ANDROID_CONTROL_AF_TRIGGER_CANCEL));
+    EXPECT_FALSE(builder.isAfLocked());
+
+    // Switching AF off drops the lock as well.
+    fillAfState(builder, kAuto, ANDROID_CONTROL_AF_TRIGGER_START);
+    EXPECT_TRUE(builder.isAfLocked());
+    EXPECT_EQ(ANDROID_CONTROL_AF_STATE_INACTIVE,
+            fillAfState(builder, ANDROID_CONTROL_AF_MODE_OFF, ANDROID_CONTROL_AF_TRIGGER_IDLE));
+    EXPECT_EQ(ANDROID_CONTROL_AF_STATE_INACTIVE,
+            fillAfState(builder, kAuto, ANDROID_CONTROL_AF_TRIGGER_IDLE));
+}
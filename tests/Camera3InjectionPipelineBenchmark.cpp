@@ -0,0 +1,295 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <android-base/file.h>
+#include <benchmark/benchmark.h>
+
+#include "../device3/Camera3InjectionFrameRing.h"
+#include "../device3/Camera3InjectionIngestBuffer.h"
+#include "../device3/Camera3InjectionRecording.h"
+#include "../device3/Camera3InjectionStreamReader.h"
+#include "../device3/Camera3InjectionTransform.h"
+#include "../device3/Camera3NalSplitter.h"
+#include "../device3/Camera3SoftwareH264Codec.h"
+#include "H264PcmEncoder.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+// One second of a 30 fps source.
+constexpr size_t kFrames = 30;
+constexpr nsecs_t kFrameInterval = 33333333;
+constexpr uint32_t kDecoderThreads = 2;
+constexpr size_t kMinReadSize = 64 * 1024;
+constexpr size_t kFrameSlots = 6;
+// Output stream the decoded frames are composited into.
+constexpr int32_t kStreamWidth = 1280;
+constexpr int32_t kStreamHeight = 720;
+
+void writeLe(uint64_t value, size_t bytes, std::vector<uint8_t>* out) {
+    for (size_t i = 0; i < bytes; i++) {
+        out->push_back((value >> (8 * i)) & 0xFF);
+    }
+}
+
+// A framed-protocol recording of kFrames I_PCM frames, one chunk per frame as a
+// sender would write them, the first one preceded by the hello. I_PCM frames are
+// larger and cheaper to decode than camera-encoded ones, so the numbers weigh the
+// transport more heavily than a real stream would.
+struct Recording {
+    TemporaryFile file;
+    size_t bytes = 0;
+
+    Recording(uint32_t width, uint32_t height) {
+        H264PcmEncoder encoder(width, height);
+        std::vector<uint8_t> image(Camera3SoftwareH264Codec::frameSize(width, height));
+        Camera3InjectionRecording::Writer writer;
+        writer.open(file.path);
+        for (size_t i = 0; i < kFrames; i++) {
+            for (size_t j = 0; j < image.size(); j++) {
+                image[j] = static_cast<uint8_t>(j * 7 + i * 29);
+            }
+            std::vector<uint8_t> au = encoder.encode(image.data(), i == 0);
+
+            std::vector<uint8_t> chunk;
+            if (i == 0) {
+                chunk.insert(chunk.end(), Camera3InjectionStreamReader::kMagic,
+                        Camera3InjectionStreamReader::kMagic + 4);
+                writeLe(Camera3InjectionStreamReader::kVersion, 2, &chunk);
+                writeLe(Camera3InjectionStreamReader::kClockMonotonic, 2, &chunk);
+            }
+            uint32_t flags = Camera3InjectionStreamReader::kFlagKeyFrame;
+            if (i == 0) flags |= Camera3InjectionStreamReader::kFlagCodecConfig;
+            writeLe(au.size(), 4, &chunk);
+            writeLe(flags, 4, &chunk);
+            writeLe(i, 8, &chunk);
+            writeLe(ns2us(i * kFrameInterval), 8, &chunk);
+            chunk.insert(chunk.end(), au.begin(), au.end());
+            writer.append(chunk.data(), chunk.size(), i * kFrameInterval);
+        }
+        bytes = writer.getBytes();
+    }
+};
+
+struct StreamBuffer {
+    int32_t stride = (kStreamWidth + 63) & ~63;
+    std::vector<uint8_t> data = std::vector<uint8_t>(
+            static_cast<size_t>(stride) * kStreamHeight * 3 / 2);
+
+    uint8_t* y() { return data.data(); }
+    uint8_t* uv() { return data.data() + static_cast<size_t>(stride) * kStreamHeight; }
+};
+
+nsecs_t processCpuTime() {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return s2ns(ts.tv_sec) + ts.tv_nsec;
+}
+
+double percentileMs(std::vector<nsecs_t>* values, double percentile) {
+    if (values->empty()) return 0;
+    size_t index = std::min(values->size() - 1,
+            static_cast<size_t>(percentile * values->size()));
+    std::nth_element(values->begin(), values->begin() + index, values->end());
+    return (*values)[index] / 1e6;
+}
+
+// The socket server's receive path and the output stream's composite, run on one thread:
+// a sender thread replays the recording over a socketpair, each received frame is split,
+// decoded, published into the frame ring and composited into a stream buffer right away.
+// Latency runs from the end of the send to the end of the composite.
+void BM_InjectionPipeline(benchmark::State& state) {
+    uint32_t width = state.range(0);
+    uint32_t height = state.range(1);
+    double speed = state.range(2) == 0 ? Camera3InjectionRecording::Player::kMaxRate : 1;
+    Recording recording(width, height);
+
+    Camera3SoftwareH264Codec codec;
+    if (codec.initialize(width, height, kDecoderThreads) != OK) {
+        state.SkipWithError("software decoder unavailable");
+        return;
+    }
+    Camera3InjectionStreamReader streamReader;
+    Camera3InjectionIngestBuffer ingest(2 * streamReader.getMaxUnitSize());
+    Camera3NalSplitter splitter;
+    Camera3InjectionFrameRing ring;
+    std::vector<std::shared_ptr<DecodedFrame>> slots;
+    for (size_t i = 0; i < kFrameSlots; i++) {
+        auto frame = std::make_shared<DecodedFrame>();
+        frame->data.resize(Camera3SoftwareH264Codec::frameSize(width, height));
+        slots.push_back(frame);
+    }
+    StreamBuffer stream;
+    Camera3InjectionTransform::Plan plan;
+    plan.update({static_cast<int32_t>(width), static_cast<int32_t>(height),
+            static_cast<int32_t>(width), kStreamWidth, kStreamHeight, stream.stride, 0});
+
+    std::vector<nsecs_t> latencies;
+    uint64_t frames = 0;
+    nsecs_t wallTime = 0;
+    nsecs_t cpuTime = 0;
+    bool failed = false;
+    for (auto _ : state) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+            state.SkipWithError("socketpair failed");
+            return;
+        }
+        std::vector<std::atomic<nsecs_t>> sentTimes(kFrames);
+        std::vector<nsecs_t> compositeTimes(kFrames, 0);
+        nsecs_t wallStart = systemTime(SYSTEM_TIME_MONOTONIC);
+        nsecs_t cpuStart = processCpuTime();
+
+        std::thread sender([&]() {
+            Camera3InjectionRecording::Reader reader;
+            Camera3InjectionRecording::Player::Stats stats;
+            if (reader.open(recording.file.path) == OK) {
+                Camera3InjectionRecording::Player(speed).play(reader, fds[0],
+                        [&](size_t index, nsecs_t sentTime) {
+                            sentTimes[index].store(sentTime, std::memory_order_relaxed);
+                        }, &stats);
+            }
+            shutdown(fds[0], SHUT_WR);
+        });
+
+        streamReader.reset();
+        splitter.reset();
+        ingest.clear();
+        size_t slot = 0;
+        Camera3InjectionStreamReader::Callbacks callbacks;
+        callbacks.onHello = [&](const Camera3InjectionStreamReader::Hello&) {
+            uint8_t ack[Camera3InjectionStreamReader::kAckSize];
+            Camera3InjectionStreamReader::writeAck(Camera3InjectionStreamReader::kVersion, 0,
+                    ack);
+            return write(fds[1], ack, sizeof(ack)) == static_cast<ssize_t>(sizeof(ack)) ? OK
+                    : UNKNOWN_ERROR;
+        };
+        callbacks.onFrame = [&](const Camera3InjectionStreamReader::Frame& frame) {
+            const uint8_t* begin = nullptr;
+            const uint8_t* end = nullptr;
+            splitter.split(frame.data, frame.size, [&](const Camera3NalSplitter::NalUnit& nal) {
+                if (begin == nullptr) begin = nal.data;
+                end = nal.data + nal.size;
+            });
+            if (begin == nullptr) return;
+
+            // Skip slots the ring or the compositor still hold, as the frame pool does.
+            std::shared_ptr<DecodedFrame> decoded;
+            for (size_t i = 0; i < kFrameSlots && decoded == nullptr; i++) {
+                std::shared_ptr<DecodedFrame>& candidate = slots[(slot + i) % kFrameSlots];
+                if (candidate.use_count() == 1) decoded = candidate;
+            }
+            if (decoded == nullptr) return;
+            slot++;
+            Camera3SoftwareH264Codec::Picture picture;
+            codec.decode(begin, end - begin, frame.sequence, decoded->data.data(),
+                    decoded->data.size(), &picture);
+            if (!picture.present) return;
+            decoded->width = picture.width;
+            decoded->height = picture.height;
+            decoded->sequence = picture.timestampUs;
+            decoded->timestamp = systemTime(SYSTEM_TIME_MONOTONIC);
+            ring.push(decoded);
+
+            std::shared_ptr<DecodedFrame> selected = ring.select(
+                    Camera3InjectionFrameRing::Policy::LATEST, decoded->timestamp);
+            const uint8_t* y = selected->pixels();
+            plan.execute(y, y + static_cast<size_t>(width) * height, stream.y(), stream.uv());
+            if (selected->sequence < kFrames) {
+                compositeTimes[selected->sequence] = systemTime(SYSTEM_TIME_MONOTONIC);
+            }
+        };
+
+        size_t needed = 0;
+        while (true) {
+            size_t pending = ingest.readable();
+            if (ingest.reserve(std::max(kMinReadSize, needed > pending ? needed - pending : 0))
+                    != OK) {
+                failed = true;
+                break;
+            }
+            ssize_t n = read(fds[1], ingest.writeData(), ingest.writable());
+            if (n <= 0) break;
+            ingest.commit(n);
+            size_t consumed = 0;
+            status_t res = streamReader.parse(ingest.readData(), ingest.readable(), callbacks,
+                    &consumed, &needed);
+            ingest.consume(consumed);
+            if (res != OK) {
+                failed = true;
+                break;
+            }
+        }
+        // Unblock the sender if the receive side gave up early.
+        shutdown(fds[1], SHUT_RDWR);
+        sender.join();
+        close(fds[0]);
+        close(fds[1]);
+
+        wallTime += systemTime(SYSTEM_TIME_MONOTONIC) - wallStart;
+        cpuTime += processCpuTime() - cpuStart;
+        for (size_t i = 0; i < kFrames; i++) {
+            if (compositeTimes[i] == 0) continue;
+            frames++;
+            latencies.push_back(std::max<nsecs_t>(0,
+                    compositeTimes[i] - sentTimes[i].load(std::memory_order_relaxed)));
+        }
+        if (failed) break;
+    }
+
+    if (failed) {
+        state.SkipWithError("injection protocol error");
+        return;
+    }
+    if (frames == 0) {
+        state.SkipWithError("decoder produced no frames");
+        return;
+    }
+    state.counters["fps"] = frames / (wallTime / 1e9);
+    state.counters["p50_latency_ms"] = percentileMs(&latencies, 0.5);
+    state.counters["p99_latency_ms"] = percentileMs(&latencies, 0.99);
+    state.counters["cpu_us_per_frame"] = cpuTime / 1e3 / frames;
+    state.SetBytesProcessed(state.iterations() * recording.bytes);
+    state.SetItemsProcessed(frames);
+}
+
+void PipelineArgs(benchmark::internal::Benchmark* b) {
+    // speed 0 replays as fast as possible, 1 at the recorded 30 fps.
+    b->ArgNames({"width", "height", "speed"});
+    b->Args({640, 480, 0});
+    b->Args({1280, 720, 0});
+    b->Args({1920, 1080, 0});
+    b->Args({1280, 720, 1});
+}
+
+BENCHMARK(BM_InjectionPipeline)->Apply(PipelineArgs)->UseRealTime()
+        ->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "Camera3InjectionPlaceholderTest"
+
+#include <memory>
+#include <set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../device3/Camera3InjectionPlaceholder.h"
+
+using namespace android;
+using namespace android::camera3;
+
+using Policy = Camera3InjectionPlaceholder::Policy;
+
+TEST(Camera3InjectionPlaceholderTest, ParsesPolicyNames) {
+    for (Policy policy : {Policy::HOLD, Policy::BLACK, Policy::PLACEHOLDER}) {
+        EXPECT_EQ(policy, Camera3InjectionPlaceholder::parsePolicy(
+                Camera3InjectionPlaceholder::policyName(policy), Policy::HOLD));
+    }
+    EXPECT_EQ(Policy::BLACK, Camera3InjectionPlaceholder::parsePolicy("freeze", Policy::BLACK));
+    EXPECT_EQ(Policy::BLACK, Camera3InjectionPlaceholder::parsePolicy(nullptr, Policy::BLACK));
+}
+
+TEST(Camera3InjectionPlaceholderTest, RejectsInvalidGeometry) {
+    Camera3InjectionPlaceholder placeholder;
+    EXPECT_EQ(nullptr, placeholder.getTemplate(0, 48, 64));
+    EXPECT_EQ(nullptr, placeholder.getTemplate(64, 0, 64));
+    EXPECT_EQ(nullptr, placeholder.getTemplate(64, 48, 32));
+}
+
+TEST(Camera3InjectionPlaceholderTest, TemplateMatchesBufferLayout) {
+    Camera3InjectionPlaceholder placeholder;
+    auto tmpl = placeholder.getTemplate(64, 48, 80);
+    ASSERT_NE(nullptr, tmpl);
+    EXPECT_TRUE(tmpl->matches(64, 48, 80));
+    EXPECT_FALSE(tmpl->matches(64, 48, 64));
+    // Y plane of stride * height followed by the interleaved chroma plane.
+    ASSERT_EQ(80u * 48 * 3 / 2, tmpl->data.size());
+
+    // Rendering is deterministic, so every stream of this geometry writes the same bytes.
+    Camera3InjectionPlaceholder other;
+    auto same = other.getTemplate(64, 48, 80);
+    ASSERT_NE(nullptr, same);
+    EXPECT_EQ(tmpl->data, same->data);
+
+    if (placeholder.getPolicy() == Policy::BLACK) {
+        const uint8_t* uv = tmpl->data.data() + 80 * 48;
+        for (size_t i = 0; i < 80 * 48; i++) {
+            ASSERT_EQ(16, tmpl->data[i]) << "luma " << i;
+        }
+        for (size_t i = 0; i < 80 * 24; i++) {
+            ASSERT_EQ(128, uv[i]) << "chroma " << i;
+        }
+    }
+}
+
+TEST(Camera3InjectionPlaceholderTest, ReusesTemplatePerGeometry) {
+    Camera3InjectionPlaceholder placeholder;
+    auto first = placeholder.getTemplate(64, 48, 64);
+    auto again = placeholder.getTemplate(64, 48, 64);
+    ASSERT_NE(nullptr, first);
+    EXPECT_EQ(first.get(), again.get());
+
+    // A different stride is a different buffer layout and gets its own ID.
+    auto padded = placeholder.getTemplate(64, 48, 128);
+    ASSERT_NE(nullptr, padded);
+    EXPECT_NE(first->id, padded->id);
+}
+
+TEST(Camera3InjectionPlaceholderTest, EvictsLeastRecentlyUsed) {
+    Camera3InjectionPlaceholder placeholder;
+    auto oldest = placeholder.getTemplate(16, 16, 16);
+    ASSERT_NE(nullptr, oldest);
+    uint64_t oldestId = oldest->id;
+    std::set<uint64_t> ids = {oldestId};
+    for (uint32_t i = 1; i <= Camera3InjectionPlaceholder::kMaxTemplates; i++) {
+        auto tmpl = placeholder.getTemplate(16 * (i + 1), 16, 16 * (i + 1));
+        ASSERT_NE(nullptr, tmpl);
+        EXPECT_TRUE(ids.insert(tmpl->id).second);
+    }
+    // The evicted template stays valid for holders, but asking again renders a new
+    // one with a fresh ID so buffers filled from the old one are rewritten.
+    EXPECT_EQ(16u * 16 * 3 / 2, oldest->data.size());
+    auto rendered = placeholder.getTemplate(16, 16, 16);
+    ASSERT_NE(nullptr, rendered);
+    EXPECT_NE(oldestId, rendered->id);
+    EXPECT_TRUE(ids.insert(rendered->id).second);
+}
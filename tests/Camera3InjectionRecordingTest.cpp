@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "Camera3InjectionRecordingTest"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <thread>
+#include <vector>
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+
+#include "../device3/Camera3InjectionRecording.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+using Player = Camera3InjectionRecording::Player;
+
+std::vector<uint8_t> pattern(size_t size, uint8_t seed) {
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; i++) {
+        data[i] = static_cast<uint8_t>(seed + i * 13);
+    }
+    return data;
+}
+
+// Records chunks of the given sizes, one millisecond apart.
+void record(const char* path, const std::vector<size_t>& sizes) {
+    Camera3InjectionRecording::Writer writer;
+    ASSERT_EQ(OK, writer.open(path));
+    nsecs_t base = 5000000000;
+    for (size_t i = 0; i < sizes.size(); i++) {
+        std::vector<uint8_t> data = pattern(sizes[i], i);
+        ASSERT_EQ(OK, writer.append(data.data(), data.size(), base + i * 1000000));
+    }
+}
+
+} // namespace
+
+TEST(Camera3InjectionRecordingTest, RoundTripKeepsDataAndOffsets) {
+    TemporaryFile file;
+    Camera3InjectionRecording::Writer writer;
+    ASSERT_EQ(OK, writer.open(file.path));
+    std::vector<uint8_t> first = pattern(100, 1);
+    std::vector<uint8_t> second = pattern(4096, 2);
+    std::vector<uint8_t> third = pattern(1, 3);
+    ASSERT_EQ(OK, writer.append(first.data(), first.size(), 1000000));
+    // Empty reads are not recorded.
+    ASSERT_EQ(OK, writer.append(second.data(), 0, 2000000));
+    ASSERT_EQ(OK, writer.append(second.data(), second.size(), 34000000));
+    // A receive time earlier than the previous chunk keeps the previous offset.
+    ASSERT_EQ(OK, writer.append(third.data(), third.size(), 30000000));
+    EXPECT_EQ(3u, writer.getChunks());
+    EXPECT_EQ(4197u, writer.getBytes());
+    writer.close();
+    EXPECT_EQ(NO_INIT, writer.append(first.data(), first.size(), 40000000));
+
+    Camera3InjectionRecording::Reader reader;
+    ASSERT_EQ(OK, reader.open(file.path));
+    EXPECT_GT(reader.getCreatedRealtimeUs(), 0);
+    Camera3InjectionRecording::Chunk chunk;
+    ASSERT_EQ(OK, reader.next(&chunk));
+    EXPECT_EQ(0, chunk.offset);
+    EXPECT_EQ(first, chunk.data);
+    ASSERT_EQ(OK, reader.next(&chunk));
+    EXPECT_EQ(33000000, chunk.offset);
+    EXPECT_EQ(second, chunk.data);
+    ASSERT_EQ(OK, reader.next(&chunk));
+    EXPECT_EQ(33000000, chunk.offset);
+    EXPECT_EQ(third, chunk.data);
+    EXPECT_EQ(NOT_ENOUGH_DATA, reader.next(&chunk));
+
+    ASSERT_EQ(OK, reader.rewind());
+    ASSERT_EQ(OK, reader.next(&chunk));
+    EXPECT_EQ(first, chunk.data);
+}
+
+TEST(Camera3InjectionRecordingTest, RejectsOtherFiles) {
+    TemporaryFile file;
+    const char text[] = "not a recording file";
+    ASSERT_EQ(static_cast<ssize_t>(sizeof(text)), write(file.fd, text, sizeof(text)));
+
+    Camera3InjectionRecording::Reader reader;
+    EXPECT_EQ(BAD_VALUE, reader.open(file.path));
+    Camera3InjectionRecording::Chunk chunk;
+    EXPECT_EQ(NO_INIT, reader.next(&chunk));
+    EXPECT_NE(OK, reader.open("/nonexistent/recording.aidrec"));
+}
+
+TEST(Camera3InjectionRecordingTest, TruncatedChunkIsCorrupt) {
+    TemporaryFile file;
+    record(file.path, {64, 64});
+    // Cut the second chunk's payload short, as a full disk would.
+    off_t size = lseek(file.fd, 0, SEEK_END);
+    ASSERT_EQ(0, ftruncate(file.fd, size - 10));
+
+    Camera3InjectionRecording::Reader reader;
+    ASSERT_EQ(OK, reader.open(file.path));
+    Camera3InjectionRecording::Chunk chunk;
+    EXPECT_EQ(OK, reader.next(&chunk));
+    EXPECT_EQ(BAD_VALUE, reader.next(&chunk));
+}
+
+TEST(Camera3InjectionRecordingTest, ParseSpeed) {
+    double speed = -1;
+    EXPECT_TRUE(Player::parseSpeed("original", &speed));
+    EXPECT_EQ(1, speed);
+    EXPECT_TRUE(Player::parseSpeed("max", &speed));
+    EXPECT_EQ(Player::kMaxRate, speed);
+    EXPECT_TRUE(Player::parseSpeed("2x", &speed));
+    EXPECT_EQ(2, speed);
+    EXPECT_TRUE(Player::parseSpeed("0.5", &speed));
+    EXPECT_EQ(0.5, speed);
+
+    EXPECT_FALSE(Player::parseSpeed(nullptr, &speed));
+    EXPECT_FALSE(Player::parseSpeed("", &speed));
+    EXPECT_FALSE(Player::parseSpeed("fast", &speed));
+    EXPECT_FALSE(Player::parseSpeed("0", &speed));
+    EXPECT_FALSE(Player::parseSpeed("-2x", &speed));
+    EXPECT_FALSE(Player::parseSpeed("2xx", &speed));
+}
+
+TEST(Camera3InjectionRecordingTest, ScheduleTime) {
+    EXPECT_EQ(1000 + 33000000, Player::scheduleTime(1000, 33000000, 1));
+    EXPECT_EQ(1000 + 16500000, Player::scheduleTime(1000, 33000000, 2));
+    EXPECT_EQ(1000 + 66000000, Player::scheduleTime(1000, 33000000, 0.5));
+    EXPECT_EQ(1000, Player::scheduleTime(1000, 33000000, Player::kMaxRate));
+}
+
+TEST(Camera3InjectionRecordingTest, PlayerReproducesBytes) {
+    TemporaryFile file;
+    std::vector<size_t> sizes = {10, 300000, 7, 65536};
+    record(file.path, sizes);
+    std::vector<uint8_t> expected;
+    for (size_t i = 0; i < sizes.size(); i++) {
+        std::vector<uint8_t> data = pattern(sizes[i], i);
+        expected.insert(expected.end(), data.begin(), data.end());
+    }
+
+    int fds[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    std::vector<uint8_t> received;
+    std::thread server([&]() {
+        // Reply like the framed protocol's ack so the player has something to drain.
+        uint8_t ack[8] = {};
+        EXPECT_EQ(static_cast<ssize_t>(sizeof(ack)), write(fds[1], ack, sizeof(ack)));
+        uint8_t buffer[4096];
+        ssize_t n;
+        while ((n = read(fds[1], buffer, sizeof(buffer))) > 0) {
+            received.insert(received.end(), buffer, buffer + n);
+        }
+    });
+
+    Camera3InjectionRecording::Reader reader;
+    ASSERT_EQ(OK, reader.open(file.path));
+    Player player(Player::kMaxRate);
+    Player::Stats stats;
+    std::vector<size_t> sent;
+    EXPECT_EQ(OK, player.play(reader, fds[0],
+            [&](size_t index, nsecs_t) { sent.push_back(index); }, &stats));
+    shutdown(fds[0], SHUT_WR);
+    server.join();
+    close(fds[0]);
+    close(fds[1]);
+
+    EXPECT_EQ(expected, received);
+    EXPECT_EQ(sizes.size(), stats.chunks);
+    EXPECT_EQ(expected.size(), stats.bytes);
+    EXPECT_EQ((std::vector<size_t>{0, 1, 2, 3}), sent);
+}
+
+TEST(Camera3InjectionRecordingTest, PlayerKeepsRecordedPace) {
+    TemporaryFile file;
+    record(file.path, {16, 16, 16});
+
+    int fds[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    Camera3InjectionRecording::Reader reader;
+    ASSERT_EQ(OK, reader.open(file.path));
+    Player player(1);
+    Player::Stats stats;
+    std::vector<nsecs_t> sentTimes;
+    EXPECT_EQ(OK, player.play(reader, fds[0],
+            [&](size_t, nsecs_t sentTime) { sentTimes.push_back(sentTime); }, &stats));
+    close(fds[0]);
+    close(fds[1]);
+
+    // Chunks were recorded 1 ms apart.
+    ASSERT_EQ(3u, sentTimes.size());
+    EXPECT_GE(sentTimes[2] - sentTimes[0], 1500000);
+    EXPECT_GE(stats.duration, 2000000);
+}
@@ -0,0 +1,237 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "Camera3InjectionRenderCacheTest"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../device3/Camera3InjectionRenderCache.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+constexpr int32_t kWidth = 64;
+constexpr int32_t kHeight = 48;
+constexpr int32_t kStride = 80;
+
+Camera3InjectionTransform::Key makeKey(int32_t transform) {
+    return {kWidth * 2, kHeight * 2, kWidth * 2, kWidth, kHeight, kStride, transform};
+}
+
+struct TestBuffer {
+    std::vector<uint8_t> data = std::vector<uint8_t>(kStride * kHeight * 3 / 2, 0);
+    uint8_t* y() { return data.data(); }
+    uint8_t* uv() { return data.data() + kStride * kHeight; }
+};
+
+// Fills both planes with a fixed value and counts invocations.
+Camera3InjectionRenderCache::RenderFunc makeRender(uint8_t value, std::atomic<int>* calls) {
+    return [value, calls](uint8_t* y, uint8_t* uv) {
+        (*calls)++;
+        memset(y, value, kStride * kHeight);
+        memset(uv, value + 1, kStride * kHeight / 2);
+        return OK;
+    };
+}
+
+using Outcome = Camera3InjectionRenderCache::Outcome;
+
+// Stand-ins for two output streams sharing a geometry.
+char gPreviewStream;
+char gReaderStream;
+const void* const kPreview = &gPreviewStream;
+const void* const kReader = &gReaderStream;
+
+} // namespace
+
+TEST(Camera3InjectionRenderCacheTest, SingleStreamRendersIntoDestination) {
+    Camera3InjectionRenderCache cache;
+    std::atomic<int> calls = 0;
+    TestBuffer buffer;
+    uint8_t* renderedY = nullptr;
+    auto render = [&](uint8_t* y, uint8_t* uv) {
+        renderedY = y;
+        return makeRender(10, &calls)(y, uv);
+    };
+
+    Outcome outcome = Outcome::HIT;
+    for (uint64_t sequence : {1, 2, 2}) {
+        ASSERT_EQ(OK, cache.render(sequence, makeKey(0), kPreview, buffer.y(), buffer.uv(),
+                render, &outcome));
+        EXPECT_EQ(Outcome::RENDERED, outcome);
+        EXPECT_EQ(buffer.y(), renderedY);
+    }
+    EXPECT_EQ(3, calls);
+    EXPECT_EQ(10, buffer.y()[0]);
+    EXPECT_EQ(11, buffer.uv()[0]);
+}
+
+TEST(Camera3InjectionRenderCacheTest, SharedGeometryRenderedOnce) {
+    Camera3InjectionRenderCache cache;
+    std::atomic<int> calls = 0;
+    TestBuffer first, second;
+    Outcome outcome = Outcome::HIT;
+
+    // The first frame finds out that the geometry is shared.
+    ASSERT_EQ(OK, cache.render(1, makeKey(0), kPreview, first.y(), first.uv(),
+            makeRender(10, &calls), &outcome));
+    EXPECT_EQ(Outcome::RENDERED, outcome);
+    ASSERT_EQ(OK, cache.render(1, makeKey(0), kReader, second.y(), second.uv(),
+            makeRender(10, &calls), &outcome));
+    EXPECT_EQ(Outcome::RENDERED_AND_CACHED, outcome);
+
+    ASSERT_EQ(OK, cache.render(2, makeKey(0), kPreview, first.y(), first.uv(),
+            makeRender(20, &calls), &outcome));
+    EXPECT_EQ(Outcome::RENDERED_AND_CACHED, outcome);
+    ASSERT_EQ(OK, cache.render(2, makeKey(0), kReader, second.y(), second.uv(),
+            makeRender(99, &calls), &outcome));
+    EXPECT_EQ(Outcome::HIT, outcome);
+    EXPECT_EQ(3, calls);
+    EXPECT_EQ(first.data, second.data);
+    EXPECT_EQ(20, second.y()[0]);
+    EXPECT_EQ(21, second.uv()[0]);
+}
+
+TEST(Camera3InjectionRenderCacheTest, StoppedStreamNoLongerShares) {
+    Camera3InjectionRenderCache cache;
+    std::atomic<int> calls = 0;
+    TestBuffer buffer;
+    Outcome outcome = Outcome::HIT;
+
+    for (uint64_t sequence : {1, 2}) {
+        cache.render(sequence, makeKey(0), kPreview, buffer.y(), buffer.uv(),
+                makeRender(10, &calls), nullptr);
+        cache.render(sequence, makeKey(0), kReader, buffer.y(), buffer.uv(),
+                makeRender(10, &calls), nullptr);
+    }
+    // The reader still counts while its last frame is one of the two most recent ones.
+    cache.render(3, makeKey(0), kPreview, buffer.y(), buffer.uv(), makeRender(10, &calls),
+            &outcome);
+    EXPECT_EQ(Outcome::RENDERED_AND_CACHED, outcome);
+    cache.render(4, makeKey(0), kPreview, buffer.y(), buffer.uv(), makeRender(10, &calls),
+            &outcome);
+    EXPECT_EQ(Outcome::RENDERED, outcome);
+}
+
+TEST(Camera3InjectionRenderCacheTest, NewFrameOrGeometryRendersAgain) {
+    Camera3InjectionRenderCache cache;
+    std::atomic<int> calls = 0;
+    TestBuffer buffer;
+
+    for (const void* user : {kPreview, kReader}) {
+        ASSERT_EQ(OK, cache.render(1, makeKey(0), user, buffer.y(), buffer.uv(),
+                makeRender(10, &calls), nullptr));
+    }
+    ASSERT_EQ(OK, cache.render(2, makeKey(0), kPreview, buffer.y(), buffer.uv(),
+            makeRender(20, &calls), nullptr));
+    EXPECT_EQ(20, buffer.y()[0]);
+    ASSERT_EQ(OK, cache.render(2, makeKey(4), kPreview, buffer.y(), buffer.uv(),
+            makeRender(30, &calls), nullptr));
+    EXPECT_EQ(30, buffer.y()[0]);
+    EXPECT_EQ(4, calls);
+}
+
+TEST(Camera3InjectionRenderCacheTest, FailedRenderIsNotCached) {
+    Camera3InjectionRenderCache cache;
+    std::atomic<int> calls = 0;
+    TestBuffer buffer;
+
+    auto failing = [&calls](uint8_t*, uint8_t*) {
+        calls++;
+        return UNKNOWN_ERROR;
+    };
+    ASSERT_EQ(OK, cache.render(1, makeKey(0), kPreview, buffer.y(), buffer.uv(),
+            makeRender(10, &calls), nullptr));
+    EXPECT_EQ(UNKNOWN_ERROR, cache.render(1, makeKey(0), kReader, buffer.y(), buffer.uv(),
+            failing, nullptr));
+    Outcome outcome = Outcome::HIT;
+    ASSERT_EQ(OK, cache.render(1, makeKey(0), kReader, buffer.y(), buffer.uv(),
+            makeRender(10, &calls), &outcome));
+    EXPECT_EQ(Outcome::RENDERED_AND_CACHED, outcome);
+    EXPECT_EQ(3, calls);
+}
+
+TEST(Camera3InjectionRenderCacheTest, LeastRecentlyUsedGeometryEvicted) {
+    Camera3InjectionRenderCache cache(/*maxEntries*/2);
+    std::atomic<int> calls = 0;
+    TestBuffer buffer;
+    // Each geometry is shared, so its first frame renders twice and is then cached.
+    auto renderShared = [&](int32_t transform) {
+        for (const void* user : {kPreview, kReader}) {
+            cache.render(1, makeKey(transform), user, buffer.y(), buffer.uv(),
+                    makeRender(10, &calls), nullptr);
+        }
+    };
+
+    renderShared(0);
+    renderShared(4);
+    renderShared(0);
+    renderShared(7);
+    EXPECT_EQ(6, calls);
+
+    Outcome outcome = Outcome::RENDERED;
+    cache.render(1, makeKey(0), kPreview, buffer.y(), buffer.uv(), makeRender(10, &calls),
+            &outcome);
+    EXPECT_EQ(Outcome::HIT, outcome);
+    cache.render(1, makeKey(4), kPreview, buffer.y(), buffer.uv(), makeRender(10, &calls),
+            &outcome);
+    EXPECT_NE(Outcome::HIT, outcome);
+}
+
+TEST(Camera3InjectionRenderCacheTest, ConcurrentStreamsShareInFlightRender) {
+    Camera3InjectionRenderCache cache;
+    std::atomic<int> calls = 0;
+    std::atomic<bool> started = false;
+    TestBuffer first, second;
+
+    for (const void* user : {kPreview, kReader}) {
+        cache.render(4, makeKey(0), user, first.y(), first.uv(), makeRender(1, &calls),
+                nullptr);
+    }
+    calls = 0;
+
+    auto slowRender = [&](uint8_t* y, uint8_t* uv) {
+        calls++;
+        started = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        memset(y, 42, kStride * kHeight);
+        memset(uv, 43, kStride * kHeight / 2);
+        return OK;
+    };
+    std::thread renderer([&]() {
+        cache.render(5, makeKey(0), kPreview, first.y(), first.uv(), slowRender, nullptr);
+    });
+    while (!started) {
+        std::this_thread::yield();
+    }
+    Outcome outcome = Outcome::RENDERED;
+    ASSERT_EQ(OK, cache.render(5, makeKey(0), kReader, second.y(), second.uv(), slowRender,
+            &outcome));
+    renderer.join();
+
+    EXPECT_EQ(Outcome::HIT, outcome);
+    EXPECT_EQ(1, calls);
+    EXPECT_EQ(first.data, second.data);
+}
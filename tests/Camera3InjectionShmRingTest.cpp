@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "Camera3InjectionShmRingTest"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include "../device3/Camera3InjectionShmRing.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+const Camera3InjectionShmRing::Layout kLayout = {
+        Camera3InjectionShmRing::kFormatNv21, 64, 48, 64, 3};
+
+// Stand-in for the out-of-process producer: creates the ring and hands the
+// server side its own mapping of the memfd, as the socket would.
+struct RingPair {
+    std::shared_ptr<Camera3InjectionShmRing> producer;
+    std::shared_ptr<Camera3InjectionShmRing> server;
+    int fd = -1;
+
+    explicit RingPair(const Camera3InjectionShmRing::Layout& layout) {
+        producer = Camera3InjectionShmRing::create(layout, &fd);
+        if (producer != nullptr) {
+            status_t res;
+            server = Camera3InjectionShmRing::attach(fd, &res);
+        }
+    }
+    ~RingPair() {
+        if (fd >= 0) close(fd);
+    }
+};
+
+uint64_t produce(Camera3InjectionShmRing* ring, uint8_t fill, int64_t timeUs) {
+    uint32_t slot;
+    uint8_t* data = ring->beginWrite(&slot);
+    if (data == nullptr) return 0;
+    memset(data, fill, Camera3InjectionShmRing::frameSize(ring->getLayout()));
+    return ring->publish(slot, timeUs);
+}
+
+} // namespace
+
+TEST(Camera3InjectionShmRingTest, ServerSeesLatestFrameWithoutCopy) {
+    RingPair rings(kLayout);
+    ASSERT_NE(nullptr, rings.producer);
+    ASSERT_NE(nullptr, rings.server);
+    EXPECT_EQ(64u, rings.server->getLayout().width);
+
+    Camera3InjectionShmRing::Frame frame;
+    EXPECT_EQ(NOT_ENOUGH_DATA, rings.server->acquireLatest(0, &frame));
+
+    produce(rings.producer.get(), 0x11, 1000);
+    uint64_t sequence = produce(rings.producer.get(), 0x22, 2000);
+    ASSERT_EQ(OK, rings.server->acquireLatest(0, &frame));
+    EXPECT_EQ(sequence, frame.sequence);
+    EXPECT_EQ(2000, frame.captureTimeUs);
+    EXPECT_EQ(64u * 48 * 3 / 2, frame.size);
+    EXPECT_EQ(0x22, frame.data[0]);
+    EXPECT_EQ(0x22, frame.data[frame.size - 1]);
+
+    // Nothing newer than what the server already consumed.
+    Camera3InjectionShmRing::Frame again;
+    EXPECT_EQ(NOT_ENOUGH_DATA, rings.server->acquireLatest(frame.sequence, &again));
+}
+
+TEST(Camera3InjectionShmRingTest, HeldSlotIsNeverOverwritten) {
+    RingPair rings(kLayout);
+    ASSERT_NE(nullptr, rings.server);
+
+    produce(rings.producer.get(), 0x33, 0);
+    Camera3InjectionShmRing::Frame held;
+    ASSERT_EQ(OK, rings.server->acquireLatest(0, &held));
+
+    // The producer keeps going; with one slot held and the latest one skipped
+    // it still finds a free slot every time and never touches the held one.
+    for (int i = 0; i < 10; i++) {
+        ASSERT_NE(0u, produce(rings.producer.get(), 0x44 + i, i));
+        EXPECT_EQ(0x33, held.data[0]);
+    }
+
+    // Hold the newest frame too and let the producer claim the last free slot:
+    // every slot is now either held by the server or being written.
+    Camera3InjectionShmRing::Frame latest;
+    ASSERT_EQ(OK, rings.server->acquireLatest(held.sequence, &latest));
+    uint32_t slot;
+    ASSERT_NE(nullptr, rings.producer->beginWrite(&slot));
+    uint32_t other;
+    EXPECT_EQ(nullptr, rings.producer->beginWrite(&other));
+
+    held.hold.reset();
+    EXPECT_NE(nullptr, rings.producer->beginWrite(&other));
+    EXPECT_NE(slot, other);
+}
+
+TEST(Camera3InjectionShmRingTest, HoldOutlivesTheRingHandle) {
+    RingPair rings(kLayout);
+    ASSERT_NE(nullptr, rings.server);
+    produce(rings.producer.get(), 0x55, 0);
+
+    Camera3InjectionShmRing::Frame frame;
+    ASSERT_EQ(OK, rings.server->acquireLatest(0, &frame));
+    rings.server.reset();
+    // The mapping stays alive until the frame is released.
+    EXPECT_EQ(0x55, frame.data[0]);
+    frame.hold.reset();
+}
+
+TEST(Camera3InjectionShmRingTest, RejectsUnsealedOrCorruptMemory) {
+    int fd = memfd_create("unsealed", MFD_CLOEXEC);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(0, ftruncate(fd, 1024 * 1024));
+    status_t res;
+    EXPECT_EQ(nullptr, Camera3InjectionShmRing::attach(fd, &res));
+    EXPECT_NE(OK, res);
+    close(fd);
+
+    RingPair rings(kLayout);
+    ASSERT_NE(nullptr, rings.producer);
+    void* base = mmap(nullptr, sizeof(Camera3InjectionShmRing::ShmHeader),
+            PROT_READ | PROT_WRITE, MAP_SHARED, rings.fd, 0);
+    ASSERT_NE(MAP_FAILED, base);
+    auto* header = static_cast<Camera3InjectionShmRing::ShmHeader*>(base);
+    // A height that would put the last slot past the end of the memfd.
+    header->height = 4096;
+    EXPECT_EQ(nullptr, Camera3InjectionShmRing::attach(rings.fd, &res));
+    EXPECT_NE(OK, res);
+    munmap(base, sizeof(Camera3InjectionShmRing::ShmHeader));
+
+    Camera3InjectionShmRing::Layout odd = kLayout;
+    odd.width = 63;
+    int oddFd;
+    EXPECT_EQ(nullptr, Camera3InjectionShmRing::create(odd, &oddFd));
+    EXPECT_EQ(-1, oddFd);
+}
+
+TEST(Camera3InjectionShmRingTest, ChromaPlanesComeFromHeader) {
+    // I420 with an odd luma stride and chroma planes padded and aligned on their own.
+    Camera3InjectionShmRing::Layout padded = {
+            Camera3InjectionShmRing::kFormatI420, 64, 48, 65, 3};
+    padded.chromaStride = 48;
+    padded.chromaOffset = 4096;
+    padded.chroma2Offset = 8192;
+    RingPair rings(padded);
+    ASSERT_NE(nullptr, rings.server);
+    const Camera3InjectionShmRing::Layout& layout = rings.server->getLayout();
+    EXPECT_EQ(48u, layout.chromaStride);
+    EXPECT_EQ(4096u, layout.chromaOffset);
+    EXPECT_EQ(8192u, layout.chroma2Offset);
+    EXPECT_EQ(8192u + 48 * 24, Camera3InjectionShmRing::frameSize(layout));
+
+    // Without explicit values the planes are packed behind the luma plane.
+    Camera3InjectionShmRing::Layout packed = {
+            Camera3InjectionShmRing::kFormatI420, 64, 48, 65, 3};
+    RingPair packedRings(packed);
+    ASSERT_NE(nullptr, packedRings.server);
+    const Camera3InjectionShmRing::Layout& resolved = packedRings.server->getLayout();
+    EXPECT_EQ(33u, resolved.chromaStride);
+    EXPECT_EQ(65u * 48, resolved.chromaOffset);
+    EXPECT_EQ(65u * 48 + 33 * 24, resolved.chroma2Offset);
+}
+
+TEST(Camera3InjectionShmRingTest, RejectsOverlappingChromaPlanes) {
+    int fd;
+    Camera3InjectionShmRing::Layout layout = {
+            Camera3InjectionShmRing::kFormatI420, 64, 48, 64, 3};
+    layout.chromaOffset = 64 * 48 - 1;
+    EXPECT_EQ(nullptr, Camera3InjectionShmRing::create(layout, &fd));
+
+    layout.chromaOffset = 64 * 48;
+    layout.chroma2Offset = 64 * 48 + 32 * 24 - 1;
+    EXPECT_EQ(nullptr, Camera3InjectionShmRing::create(layout, &fd));
+
+    Camera3InjectionShmRing::Layout nv12 = {
+            Camera3InjectionShmRing::kFormatNv12, 64, 48, 64, 3};
+    nv12.chromaStride = 32;
+    EXPECT_EQ(nullptr, Camera3InjectionShmRing::create(nv12, &fd));
+}
+
+TEST(Camera3InjectionShmRingTest, AttachesVersionOneHeader) {
+    Camera3InjectionShmRing::Layout layout = {
+            Camera3InjectionShmRing::kFormatI420, 64, 48, 64, 3};
+    RingPair rings(layout);
+    ASSERT_NE(nullptr, rings.producer);
+    void* base = mmap(nullptr, sizeof(Camera3InjectionShmRing::ShmHeader),
+            PROT_READ | PROT_WRITE, MAP_SHARED, rings.fd, 0);
+    ASSERT_NE(MAP_FAILED, base);
+    // A version 1 producer leaves the chroma fields zero.
+    auto* header = static_cast<Camera3InjectionShmRing::ShmHeader*>(base);
+    header->version = 1;
+    header->chromaStride = 0;
+    header->chromaOffset = 0;
+    header->chroma2Offset = 0;
+    status_t res;
+    auto server = Camera3InjectionShmRing::attach(rings.fd, &res);
+    ASSERT_NE(nullptr, server);
+    EXPECT_EQ(32u, server->getLayout().chromaStride);
+    EXPECT_EQ(64u * 48 + 32 * 24, server->getLayout().chroma2Offset);
+    munmap(base, sizeof(Camera3InjectionShmRing::ShmHeader));
+}
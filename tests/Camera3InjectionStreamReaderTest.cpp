@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "Camera3InjectionStreamReaderTest"
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../device3/Camera3InjectionIngestBuffer.h"
+#include "../device3/Camera3InjectionStreamReader.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+using Reader = Camera3InjectionStreamReader;
+
+void appendLe(std::vector<uint8_t>* out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) {
+        out->push_back((value >> (8 * i)) & 0xFF);
+    }
+}
+
+std::vector<uint8_t> hello(uint16_t version, uint16_t clock) {
+    std::vector<uint8_t> out(Reader::kMagic, Reader::kMagic + sizeof(Reader::kMagic));
+    appendLe(&out, version, 2);
+    appendLe(&out, clock, 2);
+    return out;
+}
+
+void appendFrame(std::vector<uint8_t>* out, const std::vector<uint8_t>& payload,
+        uint32_t flags, uint64_t sequence, int64_t captureTimeUs) {
+    appendLe(out, payload.size(), 4);
+    appendLe(out, flags, 4);
+    appendLe(out, sequence, 8);
+    appendLe(out, static_cast<uint64_t>(captureTimeUs), 8);
+    out->insert(out->end(), payload.begin(), payload.end());
+}
+
+struct Collector {
+    std::vector<Reader::Hello> hellos;
+    std::vector<uint8_t> raw;
+    struct Received {
+        std::vector<uint8_t> data;
+        uint32_t flags;
+        uint64_t sequence;
+        int64_t captureTimeUs;
+    };
+    std::vector<Received> frames;
+    status_t helloResult = OK;
+
+    Reader::Callbacks callbacks() {
+        Reader::Callbacks cb;
+        cb.onHello = [this](const Reader::Hello& h) {
+            hellos.push_back(h);
+            return helloResult;
+        };
+        cb.onRawData = [this](const uint8_t* data, size_t size) {
+            raw.insert(raw.end(), data, data + size);
+        };
+        cb.onFrame = [this](const Reader::Frame& f) {
+            frames.push_back({std::vector<uint8_t>(f.data, f.data + f.size), f.flags,
+                    f.sequence, f.captureTimeUs});
+        };
+        return cb;
+    }
+};
+
+// Feeds the stream in chunks of the given size through an ingest buffer, the way the socket
+// server does with successive reads.
+status_t pushChunked(Reader* reader, const std::vector<uint8_t>& stream, size_t chunk,
+        const Reader::Callbacks& cb) {
+    Camera3InjectionIngestBuffer buffer(reader->getMaxUnitSize() + chunk,
+            /*initialCapacity*/ 16);
+    size_t needed = 0;
+    for (size_t pos = 0; pos < stream.size(); pos += chunk) {
+        size_t n = std::min(chunk, stream.size() - pos);
+        size_t pending = buffer.readable();
+        status_t res = buffer.reserve(std::max(n, needed > pending ? needed - pending : 0));
+        if (res != OK) return res;
+        memcpy(buffer.writeData(), stream.data() + pos, n);
+        buffer.commit(n);
+        size_t consumed = 0;
+        res = reader->parse(buffer.readData(), buffer.readable(), cb, &consumed, &needed);
+        buffer.consume(consumed);
+        if (res != OK) return res;
+    }
+    return OK;
+}
+
+status_t parseAll(Reader* reader, const std::vector<uint8_t>& stream,
+        const Reader::Callbacks& cb) {
+    return pushChunked(reader, stream, stream.size(), cb);
+}
+
+} // namespace
+
+TEST(Camera3InjectionStreamReaderTest, RawAnnexBPassesThrough) {
+    std::vector<uint8_t> stream = {0, 0, 0, 1, 0x67, 0x42, 0, 0, 1, 0x68, 0xCE};
+    for (size_t chunk : {1, 3, 64}) {
+        Reader reader;
+        Collector c;
+        ASSERT_EQ(OK, pushChunked(&reader, stream, chunk, c.callbacks()));
+        EXPECT_EQ(Reader::Mode::RAW, reader.getMode());
+        EXPECT_EQ(stream, c.raw) << "chunk " << chunk;
+        EXPECT_TRUE(c.frames.empty());
+    }
+}
+
+TEST(Camera3InjectionStreamReaderTest, FramedStreamAcrossChunkBoundaries) {
+    std::vector<uint8_t> stream = hello(1, Reader::kClockRealtime);
+    std::vector<uint8_t> first = {0, 0, 0, 1, 0x65, 0x88, 0x84};
+    std::vector<uint8_t> second(1000, 0xAB);
+    appendFrame(&stream, first, Reader::kFlagKeyFrame, 7, 1234567);
+    appendFrame(&stream, second, 0, 8, -5);
+
+    for (size_t chunk : {1, 5, 24, 31, 4096}) {
+        Reader reader;
+        Collector c;
+        ASSERT_EQ(OK, pushChunked(&reader, stream, chunk, c.callbacks()));
+        EXPECT_EQ(Reader::Mode::FRAMED, reader.getMode());
+        ASSERT_EQ(1u, c.hellos.size());
+        EXPECT_EQ(1, c.hellos[0].version);
+        EXPECT_EQ(Reader::kClockRealtime, c.hellos[0].clock);
+        EXPECT_TRUE(c.raw.empty());
+
+        ASSERT_EQ(2u, c.frames.size()) << "chunk " << chunk;
+        EXPECT_EQ(first, c.frames[0].data);
+        EXPECT_EQ(static_cast<uint32_t>(Reader::kFlagKeyFrame), c.frames[0].flags);
+        EXPECT_EQ(7u, c.frames[0].sequence);
+        EXPECT_EQ(1234567, c.frames[0].captureTimeUs);
+        EXPECT_EQ(second, c.frames[1].data);
+        EXPECT_EQ(8u, c.frames[1].sequence);
+        EXPECT_EQ(-5, c.frames[1].captureTimeUs);
+    }
+}
+
+TEST(Camera3InjectionStreamReaderTest, EmptyPayloadFrame) {
+    std::vector<uint8_t> stream = hello(1, Reader::kClockMonotonic);
+    appendFrame(&stream, {}, Reader::kFlagEndOfStream, 1, 0);
+    Reader reader;
+    Collector c;
+    ASSERT_EQ(OK, parseAll(&reader, stream, c.callbacks()));
+    ASSERT_EQ(1u, c.frames.size());
+    EXPECT_TRUE(c.frames[0].data.empty());
+    EXPECT_EQ(static_cast<uint32_t>(Reader::kFlagEndOfStream), c.frames[0].flags);
+}
+
+TEST(Camera3InjectionStreamReaderTest, RejectsProtocolErrors) {
+    {
+        // Unknown clock.
+        std::vector<uint8_t> stream = hello(1, 9);
+        Reader reader;
+        Collector c;
+        EXPECT_EQ(BAD_VALUE, parseAll(&reader, stream, c.callbacks()));
+    }
+    {
+        // Payload larger than the limit.
+        std::vector<uint8_t> stream = hello(1, Reader::kClockMonotonic);
+        appendFrame(&stream, std::vector<uint8_t>(65, 0), 0, 1, 0);
+        Reader reader(64);
+        Collector c;
+        EXPECT_EQ(BAD_VALUE, parseAll(&reader, stream, c.callbacks()));
+        EXPECT_TRUE(c.frames.empty());
+    }
+    {
+        // The server can refuse the handshake.
+        std::vector<uint8_t> stream = hello(2, Reader::kClockMonotonic);
+        Reader reader;
+        Collector c;
+        c.helloResult = BAD_VALUE;
+        EXPECT_EQ(BAD_VALUE, parseAll(&reader, stream, c.callbacks()));
+    }
+}
+
+TEST(Camera3InjectionStreamReaderTest, ResetStartsNewConnection) {
+    std::vector<uint8_t> framed = hello(1, Reader::kClockMonotonic);
+    appendFrame(&framed, {1, 2, 3}, 0, 1, 0);
+    std::vector<uint8_t> raw = {0, 0, 1, 0x09, 0xF0};
+
+    Reader reader;
+    Collector c;
+    size_t consumed = 0;
+    size_t needed = 0;
+    ASSERT_EQ(OK, reader.parse(framed.data(), framed.size() - 1, c.callbacks(), &consumed,
+            &needed));
+    EXPECT_EQ(Reader::kHelloSize, consumed);
+    reader.reset();
+    ASSERT_EQ(OK, parseAll(&reader, raw, c.callbacks()));
+    EXPECT_EQ(Reader::Mode::RAW, reader.getMode());
+    EXPECT_EQ(raw, c.raw);
+    EXPECT_TRUE(c.frames.empty());
+}
+
+TEST(Camera3InjectionStreamReaderTest, LeavesIncompleteFramesToTheCaller) {
+    std::vector<uint8_t> stream = hello(1, Reader::kClockMonotonic);
+    std::vector<uint8_t> payload(100, 0x42);
+    appendFrame(&stream, payload, 0, 1, 0);
+    appendFrame(&stream, payload, 0, 2, 0);
+
+    Reader reader;
+    Collector c;
+    size_t consumed = 0;
+    size_t needed = 0;
+    // Only the second frame's header has arrived.
+    size_t available = Reader::kHelloSize + 2 * Reader::kFrameHeaderSize + payload.size();
+    ASSERT_EQ(OK, reader.parse(stream.data(), available, c.callbacks(), &consumed, &needed));
+    EXPECT_EQ(Reader::kHelloSize + Reader::kFrameHeaderSize + payload.size(), consumed);
+    EXPECT_EQ(Reader::kFrameHeaderSize + payload.size(), needed);
+    ASSERT_EQ(1u, c.frames.size());
+
+    ASSERT_EQ(OK, reader.parse(stream.data() + consumed, stream.size() - consumed,
+            c.callbacks(), &consumed, &needed));
+    EXPECT_EQ(Reader::kFrameHeaderSize + payload.size(), consumed);
+    ASSERT_EQ(2u, c.frames.size());
+    EXPECT_EQ(2u, c.frames[1].sequence);
+}
+
+TEST(Camera3InjectionStreamReaderTest, FramesPointIntoTheInput) {
+    std::vector<uint8_t> stream = hello(1, Reader::kClockMonotonic);
+    appendFrame(&stream, {0, 0, 0, 1, 0x65}, 0, 1, 0);
+    Reader reader;
+    const uint8_t* framePointer = nullptr;
+    Reader::Callbacks cb;
+    cb.onFrame = [&framePointer](const Reader::Frame& f) { framePointer = f.data; };
+    size_t consumed = 0;
+    size_t needed = 0;
+    ASSERT_EQ(OK, reader.parse(stream.data(), stream.size(), cb, &consumed, &needed));
+    EXPECT_EQ(stream.data() + Reader::kHelloSize + Reader::kFrameHeaderSize, framePointer);
+    EXPECT_EQ(stream.size(), consumed);
+}
+
+TEST(Camera3InjectionStreamReaderTest, WriteAck) {
+    uint8_t ack[Reader::kAckSize];
+    Reader::writeAck(Reader::kVersion, 3, ack);
+    EXPECT_EQ(0, memcmp(ack, Reader::kMagic, sizeof(Reader::kMagic)));
+    EXPECT_EQ(Reader::kVersion, ack[4] | (ack[5] << 8));
+    EXPECT_EQ(3, ack[6] | (ack[7] << 8));
+}
+
+TEST(Camera3InjectionStreamReaderTest, WriteRequest) {
+    uint8_t request[Reader::kRequestSize];
+    Reader::writeRequest(Reader::kRequestKeyFrame, request);
+    EXPECT_EQ(0, memcmp(request, Reader::kRequestMagic, sizeof(Reader::kRequestMagic)));
+    EXPECT_EQ(Reader::kRequestKeyFrame, request[4] | (request[5] << 8));
+    EXPECT_EQ(0, request[6] | (request[7] << 8));
+}
@@ -0,0 +1,328 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "Camera3InjectionTransformTest"
+
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <libyuv.h>
+#include <system/graphics.h>
+
+#include "../device3/Camera3InjectionTransform.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+constexpr uint8_t kPaddingValue = 0xA5;
+
+struct TestFrame {
+    int32_t width;
+    int32_t height;
+    std::vector<uint8_t> data;
+
+    TestFrame(int32_t w, int32_t h) : width(w), height(h), data(w * h * 3 / 2) {
+        std::mt19937 rng(w * 31 + h);
+        std::uniform_int_distribution<int> dist(0, 255);
+        for (auto& b : data) b = static_cast<uint8_t>(dist(rng));
+    }
+
+    Camera3InjectionTransform::Source source() const {
+        return {data.data(), data.data() + width * height, width, width, height};
+    }
+};
+
+struct TestBuffer {
+    int32_t width;
+    int32_t height;
+    int32_t stride;
+    std::vector<uint8_t> data;
+
+    TestBuffer(int32_t w, int32_t h, int32_t s) : width(w), height(h), stride(s),
+            data(s * h * 3 / 2, kPaddingValue) {}
+
+    Camera3InjectionTransform::Destination destination() {
+        return {data.data(), data.data() + stride * height, stride, width, height};
+    }
+};
+
+// The compositing path previously inlined in Camera3OutputStream::returnBufferCheckedLocked:
+// rotate the full source frame into a temporary buffer, crop to the destination aspect
+// ratio, then box-scale into the destination.
+void referenceTransform(const TestFrame& frame, int32_t rotation, TestBuffer* out) {
+    int srcW = frame.width;
+    int srcH = frame.height;
+    const uint8_t* srcData = frame.data.data();
+    int w = out->width;
+    int h = out->height;
+    int dstStride = out->stride;
+
+    libyuv::RotationMode rotationMode = libyuv::kRotate0;
+    if (rotation == 90) rotationMode = libyuv::kRotate90;
+    else if (rotation == 180) rotationMode = libyuv::kRotate180;
+    else if (rotation == 270) rotationMode = libyuv::kRotate270;
+
+    std::vector<uint8_t> rotateBuf;
+    int effectiveW = srcW;
+    int effectiveH = srcH;
+    const uint8_t* curY = srcData;
+    const uint8_t* curUV = srcData + srcW * srcH;
+    int curStride = srcW;
+
+    if (rotation != 0) {
+        rotateBuf.resize(frame.data.size());
+        uint8_t* dstRY = rotateBuf.data();
+        uint8_t* dstRUV = dstRY + srcW * srcH;
+        libyuv::RotatePlane(curY, srcW, dstRY,
+                (rotationMode == libyuv::kRotate180) ? srcW : srcH, srcW, srcH, rotationMode);
+
+        const uint16_t* srcUV16 = reinterpret_cast<const uint16_t*>(curUV);
+        uint16_t* dstUV16 = reinterpret_cast<uint16_t*>(dstRUV);
+        int srcUVH = srcH / 2;
+        int srcUVW = srcW / 2;
+        if (rotation == 90) {
+            for (int y = 0; y < srcUVH; ++y) {
+                for (int x = 0; x < srcUVW; ++x) {
+                    dstUV16[x * srcUVH + (srcUVH - 1 - y)] = srcUV16[y * srcUVW + x];
+                }
+            }
+            effectiveW = srcH; effectiveH = srcW; curStride = srcH;
+        } else if (rotation == 180) {
+            for (int y = 0; y < srcUVH; ++y) {
+                for (int x = 0; x < srcUVW; ++x) {
+                    dstUV16[(srcUVH - 1 - y) * srcUVW + (srcUVW - 1 - x)] =
+                            srcUV16[y * srcUVW + x];
+                }
+            }
+        } else {
+            for (int y = 0; y < srcUVH; ++y) {
+                for (int x = 0; x < srcUVW; ++x) {
+                    dstUV16[(srcUVW - 1 - x) * srcUVH + y] = srcUV16[y * srcUVW + x];
+                }
+            }
+            effectiveW = srcH; effectiveH = srcW; curStride = srcH;
+        }
+        curY = dstRY;
+        curUV = dstRUV;
+    }
+
+    float dstAspect = (float)w / h;
+    int cropW, cropH;
+    int cropX = 0, cropY = 0;
+    if ((float)effectiveW / effectiveH > dstAspect) {
+        cropH = effectiveH;
+        cropW = (int)(effectiveH * dstAspect);
+        cropX = (effectiveW - cropW) / 2;
+    } else {
+        cropW = effectiveW;
+        cropH = (int)(effectiveW / dstAspect);
+        cropY = (effectiveH - cropH) / 2;
+    }
+    cropX = (cropX / 2) * 2;
+    cropY = (cropY / 2) * 2;
+    cropW = (cropW / 2) * 2;
+    cropH = (cropH / 2) * 2;
+
+    const uint8_t* finalSrcY = curY + cropY * curStride + cropX;
+    const uint8_t* finalSrcUV = curUV + (cropY / 2) * curStride + cropX;
+    uint8_t* dstY = out->data.data();
+    uint8_t* dstUV = dstY + dstStride * h;
+    libyuv::NV12Scale(finalSrcY, curStride, finalSrcUV, curStride, cropW, cropH,
+            dstY, dstStride, dstUV, dstStride, w, h, libyuv::kFilterBox);
+}
+
+void expectSameImage(const TestBuffer& expected, const TestBuffer& actual) {
+    ASSERT_EQ(expected.data.size(), actual.data.size());
+    int32_t stride = expected.stride;
+    for (int32_t row = 0; row < expected.height; row++) {
+        for (int32_t col = 0; col < expected.width; col++) {
+            ASSERT_EQ(expected.data[row * stride + col], actual.data[row * stride + col])
+                    << "Y mismatch at (" << col << ", " << row << ")";
+        }
+    }
+    const uint8_t* expectedUV = expected.data.data() + stride * expected.height;
+    const uint8_t* actualUV = actual.data.data() + stride * actual.height;
+    for (int32_t row = 0; row < expected.height / 2; row++) {
+        for (int32_t col = 0; col < expected.width; col++) {
+            ASSERT_EQ(expectedUV[row * stride + col], actualUV[row * stride + col])
+                    << "UV mismatch at (" << col << ", " << row << ")";
+        }
+    }
+}
+
+void compareWithReference(int32_t srcW, int32_t srcH, int32_t rotation,
+        int32_t dstW, int32_t dstH, int32_t dstStride) {
+    TestFrame frame(srcW, srcH);
+    TestBuffer expected(dstW, dstH, dstStride);
+    TestBuffer actual(dstW, dstH, dstStride);
+    std::vector<uint8_t> scratch;
+
+    referenceTransform(frame, rotation, &expected);
+    ASSERT_EQ(OK, Camera3InjectionTransform::apply(frame.source(), rotation,
+            actual.destination(), &scratch));
+    expectSameImage(expected, actual);
+}
+
+} // anonymous namespace
+
+TEST(Camera3InjectionTransformTest, CompensationRotation) {
+    EXPECT_EQ(0, Camera3InjectionTransform::compensationRotation(0));
+    EXPECT_EQ(270, Camera3InjectionTransform::compensationRotation(HAL_TRANSFORM_ROT_90));
+    EXPECT_EQ(180, Camera3InjectionTransform::compensationRotation(HAL_TRANSFORM_ROT_180));
+    EXPECT_EQ(90, Camera3InjectionTransform::compensationRotation(HAL_TRANSFORM_ROT_270));
+}
+
+TEST(Camera3InjectionTransformTest, NoRotationMatchesReference) {
+    // Crop + arbitrary box scale is the same libyuv call in both paths
+    compareWithReference(1280, 720, 0, 1280, 720, 1280);
+    compareWithReference(1920, 1080, 0, 720, 960, 768);
+    compareWithReference(640, 480, 0, 1280, 720, 1280);
+    compareWithReference(1280, 720, 0, 176, 144, 192);
+}
+
+TEST(Camera3InjectionTransformTest, RotationMatchesReference) {
+    // Scaling before rotating is pixel-exact when each destination pixel maps to the same
+    // source box in both orders, i.e. for unity and exact 2:1 downscales.
+    // Aspect ratios are kept exactly representable so both paths pick the same crop.
+    for (int32_t rotation : {90, 180, 270}) {
+        SCOPED_TRACE(rotation);
+        bool swap = (rotation != 180);
+        int32_t w = swap ? 256 : 512;
+        int32_t h = swap ? 512 : 256;
+        compareWithReference(512, 256, rotation, w, h, w);
+        compareWithReference(512, 256, rotation, w / 2, h / 2, w / 2 + 32);
+        // Cropped to destination aspect ratio before scaling
+        compareWithReference(1280, 720, rotation, swap ? 360 : 640, swap ? 360 : 320,
+                swap ? 384 : 640);
+    }
+}
+
+TEST(Camera3InjectionTransformTest, PaddingUntouched) {
+    TestFrame frame(640, 480);
+    TestBuffer buffer(320, 240, 384);
+    std::vector<uint8_t> scratch;
+    ASSERT_EQ(OK, Camera3InjectionTransform::apply(frame.source(), 90, buffer.destination(),
+            &scratch));
+    for (int32_t row = 0; row < buffer.height * 3 / 2; row++) {
+        for (int32_t col = buffer.width; col < buffer.stride; col++) {
+            ASSERT_EQ(kPaddingValue, buffer.data[row * buffer.stride + col]);
+        }
+    }
+}
+
+TEST(Camera3InjectionTransformTest, ScratchIsDestinationSizedAndReused) {
+    TestFrame frame(1920, 1080);
+    TestBuffer buffer(360, 640, 384);
+    std::vector<uint8_t> scratch;
+    ASSERT_EQ(OK, Camera3InjectionTransform::apply(frame.source(), 90, buffer.destination(),
+            &scratch));
+    EXPECT_LE(scratch.size(), static_cast<size_t>(buffer.width * buffer.height * 3 / 2));
+    const uint8_t* scratchData = scratch.data();
+    ASSERT_EQ(OK, Camera3InjectionTransform::apply(frame.source(), 270, buffer.destination(),
+            &scratch));
+    EXPECT_EQ(scratchData, scratch.data());
+
+    // No intermediate buffer at all without rotation
+    std::vector<uint8_t> unused;
+    ASSERT_EQ(OK, Camera3InjectionTransform::apply(frame.source(), 0, buffer.destination(),
+            &unused));
+    EXPECT_TRUE(unused.empty());
+}
+
+TEST(Camera3InjectionTransformTest, InvalidArguments) {
+    TestFrame frame(640, 480);
+    TestBuffer buffer(320, 240, 320);
+    std::vector<uint8_t> scratch;
+    EXPECT_EQ(BAD_VALUE, Camera3InjectionTransform::apply(frame.source(), 45,
+            buffer.destination(), &scratch));
+
+    TestBuffer oddStride(320, 240, 321);
+    EXPECT_EQ(BAD_VALUE, Camera3InjectionTransform::apply(frame.source(), 0,
+            oddStride.destination(), &scratch));
+}
+
+TEST(Camera3InjectionTransformTest, PlanRebuiltOnlyOnKeyChange) {
+    TestFrame frame(640, 480);
+    TestBuffer buffer(480, 640, 512);
+    TestBuffer expected(480, 640, 512);
+    std::vector<uint8_t> scratch;
+    ASSERT_EQ(OK, Camera3InjectionTransform::apply(frame.source(), 270, expected.destination(),
+            &scratch));
+
+    Camera3InjectionTransform::Plan plan;
+    Camera3InjectionTransform::Key key = {640, 480, 640, 480, 640, 512, HAL_TRANSFORM_ROT_90};
+    EXPECT_TRUE(plan.update(key));
+    EXPECT_TRUE(plan.isValid());
+    EXPECT_EQ(270, plan.getRotation());
+    for (int i = 0; i < 3; i++) {
+        EXPECT_FALSE(plan.update(key));
+        auto src = frame.source();
+        auto dst = buffer.destination();
+        ASSERT_EQ(OK, plan.execute(src.y, src.uv, dst.y, dst.uv));
+    }
+    EXPECT_EQ(1u, plan.getRebuildCount());
+    expectSameImage(expected, buffer);
+
+    key.transform = 0;
+    EXPECT_TRUE(plan.update(key));
+    key.dstStride = 576;
+    EXPECT_TRUE(plan.update(key));
+    EXPECT_FALSE(plan.update(key));
+    EXPECT_EQ(3u, plan.getRebuildCount());
+
+    // An unusable key leaves the plan invalid until the key changes again
+    key.dstStride = 577;
+    EXPECT_TRUE(plan.update(key));
+    EXPECT_FALSE(plan.update(key));
+    EXPECT_FALSE(plan.isValid());
+    auto src = frame.source();
+    auto dst = buffer.destination();
+    EXPECT_EQ(INVALID_OPERATION, plan.execute(src.y, src.uv, dst.y, dst.uv));
+}
+
+TEST(Camera3InjectionTransformTest, SwapChromaMatchesPreswappedSource) {
+    // Reading an NV12 source directly must give the same result as converting it to
+    // NV21 first and transforming that, with and without rotation.
+    TestFrame nv12(640, 480);
+    TestFrame nv21(640, 480);
+    auto src = nv12.source();
+    auto converted = nv21.source();
+    libyuv::SwapUVPlane(src.uv, src.stride, const_cast<uint8_t*>(converted.uv),
+            converted.stride, src.width / 2, src.height / 2);
+    std::vector<uint8_t> scratch;
+
+    for (int32_t transform : {0, static_cast<int32_t>(HAL_TRANSFORM_ROT_90)}) {
+        TestBuffer expected(320, 240, 384);
+        TestBuffer actual(320, 240, 384);
+        ASSERT_EQ(OK, Camera3InjectionTransform::apply(converted,
+                Camera3InjectionTransform::compensationRotation(transform),
+                expected.destination(), &scratch));
+
+        Camera3InjectionTransform::Plan plan;
+        Camera3InjectionTransform::Key key = {640, 480, 640, 320, 240, 384, transform, true};
+        EXPECT_TRUE(plan.update(key));
+        auto dst = actual.destination();
+        ASSERT_EQ(OK, plan.execute(src.y, src.uv, dst.y, dst.uv));
+        expectSameImage(expected, actual);
+
+        key.swapChroma = false;
+        EXPECT_TRUE(plan.update(key));
+    }
+}
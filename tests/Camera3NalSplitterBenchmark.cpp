@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "../device3/Camera3NalSplitter.h"
+
+using namespace android::camera3;
+
+namespace {
+
+// Builds an Annex-B stream of escaped random NAL units, roughly shaped like a 1080p
+// H.264 stream: one large slice every 30 units, small slices in between.
+std::vector<uint8_t> makeStream(size_t totalSize) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> dist(0, 255);
+    std::vector<uint8_t> stream;
+    stream.reserve(totalSize + 256 * 1024);
+    size_t index = 0;
+    while (stream.size() < totalSize) {
+        size_t nalSize = (index++ % 30 == 0) ? 200 * 1024 : 12 * 1024;
+        const uint8_t startCode[] = {0x00, 0x00, 0x00, 0x01, 0x41};
+        stream.insert(stream.end(), startCode, startCode + sizeof(startCode));
+        size_t zeros = 0;
+        for (size_t i = 0; i < nalSize; i++) {
+            uint8_t b = static_cast<uint8_t>(dist(rng));
+            if (zeros >= 2 && b <= 0x03) {
+                stream.push_back(0x03);
+                zeros = 0;
+            }
+            stream.push_back(b);
+            zeros = (b == 0) ? zeros + 1 : 0;
+        }
+        stream.push_back(0x80);
+    }
+    return stream;
+}
+
+// The old byte-by-byte scan for 00 00 00 01, kept as a baseline.
+size_t countStartCodesNaive(const uint8_t* data, size_t size) {
+    size_t count = 0;
+    for (size_t i = 0; i + 4 <= size; i++) {
+        if (data[i] == 0x00 && data[i + 1] == 0x00 && data[i + 2] == 0x00 && data[i + 3] == 0x01) {
+            count++;
+            i += 3;
+        }
+    }
+    return count;
+}
+
+void BM_NalSplitter(benchmark::State& state) {
+    std::vector<uint8_t> stream = makeStream(32 * 1024 * 1024);
+    size_t chunkSize = state.range(0);
+    Camera3NalSplitter splitter;
+    size_t nalBytes = 0;
+    auto onNal = [&nalBytes](const Camera3NalSplitter::NalUnit& nal) { nalBytes += nal.size; };
+    for (auto _ : state) {
+        for (size_t pos = 0; pos < stream.size(); pos += chunkSize) {
+            splitter.push(stream.data() + pos, std::min(chunkSize, stream.size() - pos), onNal);
+        }
+        splitter.flush(onNal);
+        benchmark::DoNotOptimize(nalBytes);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * stream.size());
+}
+// 64 KiB matches the socket server's read size.
+BENCHMARK(BM_NalSplitter)->Arg(4096)->Arg(64 * 1024)->Arg(1024 * 1024);
+
+void BM_NaiveStartCodeScan(benchmark::State& state) {
+    std::vector<uint8_t> stream = makeStream(32 * 1024 * 1024);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(countStartCodesNaive(stream.data(), stream.size()));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * stream.size());
+}
+BENCHMARK(BM_NaiveStartCodeScan);
+
+} // namespace
+
+BENCHMARK_MAIN();
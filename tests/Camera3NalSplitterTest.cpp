@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "Camera3NalSplitterTest"
+
+#include <algorithm>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../device3/Camera3NalSplitter.h"
+
+using namespace android::camera3;
+
+namespace {
+
+using Bytes = std::vector<uint8_t>;
+
+// Collects every NAL unit (including its start code) emitted by a splitter.
+struct Collector {
+    std::vector<Bytes> nals;
+
+    Camera3NalSplitter::NalCallback callback() {
+        return [this](const Camera3NalSplitter::NalUnit& nal) {
+            nals.emplace_back(nal.data, nal.data + nal.size);
+        };
+    }
+};
+
+Bytes concat(const std::vector<Bytes>& parts) {
+    Bytes out;
+    for (const auto& part : parts) out.insert(out.end(), part.begin(), part.end());
+    return out;
+}
+
+std::vector<Bytes> splitAll(const Bytes& stream, size_t chunkSize) {
+    Camera3NalSplitter splitter;
+    Collector collector;
+    for (size_t pos = 0; pos < stream.size(); pos += chunkSize) {
+        size_t len = std::min(chunkSize, stream.size() - pos);
+        splitter.push(stream.data() + pos, len, collector.callback());
+    }
+    splitter.flush(collector.callback());
+    return collector.nals;
+}
+
+// A random NAL payload that never contains a start code, escaped the way an encoder would.
+Bytes randomNal(std::mt19937* rng, size_t size, uint8_t header) {
+    std::uniform_int_distribution<int> dist(0, 255);
+    std::uniform_int_distribution<int> zeroDist(0, 7);
+    Bytes nal = {header};
+    size_t zeros = 0;
+    while (nal.size() < size) {
+        uint8_t b = zeroDist(*rng) == 0 ? 0 : static_cast<uint8_t>(dist(*rng));
+        if (zeros >= 2 && b <= 0x03) {
+            nal.push_back(0x03);
+            zeros = 0;
+        }
+        nal.push_back(b);
+        zeros = (b == 0) ? zeros + 1 : 0;
+    }
+    if (nal.back() == 0) nal.push_back(0x80); // rbsp_stop_one_bit
+    return nal;
+}
+
+const Bytes kStart3 = {0x00, 0x00, 0x01};
+const Bytes kStart4 = {0x00, 0x00, 0x00, 0x01};
+
+} // namespace
+
+TEST(Camera3NalSplitterTest, SplitsFourByteStartCodes) {
+    Bytes sps = {0x67, 0x42, 0x00, 0x1f};
+    Bytes pps = {0x68, 0xce, 0x3c, 0x80};
+    Bytes idr = {0x65, 0x88, 0x84, 0x00, 0x21};
+    auto nals = splitAll(concat({kStart4, sps, kStart4, pps, kStart4, idr}), 4096);
+
+    ASSERT_EQ(3u, nals.size());
+    EXPECT_EQ(concat({kStart4, sps}), nals[0]);
+    EXPECT_EQ(concat({kStart4, pps}), nals[1]);
+    EXPECT_EQ(concat({kStart4, idr}), nals[2]);
+}
+
+TEST(Camera3NalSplitterTest, SplitsThreeByteAndMixedStartCodes) {
+    Bytes a = {0x67, 0x42};
+    Bytes b = {0x68, 0xce};
+    Bytes c = {0x41, 0x9a, 0x01};
+    auto nals = splitAll(concat({kStart3, a, kStart4, b, kStart3, c}), 4096);
+
+    ASSERT_EQ(3u, nals.size());
+    EXPECT_EQ(concat({kStart3, a}), nals[0]);
+    EXPECT_EQ(concat({kStart4, b}), nals[1]);
+    EXPECT_EQ(concat({kStart3, c}), nals[2]);
+}
+
+TEST(Camera3NalSplitterTest, NalUnitAccessors) {
+    Camera3NalSplitter splitter;
+    Bytes stream = concat({kStart3, {0x65, 0x11}, kStart4, {0x67, 0x22, 0x33}});
+    std::vector<std::tuple<size_t, size_t, uint8_t>> seen;
+    auto cb = [&seen](const Camera3NalSplitter::NalUnit& nal) {
+        seen.emplace_back(nal.startCodeLength, nal.payloadSize(), nal.type());
+    };
+    splitter.push(stream.data(), stream.size(), cb);
+    splitter.flush(cb);
+
+    ASSERT_EQ(2u, seen.size());
+    EXPECT_EQ(std::make_tuple(size_t(3), size_t(2), uint8_t(5)), seen[0]);
+    EXPECT_EQ(std::make_tuple(size_t(4), size_t(3), uint8_t(7)), seen[1]);
+}
+
+TEST(Camera3NalSplitterTest, DropsLeadingGarbageAndTrailingZeros) {
+    Bytes garbage = {0x12, 0x00, 0x34};
+    Bytes a = {0x67, 0x42};
+    Bytes b = {0x68, 0xce};
+    // Extra zero bytes before a start code are trailing_zero_8bits of the previous NAL.
+    auto nals = splitAll(concat({garbage, kStart4, a, {0x00, 0x00}, kStart4, b, {0x00, 0x00}}),
+            4096);
+
+    ASSERT_EQ(2u, nals.size());
+    EXPECT_EQ(concat({kStart4, a}), nals[0]);
+    EXPECT_EQ(concat({kStart4, b}), nals[1]);
+}
+
+TEST(Camera3NalSplitterTest, EmulationPreventionIsNotAStartCode) {
+    Bytes escaped = {0x65, 0x00, 0x00, 0x03, 0x01, 0x00, 0x00, 0x03, 0x00, 0x7f};
+    auto nals = splitAll(concat({kStart4, escaped}), 4096);
+
+    ASSERT_EQ(1u, nals.size());
+    EXPECT_EQ(concat({kStart4, escaped}), nals[0]);
+
+    Bytes rbsp;
+    Camera3NalSplitter::extractRbsp(escaped.data(), escaped.size(), &rbsp);
+    EXPECT_EQ(Bytes({0x65, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x7f}), rbsp);
+}
+
+TEST(Camera3NalSplitterTest, EveryChunkBoundaryMatchesSinglePush) {
+    std::mt19937 rng(1234);
+    std::vector<Bytes> expected;
+    Bytes stream;
+    for (int i = 0; i < 12; i++) {
+        const Bytes& startCode = (i % 3 == 0) ? kStart3 : kStart4;
+        Bytes nal = randomNal(&rng, 5 + i * 7, 0x41 + i);
+        expected.push_back(concat({startCode, nal}));
+        stream.insert(stream.end(), startCode.begin(), startCode.end());
+        stream.insert(stream.end(), nal.begin(), nal.end());
+    }
+
+    for (size_t chunkSize = 1; chunkSize <= 17; chunkSize++) {
+        SCOPED_TRACE(chunkSize);
+        EXPECT_EQ(expected, splitAll(stream, chunkSize));
+    }
+
+    // Split once at every possible position, so each start code straddles a boundary.
+    for (size_t split = 1; split < stream.size(); split++) {
+        Camera3NalSplitter splitter;
+        Collector collector;
+        splitter.push(stream.data(), split, collector.callback());
+        splitter.push(stream.data() + split, stream.size() - split, collector.callback());
+        splitter.flush(collector.callback());
+        ASSERT_EQ(expected, collector.nals) << "split at " << split;
+    }
+}
+
+TEST(Camera3NalSplitterTest, SplitCompleteBufferMatchesPushAndFlush) {
+    std::mt19937 rng(99);
+    std::vector<Bytes> parts = {{0x12, 0x00}};
+    for (int i = 0; i < 8; i++) {
+        parts.push_back((i % 2 == 0) ? kStart3 : kStart4);
+        parts.push_back(randomNal(&rng, 3 + i * 11, 0x41 + i));
+        if (i == 3) parts.push_back({0x00, 0x00});
+    }
+    parts.push_back({0x00, 0x00, 0x00});
+    Bytes stream = concat(parts);
+
+    Camera3NalSplitter splitter;
+    std::vector<const uint8_t*> pointers;
+    Collector collector;
+    splitter.split(stream.data(), stream.size(),
+            [&](const Camera3NalSplitter::NalUnit& nal) {
+                pointers.push_back(nal.data);
+                collector.callback()(nal);
+            });
+    EXPECT_EQ(splitAll(stream, stream.size()), collector.nals);
+
+    // Every NAL unit, including the last one, points into the input.
+    for (const uint8_t* p : pointers) {
+        EXPECT_TRUE(p >= stream.data() && p < stream.data() + stream.size());
+    }
+    EXPECT_EQ(8u, splitter.getNalCount());
+}
+
+TEST(Camera3NalSplitterTest, SplitFlushesPendingPushData) {
+    Camera3NalSplitter splitter;
+    Collector collector;
+    Bytes partial = concat({kStart4, {0x41, 0x01}});
+    Bytes frame = concat({kStart4, {0x65, 0x02}});
+    splitter.push(partial.data(), partial.size(), collector.callback());
+    splitter.split(frame.data(), frame.size(), collector.callback());
+
+    ASSERT_EQ(2u, collector.nals.size());
+    EXPECT_EQ(partial, collector.nals[0]);
+    EXPECT_EQ(frame, collector.nals[1]);
+}
+
+TEST(Camera3NalSplitterTest, OversizedNalIsDropped) {
+    Camera3NalSplitter splitter(/*maxNalSize*/16);
+    Collector collector;
+    Bytes big(64, 0x55);
+    big[0] = 0x65;
+    Bytes small = {0x41, 0x9a};
+    Bytes stream = concat({kStart4, small, kStart4, big, kStart4, small});
+    for (size_t pos = 0; pos < stream.size(); pos += 8) {
+        splitter.push(stream.data() + pos, std::min<size_t>(8, stream.size() - pos),
+                collector.callback());
+    }
+    splitter.flush(collector.callback());
+
+    ASSERT_EQ(2u, collector.nals.size());
+    EXPECT_EQ(concat({kStart4, small}), collector.nals[0]);
+    EXPECT_EQ(concat({kStart4, small}), collector.nals[1]);
+    EXPECT_EQ(1u, splitter.getOversizedCount());
+}
+
+TEST(Camera3NalSplitterTest, OversizedNalInOneChunkIsDropped) {
+    Camera3NalSplitter splitter(/*maxNalSize*/16);
+    Collector collector;
+    Bytes big(64, 0x55);
+    big[0] = 0x65;
+    Bytes small = {0x41, 0x9a};
+    // The oversized unit starts and ends inside a single push, like split() sees it.
+    Bytes stream = concat({kStart4, small, kStart4, big, kStart4, small});
+    splitter.push(stream.data(), stream.size(), collector.callback());
+    splitter.flush(collector.callback());
+
+    ASSERT_EQ(2u, collector.nals.size());
+    EXPECT_EQ(concat({kStart4, small}), collector.nals[0]);
+    EXPECT_EQ(concat({kStart4, small}), collector.nals[1]);
+    EXPECT_EQ(1u, splitter.getOversizedCount());
+}
+
+TEST(Camera3NalSplitterTest, ResetDiscardsPartialNal) {
+    Camera3NalSplitter splitter;
+    Collector collector;
+    Bytes partial = concat({kStart4, {0x65, 0x01, 0x02}});
+    splitter.push(partial.data(), partial.size(), collector.callback());
+    splitter.reset();
+    Bytes next = concat({kStart3, {0x67, 0x42}});
+    splitter.push(next.data(), next.size(), collector.callback());
+    splitter.flush(collector.callback());
+
+    ASSERT_EQ(1u, collector.nals.size());
+    EXPECT_EQ(next, collector.nals[0]);
+    EXPECT_EQ(partial.size() + next.size(), splitter.getBytesScanned());
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "Camera3RequestBatchTest"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../device3/Camera3RequestBatch.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+using Request = Camera3RequestBatch::Request;
+
+const int32_t kSessionKeys[] = {ANDROID_CONTROL_AE_TARGET_FPS_RANGE, ANDROID_CONTROL_MODE};
+
+CameraMetadata makeSettings(int32_t maxFps, uint8_t controlMode = ANDROID_CONTROL_MODE_AUTO) {
+    CameraMetadata settings;
+    int32_t fpsRange[] = {15, maxFps};
+    settings.update(ANDROID_CONTROL_AE_TARGET_FPS_RANGE, fpsRange, 2);
+    settings.update(ANDROID_CONTROL_MODE, &controlMode, 1);
+    return settings;
+}
+
+Request makeRequest(const void* id, const CameraMetadata& settings, size_t halQueueLimit = 0) {
+    Request request;
+    request.id = id;
+    request.settings = &settings;
+    request.halQueueLimit = halQueueLimit;
+    return request;
+}
+
+bool canJoin(const Request& candidate, const std::vector<Request>& batch) {
+    return Camera3RequestBatch::canJoin(candidate, batch.data(), batch.size(), kSessionKeys,
+            sizeof(kSessionKeys) / sizeof(kSessionKeys[0]));
+}
+
+} // namespace
+
+TEST(Camera3RequestBatchTest, BatchesWhilePipelineIsFull) {
+    // A streaming burst: the HAL already holds pipelineMaxDepth requests, the preview and
+    // video streams allow 6 HAL buffers each, and 4 distinct requests are queued.
+    int ids[4];
+    CameraMetadata settings = makeSettings(30);
+    std::vector<Request> batch = {makeRequest(&ids[0], settings, 6)};
+    for (size_t i = 1; i < 4; i++) {
+        Request candidate = makeRequest(&ids[i], settings, 6);
+        ASSERT_TRUE(canJoin(candidate, batch)) << "request " << i;
+        batch.push_back(candidate);
+    }
+    EXPECT_EQ(4u, batch.size());
+}
+
+TEST(Camera3RequestBatchTest, BatchStopsAtHalQueueLimit) {
+    int a, b, c;
+    CameraMetadata settings = makeSettings(30);
+    std::vector<Request> batch = {makeRequest(&a, settings, 2)};
+
+    EXPECT_TRUE(canJoin(makeRequest(&b, settings, 8), batch));
+    batch.push_back(makeRequest(&b, settings, 8));
+    // The smallest limit in the batch applies, whichever request carries it.
+    EXPECT_FALSE(canJoin(makeRequest(&c, settings, 8), batch));
+    batch[0].halQueueLimit = 0;
+    EXPECT_TRUE(canJoin(makeRequest(&c, settings), batch));
+    EXPECT_FALSE(canJoin(makeRequest(&c, settings, 2), batch));
+}
+
+TEST(Camera3RequestBatchTest, JoinsQueuedRequestsWithSameSessionParams) {
+    int a, b, c;
+    CameraMetadata first = makeSettings(30);
+    CameraMetadata second = makeSettings(30);
+    std::vector<Request> batch = {makeRequest(&a, first)};
+
+    EXPECT_TRUE(canJoin(makeRequest(&b, second), batch));
+    batch.push_back(makeRequest(&b, second));
+    // Settings outside the session keys may differ between batched requests.
+    CameraMetadata third = makeSettings(30);
+    uint8_t afMode = ANDROID_CONTROL_AF_MODE_AUTO;
+    third.update(ANDROID_CONTROL_AF_MODE, &afMode, 1);
+    EXPECT_TRUE(canJoin(makeRequest(&c, third), batch));
+}
+
+TEST(Camera3RequestBatchTest, RejectsRepeatedRequestObject) {
+    int a, b;
+    CameraMetadata settings = makeSettings(30);
+    std::vector<Request> batch = {makeRequest(&a, settings), makeRequest(&b, settings)};
+
+    // A repeating request queued twice would overwrite the frame number of the first copy.
+    EXPECT_FALSE(canJoin(makeRequest(&a, settings), batch));
+    EXPECT_FALSE(canJoin(makeRequest(&b, settings), batch));
+}
+
+TEST(Camera3RequestBatchTest, RejectsDifferentSessionParams) {
+    int a, b;
+    CameraMetadata first = makeSettings(30);
+    std::vector<Request> batch = {makeRequest(&a, first)};
+
+    CameraMetadata fps = makeSettings(60);
+    EXPECT_FALSE(canJoin(makeRequest(&b, fps), batch));
+    CameraMetadata mode = makeSettings(30, ANDROID_CONTROL_MODE_OFF);
+    EXPECT_FALSE(canJoin(makeRequest(&b, mode), batch));
+
+    // A key present on one side only also counts as a change.
+    CameraMetadata missing;
+    uint8_t controlMode = ANDROID_CONTROL_MODE_AUTO;
+    missing.update(ANDROID_CONTROL_MODE, &controlMode, 1);
+    EXPECT_FALSE(canJoin(makeRequest(&b, missing), batch));
+
+    // Without session keys nothing is compared.
+    EXPECT_TRUE(Camera3RequestBatch::canJoin(makeRequest(&b, fps), batch.data(), batch.size(),
+            nullptr, 0));
+}
+
+TEST(Camera3RequestBatchTest, RejectsHfrAndReprocessRequests) {
+    int a, b;
+    CameraMetadata settings = makeSettings(30);
+    std::vector<Request> batch = {makeRequest(&a, settings)};
+
+    Request hfr = makeRequest(&b, settings);
+    hfr.hfrBatchSize = 4;
+    EXPECT_FALSE(canJoin(hfr, batch));
+    Request reprocess = makeRequest(&b, settings);
+    reprocess.reprocess = true;
+    EXPECT_FALSE(canJoin(reprocess, batch));
+    EXPECT_FALSE(canJoin(makeRequest(&b, settings), {}));
+}
@@ -0,0 +1,282 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "Camera3SettingsDeltaTest"
+
+#include <algorithm>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../device3/Camera3SettingsDelta.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+// Stands in for the HAL's vendor tag; any int32 tag the settings never carry works.
+constexpr uint32_t kDeltaTag = ANDROID_REQUEST_INPUT_STREAMS;
+
+struct MetadataDeleter {
+    void operator()(camera_metadata_t* metadata) const { free_camera_metadata(metadata); }
+};
+using Metadata = std::unique_ptr<camera_metadata_t, MetadataDeleter>;
+
+// Streaming settings: a large static part plus the few tags a preview changes per frame.
+struct Settings {
+    uint8_t aeMode = ANDROID_CONTROL_AE_MODE_ON;
+    float zoomRatio = 1.0f;
+    std::vector<int32_t> aeRegions = {0, 0, 1920, 1080, 1};
+    int64_t exposureTime = 10000000;
+    // The bulk of the settings, which a preview never changes
+    std::vector<float> tonemapCurve = std::vector<float>(64, 0.5f);
+    bool withJpegQuality = true;
+    uint8_t jpegQuality = 95;
+    bool withAfTrigger = false;
+
+    // Compact, like the settings the request thread submits
+    Metadata build() const {
+        Metadata metadata(allocate_camera_metadata(16, 1024));
+        add_camera_metadata_entry(metadata.get(), ANDROID_CONTROL_AE_MODE, &aeMode, 1);
+        add_camera_metadata_entry(metadata.get(), ANDROID_CONTROL_ZOOM_RATIO, &zoomRatio, 1);
+        add_camera_metadata_entry(metadata.get(), ANDROID_CONTROL_AE_REGIONS, aeRegions.data(),
+                aeRegions.size());
+        add_camera_metadata_entry(metadata.get(), ANDROID_SENSOR_EXPOSURE_TIME, &exposureTime, 1);
+        add_camera_metadata_entry(metadata.get(), ANDROID_TONEMAP_CURVE_RED, tonemapCurve.data(),
+                tonemapCurve.size());
+        if (withJpegQuality) {
+            add_camera_metadata_entry(metadata.get(), ANDROID_JPEG_QUALITY, &jpegQuality, 1);
+        }
+        if (withAfTrigger) {
+            uint8_t trigger = ANDROID_CONTROL_AF_TRIGGER_START;
+            add_camera_metadata_entry(metadata.get(), ANDROID_CONTROL_AF_TRIGGER, &trigger, 1);
+        }
+        return Metadata(clone_camera_metadata(metadata.get()));
+    }
+};
+
+// A HAL that understands delta settings: keeps the last full settings and rebuilds them
+// from each delta.
+class FakeHal {
+  public:
+    void process(const camera_metadata_t* received) {
+        if (received == nullptr) {
+            return;
+        }
+        camera_metadata_ro_entry_t marker;
+        if (find_camera_metadata_ro_entry(received, kDeltaTag, &marker) != OK) {
+            mFullRequests++;
+            mSettings.reset(allocate_camera_metadata(get_camera_metadata_entry_count(received),
+                    get_camera_metadata_size(received)));
+            copyEntries(received, [](uint32_t) { return true; });
+            return;
+        }
+        ASSERT_NE(nullptr, mSettings) << "delta settings before any full settings";
+        mDeltaRequests++;
+        std::set<uint32_t> removed(marker.data.i32, marker.data.i32 + marker.count);
+        Metadata base = std::move(mSettings);
+        mSettings.reset(allocate_camera_metadata(
+                get_camera_metadata_entry_count(base.get()) +
+                        get_camera_metadata_entry_count(received),
+                get_camera_metadata_size(base.get()) + get_camera_metadata_size(received)));
+        copyEntries(base.get(), [&](uint32_t tag) {
+            camera_metadata_ro_entry_t entry;
+            return removed.count(tag) == 0 &&
+                    find_camera_metadata_ro_entry(received, tag, &entry) != OK;
+        });
+        copyEntries(received, [](uint32_t tag) { return tag != kDeltaTag; });
+    }
+
+    const camera_metadata_t* settings() const { return mSettings.get(); }
+    int fullRequests() const { return mFullRequests; }
+    int deltaRequests() const { return mDeltaRequests; }
+
+  private:
+    template <typename Filter>
+    void copyEntries(const camera_metadata_t* source, Filter filter) {
+        for (size_t i = 0; i < get_camera_metadata_entry_count(source); i++) {
+            camera_metadata_ro_entry_t entry;
+            get_camera_metadata_ro_entry(source, i, &entry);
+            if (filter(entry.tag)) {
+                ASSERT_EQ(OK, add_camera_metadata_entry(mSettings.get(), entry.tag,
+                        entry.data.u8, entry.count));
+            }
+        }
+    }
+
+    Metadata mSettings;
+    int mFullRequests = 0;
+    int mDeltaRequests = 0;
+};
+
+void expectSameSettings(const camera_metadata_t* expected, const camera_metadata_t* actual) {
+    ASSERT_NE(nullptr, actual);
+    Camera3SettingsDelta::Diff diff;
+    Camera3SettingsDelta::diff(expected, actual, &diff);
+    EXPECT_TRUE(diff.empty()) << diff.changed.size() << " changed, " << diff.removed.size()
+            << " removed";
+}
+
+} // namespace
+
+TEST(Camera3SettingsDeltaTest, DiffFindsChangedAndRemovedTags) {
+    Settings settings;
+    Metadata previous = settings.build();
+    Camera3SettingsDelta::Diff diff;
+    Camera3SettingsDelta::diff(previous.get(), previous.get(), &diff);
+    EXPECT_TRUE(diff.empty());
+
+    settings.zoomRatio = 2.0f;
+    settings.aeRegions[4] = 1000;
+    settings.withJpegQuality = false;
+    settings.withAfTrigger = true;
+    Metadata current = settings.build();
+    Camera3SettingsDelta::diff(previous.get(), current.get(), &diff);
+    std::vector<uint32_t> changed = {ANDROID_CONTROL_AE_REGIONS, ANDROID_CONTROL_AF_TRIGGER,
+            ANDROID_CONTROL_ZOOM_RATIO};
+    std::sort(changed.begin(), changed.end());
+    EXPECT_EQ(changed, diff.changed);
+    EXPECT_EQ(std::vector<uint32_t>{ANDROID_JPEG_QUALITY}, diff.removed);
+
+    // Without a previous buffer every tag counts as changed.
+    Camera3SettingsDelta::diff(nullptr, current.get(), &diff);
+    EXPECT_EQ(get_camera_metadata_entry_count(current.get()), diff.changed.size());
+    EXPECT_TRUE(diff.removed.empty());
+}
+
+TEST(Camera3SettingsDeltaTest, DisabledSendsFullSettings) {
+    Camera3SettingsDelta encoder;
+    EXPECT_FALSE(encoder.isDeltaEnabled());
+    Settings settings;
+    Metadata first = settings.build();
+    settings.zoomRatio = 1.5f;
+    Metadata second = settings.build();
+
+    EXPECT_EQ(first.get(), encoder.encode(first.get(), s2ns(1)));
+    EXPECT_EQ(second.get(), encoder.encode(second.get(), s2ns(1) + ms2ns(8)));
+    EXPECT_EQ(nullptr, encoder.encode(nullptr, s2ns(1) + ms2ns(16)));
+
+    Camera3SettingsDelta::Stats stats = encoder.getStats();
+    EXPECT_EQ(2u, stats.fullSettings);
+    EXPECT_EQ(0u, stats.deltaSettings);
+    EXPECT_EQ(stats.bytesFull, stats.bytesSent);
+    EXPECT_EQ(get_camera_metadata_size(first.get()) + get_camera_metadata_size(second.get()),
+            stats.bytesSent);
+}
+
+TEST(Camera3SettingsDeltaTest, HalRebuildsStreamingSettingsFromDeltas) {
+    Camera3SettingsDelta encoder(kDeltaTag);
+    FakeHal hal;
+    Settings settings;
+    nsecs_t now = s2ns(10);
+    std::vector<Metadata> sent;
+
+    auto submit = [&](const Settings& s) {
+        sent.push_back(s.build());
+        const camera_metadata_t* out = encoder.encode(sent.back().get(), now);
+        now += ms2ns(8);
+        hal.process(out);
+        expectSameSettings(sent.back().get(), hal.settings());
+        return out != sent.back().get();
+    };
+
+    EXPECT_FALSE(submit(settings));
+    // Pinch zoom, then a touch to meter.
+    for (int i = 1; i <= 5; i++) {
+        settings.zoomRatio = 1.0f + i * 0.1f;
+        EXPECT_TRUE(submit(settings));
+    }
+    settings.aeRegions = {100, 100, 300, 300, 1000};
+    EXPECT_TRUE(submit(settings));
+    // A one-shot trigger is added and removed again.
+    settings.withAfTrigger = true;
+    EXPECT_TRUE(submit(settings));
+    settings.withAfTrigger = false;
+    EXPECT_TRUE(submit(settings));
+    // Unchanged settings in a new request object
+    EXPECT_TRUE(submit(settings));
+    // Null settings leave the HAL's settings and the encoder's base alone.
+    EXPECT_EQ(nullptr, encoder.encode(nullptr, now));
+    hal.process(nullptr);
+    settings.withJpegQuality = false;
+    EXPECT_TRUE(submit(settings));
+
+    EXPECT_EQ(1, hal.fullRequests());
+    EXPECT_EQ(10, hal.deltaRequests());
+    Camera3SettingsDelta::Stats stats = encoder.getStats();
+    EXPECT_EQ(1u, stats.fullSettings);
+    EXPECT_EQ(10u, stats.deltaSettings);
+    EXPECT_LT(stats.bytesSent * 2, stats.bytesFull);
+}
+
+TEST(Camera3SettingsDeltaTest, ResetSendsFullSettings) {
+    Camera3SettingsDelta encoder(kDeltaTag);
+    FakeHal hal;
+    Settings settings;
+    Metadata first = settings.build();
+    hal.process(encoder.encode(first.get(), s2ns(1)));
+
+    encoder.reset();
+    settings.zoomRatio = 3.0f;
+    Metadata second = settings.build();
+    EXPECT_EQ(second.get(), encoder.encode(second.get(), s2ns(2)));
+
+    settings.zoomRatio = 4.0f;
+    Metadata third = settings.build();
+    const camera_metadata_t* out = encoder.encode(third.get(), s2ns(3));
+    EXPECT_NE(third.get(), out);
+    hal.process(second.get());
+    hal.process(out);
+    expectSameSettings(third.get(), hal.settings());
+}
+
+TEST(Camera3SettingsDeltaTest, LargeChangesSendFullSettings) {
+    Camera3SettingsDelta encoder(kDeltaTag);
+    Settings settings;
+    Metadata first = settings.build();
+    encoder.encode(first.get(), s2ns(1));
+
+    // Every tag changes, so the delta would be larger than the settings themselves.
+    settings.aeMode = ANDROID_CONTROL_AE_MODE_OFF;
+    settings.zoomRatio = 2.0f;
+    settings.aeRegions[0] = 10;
+    settings.exposureTime = 20000000;
+    settings.tonemapCurve.assign(settings.tonemapCurve.size(), 0.25f);
+    settings.jpegQuality = 80;
+    Metadata second = settings.build();
+    EXPECT_EQ(second.get(), encoder.encode(second.get(), s2ns(2)));
+    EXPECT_EQ(2u, encoder.getStats().fullSettings);
+}
+
+TEST(Camera3SettingsDeltaTest, BytesPerSecondOverWindow) {
+    Camera3SettingsDelta encoder;
+    Settings settings;
+    Metadata metadata = settings.build();
+    size_t size = get_camera_metadata_size(metadata.get());
+
+    // 31 requests 33 ms apart close the first one-second window at 30 requests.
+    nsecs_t start = s2ns(100);
+    for (int i = 0; i <= 30; i++) {
+        encoder.encode(metadata.get(), start + i * ms2ns(33) + (i == 30 ? ms2ns(10) : 0));
+    }
+    Camera3SettingsDelta::Stats stats = encoder.getStats();
+    EXPECT_EQ(31u * size, stats.bytesSent);
+    EXPECT_NEAR(31.0 * size, stats.bytesPerSecond, size);
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "../device3/Camera3SoftwareH264Codec.h"
+#include "H264PcmEncoder.h"
+
+using namespace android::camera3;
+
+namespace {
+
+constexpr uint32_t kWidth = 1280;
+constexpr uint32_t kHeight = 720;
+constexpr size_t kFrames = 8;
+
+// I_PCM frames exercise parsing, reconstruction, threading and the NV21 output
+// copy, but not entropy decoding or prediction; absolute numbers are lower than
+// for camera-encoded streams of the same size.
+std::vector<std::vector<uint8_t>> makeStream() {
+    H264PcmEncoder encoder(kWidth, kHeight);
+    std::vector<uint8_t> frame(Camera3SoftwareH264Codec::frameSize(kWidth, kHeight));
+    std::vector<std::vector<uint8_t>> stream;
+    for (size_t i = 0; i < kFrames; i++) {
+        for (size_t j = 0; j < frame.size(); j++) {
+            frame[j] = static_cast<uint8_t>(j * 7 + i * 29);
+        }
+        stream.push_back(encoder.encode(frame.data(), i == 0));
+    }
+    return stream;
+}
+
+void BM_SoftwareH264Decode(benchmark::State& state) {
+    std::vector<std::vector<uint8_t>> stream = makeStream();
+    Camera3SoftwareH264Codec codec;
+    if (codec.initialize(kWidth, kHeight, state.range(0)) != android::OK) {
+        state.SkipWithError("software decoder unavailable");
+        return;
+    }
+    std::vector<uint8_t> out(Camera3SoftwareH264Codec::frameSize(kWidth, kHeight));
+    Camera3SoftwareH264Codec::Picture picture;
+    size_t index = 0;
+    int64_t bytes = 0;
+    for (auto _ : state) {
+        const std::vector<uint8_t>& au = stream[index];
+        codec.decode(au.data(), au.size(), index, out.data(), out.size(), &picture);
+        benchmark::DoNotOptimize(out.data());
+        bytes += au.size();
+        // Skip the SPS/PPS access unit after the first pass.
+        index = (index + 1) % kFrames;
+        if (index == 0) index = 1;
+    }
+    state.SetBytesProcessed(bytes);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SoftwareH264Decode)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "Camera3SoftwareH264CodecTest"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../device3/Camera3SoftwareH264Codec.h"
+#include "H264PcmEncoder.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+std::vector<uint8_t> makeFrame(uint32_t width, uint32_t height, uint32_t seed) {
+    std::vector<uint8_t> frame(Camera3SoftwareH264Codec::frameSize(width, height));
+    for (size_t i = 0; i < frame.size(); i++) {
+        frame[i] = static_cast<uint8_t>((i * 7 + (i / width) * 13 + seed * 31) & 0xFF);
+    }
+    return frame;
+}
+
+// Decodes one access unit and, if the decoder held the picture back, drains it.
+status_t decodeFrame(Camera3SoftwareH264Codec* codec, const std::vector<uint8_t>& au,
+        int64_t timestampUs, std::vector<uint8_t>* out,
+        Camera3SoftwareH264Codec::Picture* picture) {
+    status_t res = codec->decode(au.data(), au.size(), timestampUs, out->data(), out->size(),
+            picture);
+    if (res == OK && !picture->present) {
+        res = codec->drain(out->data(), out->size(), picture);
+    }
+    return res;
+}
+
+} // namespace
+
+TEST(Camera3SoftwareH264CodecTest, RejectsDecodeBeforeInitialize) {
+    Camera3SoftwareH264Codec codec;
+    EXPECT_FALSE(codec.isInitialized());
+    uint8_t data[] = {0x00, 0x00, 0x00, 0x01, 0x65};
+    std::vector<uint8_t> out(64);
+    Camera3SoftwareH264Codec::Picture picture;
+    EXPECT_EQ(INVALID_OPERATION, codec.decode(data, sizeof(data), 0, out.data(), out.size(),
+            &picture));
+    EXPECT_FALSE(picture.present);
+    EXPECT_EQ(BAD_VALUE, codec.initialize(63, 48, 1));
+    EXPECT_FALSE(codec.isInitialized());
+}
+
+TEST(Camera3SoftwareH264CodecTest, DecodesLosslessFrameExactly) {
+    const uint32_t width = 64, height = 48;
+    Camera3SoftwareH264Codec codec;
+    ASSERT_EQ(OK, codec.initialize(width, height, 1));
+    EXPECT_EQ(1u, codec.getThreads());
+
+    H264PcmEncoder encoder(width, height);
+    std::vector<uint8_t> input = makeFrame(width, height, 1);
+    std::vector<uint8_t> output(Camera3SoftwareH264Codec::frameSize(width, height));
+    Camera3SoftwareH264Codec::Picture picture;
+    ASSERT_EQ(OK, decodeFrame(&codec, encoder.encode(input.data()), 1234, &output, &picture));
+    ASSERT_TRUE(picture.present);
+    EXPECT_EQ(width, picture.width);
+    EXPECT_EQ(height, picture.height);
+    EXPECT_EQ(1234, picture.timestampUs);
+    // I_PCM without deblocking is lossless, and the codec writes NV21 directly.
+    EXPECT_EQ(input, output);
+}
+
+TEST(Camera3SoftwareH264CodecTest, CroppedSizeDecodesToDisplaySize) {
+    // 72x40 is coded as 80x48 with right and bottom cropping.
+    const uint32_t width = 72, height = 40;
+    Camera3SoftwareH264Codec codec;
+    ASSERT_EQ(OK, codec.initialize(width, height, 1));
+
+    H264PcmEncoder encoder(width, height);
+    std::vector<uint8_t> input = makeFrame(width, height, 2);
+    std::vector<uint8_t> output(Camera3SoftwareH264Codec::frameSize(width, height));
+    Camera3SoftwareH264Codec::Picture picture;
+    ASSERT_EQ(OK, decodeFrame(&codec, encoder.encode(input.data()), 0, &output, &picture));
+    ASSERT_TRUE(picture.present);
+    EXPECT_EQ(input, output);
+}
+
+TEST(Camera3SoftwareH264CodecTest, MultiThreadedDecodeMatchesInput) {
+    const uint32_t width = 320, height = 240;
+    Camera3SoftwareH264Codec codec;
+    ASSERT_EQ(OK, codec.initialize(width, height, 64));
+    EXPECT_EQ(Camera3SoftwareH264Codec::kMaxThreads, codec.getThreads());
+
+    H264PcmEncoder encoder(width, height);
+    std::vector<uint8_t> output(Camera3SoftwareH264Codec::frameSize(width, height));
+    for (uint32_t i = 0; i < 5; i++) {
+        std::vector<uint8_t> input = makeFrame(width, height, 10 + i);
+        // Only the first access unit carries SPS/PPS.
+        Camera3SoftwareH264Codec::Picture picture;
+        ASSERT_EQ(OK, decodeFrame(&codec, encoder.encode(input.data(), i == 0),
+                1000 * (i + 1), &output, &picture));
+        ASSERT_TRUE(picture.present) << "frame " << i;
+        EXPECT_EQ(1000 * (i + 1), picture.timestampUs);
+        EXPECT_EQ(input, output) << "frame " << i;
+    }
+}
+
+TEST(Camera3SoftwareH264CodecTest, ResolutionChangeNeedsReinitialize) {
+    Camera3SoftwareH264Codec codec;
+    ASSERT_EQ(OK, codec.initialize(64, 48, 2));
+
+    H264PcmEncoder encoder(128, 96);
+    std::vector<uint8_t> input = makeFrame(128, 96, 3);
+    std::vector<uint8_t> au = encoder.encode(input.data());
+    // The output buffer is sized for the configured 64x48 stream and must not
+    // receive a 128x96 picture.
+    std::vector<uint8_t> small(Camera3SoftwareH264Codec::frameSize(64, 48));
+    Camera3SoftwareH264Codec::Picture picture;
+    codec.decode(au.data(), au.size(), 0, small.data(), small.size(), &picture);
+    EXPECT_FALSE(picture.present);
+
+    ASSERT_EQ(OK, codec.initialize(128, 96, 2));
+    std::vector<uint8_t> output(Camera3SoftwareH264Codec::frameSize(128, 96));
+    ASSERT_EQ(OK, decodeFrame(&codec, au, 0, &output, &picture));
+    ASSERT_TRUE(picture.present);
+    EXPECT_EQ(input, output);
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_NDEBUG 0
+#define LOG_TAG "Camera3StreamInjectionManagerTest"
+
+#include <stdio.h>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "../device3/Camera3StreamInjectionManager.h"
+
+using namespace android;
+using namespace android::camera3;
+
+namespace {
+
+std::shared_ptr<DecodedFrame> publishTestFrame(const sp<Camera3InjectionSource>& source) {
+    auto frame = source->acquireFrame(16, 16);
+    Camera3StreamInjectionManager::getInstance()->publishFrame(source, frame);
+    return frame;
+}
+
+} // namespace
+
+// The manager is a process-wide singleton, so every test uses its own source IDs.
+
+TEST(Camera3StreamInjectionManagerTest, GetSourceReturnsSameInstance) {
+    auto mgr = Camera3StreamInjectionManager::getInstance();
+    sp<Camera3InjectionSource> a = mgr->getSource("same-0");
+    sp<Camera3InjectionSource> b = mgr->getSource("same-0");
+    EXPECT_EQ(a, b);
+    EXPECT_EQ("same-0", a->getId());
+    EXPECT_NE(a, mgr->getSource(Camera3StreamInjectionManager::kDefaultSourceId));
+}
+
+TEST(Camera3StreamInjectionManagerTest, RoutesToActiveCameraSource) {
+    auto mgr = Camera3StreamInjectionManager::getInstance();
+    sp<Camera3InjectionSource> defaultSource =
+            mgr->getSource(Camera3StreamInjectionManager::kDefaultSourceId);
+    sp<Camera3InjectionSource> camera = mgr->getSource("route-0");
+
+    // Inactive per-camera sources fall back to the default source.
+    EXPECT_EQ(defaultSource, mgr->routeSource("route-0", ""));
+
+    camera->setInjectionActive(true);
+    EXPECT_EQ(camera, mgr->routeSource("route-0", ""));
+    // Other cameras are not affected.
+    EXPECT_EQ(defaultSource, mgr->routeSource("route-1", ""));
+
+    camera->setInjectionActive(false);
+    EXPECT_EQ(defaultSource, mgr->routeSource("route-0", ""));
+}
+
+TEST(Camera3StreamInjectionManagerTest, PhysicalCameraSourceTakesPriority) {
+    auto mgr = Camera3StreamInjectionManager::getInstance();
+    sp<Camera3InjectionSource> logical = mgr->getSource("phys-logical");
+    sp<Camera3InjectionSource> physical = mgr->getSource("phys-physical");
+    logical->setInjectionActive(true);
+
+    EXPECT_EQ(logical, mgr->routeSource("phys-logical", "phys-physical"));
+    physical->setInjectionActive(true);
+    EXPECT_EQ(physical, mgr->routeSource("phys-logical", "phys-physical"));
+
+    logical->setInjectionActive(false);
+    physical->setInjectionActive(false);
+}
+
+TEST(Camera3StreamInjectionManagerTest, SourcesKeepSeparateFrames) {
+    auto mgr = Camera3StreamInjectionManager::getInstance();
+    sp<Camera3InjectionSource> a = mgr->getSource("frames-a");
+    sp<Camera3InjectionSource> b = mgr->getSource("frames-b");
+
+    auto frameA = publishTestFrame(a);
+    auto frameB = publishTestFrame(b);
+    EXPECT_EQ(frameA, a->getLatestFrame());
+    EXPECT_EQ(frameB, b->getLatestFrame());
+    EXPECT_TRUE(a->isInjectionActive());
+
+    // Sequences are unique across sources so the render caches never confuse frames.
+    EXPECT_NE(frameA->sequence, frameB->sequence);
+    EXPECT_LT(frameA->sequence, frameB->sequence);
+
+    a->setInjectionActive(false);
+    b->setInjectionActive(false);
+}
+
+TEST(Camera3StreamInjectionManagerTest, DumpListsOnlyLiveStreams) {
+    auto mgr = Camera3StreamInjectionManager::getInstance();
+    auto live = mgr->registerStream("dump-0", 1);
+    live->framesComposited += 3;
+    live->addLockWait(2000);
+    live->addLockWait(500);
+    EXPECT_EQ(2u, live->lockContentions.load());
+    EXPECT_EQ(2000, live->maxLockWaitNs.load());
+    mgr->registerStream("dump-0", 2).reset();
+
+    FILE* out = tmpfile();
+    ASSERT_NE(nullptr, out);
+    mgr->dump(fileno(out));
+    std::string text(4096, '\0');
+    rewind(out);
+    text.resize(fread(text.data(), 1, text.size(), out));
+    fclose(out);
+    EXPECT_NE(std::string::npos, text.find("Camera dump-0 stream 1 (0x0): composited 3"));
+    EXPECT_EQ(std::string::npos, text.find("Camera dump-0 stream 2"));
+}
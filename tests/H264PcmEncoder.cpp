@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "H264PcmEncoder.h"
+
+#include <algorithm>
+
+namespace {
+
+constexpr uint8_t kNalSps = 0x67; // nal_ref_idc 3, type 7
+constexpr uint8_t kNalPps = 0x68; // nal_ref_idc 3, type 8
+constexpr uint8_t kNalIdr = 0x65; // nal_ref_idc 3, type 5
+constexpr uint32_t kMbTypeIPcm = 25;
+
+class BitWriter {
+public:
+    void u(uint32_t bits, uint32_t value) {
+        for (uint32_t i = bits; i > 0; i--) {
+            bit((value >> (i - 1)) & 1);
+        }
+    }
+    void ue(uint32_t value) {
+        uint64_t coded = static_cast<uint64_t>(value) + 1;
+        uint32_t length = 0;
+        while ((coded >> length) > 1) length++;
+        u(length, 0);
+        for (uint32_t i = length + 1; i > 0; i--) {
+            bit((coded >> (i - 1)) & 1);
+        }
+    }
+    void se(int32_t value) {
+        ue(value > 0 ? 2 * value - 1 : -2 * value);
+    }
+    void alignZero() {
+        while (mBitCount != 0) bit(0);
+    }
+    void trailingBits() {
+        bit(1);
+        alignZero();
+    }
+    const std::vector<uint8_t>& bytes() const { return mBytes; }
+
+private:
+    void bit(uint32_t b) {
+        mCurrent = (mCurrent << 1) | b;
+        if (++mBitCount == 8) {
+            mBytes.push_back(mCurrent);
+            mCurrent = 0;
+            mBitCount = 0;
+        }
+    }
+
+    std::vector<uint8_t> mBytes;
+    uint8_t mCurrent = 0;
+    uint32_t mBitCount = 0;
+};
+
+// Appends a start code, the NAL header and the RBSP with emulation prevention.
+void appendNal(uint8_t header, const std::vector<uint8_t>& rbsp, std::vector<uint8_t>* out) {
+    const uint8_t startCode[] = {0x00, 0x00, 0x00, 0x01};
+    out->insert(out->end(), startCode, startCode + sizeof(startCode));
+    out->push_back(header);
+    size_t zeros = 0;
+    for (uint8_t b : rbsp) {
+        if (zeros >= 2 && b <= 0x03) {
+            out->push_back(0x03);
+            zeros = 0;
+        }
+        out->push_back(b);
+        zeros = (b == 0) ? zeros + 1 : 0;
+    }
+}
+
+} // namespace
+
+H264PcmEncoder::H264PcmEncoder(uint32_t width, uint32_t height) :
+        mWidth(width),
+        mHeight(height),
+        mMbWidth((width + 15) / 16),
+        mMbHeight((height + 15) / 16),
+        mIdrPicId(0) {
+}
+
+std::vector<uint8_t> H264PcmEncoder::encodeSps() const {
+    BitWriter w;
+    w.u(8, 66);             // profile_idc: Baseline
+    w.u(8, 0xC0);           // constraint_set0/1: Constrained Baseline
+    w.u(8, 40);             // level_idc
+    w.ue(0);                // seq_parameter_set_id
+    w.ue(0);                // log2_max_frame_num_minus4
+    w.ue(2);                // pic_order_cnt_type: output order == decode order
+    w.ue(1);                // max_num_ref_frames
+    w.u(1, 0);              // gaps_in_frame_num_value_allowed_flag
+    w.ue(mMbWidth - 1);     // pic_width_in_mbs_minus1
+    w.ue(mMbHeight - 1);    // pic_height_in_map_units_minus1
+    w.u(1, 1);              // frame_mbs_only_flag
+    w.u(1, 1);              // direct_8x8_inference_flag
+    uint32_t cropRight = (mMbWidth * 16 - mWidth) / 2;
+    uint32_t cropBottom = (mMbHeight * 16 - mHeight) / 2;
+    bool cropping = cropRight != 0 || cropBottom != 0;
+    w.u(1, cropping);       // frame_cropping_flag
+    if (cropping) {
+        w.ue(0);
+        w.ue(cropRight);
+        w.ue(0);
+        w.ue(cropBottom);
+    }
+    w.u(1, 1);              // vui_parameters_present_flag
+    w.u(1, 0);              // aspect_ratio_info_present_flag
+    w.u(1, 0);              // overscan_info_present_flag
+    w.u(1, 0);              // video_signal_type_present_flag
+    w.u(1, 0);              // chroma_loc_info_present_flag
+    w.u(1, 0);              // timing_info_present_flag
+    w.u(1, 0);              // nal_hrd_parameters_present_flag
+    w.u(1, 0);              // vcl_hrd_parameters_present_flag
+    w.u(1, 0);              // pic_struct_present_flag
+    w.u(1, 1);              // bitstream_restriction_flag
+    w.u(1, 1);              // motion_vectors_over_pic_boundaries_flag
+    w.ue(0);                // max_bytes_per_pic_denom
+    w.ue(0);                // max_bits_per_mb_denom
+    w.ue(16);               // log2_max_mv_length_horizontal
+    w.ue(16);               // log2_max_mv_length_vertical
+    w.ue(0);                // max_num_reorder_frames
+    w.ue(1);                // max_dec_frame_buffering
+    w.trailingBits();
+    std::vector<uint8_t> out;
+    appendNal(kNalSps, w.bytes(), &out);
+    return out;
+}
+
+std::vector<uint8_t> H264PcmEncoder::encodePps() const {
+    BitWriter w;
+    w.ue(0);                // pic_parameter_set_id
+    w.ue(0);                // seq_parameter_set_id
+    w.u(1, 0);              // entropy_coding_mode_flag: CAVLC
+    w.u(1, 0);              // bottom_field_pic_order_in_frame_present_flag
+    w.ue(0);                // num_slice_groups_minus1
+    w.ue(0);                // num_ref_idx_l0_default_active_minus1
+    w.ue(0);                // num_ref_idx_l1_default_active_minus1
+    w.u(1, 0);              // weighted_pred_flag
+    w.u(2, 0);              // weighted_bipred_idc
+    w.se(0);                // pic_init_qp_minus26
+    w.se(0);                // pic_init_qs_minus26
+    w.se(0);                // chroma_qp_index_offset
+    w.u(1, 1);              // deblocking_filter_control_present_flag
+    w.u(1, 0);              // constrained_intra_pred_flag
+    w.u(1, 0);              // redundant_pic_cnt_present_flag
+    w.trailingBits();
+    std::vector<uint8_t> out;
+    appendNal(kNalPps, w.bytes(), &out);
+    return out;
+}
+
+std::vector<uint8_t> H264PcmEncoder::encode(const uint8_t* nv21, bool withHeaders) {
+    std::vector<uint8_t> out;
+    if (withHeaders) {
+        out = encodeSps();
+        std::vector<uint8_t> pps = encodePps();
+        out.insert(out.end(), pps.begin(), pps.end());
+    }
+
+    BitWriter w;
+    w.ue(0);                // first_mb_in_slice
+    w.ue(7);                // slice_type: I, all slices of the picture
+    w.ue(0);                // pic_parameter_set_id
+    w.u(4, 0);              // frame_num
+    w.ue(mIdrPicId);        // idr_pic_id
+    w.u(1, 0);              // no_output_of_prior_pics_flag
+    w.u(1, 0);              // long_term_reference_flag
+    w.se(0);                // slice_qp_delta
+    w.ue(1);                // disable_deblocking_filter_idc
+    // Consecutive IDR pictures need different idr_pic_id values.
+    mIdrPicId = (mIdrPicId + 1) % 2;
+
+    // Samples outside the visible area repeat the nearest edge.
+    const uint8_t* vu = nv21 + mWidth * mHeight;
+    auto luma = [&](uint32_t x, uint32_t y) {
+        return nv21[std::min(y, mHeight - 1) * mWidth + std::min(x, mWidth - 1)];
+    };
+    auto chroma = [&](uint32_t x, uint32_t y, uint32_t plane) {
+        x = std::min(x, mWidth / 2 - 1);
+        y = std::min(y, mHeight / 2 - 1);
+        return vu[y * mWidth + x * 2 + plane];
+    };
+    for (uint32_t mbY = 0; mbY < mMbHeight; mbY++) {
+        for (uint32_t mbX = 0; mbX < mMbWidth; mbX++) {
+            w.ue(kMbTypeIPcm);
+            w.alignZero();  // pcm_alignment_zero_bit
+            for (uint32_t y = 0; y < 16; y++) {
+                for (uint32_t x = 0; x < 16; x++) {
+                    w.u(8, luma(mbX * 16 + x, mbY * 16 + y));
+                }
+            }
+            // Cb (U) then Cr (V); NV21 interleaves V first.
+            for (uint32_t plane : {1u, 0u}) {
+                for (uint32_t y = 0; y < 8; y++) {
+                    for (uint32_t x = 0; x < 8; x++) {
+                        w.u(8, chroma(mbX * 8 + x, mbY * 8 + y, plane));
+                    }
+                }
+            }
+        }
+    }
+    w.trailingBits();
+    appendNal(kNalIdr, w.bytes(), &out);
+    return out;
+}
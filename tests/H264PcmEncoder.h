@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TEST_CAMERA_H264_PCM_ENCODER_H
+#define TEST_CAMERA_H264_PCM_ENCODER_H
+
+#include <stdint.h>
+
+#include <vector>
+
+/* Minimal H.264 encoder for decoder tests: every frame is a Constrained
+ * Baseline IDR picture made of I_PCM macroblocks with deblocking disabled, so
+ * a conforming decoder must reproduce the input samples exactly. The output is
+ * an Annex-B stream; the SPS carries frame cropping for sizes that are not a
+ * multiple of 16 and a VUI that asks for no display reordering.
+ */
+class H264PcmEncoder {
+public:
+    // |width| and |height| must be even.
+    H264PcmEncoder(uint32_t width, uint32_t height);
+
+    /* Encode one NV21 frame of the configured size. When |withHeaders| is set
+     * the SPS and PPS are emitted in front of the slice, as encoders do for
+     * every IDR.
+     */
+    std::vector<uint8_t> encode(const uint8_t* nv21, bool withHeaders = true);
+
+    std::vector<uint8_t> encodeSps() const;
+    std::vector<uint8_t> encodePps() const;
+
+private:
+    uint32_t mWidth;
+    uint32_t mHeight;
+    uint32_t mMbWidth;
+    uint32_t mMbHeight;
+    uint32_t mIdrPicId;
+};
+
+#endif // TEST_CAMERA_H264_PCM_ENCODER_H
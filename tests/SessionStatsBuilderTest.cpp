@@ -67,3 +67,31 @@ TEST(SessionStatsBuilderTest, FpsHistogramTest) {
     ASSERT_EQ(mostRequestedFpsRange, make_pair(2, 2)) << "Incorrect stats overflow behavior";
 
 }
+
+TEST(SessionStatsBuilderTest, InjectionCountersTest) {
+    SessionStatsBuilder b{};
+
+    int64_t requestCount, resultErrorCount;
+    bool deviceError;
+    pair<int32_t, int32_t> mostRequestedFpsRange;
+    map<int, StreamStats> streamStatsMap;
+
+    b.addStream(1);
+    b.incInjectionCounters(1, 10, 2, 3);
+    b.incInjectionCounters(1, 5, 1, 0);
+    // Unknown streams are ignored
+    b.incInjectionCounters(2, 7, 7, 7);
+
+    b.buildAndReset(&requestCount, &resultErrorCount,
+        &deviceError, &mostRequestedFpsRange, &streamStatsMap);
+    ASSERT_EQ(streamStatsMap.count(2), 0u);
+    ASSERT_EQ(streamStatsMap[1].mInjectedFrameCount, 15);
+    ASSERT_EQ(streamStatsMap[1].mRepeatedInjectedFrameCount, 3);
+    ASSERT_EQ(streamStatsMap[1].mPlaceholderFrameCount, 3);
+
+    // Counters restart with the next session
+    b.buildAndReset(&requestCount, &resultErrorCount,
+        &deviceError, &mostRequestedFpsRange, &streamStatsMap);
+    ASSERT_EQ(streamStatsMap[1].mInjectedFrameCount, 0);
+    ASSERT_EQ(streamStatsMap[1].mPlaceholderFrameCount, 0);
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// 个人修改开始
+// 注入 socket 的替身客户端：把 Camera3SocketServer 录制的文件按原始节奏、加速或尽快地
+// 写回注入 socket，用于在没有真实发送端时复现和测量注入管线。
+//
+//   camera_injection_replay [-s socket_name] [-r original|max|<N>x] [-l loops] file.aidrec
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "../device3/Camera3InjectionRecording.h"
+
+using android::OK;
+using android::status_t;
+using android::camera3::Camera3InjectionRecording;
+
+namespace {
+
+const char* kDefaultSocketName = "aidock_cam_h264";
+
+void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [-s socket_name] [-r original|max|<N>x] [-l loops] file\n"
+            "  -s  abstract socket name (default %s)\n"
+            "  -r  replay rate: original timing, as fast as possible, or N times faster\n"
+            "      (default original)\n"
+            "  -l  play the recording this many times over one connection (default 1)\n",
+            argv0, kDefaultSocketName);
+}
+
+// 连接 Camera3SocketServer 监听的抽象命名空间 socket
+int connectAbstract(const std::string& name) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (name.empty() || name.size() > sizeof(addr.sun_path) - 2) {
+        fprintf(stderr, "invalid socket name '%s'\n", name.c_str());
+        return -1;
+    }
+    addr.sun_path[0] = '\0';
+    memcpy(addr.sun_path + 1, name.c_str(), name.size());
+    socklen_t len = offsetof(struct sockaddr_un, sun_path) + 1 + name.size();
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        fprintf(stderr, "socket: %s\n", strerror(errno));
+        return -1;
+    }
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), len) < 0) {
+        fprintf(stderr, "connect to @%s: %s\n", name.c_str(), strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string socketName = kDefaultSocketName;
+    double speed = 1;
+    long loops = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:r:l:h")) != -1) {
+        switch (opt) {
+            case 's':
+                socketName = optarg;
+                break;
+            case 'r':
+                if (!Camera3InjectionRecording::Player::parseSpeed(optarg, &speed)) {
+                    fprintf(stderr, "invalid rate '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'l':
+                loops = strtol(optarg, nullptr, 10);
+                if (loops <= 0) {
+                    fprintf(stderr, "invalid loop count '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            default:
+                usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    Camera3InjectionRecording::Reader reader;
+    status_t res = reader.open(argv[optind]);
+    if (res != OK) {
+        fprintf(stderr, "cannot open recording %s: %s (%d)\n", argv[optind], strerror(-res),
+                res);
+        return 1;
+    }
+
+    int fd = connectAbstract(socketName);
+    if (fd < 0) {
+        return 1;
+    }
+
+    // 多次循环共用同一个连接：分帧模式下 hello 只在第一遍有效，因此循环只适用于
+    // 原始模式的录制，或者服务端允许重复 hello 的情况
+    Camera3InjectionRecording::Player player(speed);
+    Camera3InjectionRecording::Player::Stats stats;
+    for (long i = 0; i < loops && res == OK; i++) {
+        if (i > 0) {
+            res = reader.rewind();
+            if (res != OK) break;
+        }
+        res = player.play(reader, fd, nullptr, &stats);
+    }
+    close(fd);
+
+    double seconds = stats.duration / 1e9;
+    printf("sent %llu chunks, %llu bytes in %.3f s (%.2f MB/s), received %llu bytes\n",
+            static_cast<unsigned long long>(stats.chunks),
+            static_cast<unsigned long long>(stats.bytes), seconds,
+            seconds > 0 ? stats.bytes / seconds / (1024 * 1024) : 0.0,
+            static_cast<unsigned long long>(stats.bytesReceived));
+    if (speed != Camera3InjectionRecording::Player::kMaxRate) {
+        printf("max lateness %.3f ms\n", stats.maxLateness / 1e6);
+    }
+    if (res != OK) {
+        fprintf(stderr, "replay stopped: %s (%d)\n", strerror(-res), res);
+        return 1;
+    }
+    return 0;
+}
+// 个人修改结束
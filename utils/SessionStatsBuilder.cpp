@@ -83,6 +83,11 @@ void SessionStatsBuilder::buildAndReset(int64_t* requestCount,
         streamStat.mDroppedFrameCount = 0;
         streamStat.mCounterStopped = false;
         streamStat.mStartLatencyMs = 0;
+        // 个人修改开始
+        streamStat.mInjectedFrameCount = 0;
+        streamStat.mRepeatedInjectedFrameCount = 0;
+        streamStat.mPlaceholderFrameCount = 0;
+        // 个人修改结束
 
         std::fill(streamStat.mCaptureLatencyHistogram.begin(),
                 streamStat.mCaptureLatencyHistogram.end(), 0);
@@ -120,6 +125,21 @@ void SessionStatsBuilder::incCounter(int id, bool dropped, int32_t captureLatenc
     streamStat.updateLatencyHistogram(captureLatencyMs);
 }
 
+// 个人修改开始
+void SessionStatsBuilder::incInjectionCounters(int id, int64_t injected, int64_t repeated,
+        int64_t placeholder) {
+    std::lock_guard<std::mutex> l(mLock);
+
+    auto it = mStatsMap.find(id);
+    if (it == mStatsMap.end()) return;
+
+    StreamStats& streamStat = it->second;
+    streamStat.mInjectedFrameCount += injected;
+    streamStat.mRepeatedInjectedFrameCount += repeated;
+    streamStat.mPlaceholderFrameCount += placeholder;
+}
+// 个人修改结束
+
 void SessionStatsBuilder::stopCounter() {
     std::lock_guard<std::mutex> l(mLock);
     mCounterStopped = true;
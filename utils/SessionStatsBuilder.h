@@ -45,11 +45,22 @@ struct StreamStats {
     // Counter values for all histogram bins. One more entry than mCaptureLatencyBins.
     std::array<int64_t, LATENCY_BIN_COUNT> mCaptureLatencyHistogram;
 
+    // 个人修改开始
+    // Fields for injected frames: buffers filled with an injected frame, those of them
+    // repeating the previous frame, and buffers filled with the placeholder
+    int64_t mInjectedFrameCount;
+    int64_t mRepeatedInjectedFrameCount;
+    int64_t mPlaceholderFrameCount;
+    // 个人修改结束
+
     StreamStats() : mRequestedFrameCount(0),
                      mDroppedFrameCount(0),
                      mCounterStopped(false),
                      mStartLatencyMs(0),
-                     mCaptureLatencyHistogram{}
+                     mCaptureLatencyHistogram{},
+                     mInjectedFrameCount(0),
+                     mRepeatedInjectedFrameCount(0),
+                     mPlaceholderFrameCount(0)
                   {}
 
     void updateLatencyHistogram(int32_t latencyMs);
@@ -73,6 +84,10 @@ public:
     void startCounter(int streamId);
     void stopCounter(int streamId);
     void incCounter(int streamId, bool dropped, int32_t captureLatencyMs);
+    // 个人修改开始
+    void incInjectionCounters(int streamId, int64_t injected, int64_t repeated,
+            int64_t placeholder);
+    // 个人修改结束
 
     // Session specific counter
     void stopCounter();